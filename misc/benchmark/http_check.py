@@ -0,0 +1,126 @@
+#!/usr/bin/env python3
+# Checks how the http workers schedule requests, using the benchmark build's http stage
+#  against a local http server that records when each request was performed
+# Usage: python3 misc/benchmark/http_check.py [path to ClassiCube-benchmark]
+#  (build it first with "make benchmark")
+import http.server, os, re, socketserver, subprocess, sys, tempfile, threading, time
+
+DELAY     = 0.1  # seconds the server takes to respond to each request
+TOLERANCE = 0.05 # seconds two requests may start apart and still count as starting at once
+# Must match HTTP_MAX_HOST_REQUESTS in src/Http_Worker.c
+MAX_HOST_REQUESTS = 3
+# Must match HTTP_BENCH_ in src/Benchmark.c
+NORMAL, PRIORITY, COOKIE = 12, 2, 4
+
+lock     = threading.Lock()
+requests = []  # (lane, index, start, end)
+active   = {}  # host -> requests currently being responded to
+peak     = {}  # host -> most requests responded to at once
+cookie_active, cookie_peak, cookie_done = 0, 0, 0
+errors   = []
+
+class Handler(http.server.BaseHTTPRequestHandler):
+    protocol_version = 'HTTP/1.1'
+
+    def do_GET(self):
+        global cookie_active, cookie_peak, cookie_done
+        host  = self.headers['Host']
+        parts = self.path.strip('/').split('/')
+        lane, index = parts[-2], int(parts[-1])
+        start = time.monotonic()
+
+        with lock:
+            active[host] = active.get(host, 0) + 1
+            peak[host]   = max(peak.get(host, 0), active[host])
+            if lane == 'cookie':
+                cookie_active += 1
+                cookie_peak = max(cookie_peak, cookie_active)
+                # Each request must send the cookie set by the previous request's response
+                sent = re.search(r'\bn=(\d+)', self.headers['Cookie'] or '')
+                sent = int(sent.group(1)) if sent else 0
+                if sent != cookie_done:
+                    errors.append('cookie request %d sent n=%d, expected n=%d' % (index, sent, cookie_done))
+
+        time.sleep(DELAY)
+        body = self.path.encode()
+        self.send_response(200)
+        self.send_header('Content-Length', str(len(body)))
+        if lane == 'cookie':
+            with lock: value = cookie_done + 1
+            self.send_header('Set-Cookie', 'n=%d; path=/' % value)
+        self.end_headers()
+        self.wfile.write(body)
+
+        with lock:
+            active[host] -= 1
+            if lane == 'cookie':
+                cookie_active -= 1
+                cookie_done   += 1
+            requests.append((lane, index, start, time.monotonic()))
+
+    def log_message(self, *args): pass
+
+class Server(socketserver.ThreadingMixIn, http.server.HTTPServer):
+    daemon_threads = True
+
+def start_of(lane, index):
+    for r in requests:
+        if r[0] == lane and r[1] == index: return r[2]
+    errors.append('%s request %d was never performed' % (lane, index))
+    return 0
+
+def check(condition, message):
+    if not condition: errors.append(message)
+
+def main():
+    exe = os.path.abspath(sys.argv[1] if len(sys.argv) > 1 else 'ClassiCube-benchmark')
+    server = Server(('127.0.0.1', 0), Handler)
+    threading.Thread(target=server.serve_forever, daemon=True).start()
+    url = 'http://127.0.0.1:%d' % server.server_address[1]
+
+    # Use a tiny map, since only the http stage matters here
+    args = [exe, 'http=' + url, 'width=16', 'height=16', 'length=16', 'runs=1']
+    with tempfile.TemporaryDirectory() as dir:
+        proc = subprocess.run(args, cwd=dir, stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+                              universal_newlines=True, timeout=120)
+    server.shutdown()
+
+    result = [l for l in proc.stdout.splitlines() if l.startswith('stage=http ')]
+    check(proc.returncode == 0, 'benchmark exited with %d' % proc.returncode)
+    check(len(result) == 1, 'benchmark did not run the http stage')
+    if result:
+        print(result[0])
+        stats = dict(kv.split('=', 1) for kv in result[0].split()[1:])
+        check(stats['failed'] == '0', '%s requests failed' % stats['failed'])
+        check(stats['cookie'] == str(COOKIE), 'final cookie was n=%s, expected n=%d' % (stats['cookie'], COOKIE))
+
+    # Requests to one server are limited, but should still be performed at once
+    for host, count in peak.items():
+        check(count <= MAX_HOST_REQUESTS, '%d requests to %s were performed at once' % (count, host))
+        check(count > 1, 'requests to %s were only performed one at a time' % host)
+
+    # Requests in each queue are started in the order they were added
+    normal = [start_of('normal', i) for i in range(NORMAL)] + [start_of('cookie', i) for i in range(COOKIE)]
+    prio   = [start_of('priority', i) for i in range(PRIORITY)]
+    for queue, name in ((normal, 'normal'), (prio, 'priority')):
+        for i in range(1, len(queue)):
+            check(queue[i] >= max(queue[:i]) - TOLERANCE, '%s request %d started before an earlier one' % (name, i))
+
+    # Priority requests are added once the first normal requests have started,
+    #  so must start no later than the first normal request that was still waiting
+    first_waiting = normal[MAX_HOST_REQUESTS]
+    for i, start in enumerate(prio):
+        check(start <= first_waiting + TOLERANCE, 'priority request %d started after queued normal requests' % i)
+
+    # Responses may modify the cookies, so requests sharing them must be performed one at a time
+    check(cookie_peak == 1, '%d requests sharing cookies were performed at once' % cookie_peak)
+
+    for error in errors: print('FAIL: ' + error)
+    if errors:
+        print(proc.stdout)
+        return 1
+    print('OK: %d requests, at most %s at once' % (len(requests), max(peak.values())))
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -358,15 +358,10 @@ static void Animations_Tick(struct ScheduledTask* task) {
 /*########################################################################################################################*
 *--------------------------------------------------Animations component---------------------------------------------------*
 *#########################################################################################################################*/
-static void AnimationsPngProcess(struct Stream* stream, const cc_string* name) {
-	cc_result res = Png_Decode(&anims_bmp, stream);
-	if (!res) return;
-
-	Logger_SysWarn2(res, "decoding", name);
-	Mem_Free(anims_bmp.scan0);
-	anims_bmp.scan0 = NULL;
+static void AnimationsPngProcess(struct Bitmap* bmp, const cc_string* name) {
+	anims_bmp = *bmp;
 }
-static struct TextureEntry animations_entry = { "animations.png", AnimationsPngProcess };
+static struct TextureEntry animations_entry = { "animations.png", NULL, AnimationsPngProcess };
 static struct TextureEntry animations_txt   = { "animations.txt", Animations_ReadDescription };
 
 static void UseWaterProcess(struct Stream* stream, const cc_string* name) {
@@ -304,6 +304,7 @@ static void Sounds_Stop(void) { AudioPool_Close(); }
 
 static void Sounds_Init(void) {
 	int volume = Options_GetInt(OPT_SOUND_VOLUME, 0, 100, DEFAULT_SOUNDS_VOLUME);
+	AudioMixer_Enabled = Options_GetBool(OPT_AUDIO_MIXER, false);
 	Audio_SetSounds(volume);
 	Event_Register_(&UserEvents.BlockChanged, NULL, Audio_PlayBlockSound);
 }
@@ -9,6 +9,7 @@ CC_BEGIN_HEADER
 struct IGameComponent;
 extern struct IGameComponent Audio_Component; 
 struct AudioContext;
+struct Stream;
 
 #ifdef CC_BUILD_WEBAUDIO
 #define DEFAULT_SOUNDS_VOLUME   0
@@ -90,5 +91,21 @@ void Audio_Warn(cc_result res, const char* action);
 cc_result AudioPool_Play(struct AudioData* data);
 void AudioPool_Close(void);
 
+/* Sample rate the software mixer outputs at (output is always stereo) */
+#define AUDIO_MIXER_SAMPLE_RATE 44100
+/* Whether sounds are mixed together in software and then played through a single audio context, */
+/*  instead of each sound being played on one of a limited pool of audio contexts */
+extern cc_bool AudioMixer_Enabled;
+/* Starts mixing in the given sound, which MUST remain valid until it finishes playing */
+cc_result AudioMixer_Play(struct AudioData* data);
+/* Mixes together the next samples of all playing sounds into interleaved stereo samples */
+/* Returns the number of sounds still playing afterwards */
+int AudioMixer_Mix(cc_int16* samples, int frames);
+/* Stops all sounds being mixed */
+void AudioMixer_Clear(void);
+/* Mixes the given number of sample frames, then writes them to the given stream as a .wav file */
+/* NOTE: If dst is NULL, the mixed samples are just discarded */
+cc_result AudioMixer_Render(struct Stream* dst, int frames);
+
 CC_END_HEADER
 #endif
@@ -5,6 +5,8 @@
 #include "Errors.h"
 #include "Utils.h"
 #include "Platform.h"
+#include "Stream.h"
+#include "ExtMath.h"
 
 void Audio_Warn(cc_result res, const char* action) {
 	Logger_Warn(res, action, Audio_DescribeError);
@@ -1820,6 +1822,254 @@ static void AudioBase_FreeChunks(struct AudioChunk* chunks, int numChunks) {
 #endif
 
 
+/*########################################################################################################################*
+*------------------------------------------------------Software mixer-----------------------------------------------------*
+*#########################################################################################################################*/
+cc_bool AudioMixer_Enabled;
+/* WebAudio sounds are just names of sounds, instead of actual samples */
+#if !defined CC_BUILD_NOSOUNDS && !defined CC_BUILD_WEBAUDIO
+#define AUDIO_MIXER_SUPPORTED
+/* Number of sample frames mixed at once (~12 milliseconds) */
+#define MIXER_BLOCK_FRAMES 512
+
+struct MixerVoice {
+	const cc_int16* data;
+	cc_uint32 frames;    /* number of sample frames in data */
+	cc_uint32 pos, frac; /* current sample frame, and fractional part of it in 16.16 fixed point */
+	cc_uint32 step;      /* how far to advance per output frame, in 16.16 fixed point */
+	int channels, gain;  /* gain is in 8.8 fixed point */
+};
+
+static struct MixerVoice* mixer_voices;
+static int mixer_count, mixer_capacity;
+static void* mixer_lock;
+static cc_int32 mixer_accum[MIXER_BLOCK_FRAMES * 2];
+
+static void* mixer_thread;
+static void* mixer_waitable;
+static volatile cc_bool mixer_stopping;
+static struct AudioContext mixer_ctx;
+
+cc_result AudioMixer_Play(struct AudioData* data) {
+	struct MixerVoice* v;
+	cc_uint64 rate;
+	int channels = data->channels;
+
+	if (channels < 1 || channels > 2 || data->sampleRate <= 0 || data->rate <= 0) return ERR_INVALID_ARGUMENT;
+	if (!data->chunk.size) return 0;
+	if (!mixer_lock) mixer_lock = Mutex_Create("Audio mixer");
+	
+	Mutex_Lock(mixer_lock);
+	{
+		if (mixer_count == mixer_capacity) {
+			Utils_Resize((void**)&mixer_voices, &mixer_capacity, 
+						sizeof(struct MixerVoice), 16, 16);
+		}
+		v = &mixer_voices[mixer_count++];
+
+		/* play at higher sample rate to achieve higher speed, same as backends */
+		rate = (cc_uint64)Audio_AdjustSampleRate(data->sampleRate, data->rate);
+		v->data     = (const cc_int16*)data->chunk.data;
+		v->frames   = data->chunk.size / (2 * channels);
+		v->pos      = 0;
+		v->frac     = 0;
+		v->step     = (cc_uint32)((rate << 16) / AUDIO_MIXER_SAMPLE_RATE);
+		v->channels = channels;
+		v->gain     = max(0, data->volume) * 256 / 100;
+	}
+	Mutex_Unlock(mixer_lock);
+
+	if (mixer_waitable) Waitable_Signal(mixer_waitable);
+	return 0;
+}
+
+/* Linearly interpolates between the sample at i and the sample 'next' samples after */
+/*  (frac is reduced to 15 bits so the multiplication can't overflow) */
+#define MixerVoice_Lerp(src, i, next, frac) (src[i] + (((src[(i) + (next)] - src[i]) * (int)((frac) >> 1)) >> 15))
+
+/* Resamples and adds the voice's samples to the given stereo samples */
+/* Returns whether the voice still has samples left to play afterwards */
+static cc_bool MixerVoice_Mix(struct MixerVoice* v, cc_int32* dst, int frames) {
+	const cc_int16* src = v->data;
+	cc_uint32 pos = v->pos, frac = v->frac, step = v->step;
+	cc_uint32 last = v->frames - 1, i;
+	int gain = v->gain, next, l, r;
+
+	for (; frames && pos <= last; frames--, dst += 2) 
+	{
+		/* last sample has nothing to interpolate towards */
+		next = pos < last ? v->channels : 0;
+
+		if (v->channels == 1) {
+			l = MixerVoice_Lerp(src, pos, next, frac);
+			r = l;
+		} else {
+			i = pos * 2;
+			l = MixerVoice_Lerp(src, i,     next, frac);
+			r = MixerVoice_Lerp(src, i + 1, next, frac);
+		}
+
+		dst[0] += (l * gain) >> 8;
+		dst[1] += (r * gain) >> 8;
+
+		frac += step;
+		pos  += frac >> 16;
+		frac &= 0xFFFF;
+	}
+
+	v->pos  = pos;
+	v->frac = frac;
+	return pos <= last;
+}
+
+int AudioMixer_Mix(cc_int16* samples, int frames) {
+	int i, count, total;
+	cc_int32 sample;
+	if (!mixer_lock) mixer_lock = Mutex_Create("Audio mixer");
+
+	Mutex_Lock(mixer_lock);
+	for (; frames > 0; frames -= count) 
+	{
+		count = min(frames, MIXER_BLOCK_FRAMES);
+		total = count * 2;
+		Mem_Set(mixer_accum, 0, total * sizeof(cc_int32));
+
+		for (i = 0; i < mixer_count; ) 
+		{
+			if (MixerVoice_Mix(&mixer_voices[i], mixer_accum, count)) { i++; continue; }
+			/* voice finished playing, so remove it */
+			mixer_voices[i] = mixer_voices[--mixer_count];
+		}
+
+		for (i = 0; i < total; i++) 
+		{
+			sample = mixer_accum[i];
+			Math_Clamp(sample, -32768, 32767);
+			*samples++ = (cc_int16)sample;
+		}
+	}
+	count = mixer_count;
+	Mutex_Unlock(mixer_lock);
+	return count;
+}
+
+void AudioMixer_Clear(void) {
+	if (mixer_lock) Mutex_Lock(mixer_lock);
+	mixer_count = 0;
+	if (mixer_lock) Mutex_Unlock(mixer_lock);
+}
+
+#define MIXER_WAV_HDR_SIZE 44
+#define WAV_FourCC(a, b, c, d) (((cc_uint32)a << 24) | ((cc_uint32)b << 16) | ((cc_uint32)c << 8) | (cc_uint32)d)
+
+static cc_result AudioMixer_WriteWavHeader(struct Stream* s, cc_uint32 dataSize) {
+	cc_uint8 header[MIXER_WAV_HDR_SIZE];
+
+	Stream_SetU32_BE(header +  0, WAV_FourCC('R','I','F','F'));
+	Stream_SetU32_LE(header +  4, dataSize + MIXER_WAV_HDR_SIZE - 8);
+	Stream_SetU32_BE(header +  8, WAV_FourCC('W','A','V','E'));
+	Stream_SetU32_BE(header + 12, WAV_FourCC('f','m','t',' '));
+	Stream_SetU32_LE(header + 16, 16); /* fmt chunk size */
+	Stream_SetU16_LE(header + 20, 1);  /* PCM audio format */
+	Stream_SetU16_LE(header + 22, 2);
+	Stream_SetU32_LE(header + 24, AUDIO_MIXER_SAMPLE_RATE);
+
+	Stream_SetU32_LE(header + 28, AUDIO_MIXER_SAMPLE_RATE * 4); /* byte rate */
+	Stream_SetU16_LE(header + 32, 4);                           /* block align */
+	Stream_SetU16_LE(header + 34, 16);                          /* bits per sample */
+	Stream_SetU32_BE(header + 36, WAV_FourCC('d','a','t','a'));
+	Stream_SetU32_LE(header + 40, dataSize);
+
+	return Stream_Write(s, header, MIXER_WAV_HDR_SIZE);
+}
+
+cc_result AudioMixer_Render(struct Stream* dst, int frames) {
+	cc_int16 samples[MIXER_BLOCK_FRAMES * 2];
+	cc_result res;
+	int count;
+
+	if (dst && (res = AudioMixer_WriteWavHeader(dst, frames * 4))) return res;
+
+	for (; frames > 0; frames -= count) 
+	{
+		count = min(frames, MIXER_BLOCK_FRAMES);
+		AudioMixer_Mix(samples, count);
+		if (!dst) continue;
+
+#ifdef CC_BUILD_BIGENDIAN
+		Utils_SwapEndian16(samples, count * 2);
+#endif
+		if ((res = Stream_Write(dst, (cc_uint8*)samples, count * 4))) return res;
+	}
+	return 0;
+}
+
+/* Mixes sounds on a separate thread, then plays the output through a single audio context */
+static void AudioMixer_RunLoop(void) {
+	struct AudioChunk chunks[AUDIO_MAX_BUFFERS] = { 0 };
+	int inUse, cur = 0;
+	cc_result res;
+
+	res = Audio_Init(&mixer_ctx, AUDIO_MAX_BUFFERS);
+	if (!res) res = Audio_SetFormat(&mixer_ctx, 2, AUDIO_MIXER_SAMPLE_RATE, 100);
+	if (!res) res = Audio_AllocChunks(MIXER_BLOCK_FRAMES * 4, chunks, AUDIO_MAX_BUFFERS);
+	/* volume is applied to each sound when mixing */
+	if (!res) Audio_SetVolume(&mixer_ctx, 100);
+
+	while (!res && !mixer_stopping) {
+		if ((res = Audio_Poll(&mixer_ctx, &inUse))) break;
+
+		/* Nothing left to mix, so let the already queued buffers finish playing, */
+		/*  then wait until another sound is played (instead of queueing silence) */
+		if (!mixer_count) {
+			if (inUse) { Thread_Sleep(2); } else { Waitable_Wait(mixer_waitable); }
+			continue;
+		}
+		if (inUse >= AUDIO_MAX_BUFFERS) { Thread_Sleep(2); continue; }
+
+		AudioMixer_Mix((cc_int16*)chunks[cur].data, MIXER_BLOCK_FRAMES);
+		chunks[cur].size = MIXER_BLOCK_FRAMES * 4;
+
+		if ((res = Audio_QueueChunk(&mixer_ctx, &chunks[cur]))) break;
+		/* audio context stops once it runs out of queued data */
+		if (!inUse && (res = Audio_Play(&mixer_ctx))) break;
+		cur = (cur + 1) % AUDIO_MAX_BUFFERS;
+	}
+
+	if (res) {
+		Audio_Warn(res, "mixing sounds");
+		/* Fallback to playing sounds through the audio context pool */
+		AudioMixer_Enabled = false;
+	}
+	Audio_Close(&mixer_ctx);
+	Audio_FreeChunks(chunks, AUDIO_MAX_BUFFERS);
+}
+
+static void AudioMixer_Start(void) {
+	if (mixer_thread) return;
+	if (!mixer_waitable) mixer_waitable = Waitable_Create("Audio mixer");
+
+	mixer_stopping = false;
+	Thread_Run(&mixer_thread, AudioMixer_RunLoop, 64 * 1024, "Audio mixer");
+}
+
+static void AudioMixer_Stop(void) {
+	if (!mixer_thread) return;
+	mixer_stopping = true;
+	Waitable_Signal(mixer_waitable);
+
+	Thread_Join(mixer_thread);
+	mixer_thread = NULL;
+	AudioMixer_Clear();
+}
+#else
+cc_result AudioMixer_Play(struct AudioData* data) { return ERR_NOT_SUPPORTED; }
+int  AudioMixer_Mix(cc_int16* samples, int frames) { return 0; }
+void AudioMixer_Clear(void) { }
+cc_result AudioMixer_Render(struct Stream* dst, int frames) { return ERR_NOT_SUPPORTED; }
+#endif
+
+
 /*########################################################################################################################*
 *---------------------------------------------------Audio context code----------------------------------------------------*
 *#########################################################################################################################*/
@@ -1843,6 +2093,13 @@ cc_result AudioPool_Play(struct AudioData* data) {
 	int inUse, i;
 	cc_result res;
 
+#ifdef AUDIO_MIXER_SUPPORTED
+	if (AudioMixer_Enabled) {
+		AudioMixer_Start();
+		return AudioMixer_Play(data);
+	}
+#endif
+
 	/* Try to play on a context that doesn't need to be recreated */
 	for (i = 0; i < POOL_MAX_CONTEXTS; i++) {
 		ctx = &context_pool[i];
@@ -1870,6 +2127,9 @@ cc_result AudioPool_Play(struct AudioData* data) {
 
 void AudioPool_Close(void) {
 	int i;
+#ifdef AUDIO_MIXER_SUPPORTED
+	AudioMixer_Stop();
+#endif
 	for (i = 0; i < POOL_MAX_CONTEXTS; i++) {
 		Audio_Close(&context_pool[i]);
 	}
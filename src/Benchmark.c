@@ -0,0 +1,1175 @@
+#include "Core.h"
+#ifdef CC_BUILD_BENCHMARK
+#include "Benchmark.h"
+#include "Audio.h"
+#include "Bitmap.h"
+#include "Block.h"
+#include "BlockPhysics.h"
+#include "Builder.h"
+#include "Deflate.h"
+#include "Entity.h"
+#include "Errors.h"
+#include "Event.h"
+#include "ExtMath.h"
+#include "Formats.h"
+#include "Funcs.h"
+#include "Game.h"
+#include "Generator.h"
+#include "Graphics.h"
+#include "Http.h"
+#include "Lighting.h"
+#include "Logger.h"
+#include "MapRenderer.h"
+#include "Platform.h"
+#include "Stream.h"
+#include "String.h"
+#include "TexturePack.h"
+#include "Utils.h"
+#include "Vorbis.h"
+#include "World.h"
+
+/* Game components that the benchmarked stages depend on (in same order as in Game_Load) */
+static struct IGameComponent* const bench_comps[] = {
+	&World_Component, &Blocks_Component,      &Lighting_Component,
+	&Builder_Component, &MapRenderer_Component, &Formats_Component
+};
+
+static cc_string bench_map, bench_ogg, bench_mixer_wav, bench_http;
+static int bench_width = 256, bench_height = 64, bench_length = 256, bench_seed;
+static int bench_threads = DEFAULT_WORKER_THREADS, bench_runs = 3, bench_voices = 64;
+
+
+/*########################################################################################################################*
+*---------------------------------------------------------Results---------------------------------------------------------*
+*#########################################################################################################################*/
+/* Each stage logs a single line of the form "stage=[name] [key]=[value] [key]=[value] ..." */
+/*  (so that the results can be easily parsed by scripts, e.g. to detect performance regressions) */
+static cc_string result;
+static char resultBuffer[512];
+
+static void Result_Begin(const char* stage) {
+	String_InitArray(result, resultBuffer);
+	String_Format1(&result, "stage=%c", stage);
+}
+
+static void Result_Int(const char* key, int value) {
+	String_Format2(&result, " %c=%i", key, &value);
+}
+
+static void Result_Float(const char* key, float value) {
+	String_Format2(&result, " %c=%f3", key, &value);
+}
+
+static void Result_Hash(const char* key, cc_uint32 value) {
+	String_Format2(&result, " %c=%h", key, &value);
+}
+
+/* Logs the elapsed time, and how many millions of items per second were processed */
+static void Result_Time(cc_uint64 micros, const char* rateKey, float items) {
+	float ms = micros / 1000.0f;
+	Result_Float("ms", ms);
+	Result_Float(rateKey, micros ? items / micros : 0.0f);
+}
+
+static void Result_End(void) {
+	Platform_Log(result.buffer, result.length);
+}
+
+#define Benchmark_Best(best, elapsed, run) if (!(run) || (elapsed) < (best)) best = elapsed;
+
+
+/*########################################################################################################################*
+*----------------------------------------------------------Setup----------------------------------------------------------*
+*#########################################################################################################################*/
+static void OnMapLoaded(void* obj) {
+	int i;
+	for (i = 0; i < Array_Elems(bench_comps); i++)
+	{
+		if (bench_comps[i]->OnNewMapLoaded) bench_comps[i]->OnNewMapLoaded();
+	}
+}
+
+static void OnWarning(const cc_string* msg) {
+	Platform_Log(msg->buffer, msg->length);
+}
+
+/* Chunk mesh building requires a terrain atlas, so use a blank one the same size as default.zip's */
+static void LoadBlankAtlas(void) {
+	struct Bitmap bmp;
+	Bitmap_Allocate(&bmp, 256, 256);
+	Mem_Set(bmp.scan0, 0xFF, Bitmap_DataSize(256, 256));
+	Atlas_TryChange(&bmp);
+}
+
+static void Init(void) {
+	int i;
+	Logger_WarnFunc = OnWarning;
+	WorkerPool_Init(bench_threads);
+	Gfx_Create();
+
+	Event_Register_(&WorldEvents.MapLoaded, NULL, OnMapLoaded);
+	for (i = 0; i < Array_Elems(bench_comps); i++)
+	{
+		if (bench_comps[i]->Init) bench_comps[i]->Init();
+	}
+	LoadBlankAtlas();
+}
+
+static cc_bool ParseIntArg(const cc_string* value, int* dst, int min, int max) {
+	int v;
+	if (!Convert_ParseInt(value, &v) || v < min || v > max) return false;
+
+	*dst = v;
+	return true;
+}
+
+/* Arguments are of the form "[key]=[value]", e.g. "map=maps/test.cw" or "width=512" */
+static cc_bool ParseArgs(int argc, char** argv) {
+	cc_string arg, key, value;
+	cc_bool valid;
+	int i;
+
+	for (i = 1; i < argc; i++)
+	{
+		arg = String_FromReadonly(argv[i]);
+		if (!String_UNSAFE_Separate(&arg, '=', &key, &value)) return false;
+
+		if (String_CaselessEqualsConst(&key, "map")) {
+			bench_map = value; valid = value.length > 0;
+		} else if (String_CaselessEqualsConst(&key, "ogg")) {
+			bench_ogg = value; valid = value.length > 0;
+		} else if (String_CaselessEqualsConst(&key, "mixer_wav")) {
+			bench_mixer_wav = value; valid = value.length > 0;
+		} else if (String_CaselessEqualsConst(&key, "http")) {
+			bench_http = value; valid = value.length > 0;
+		} else if (String_CaselessEqualsConst(&key, "voices")) {
+			valid = ParseIntArg(&value, &bench_voices,  1, 4096);
+		} else if (String_CaselessEqualsConst(&key, "width")) {
+			valid = ParseIntArg(&value, &bench_width,   1, 8192);
+		} else if (String_CaselessEqualsConst(&key, "height")) {
+			valid = ParseIntArg(&value, &bench_height,  1, 8192);
+		} else if (String_CaselessEqualsConst(&key, "length")) {
+			valid = ParseIntArg(&value, &bench_length,  1, 8192);
+		} else if (String_CaselessEqualsConst(&key, "seed")) {
+			valid = Convert_ParseInt(&value, &bench_seed);
+		} else if (String_CaselessEqualsConst(&key, "threads")) {
+			valid = ParseIntArg(&value, &bench_threads, 0, WORKERPOOL_MAX_THREADS);
+		} else if (String_CaselessEqualsConst(&key, "runs")) {
+			valid = ParseIntArg(&value, &bench_runs,    1, 1000);
+		} else {
+			valid = false;
+		}
+		if (!valid) return false;
+	}
+	return true;
+}
+
+
+/*########################################################################################################################*
+*-------------------------------------------------------Map stages--------------------------------------------------------*
+*#########################################################################################################################*/
+/* Generates a map into the given blocks array, returning false if out of memory */
+static cc_bool GenerateMap(BlockRaw* blocks, cc_uint64* elapsed) {
+	cc_uint64 beg, end;
+	Gen_Blocks = blocks;
+	Gen_Seed   = bench_seed;
+	Gen_Active = &NotchyGen;
+	if (!Gen_Active->Prepare()) return false;
+
+	beg = Stopwatch_Measure();
+	Gen_Active->Generate();
+	end = Stopwatch_Measure();
+
+	*elapsed = Stopwatch_ElapsedMicroseconds(beg, end);
+	return true;
+}
+
+/* Regenerates the map without using worker threads, to check that dividing */
+/*  generator stages between worker threads still produces exactly the same map */
+static cc_uint32 GenerateSerialHash(void) {
+	BlockRaw* blocks = (BlockRaw*)Mem_TryAlloc(World.Volume, 1);
+	cc_uint64 elapsed;
+	cc_uint32 hash = 0;
+	if (!blocks) return 0;
+
+	WorkerPool_Free();
+	if (GenerateMap(blocks, &elapsed)) hash = Utils_CRC32(blocks, World.Volume);
+	WorkerPool_Init(bench_threads);
+
+	Mem_Free(blocks);
+	return hash;
+}
+
+/* CRC32 of maps generated by the original single threaded generator, for some fixed seeds and map sizes */
+/*  (so that changes which alter generated maps are detected, even when threaded and serial output agree) */
+static const struct PinnedMap { int width, height, length, seed; cc_uint32 hash; } pinned_maps[] = {
+	{ 256,  64, 256,     0, 0x398EAF56UL },
+	{ 128,  64, 128, 12345, 0xEC52955EUL },
+	{  64, 128,  96,    -7, 0x61A90D95UL },
+	{ 512,  64, 512,     1, 0xF7CED426UL },
+};
+
+/* Generates each of the pinned maps, returning false if any differ from their expected hash */
+static cc_bool CheckPinnedMaps(void) {
+	const struct PinnedMap* map;
+	BlockRaw* blocks;
+	cc_uint64 elapsed;
+	cc_uint32 hash;
+	cc_bool matches = true;
+	int i, seed = bench_seed;
+
+	for (i = 0; i < Array_Elems(pinned_maps); i++)
+	{
+		map = &pinned_maps[i];
+		World_SetDimensions(map->width, map->height, map->length);
+		blocks = (BlockRaw*)Mem_TryAlloc(World.Volume, 1);
+
+		bench_seed = map->seed;
+		hash = blocks && GenerateMap(blocks, &elapsed) ? Utils_CRC32(blocks, World.Volume) : 0;
+		Mem_Free(blocks);
+		if (hash == map->hash) continue;
+
+		Platform_Log4("Generated %ix%ix%i map differs from the expected map for seed %i",
+			&map->width, &map->height, &map->length, &map->seed);
+		matches = false;
+	}
+
+	bench_seed = seed;
+	Gen_Blocks = NULL;
+	return matches;
+}
+
+static cc_result Benchmark_Generate(void) {
+	BlockRaw* blocks;
+	cc_uint64 elapsed;
+	cc_uint32 hash, serialHash;
+	cc_bool pinnedMatch = CheckPinnedMaps();
+
+	World_SetDimensions(bench_width, bench_height, bench_length);
+	blocks = (BlockRaw*)Mem_TryAlloc(World.Volume, 1);
+	if (!blocks || !GenerateMap(blocks, &elapsed)) { Mem_Free(blocks); return ERR_OUT_OF_MEMORY; }
+
+	hash       = Utils_CRC32(blocks, World.Volume);
+	serialHash = WorkerPool_Threads() > 1 ? GenerateSerialHash() : hash;
+	World_SetNewMap(blocks, bench_width, bench_height, bench_length);
+	Gen_Blocks = NULL;
+
+	Result_Begin("generate");
+	Result_Int("width",  World.Width);
+	Result_Int("height", World.Height);
+	Result_Int("length", World.Length);
+	Result_Time(elapsed, "mblocks_per_sec", (float)World.Volume);
+	Result_Hash("hash",        hash);
+	Result_Hash("serial_hash", serialHash);
+	Result_Int("pinned_matches", pinnedMatch);
+	Result_End();
+
+	if (hash != serialHash) {
+		Platform_LogConst("Generated map differs from map generated without worker threads");
+		return ERR_INVALID_ARGUMENT;
+	}
+	return pinnedMatch ? 0 : ERR_INVALID_ARGUMENT;
+}
+
+/* Measures calculating the heightmap noise of a map, and checks that batched noise */
+/*  produces exactly the same output as calculating noise one sample at a time */
+static void Benchmark_Noise(void) {
+	cc_uint64 beg, elapsed, scalar = 0, batched = 0;
+	float *xs, *zs, *ref, *cur;
+	int i, x, z, run, count, matches;
+
+	count = bench_width * bench_length;
+	xs  = (float*)Mem_TryAlloc(count, sizeof(float));
+	zs  = (float*)Mem_TryAlloc(count, sizeof(float));
+	ref = (float*)Mem_TryAlloc(count, sizeof(float));
+	cur = (float*)Mem_TryAlloc(count, sizeof(float));
+	if (!xs || !zs || !ref || !cur) { Platform_LogConst("Out of memory for noise"); goto cleanup; }
+
+	/* Same sample coordinates as NotchyGen_CreateHeightmap */
+	for (i = 0, z = 0; z < bench_length; z++)
+		for (x = 0; x < bench_width; x++, i++)
+	{
+		xs[i] = x * 1.3f; zs[i] = z * 1.3f;
+	}
+
+	for (run = 0; run < bench_runs; run++)
+	{
+		beg = Stopwatch_Measure();
+		Gen_CalcNoise(bench_seed, xs, zs, ref, count, false);
+		elapsed = Stopwatch_ElapsedMicroseconds(beg, Stopwatch_Measure());
+		Benchmark_Best(scalar, elapsed, run);
+
+		beg = Stopwatch_Measure();
+		Gen_CalcNoise(bench_seed, xs, zs, cur, count, true);
+		elapsed = Stopwatch_ElapsedMicroseconds(beg, Stopwatch_Measure());
+		Benchmark_Best(batched, elapsed, run);
+	}
+	matches = Mem_Equal(ref, cur, count * sizeof(float));
+
+	Result_Begin("noise");
+	Result_Int("samples", count);
+	Result_Int("matches", matches);
+	Result_Float("scalar_ms", scalar / 1000.0f);
+	Result_Time(batched, "msamples_per_sec", (float)count);
+	Result_End();
+
+cleanup:
+	Mem_Free(xs);  Mem_Free(zs);
+	Mem_Free(ref); Mem_Free(cur);
+}
+
+static cc_result Benchmark_Load(void) {
+	struct LocationUpdate spawn = { 0 };
+	struct Stream stream;
+	cc_uint32 size = 0;
+	cc_uint64 beg, end, elapsed;
+	cc_result res;
+
+	res = Stream_OpenMappedFile(&stream, &bench_map);
+	if (res) { Logger_SysWarn2(res, "opening", &bench_map); return res; }
+	(void)stream.Length(&stream, &size);
+
+	beg = Stopwatch_Measure();
+	res = Map_Import(&bench_map, &stream, &spawn);
+	end = Stopwatch_Measure();
+
+	/* No point logging error for closing readonly file */
+	(void)stream.Close(&stream);
+	if (res) { Logger_SysWarn2(res, "decoding", &bench_map); return res; }
+	World_SetNewMap(World.Blocks, World.Width, World.Height, World.Length);
+
+	/* Map loading is mostly decompressing the blocks, so measure throughput both ways */
+	elapsed = Stopwatch_ElapsedMicroseconds(beg, end);
+	Result_Begin("load");
+	Result_Int("width",  World.Width);
+	Result_Int("height", World.Height);
+	Result_Int("length", World.Length);
+	Result_Int("file_bytes", size);
+	Result_Time(elapsed, "input_mb_per_sec", (float)size);
+	Result_Float("output_mb_per_sec", elapsed ? (float)World.Volume / elapsed : 0.0f);
+	Result_End();
+	return 0;
+}
+
+/* Decompresses all the data in the given gzip compressed stream into dst */
+/* NOTE: Only time spent decompressing is measured (i.e. not parsing the gzip header) */
+static cc_result InflateMap(struct Stream* src, struct InflateState* state, cc_uint8* dst, cc_uint32 size, cc_uint64* elapsed) {
+	struct GZipHeader gzHeader;
+	struct Stream compStream;
+	cc_uint32 total = 0, read;
+	cc_uint64 beg;
+	cc_result res;
+
+	if ((res = src->Seek(src, 0))) return res;
+	GZipHeader_Init(&gzHeader);
+	while (!gzHeader.done) {
+		if ((res = GZipHeader_Read(src, &gzHeader))) return res;
+	}
+	Inflate_MakeStream2(&compStream, state, src);
+
+	beg = Stopwatch_Measure();
+	while (total < size) 
+	{
+		if ((res = compStream.Read(&compStream, dst + total, size - total, &read))) break;
+		if (!read) { res = ERR_END_OF_STREAM; break; }
+		total += read;
+	}
+	*elapsed = Stopwatch_ElapsedMicroseconds(beg, Stopwatch_Measure());
+	return res;
+}
+
+/* Measures decompressing the given gzip compressed map file, and checks that the lookup tables fast path */
+/*  produces exactly the same output as the previous fast path (which decoded one huffman code at a time) */
+static void Benchmark_Inflate(void) {
+	cc_uint8* ref = NULL;
+	cc_uint8* cur = NULL;
+	struct InflateState* state;
+	struct Stream stream;
+	cc_uint32 length, size;
+	cc_uint64 elapsed, refBest = 0, best = 0;
+	cc_result res;
+	int run;
+
+	res = Stream_OpenMappedFile(&stream, &bench_map);
+	if (res) { Logger_SysWarn2(res, "opening", &bench_map); return; }
+
+	state = (struct InflateState*)Mem_TryAlloc(1, sizeof(struct InflateState));
+	if (!state) { res = ERR_OUT_OF_MEMORY; goto cleanup; }
+
+	/* Last 4 bytes of a gzip file are the size of the uncompressed data */
+	if ((res = stream.Length(&stream, &length)))          goto cleanup;
+	if (length < 4) { res = ERR_END_OF_STREAM;              goto cleanup; }
+	if ((res = stream.Seek(&stream, length - 4)))         goto cleanup;
+	if ((res = Stream_ReadU32_LE(&stream, &size)))        goto cleanup;
+
+	ref = (cc_uint8*)Mem_TryAlloc(size, 1);
+	cur = (cc_uint8*)Mem_TryAlloc(size, 1);
+	if (!ref || !cur) { res = ERR_OUT_OF_MEMORY; goto cleanup; }
+
+	for (run = 0; run < bench_runs; run++)
+	{
+		Inflate_ReferenceFast = true;
+		res = InflateMap(&stream, state, ref, size, &elapsed);
+		Inflate_ReferenceFast = false;
+		if (res) goto cleanup;
+		Benchmark_Best(refBest, elapsed, run);
+
+		if ((res = InflateMap(&stream, state, cur, size, &elapsed))) goto cleanup;
+		Benchmark_Best(best, elapsed, run);
+	}
+
+	Result_Begin("inflate");
+	Result_Int("file_bytes",   length);
+	Result_Int("output_bytes", size);
+	Result_Int("matches",      Mem_Equal(ref, cur, size));
+	Result_Float("reference_ms", refBest / 1000.0f);
+	Result_Float("reference_mb_per_sec", refBest ? (float)size / refBest : 0.0f);
+	Result_Time(best, "mb_per_sec", (float)size);
+	Result_End();
+
+cleanup:
+	if (res) Logger_SysWarn2(res, "inflating", &bench_map);
+	/* No point logging error for closing readonly file */
+	(void)stream.Close(&stream);
+	Mem_Free(state);
+	Mem_Free(ref); Mem_Free(cur);
+}
+
+
+/*########################################################################################################################*
+*-----------------------------------------------------Lighting stages-----------------------------------------------------*
+*#########################################################################################################################*/
+static void Benchmark_ClassicLighting(void) {
+	cc_uint64 beg, elapsed, best = 0;
+	int run, x, z;
+
+	for (run = 0; run < bench_runs; run++)
+	{
+		ClassicLighting_Refresh();
+		beg = Stopwatch_Measure();
+
+		/* Same as how the chunk builder requests the light of each chunk */
+		for (z = 0; z < World.Length; z += CHUNK_SIZE)
+			for (x = 0; x < World.Width; x += CHUNK_SIZE)
+		{
+			ClassicLighting_LightHint(x - 1, -1, z - 1);
+		}
+
+		elapsed = Stopwatch_ElapsedMicroseconds(beg, Stopwatch_Measure());
+		Benchmark_Best(best, elapsed, run);
+	}
+
+	Result_Begin("lighting_classic");
+	Result_Int("columns", World.Width * World.Length);
+	Result_Time(best, "mcells_per_sec", (float)World.Volume);
+	Result_End();
+}
+
+/* Fancy lighting is lazily calculated per chunk when a light colour in it is first requested */
+static void Benchmark_FancyLighting(void) {
+	cc_uint64 beg, elapsed, best = 0;
+	int run, x, y, z;
+
+	for (run = 0; run < bench_runs; run++)
+	{
+		Lighting.Refresh();
+		beg = Stopwatch_Measure();
+
+		for (y = 0; y < World.Height; y += CHUNK_SIZE)
+			for (z = 0; z < World.Length; z += CHUNK_SIZE)
+				for (x = 0; x < World.Width; x += CHUNK_SIZE)
+		{
+			Lighting.Color(x, y, z);
+		}
+
+		elapsed = Stopwatch_ElapsedMicroseconds(beg, Stopwatch_Measure());
+		Benchmark_Best(best, elapsed, run);
+	}
+
+	Result_Begin("lighting_fancy");
+	Result_Int("chunks", World.ChunksCount);
+	Result_Time(best, "mcells_per_sec", (float)World.Volume);
+	Result_End();
+}
+
+
+/*########################################################################################################################*
+*---------------------------------------------------Mesh building stages--------------------------------------------------*
+*#########################################################################################################################*/
+/* Chunks are built in batches, similar to how MapRenderer builds chunks when worker threads are used */
+#define BENCH_BATCH_SIZE 1024
+static struct ChunkInfo bench_chunks[BENCH_BATCH_SIZE];
+
+static void ResetChunk(struct ChunkInfo* info, int index) {
+	int cx = index % World.ChunksX;
+	int cy = (index / World.ChunksX) % World.ChunksY;
+	int cz = index / (World.ChunksX * World.ChunksY);
+
+	Mem_Set(info, 0, sizeof(struct ChunkInfo));
+	info->centreX = (cx << CHUNK_SHIFT) + HALF_CHUNK_SIZE;
+	info->centreY = (cy << CHUNK_SHIFT) + HALF_CHUNK_SIZE;
+	info->centreZ = (cz << CHUNK_SHIFT) + HALF_CHUNK_SIZE;
+	info->visible = true;
+	info->noData  = true;
+}
+
+static int CountVertices(struct ChunkPartInfo* part) {
+	int i, j, count = 0;
+	if (!part) return 0;
+
+	for (i = 0; i < MapRenderer_1DUsedCount; i++, part += World.ChunksCount)
+	{
+		if (part->offset < 0) continue;
+		count += part->spriteCount;
+		for (j = 0; j < FACE_COUNT; j++) count += part->counts[j];
+	}
+	return count;
+}
+
+static void Benchmark_Mesh(const char* stage) {
+	struct ChunkInfo* infos[BENCH_BATCH_SIZE];
+	struct ChunkInfo* info;
+	cc_uint64 beg, elapsed, best = 0;
+	int run, i, j, count, vertices = 0, meshes = 0;
+
+	for (run = 0; run < bench_runs; run++)
+	{
+		elapsed  = 0;
+		vertices = 0;
+		meshes   = 0;
+
+		for (i = 0; i < World.ChunksCount; i += count)
+		{
+			count = min(World.ChunksCount - i, BENCH_BATCH_SIZE);
+			for (j = 0; j < count; j++)
+			{
+				infos[j] = &bench_chunks[j];
+				ResetChunk(infos[j], i + j);
+			}
+
+			beg = Stopwatch_Measure();
+			Builder_MakeChunks(infos, count);
+			elapsed += Stopwatch_ElapsedMicroseconds(beg, Stopwatch_Measure());
+
+			for (j = 0; j < count; j++)
+			{
+				info = infos[j];
+				if (info->vb) meshes++;
+
+				vertices += CountVertices(info->normalParts);
+				vertices += CountVertices(info->translucentParts);
+				Gfx_DeleteVb(&info->vb);
+			}
+		}
+		Benchmark_Best(best, elapsed, run);
+	}
+
+	Result_Begin(stage);
+	Result_Int("chunks",   World.ChunksCount);
+	Result_Int("meshes",   meshes);
+	Result_Int("vertices", vertices);
+	Result_Time(best, "mverts_per_sec", (float)vertices);
+	Result_Float("ms_per_chunk", best / 1000.0f / World.ChunksCount);
+	Result_End();
+}
+
+
+/*########################################################################################################################*
+*-----------------------------------------------------Storage stages------------------------------------------------------*
+*#########################################################################################################################*/
+#define BENCH_RANDOM_READS (4 * 1024 * 1024)
+#define BENCH_SPARSE_WIDTH  2048
+#define BENCH_SPARSE_HEIGHT 256
+#define BENCH_SPARSE_LENGTH 2048
+
+/* Reads directly from the flat arrays, as World_GetBlock reads from World_Store in CC_BUILD_BLOCKSTORE builds */
+#ifdef EXTENDED_BLOCKS
+#define FlatBlock(i) ((World.Blocks[i] | (World.Blocks2[i] << 8)) & World.IDMask)
+#else
+#define FlatBlock(i) World.Blocks[i]
+#endif
+
+static cc_uint32 ReadFlatSequential(void) {
+	cc_uint32 sum = 0;
+	int x, y, z;
+
+	for (y = 0; y < World.Height; y++)
+		for (z = 0; z < World.Length; z++)
+			for (x = 0; x < World.Width; x++)
+	{
+		sum += FlatBlock(World_Pack(x, y, z));
+	}
+	return sum;
+}
+
+static cc_uint32 ReadStoreSequential(const struct BlockStore* store) {
+	cc_uint32 sum = 0;
+	int x, y, z;
+
+	for (y = 0; y < World.Height; y++)
+		for (z = 0; z < World.Length; z++)
+			for (x = 0; x < World.Width; x++)
+	{
+		sum += BlockStore_Get(store, World_Pack(x, y, z));
+	}
+	return sum;
+}
+
+static cc_uint32 ReadFlatRandom(void) {
+	cc_uint32 sum = 0;
+	RNGState rnd;
+	int i, x, y, z;
+
+	Random_Seed(&rnd, bench_seed);
+	for (i = 0; i < BENCH_RANDOM_READS; i++)
+	{
+		x = Random_Next(&rnd, World.Width); y = Random_Next(&rnd, World.Height); z = Random_Next(&rnd, World.Length);
+		sum += FlatBlock(World_Pack(x, y, z));
+	}
+	return sum;
+}
+
+static cc_uint32 ReadStoreRandom(const struct BlockStore* store) {
+	cc_uint32 sum = 0;
+	RNGState rnd;
+	int i, x, y, z;
+
+	Random_Seed(&rnd, bench_seed);
+	for (i = 0; i < BENCH_RANDOM_READS; i++)
+	{
+		x = Random_Next(&rnd, World.Width); y = Random_Next(&rnd, World.Height); z = Random_Next(&rnd, World.Length);
+		sum += BlockStore_Get(store, World_Pack(x, y, z));
+	}
+	return sum;
+}
+
+#define Benchmark_Reads(elapsed, sum, read) beg = Stopwatch_Measure(); sum = read; elapsed = Stopwatch_ElapsedMicroseconds(beg, Stopwatch_Measure());
+
+/* Compares reading blocks from the flat World.Blocks array with reading them from a BlockStore */
+/*  (i.e. what World_GetBlock reads from in CC_BUILD_BLOCKSTORE builds) */
+static void Benchmark_BlockStore(void) {
+	struct BlockStore store;
+	cc_uint64 beg, compress, flatSeq, storeSeq, flatRnd, storeRnd;
+	cc_uint32 flatSum, storeSum, i;
+	cc_bool matches;
+
+	beg = Stopwatch_Measure();
+	if (BlockStore_FromWorld(&store)) { Platform_LogConst("Out of memory for block store"); return; }
+	compress = Stopwatch_ElapsedMicroseconds(beg, Stopwatch_Measure());
+
+	Benchmark_Reads(flatSeq,  flatSum,  ReadFlatSequential());
+	Benchmark_Reads(storeSeq, storeSum, ReadStoreSequential(&store));
+	matches = flatSum == storeSum;
+#ifdef CC_BUILD_BLOCKSTORE
+	matches &= ReadStoreSequential(&World_Store) == flatSum;
+#endif
+	Benchmark_Reads(flatRnd,  flatSum,  ReadFlatRandom());
+	Benchmark_Reads(storeRnd, storeSum, ReadStoreRandom(&store));
+	matches &= flatSum == storeSum;
+
+	Result_Begin("blockstore");
+	Result_Int("matches", matches);
+	Result_Float("flat_mb",  World.Volume / (1024.0f * 1024.0f));
+	Result_Float("store_mb", BlockStore_MemoryUsed(&store) / (1024.0f * 1024.0f));
+	Result_Float("compress_ms", compress / 1000.0f);
+	Result_Float("seq_flat_ms",     flatSeq  / 1000.0f);
+	Result_Float("seq_store_ms",    storeSeq / 1000.0f);
+	Result_Float("random_flat_ms",  flatRnd  / 1000.0f);
+	Result_Float("random_store_ms", storeRnd / 1000.0f);
+	Result_End();
+	BlockStore_Free(&store);
+
+	/* Mostly empty worlds are where the store is most useful, e.g. a large flat world */
+	if (BlockStore_Init(&store, (cc_uint32)BENCH_SPARSE_WIDTH * BENCH_SPARSE_HEIGHT * BENCH_SPARSE_LENGTH)) {
+		Platform_LogConst("Out of memory for block store"); return;
+	}
+	/* Bottom layer is the first width * length blocks */
+	for (i = 0; i < BENCH_SPARSE_WIDTH * BENCH_SPARSE_LENGTH; i++)
+	{
+		BlockStore_Set(&store, i, BLOCK_BEDROCK);
+	}
+
+	Result_Begin("blockstore_sparse");
+	Result_Int("width",  BENCH_SPARSE_WIDTH);
+	Result_Int("height", BENCH_SPARSE_HEIGHT);
+	Result_Int("length", BENCH_SPARSE_LENGTH);
+	Result_Float("flat_mb",  store.volume / (1024.0f * 1024.0f));
+	Result_Float("store_mb", BlockStore_MemoryUsed(&store) / (1024.0f * 1024.0f));
+	Result_End();
+	BlockStore_Free(&store);
+}
+
+
+/*########################################################################################################################*
+*-----------------------------------------------------Physics stages------------------------------------------------------*
+*#########################################################################################################################*/
+/* Random ticks are picked per chunk regardless of what is in the world, so run them on the original world */
+#define BENCH_RANDOM_TICKS 100
+static void Benchmark_RandomTicks(void) {
+	cc_uint64 beg, elapsed, best = 0;
+	int run, tick;
+
+	for (run = 0; run < bench_runs; run++)
+	{
+		beg = Stopwatch_Measure();
+		for (tick = 0; tick < BENCH_RANDOM_TICKS; tick++) Physics_Tick();
+
+		elapsed = Stopwatch_ElapsedMicroseconds(beg, Stopwatch_Measure());
+		Benchmark_Best(best, elapsed, run);
+	}
+
+	Result_Begin("physics_random");
+	Result_Int("ticks", BENCH_RANDOM_TICKS);
+	Result_Time(best, "mticks_per_sec", (float)World.ChunksCount * 3 * BENCH_RANDOM_TICKS);
+	Result_Float("ms_per_tick", best / 1000.0f / BENCH_RANDOM_TICKS);
+	Result_End();
+}
+
+/* Replaces the world with an ocean held back by a wall along the middle of the map */
+static void ResetOcean(void) {
+	int x, y, z, wallX = World.Width / 2;
+	BlockID block;
+
+	for (y = 0; y < World.Height; y++)
+		for (z = 0; z < World.Length; z++)
+			for (x = 0; x < World.Width; x++)
+	{
+		if (y == 0) {
+			block = BLOCK_BEDROCK;
+		} else if (y >= World.Height / 2) {
+			block = BLOCK_AIR;
+		} else if (x == wallX) {
+			block = BLOCK_STONE;
+		} else {
+			block = x < wallX ? BLOCK_STILL_WATER : BLOCK_AIR;
+		}
+		World.Blocks[World_Pack(x, y, z)] = (BlockRaw)block;
+	}
+	World_SetNewMap(World.Blocks, World.Width, World.Height, World.Length);
+}
+
+static int CountWater(void) {
+	int i, count = 0;
+	for (i = 0; i < World.Volume; i++)
+	{
+		count += World.Blocks[i] == BLOCK_WATER || World.Blocks[i] == BLOCK_STILL_WATER;
+	}
+	return count;
+}
+
+/* Measures liquid physics by removing the wall, then letting the ocean flood the rest of the map */
+/* NOTE: This overwrites the world, so must be the last stage */
+static void Benchmark_Flood(void) {
+	cc_uint64 beg, elapsed, best = 0;
+	int run, tick, ticks, y, z, before, flooded = 0;
+	int wallX = World.Width / 2;
+
+	/* Water spreads one block every 6 ticks, so this is enough for it to reach the other side */
+	ticks = (World.Width - wallX) * 6 + 10;
+
+	for (run = 0; run < bench_runs; run++)
+	{
+		ResetOcean();
+		before = CountWater();
+		beg    = Stopwatch_Measure();
+
+		for (y = 1; y < World.Height / 2; y++)
+			for (z = 0; z < World.Length; z++)
+		{
+			Game_UpdateBlock(wallX, y, z, BLOCK_AIR);
+			Physics_OnBlockChanged(wallX, y, z, BLOCK_STONE, BLOCK_AIR);
+		}
+		for (tick = 0; tick < ticks; tick++) Physics_Tick();
+
+		elapsed = Stopwatch_ElapsedMicroseconds(beg, Stopwatch_Measure());
+		Benchmark_Best(best, elapsed, run);
+		flooded = CountWater() - before;
+	}
+
+	Result_Begin("physics_flood");
+	Result_Int("ticks",   ticks);
+	Result_Int("flooded", flooded);
+	Result_Time(best, "mupdates_per_sec", (float)flooded);
+	Result_End();
+}
+
+
+/*########################################################################################################################*
+*-------------------------------------------------------Audio stages------------------------------------------------------*
+*#########################################################################################################################*/
+struct OggDecodeResult { int frames, samples; cc_uint32 crc; cc_uint64 elapsed; };
+
+/* Decodes every frame in the given ogg vorbis file, calculating a CRC32 of the PCM output */
+/* NOTE: Only time spent decoding is measured (i.e. not calculating the CRC32) */
+static cc_result DecodeOgg(struct Stream* src, struct OggDecodeResult* r, struct VorbisState* ctx, struct OggState* ogg) {
+	cc_int16* samples = NULL;
+	cc_uint8* data;
+	cc_uint64 beg;
+	cc_result res;
+	int i, count = 0;
+
+	r->frames = 0; r->samples = 0; r->elapsed = 0;
+	r->crc    = 0xFFFFFFFFUL;
+	if ((res = src->Seek(src, 0))) return res;
+
+	Ogg_Init(ogg, src);
+	Vorbis_Init(ctx);
+	ctx->source = ogg;
+
+	beg = Stopwatch_Measure();
+	res = Vorbis_DecodeHeaders(ctx);
+	r->elapsed += Stopwatch_ElapsedMicroseconds(beg, Stopwatch_Measure());
+	if (res) goto cleanup;
+
+	samples = (cc_int16*)Mem_TryAlloc(ctx->blockSizes[1] * ctx->channels, 2);
+	if (!samples) { res = ERR_OUT_OF_MEMORY; goto cleanup; }
+
+	for (;;) 
+	{
+		beg = Stopwatch_Measure();
+		res = Vorbis_DecodeFrame(ctx);
+		if (!res) count = Vorbis_OutputFrame(ctx, samples);
+		r->elapsed += Stopwatch_ElapsedMicroseconds(beg, Stopwatch_Measure());
+
+		/* reached end of samples, so done */
+		if (res == ERR_END_OF_STREAM) { res = 0; break; }
+		if (res) break;
+
+		r->frames++;
+		r->samples += count;
+		data = (cc_uint8*)samples;
+
+		for (i = 0; i < count * 2; i++) 
+		{
+			r->crc = Utils_Crc32Table[(r->crc ^ data[i]) & 0xFF] ^ (r->crc >> 8);
+		}
+	}
+
+cleanup:
+	Mem_Free(samples);
+	Vorbis_Free(ctx);
+	return res;
+}
+
+#define OggResults_Match(a, b) ((a).crc == (b).crc && (a).samples == (b).samples)
+
+/* Measures decoding an ogg vorbis file, and checks that the huffman decoding lookup tables and SIMD paths */
+/*  produce exactly the same PCM output as decoding one bit at a time with scalar math (i.e. the original decoder) */
+static void Benchmark_Vorbis(void) {
+	struct OggDecodeResult cur, ref, scalar;
+	struct VorbisState* ctx;
+	struct OggState* ogg;
+	struct Stream stream;
+	cc_uint64 best = 0;
+	float seconds;
+	cc_result res;
+	int run;
+
+	res = Stream_OpenMappedFile(&stream, &bench_ogg);
+	if (res) { Logger_SysWarn2(res, "opening", &bench_ogg); return; }
+
+	ogg = (struct OggState*)Mem_TryAlloc(1,    sizeof(struct OggState));
+	ctx = (struct VorbisState*)Mem_TryAlloc(1, sizeof(struct VorbisState));
+	if (!ogg || !ctx) { res = ERR_OUT_OF_MEMORY; goto cleanup; }
+
+	Vorbis_ReferenceHuffman = true;
+	Vorbis_ReferenceScalar  = true;
+	res = DecodeOgg(&stream, &ref, ctx, ogg);
+	Vorbis_ReferenceHuffman = false;
+	if (res) goto cleanup;
+
+	res = DecodeOgg(&stream, &scalar, ctx, ogg);
+	Vorbis_ReferenceScalar  = false;
+	if (res) goto cleanup;
+
+	for (run = 0; run < bench_runs; run++)
+	{
+		if ((res = DecodeOgg(&stream, &cur, ctx, ogg))) goto cleanup;
+		Benchmark_Best(best, cur.elapsed, run);
+	}
+	seconds = (float)cur.samples / (ctx->channels * ctx->sampleRate);
+
+	Result_Begin("vorbis");
+	Result_Int("channels",    ctx->channels);
+	Result_Int("sample_rate", ctx->sampleRate);
+	Result_Int("frames",      cur.frames);
+	Result_Int("matches",     OggResults_Match(cur, ref) && OggResults_Match(scalar, ref));
+	Result_Float("reference_ms", ref.elapsed    / 1000.0f);
+	Result_Float("scalar_ms",    scalar.elapsed / 1000.0f);
+	Result_Float("ms",           best / 1000.0f);
+	Result_Float("frames_per_sec", best ? cur.frames * 1000000.0f / best : 0.0f);
+	Result_Float("realtime",       best ? seconds    * 1000000.0f / best : 0.0f);
+	Result_End();
+
+cleanup:
+	if (res) Logger_SysWarn2(res, "decoding", &bench_ogg);
+	/* No point logging error for closing readonly file */
+	(void)stream.Close(&stream);
+	Mem_Free(ctx);
+	Mem_Free(ogg);
+}
+
+#ifndef CC_BUILD_NOSOUNDS
+#define MIXER_BENCH_SOUNDS 8
+/* How long each generated sound is (2 seconds) */
+#define MIXER_BENCH_FRAMES (AUDIO_MIXER_SAMPLE_RATE * 2)
+static struct AudioData mixer_sounds[MIXER_BENCH_SOUNDS];
+
+/* Generates a mix of mono/stereo and 44100/22050 hz sounds (noisy tones) */
+static cc_bool GenerateSounds(RNGState* rnd) {
+	struct AudioData* snd;
+	cc_int16* data;
+	int i, j, frames, samples;
+	float freq;
+
+	for (i = 0; i < MIXER_BENCH_SOUNDS; i++)
+	{
+		snd = &mixer_sounds[i];
+		snd->channels   = i == 0 ? 2 : 1;
+		snd->sampleRate = (i & 1) ? AUDIO_MIXER_SAMPLE_RATE / 2 : AUDIO_MIXER_SAMPLE_RATE;
+
+		frames  = MIXER_BENCH_FRAMES * snd->sampleRate / AUDIO_MIXER_SAMPLE_RATE;
+		samples = frames * snd->channels;
+		data    = (cc_int16*)Mem_TryAlloc(samples, 2);
+		if (!data) return false;
+
+		freq = (2.0f * MATH_PI) * (220.0f + i * 110.0f) / snd->sampleRate;
+		for (j = 0; j < samples; j++)
+		{
+			data[j] = (cc_int16)(Math_SinF((j / snd->channels) * freq) * 12000.0f + Random_Range(rnd, -2000, 2000));
+		}
+		snd->chunk.data = data;
+		snd->chunk.size = samples * 2;
+	}
+	return true;
+}
+
+static void FreeSounds(void) {
+	int i;
+	for (i = 0; i < MIXER_BENCH_SOUNDS; i++)
+	{
+		Mem_Free(mixer_sounds[i].chunk.data);
+		mixer_sounds[i].chunk.data = NULL;
+	}
+}
+
+/* Checks that a sound played at normal speed and volume is output exactly as is */
+static cc_bool CheckMixerIdentity(struct AudioData* snd) {
+	const cc_int16* src = (const cc_int16*)snd->chunk.data;
+	cc_int16 samples[1024 * 2];
+	int i, frames = 1024;
+
+	AudioMixer_Clear();
+	snd->rate   = 100;
+	snd->volume = 100;
+	if (AudioMixer_Play(snd)) return false;
+	AudioMixer_Mix(samples, frames);
+
+	for (i = 0; i < frames * 2; i++)
+	{
+		if (samples[i] != src[snd->channels == 1 ? i >> 1 : i]) return false;
+	}
+	return true;
+}
+
+static void PlayVoices(RNGState* rnd) {
+	static const int rates[] = { 80, 100, 120, 140 };
+	struct AudioData* snd;
+	int i;
+
+	AudioMixer_Clear();
+	for (i = 0; i < bench_voices; i++)
+	{
+		snd = &mixer_sounds[Random_Next(rnd, MIXER_BENCH_SOUNDS)];
+		/* Voice copies the playback rate/volume when played, so reusing a sound is fine */
+		snd->rate   = rates[Random_Next(rnd, Array_Elems(rates))];
+		snd->volume = Random_Range(rnd, 10, 100);
+		AudioMixer_Play(snd);
+	}
+}
+
+/* Measures mixing many sounds together using the software mixer, with the output discarded */
+/*  (if mixer_wav is given, the mixed output is also afterwards written to that .wav file) */
+static void Benchmark_Mixer(void) {
+	/* 1 second, so no voice finishes (even at fastest playback rate) before mixing finishes */
+	int frames = AUDIO_MIXER_SAMPLE_RATE;
+	cc_bool identical;
+	struct Stream stream;
+	cc_uint64 beg, elapsed, best = 0;
+	RNGState rnd;
+	cc_result res;
+	int run;
+
+	Random_Seed(&rnd, bench_seed);
+	if (!GenerateSounds(&rnd)) { Logger_SysWarn(ERR_OUT_OF_MEMORY, "generating sounds"); goto cleanup; }
+	identical = CheckMixerIdentity(&mixer_sounds[0]) && CheckMixerIdentity(&mixer_sounds[2]);
+
+	for (run = 0; run < bench_runs; run++)
+	{
+		Random_Seed(&rnd, bench_seed);
+		PlayVoices(&rnd);
+
+		beg = Stopwatch_Measure();
+		AudioMixer_Render(NULL, frames);
+		elapsed = Stopwatch_ElapsedMicroseconds(beg, Stopwatch_Measure());
+		Benchmark_Best(best, elapsed, run);
+	}
+
+	Result_Begin("mixer");
+	Result_Int("voices",    bench_voices);
+	Result_Int("frames",    frames);
+	Result_Int("identical", identical);
+	Result_Time(best, "mvoice_frames_per_sec", (float)bench_voices * frames);
+	Result_Float("realtime", best ? frames * 1000000.0f / (best * (float)AUDIO_MIXER_SAMPLE_RATE) : 0.0f);
+	Result_End();
+
+	if (!bench_mixer_wav.length) goto cleanup;
+	res = Stream_CreateFile(&stream, &bench_mixer_wav);
+	if (res) { Logger_SysWarn2(res, "creating", &bench_mixer_wav); goto cleanup; }
+
+	Random_Seed(&rnd, bench_seed);
+	PlayVoices(&rnd);
+	res = AudioMixer_Render(&stream, frames);
+	if (res) Logger_SysWarn2(res, "writing", &bench_mixer_wav);
+
+	res = stream.Close(&stream);
+	if (res) Logger_SysWarn2(res, "closing", &bench_mixer_wav);
+
+cleanup:
+	AudioMixer_Clear();
+	FreeSounds();
+}
+#endif
+
+
+/*########################################################################################################################*
+*--------------------------------------------------------HTTP stage-------------------------------------------------------*
+*#########################################################################################################################*/
+#define HTTP_BENCH_NORMAL   12
+#define HTTP_BENCH_PRIORITY 2
+#define HTTP_BENCH_COOKIE   4
+#define HTTP_BENCH_COUNT (HTTP_BENCH_NORMAL + HTTP_BENCH_PRIORITY + HTTP_BENCH_COOKIE)
+/* Maximum milliseconds to wait for all the responses */
+#define HTTP_BENCH_TIMEOUT 30000
+/* NOTE: Not on the stack, as requests may still be using it if they time out */
+static struct StringsBuffer http_cookies;
+
+static int QueueHttpRequest(const char* lane, int i, cc_uint8 flags, struct StringsBuffer* cookies) {
+	cc_string url; char urlBuffer[URL_MAX_SIZE];
+	String_InitArray(url, urlBuffer);
+	String_Format3(&url, "%s/%c/%i", &bench_http, lane, &i);
+	return Http_AsyncGetDataEx(&url, flags, NULL, NULL, cookies);
+}
+
+/* Performs many requests to the server at the given url at once, in the order: */
+/*  normal requests, priority requests, then normal requests which all share the same cookie list */
+/*  (the server checks the order/concurrency they are performed in, see misc/benchmark/http_check.py) */
+static void Benchmark_Http(void) {
+	static const cc_string cookieKey = String_FromConst("n");
+	int ids[HTTP_BENCH_COUNT];
+	struct HttpRequest item;
+	struct HttpStats stats;
+	cc_uint64 beg;
+	int i, count = 0, left, failed = 0;
+	int elapsed = 0, cookie = 0, avgQueued, avgFetch;
+	cc_string value;
+
+	Http_Component.Init();
+	beg = Stopwatch_Measure();
+
+	for (i = 0; i < HTTP_BENCH_NORMAL; i++)
+	{
+		ids[count++] = QueueHttpRequest("normal",   i, 0, NULL);
+	}
+	for (i = 0; i < HTTP_BENCH_PRIORITY; i++)
+	{
+		ids[count++] = QueueHttpRequest("priority", i, HTTP_FLAG_PRIORITY, NULL);
+	}
+	for (i = 0; i < HTTP_BENCH_COOKIE; i++)
+	{
+		ids[count++] = QueueHttpRequest("cookie",   i, 0, &http_cookies);
+	}
+
+	for (left = count; left && elapsed < HTTP_BENCH_TIMEOUT; )
+	{
+		for (i = 0; i < count; i++)
+		{
+			if (!ids[i] || !Http_GetResult(ids[i], &item)) continue;
+			if (!item.success) failed++;
+
+			HttpRequest_Free(&item);
+			ids[i] = 0; left--;
+		}
+
+		elapsed = Stopwatch_ElapsedMS(beg, Stopwatch_Measure());
+		if (left) Thread_Sleep(5);
+	}
+
+	/* Each response sets the cookie to the number of cookie requests performed so far */
+	value = EntryList_UNSAFE_Get(&http_cookies, &cookieKey, '=');
+	Convert_ParseInt(&value, &cookie);
+
+	Http_GetStats(&stats);
+	avgQueued = stats.completed ? (int)(stats.waitMS / stats.completed) : 0;
+	avgFetch  = stats.completed ? (int)(stats.workMS / stats.completed) : 0;
+
+	Result_Begin("http");
+	Result_Int("requests",      count);
+	Result_Int("failed",        failed + left);
+	Result_Int("cookie",        cookie);
+	Result_Int("ms",            elapsed);
+	Result_Int("avg_queued_ms", avgQueued);
+	Result_Int("avg_fetch_ms",  avgFetch);
+	Result_End();
+}
+
+
+/*########################################################################################################################*
+*-------------------------------------------------------Benchmarks--------------------------------------------------------*
+*#########################################################################################################################*/
+int Benchmark_Run(int argc, char** argv) {
+	cc_result res;
+	CrashHandler_Install();
+	Logger_Hook();
+	Platform_Init();
+
+	if (!ParseArgs(argc, argv)) {
+		Platform_LogConst("Usage: ClassiCube-benchmark [map=path] [width=256] [height=64] [length=256] [seed=0] [threads=N] [runs=3] [ogg=path] [voices=64] [mixer_wav=path] [http=url]");
+		return 1;
+	}
+	Init();
+
+	Result_Begin("setup");
+	Result_Int("threads", WorkerPool_Threads());
+	Result_Int("runs",    bench_runs);
+	Result_End();
+
+	Benchmark_Noise();
+	res = bench_map.length ? Benchmark_Load() : Benchmark_Generate();
+	if (res) return res;
+	if (bench_map.length) Benchmark_Inflate();
+
+	Benchmark_ClassicLighting();
+	Benchmark_Mesh("mesh_classic");
+
+	Lighting_SetMode(LIGHTING_MODE_FANCY, false);
+	Benchmark_FancyLighting();
+	Benchmark_Mesh("mesh_fancy");
+
+	Benchmark_BlockStore();
+
+	Lighting_SetMode(LIGHTING_MODE_CLASSIC, false);
+	Physics_Init();
+	Physics_SetEnabled(true);
+	Benchmark_RandomTicks();
+	Benchmark_Flood();
+	Physics_Free();
+
+	if (bench_ogg.length) Benchmark_Vorbis();
+#ifndef CC_BUILD_NOSOUNDS
+	Benchmark_Mixer();
+#endif
+	if (bench_http.length) Benchmark_Http();
+	return 0;
+}
+#endif
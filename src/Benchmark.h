@@ -0,0 +1,20 @@
+#ifndef CC_BENCHMARK_H
+#define CC_BENCHMARK_H
+#include "Core.h"
+CC_BEGIN_HEADER
+
+/*
+Headless benchmarks of terrain noise, map generation/loading/decompression, lighting, chunk mesh building, physics
+  ogg vorbis decoding, software audio mixing and http request scheduling
+  Only used by CC_BUILD_BENCHMARK builds, which run these instead of the game
+  (which means no window or graphics context is ever created)
+
+Copyright 2014-2023 ClassiCube | Licensed under BSD-3
+*/
+
+/* Parses the command line arguments, then runs the benchmarks and logs the results */
+/* Returns 0 on success, non-zero on failure (e.g. the map could not be loaded) */
+int Benchmark_Run(int argc, char** argv);
+
+CC_END_HEADER
+#endif
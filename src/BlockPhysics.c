@@ -13,95 +13,119 @@
 #include "Logger.h"
 #include "Vectors.h"
 #include "Chat.h"
+#include "Utils.h"
 
-/* Data for a resizable queue, used for liquid physic tick entries. */
-struct TickQueue {
-	cc_uint32* entries; /* Buffer holding the items in the tick queue */
+struct Physics_ Physics;
+static RNGState physics_rnd;
+/* Number of physics ticks so far. Updates scheduled in a tick are due from the next tick onwards */
+static int physics_tickCount;
+/* Seed which the blocks picked for random ticks are derived from */
+static int physics_seed;
+static int physics_maxWaterX, physics_maxWaterY, physics_maxWaterZ;
+
+/* Number of ticks after being scheduled that updates are due */
+#define PHYSICS_ONE_DELAY    1
+#define PHYSICS_LAVA_DELAY  30
+#define PHYSICS_WATER_DELAY  5
+
+/* Number of ticks in the future that physics updates can be scheduled for */
+#define TICKWHEEL_SIZE 32
+#define TICKWHEEL_MASK (TICKWHEEL_SIZE - 1)
+
+/* Resizable list of blocks due to be updated in a particular tick */
+struct TickSlot {
+	cc_uint32* entries; /* Buffer holding the indices of the blocks */
 	int capacity; /* Max number of elements in the buffer */
-	int mask;     /* capacity - 1, as capacity is always a power of two */
 	int count;    /* Number of used elements */
-	int head;     /* Head index into the buffer */
-	int tail;     /* Tail index into the buffer */
 };
 
-static void TickQueue_Init(struct TickQueue* queue) {
-	queue->entries  = NULL;
-	queue->capacity = 0;
-	queue->mask  = 0;
-	queue->count = 0;
-	queue->head  = 0;
-	queue->tail  = 0;
+/* Timing wheel of scheduled physics updates, used for liquid physics. */
+/* Blocks are only looked at again when due, instead of in every tick until then */
+struct TickWheel {
+	struct TickSlot slots[TICKWHEEL_SIZE];
+	cc_uint8* pending; /* Bitset of whether each block is scheduled to be updated */
+	int count;         /* Number of scheduled updates across all slots */
+};
+
+static void TickWheel_Init(struct TickWheel* wheel) {
+	Mem_Set(wheel, 0, sizeof(struct TickWheel));
 }
 
-static void TickQueue_Clear(struct TickQueue* queue) {
-	if (!queue->entries) return;
-	Mem_Free(queue->entries);
-	TickQueue_Init(queue);
+static void TickWheel_Clear(struct TickWheel* wheel) {
+	int i;
+	for (i = 0; i < TICKWHEEL_SIZE; i++) 
+	{
+		Mem_Free(wheel->slots[i].entries);
+	}
+	Mem_Free(wheel->pending);
+	TickWheel_Init(wheel);
 }
 
-static void TickQueue_Resize(struct TickQueue* queue) {
-	cc_uint32* entries;
-	int i, idx, capacity;
+static void TickWheel_Resize(struct TickWheel* wheel, struct TickSlot* slot) {
+	int capacity;
 
-	if (queue->capacity >= (Int32_MaxValue / 4)) {
+	if (wheel->count >= (Int32_MaxValue / 4)) {
 		Chat_AddRaw("&cToo many physics entries, clearing");
-		TickQueue_Clear(queue);
+		TickWheel_Clear(wheel);
 	}
 
-	capacity = queue->capacity * 2;
+	capacity = slot->capacity * 2;
 	if (capacity < 32) capacity = 32;
-	entries = (cc_uint32*)Mem_Alloc(capacity, 4, "physics tick queue");
 
-	/* Elements must be readjusted to avoid index wrapping issues */
-	/* https://stackoverflow.com/questions/55343683/resizing-of-the-circular-queue-using-dynamic-array */
-	for (i = 0; i < queue->count; i++) {
-		idx = (queue->head + i) & queue->mask;
-		entries[i] = queue->entries[idx];
-	}
-	Mem_Free(queue->entries);
-
-	queue->entries  = entries;
-	queue->capacity = capacity;
-	queue->mask     = capacity - 1; /* capacity is power of two */
-	queue->head = 0;
-	queue->tail = queue->count;
+	slot->entries  = (cc_uint32*)Mem_Realloc(slot->entries, capacity, 4, "physics tick slot");
+	slot->capacity = capacity;
 }
 
-/* Appends an entry to the end of the queue, resizing if necessary. */
-static void TickQueue_Enqueue(struct TickQueue* queue, cc_uint32 item) {
-	if (queue->count == queue->capacity)
-		TickQueue_Resize(queue);
+/* Schedules the given block to be updated after the given number of ticks */
+/* NOTE: If the block is already scheduled, it is only scheduled again if force is true */
+static void TickWheel_Schedule(struct TickWheel* wheel, int index, int delay, cc_bool force) {
+	struct TickSlot* slot;
+	cc_uint8 bit = 1 << (index & 7);
+
+	if (!wheel->pending) {
+		/* Bitset is lazily allocated, since most maps never have any liquid physics */
+		wheel->pending = (cc_uint8*)Mem_AllocCleared((World.Volume + 7) >> 3, 1, "physics pending blocks");
+	}
+	if ((wheel->pending[index >> 3] & bit) && !force) return;
+	wheel->pending[index >> 3] |= bit;
 
-	queue->entries[queue->tail] = item;
-	queue->tail = (queue->tail + 1) & queue->mask;
-	queue->count++;
+	slot = &wheel->slots[(physics_tickCount + delay) & TICKWHEEL_MASK];
+	if (slot->count == slot->capacity) TickWheel_Resize(wheel, slot);
+
+	slot->entries[slot->count++] = index;
+	wheel->count++;
 }
 
-/* Retrieves the entry from the front of the queue. */
-static cc_uint32 TickQueue_Dequeue(struct TickQueue* queue) {
-	cc_uint32 result = queue->entries[queue->head];
-	queue->head = (queue->head + 1) & queue->mask;
-	queue->count--;
-	return result;
+/* Marks the given block as no longer scheduled, returning false if it already was */
+/* (e.g. a block forcibly scheduled again will have multiple entries in the wheel) */
+static cc_bool TickWheel_Unmark(struct TickWheel* wheel, int index) {
+	cc_uint8 bit = 1 << (index & 7);
+	if (!(wheel->pending[index >> 3] & bit)) return false;
+
+	wheel->pending[index >> 3] &= ~bit;
+	return true;
 }
 
+static struct TickWheel lavaQ, waterQ;
+/* Blocks picked for random ticks in the current tick (-1 if the picked block has no random tick handler) */
+static int* randomTicks;
+/* Results of the sponge checks for the water updates in the current tick */
+static cc_uint16* spongeChecks;
+static int spongeChecksCapacity;
 
-struct Physics_ Physics;
-static RNGState physics_rnd;
-static int physics_tickCount;
-static int physics_maxWaterX, physics_maxWaterY, physics_maxWaterZ;
-static struct TickQueue lavaQ, waterQ;
+static void Physics_FreeBuffers(void) {
+	TickWheel_Clear(&lavaQ);
+	TickWheel_Clear(&waterQ);
 
-#define PHYSICS_DELAY_MASK 0xF8000000UL
-#define PHYSICS_POS_MASK   0x07FFFFFFUL
-#define PHYSICS_DELAY_SHIFT 27
-#define PHYSICS_ONE_DELAY   (1U << PHYSICS_DELAY_SHIFT)
-#define PHYSICS_LAVA_DELAY (30U << PHYSICS_DELAY_SHIFT)
-#define PHYSICS_WATER_DELAY (5U << PHYSICS_DELAY_SHIFT)
+	Mem_Free(randomTicks);
+	randomTicks = NULL;
+	Mem_Free(spongeChecks);
+	spongeChecks = NULL;
+	spongeChecksCapacity = 0;
+}
 
 static void Physics_OnNewMapLoaded(void* obj) {
-	TickQueue_Clear(&lavaQ);
-	TickQueue_Clear(&waterQ);
+	Physics_FreeBuffers();
 
 	physics_maxWaterX = World.MaxX - 2;
 	physics_maxWaterY = World.MaxY - 2;
@@ -110,6 +134,7 @@ static void Physics_OnNewMapLoaded(void* obj) {
 	Tree_Blocks = World.Blocks;
 	Random_SeedFromCurrentTime(&physics_rnd);
 	Tree_Rnd = &physics_rnd;
+	physics_seed = Random_Next(&physics_rnd, Int32_MaxValue);
 }
 
 void Physics_SetEnabled(cc_bool enabled) {
@@ -162,39 +187,69 @@ void Physics_OnBlockChanged(int x, int y, int z, BlockID old, BlockID now) {
 	Physics_ActivateNeighbours(x, y, z, index);
 }
 
-static void Physics_TickRandomBlocks(void) {
-	int lo, hi, index;
-	BlockID block;
-	PhysicsHandler tick;
+/* Number of blocks in each chunk that are randomly ticked each tick */
+#define PHYSICS_RANDOM_TICKS 3
+
+/* Returns the seed for the RNG of the given row of chunks in the given tick */
+static int Physics_RowSeed(int tick, int row) {
+	cc_uint32 h = (cc_uint32)physics_seed ^ ((cc_uint32)tick * 0x9E3779B1UL) ^ ((cc_uint32)row * 0x85EBCA77UL);
+	h ^= h >> 16; h *= 0x7FEB352DUL;
+	h ^= h >> 15; h *= 0x846CA68BUL;
+	h ^= h >> 16;
+	return (int)h;
+}
+
+/* Picks the blocks to random tick in a row of chunks along the X axis */
+static void Physics_PickRandomJob(void* obj, int row) {
+	int tick = *((int*)obj);
+	int* picks = randomTicks + row * World.ChunksX * PHYSICS_RANDOM_TICKS;
+	int i, lo, hi, index;
 	int x, y, z, x2, y2, z2;
+	RNGState rnd;
+
+	Random_Seed(&rnd, Physics_RowSeed(tick, row));
+	y  = (row / World.ChunksZ) << CHUNK_SHIFT;
+	z  = (row % World.ChunksZ) << CHUNK_SHIFT;
+	y2 = min(y + CHUNK_MAX, World.MaxY);
+	z2 = min(z + CHUNK_MAX, World.MaxZ);
+
+	for (x = 0; x < World.Width; x += CHUNK_SIZE)
+	{
+		x2 = min(x + CHUNK_MAX, World.MaxX);
+		lo = World_Pack( x,  y,  z);
+		hi = World_Pack(x2, y2, z2);
+
+		for (i = 0; i < PHYSICS_RANDOM_TICKS; i++)
+		{
+			index    = Random_Range(&rnd, lo, hi);
+			*picks++ = Physics.OnRandomTick[World.Blocks[index]] ? index : -1;
+		}
+	}
+}
 
-	for (y = 0; y < World.Height; y += CHUNK_SIZE) {
-		y2 = min(y + CHUNK_MAX, World.MaxY);
-		for (z = 0; z < World.Length; z += CHUNK_SIZE) {
-			z2 = min(z + CHUNK_MAX, World.MaxZ);
-			for (x = 0; x < World.Width; x += CHUNK_SIZE) {
-				x2 = min(x + CHUNK_MAX, World.MaxX);
-
-				/* Inlined 3 random ticks for this chunk */
-				lo = World_Pack( x,  y,  z);
-				hi = World_Pack(x2, y2, z2);
-				
-				index = Random_Range(&physics_rnd, lo, hi);
-				block = World.Blocks[index];
-				tick = Physics.OnRandomTick[block];
-				if (tick) tick(index, block);
+/* Picking the blocks is spread across worker threads, with each row of chunks using */
+/*  its own RNG so that the same blocks are picked regardless of how many threads there are. */
+/* The handlers may change the world though, so are always run in order on this thread */
+static void Physics_TickRandomBlocks(int tick) {
+	int i, count = World.ChunksCount * PHYSICS_RANDOM_TICKS;
+	int index;
+	BlockID block;
+	PhysicsHandler handler;
 
-				index = Random_Range(&physics_rnd, lo, hi);
-				block = World.Blocks[index];
-				tick = Physics.OnRandomTick[block];
-				if (tick) tick(index, block);
+	if (!randomTicks) {
+		randomTicks = (int*)Mem_Alloc(count, sizeof(int), "physics random ticks");
+	}
+	WorkerPool_Run(Physics_PickRandomJob, &tick, World.ChunksY * World.ChunksZ);
 
-				index = Random_Range(&physics_rnd, lo, hi);
-				block = World.Blocks[index];
-				tick = Physics.OnRandomTick[block];
-				if (tick) tick(index, block);
-			}
-		}
+	for (i = 0; i < count; i++)
+	{
+		index = randomTicks[i];
+		if (index < 0) continue;
+
+		/* Block may have been changed by an earlier handler */
+		block   = World.Blocks[index];
+		handler = Physics.OnRandomTick[block];
+		if (handler) handler(index, block);
 	}
 }
 
@@ -224,16 +279,12 @@ static void Physics_DoFalling(int index, BlockID block) {
 	Physics_ActivateNeighbours(x, y, z, start);
 }
 
-static cc_bool Physics_CheckItem(struct TickQueue* queue, int* posIndex) {
-	cc_uint32 item = TickQueue_Dequeue(queue);
-	*posIndex     = (int)(item & PHYSICS_POS_MASK);
-
-	if (item >= PHYSICS_ONE_DELAY) {
-		item -= PHYSICS_ONE_DELAY;
-		TickQueue_Enqueue(queue, item);
-		return false;
-	}
-	return true;
+/* Removes the list of blocks due to be updated in the given tick from the wheel */
+/* NOTE: Blocks scheduled while processing the list always go in other slots, so the list is unaffected */
+static struct TickSlot* Physics_TakeDue(struct TickWheel* wheel, int tick) {
+	struct TickSlot* slot = &wheel->slots[tick & TICKWHEEL_MASK];
+	wheel->count -= slot->count;
+	return slot;
 }
 
 
@@ -322,7 +373,7 @@ static void Physics_HandleMushroom(int index, BlockID block) {
 
 
 static void Physics_PlaceLava(int index, BlockID block) {
-	TickQueue_Enqueue(&lavaQ, PHYSICS_LAVA_DELAY | index);
+	TickWheel_Schedule(&lavaQ, index, PHYSICS_LAVA_DELAY, false);
 }
 
 static void Physics_PropagateLava(int posIndex, int x, int y, int z) {
@@ -334,7 +385,7 @@ static void Physics_PropagateLava(int posIndex, int x, int y, int z) {
 			Game_UpdateBlock(x, y, z, BLOCK_STONE);
 		}
 	} else if (Blocks.Collide[block] == COLLIDE_NONE) {
-		TickQueue_Enqueue(&lavaQ, PHYSICS_LAVA_DELAY | posIndex);
+		TickWheel_Schedule(&lavaQ, posIndex, PHYSICS_LAVA_DELAY, false);
 		Game_UpdateBlock(x, y, z, BLOCK_LAVA);
 	}
 }
@@ -350,69 +401,144 @@ static void Physics_ActivateLava(int index, BlockID block) {
 	if (y > 0)          Physics_PropagateLava(index - World.OneY, x, y - 1, z);
 }
 
-static void Physics_TickLava(void) {
-	int i, count = lavaQ.count;
-	for (i = 0; i < count; i++) {
-		int index;
-		if (Physics_CheckItem(&lavaQ, &index)) {
-			BlockID block = World.Blocks[index];
-			if (!(block == BLOCK_LAVA || block == BLOCK_STILL_LAVA)) continue;
-			Physics_ActivateLava(index, block);
-		}
+static void Physics_TickLava(int tick) {
+	struct TickSlot* slot = Physics_TakeDue(&lavaQ, tick);
+	int i, index;
+	BlockID block;
+
+	for (i = 0; i < slot->count; i++) {
+		index = slot->entries[i];
+		if (!TickWheel_Unmark(&lavaQ, index)) continue;
+
+		block = World.Blocks[index];
+		if (!(block == BLOCK_LAVA || block == BLOCK_STILL_LAVA)) continue;
+		Physics_ActivateLava(index, block);
 	}
+	slot->count = 0;
 }
 
 
 static void Physics_PlaceWater(int index, BlockID block) {
-	TickQueue_Enqueue(&waterQ, PHYSICS_WATER_DELAY | index);
+	TickWheel_Schedule(&waterQ, index, PHYSICS_WATER_DELAY, false);
 }
 
-static void Physics_PropagateWater(int posIndex, int x, int y, int z) {
-	BlockID block = World.Blocks[posIndex];
+/* Whether a sponge nearby stops water from spreading into the given block */
+static cc_bool Physics_NearSponge(int x, int y, int z) {
 	int xx, yy, zz;
 
+	for (yy = (y < 2 ? 0 : y - 2); yy <= (y > physics_maxWaterY ? World.MaxY : y + 2); yy++) {
+		for (zz = (z < 2 ? 0 : z - 2); zz <= (z > physics_maxWaterZ ? World.MaxZ : z + 2); zz++) {
+			for (xx = (x < 2 ? 0 : x - 2); xx <= (x > physics_maxWaterX ? World.MaxX : x + 2); xx++) {
+				if (World_GetBlock(xx, yy, zz) == BLOCK_SPONGE) return true;
+			}
+		}
+	}
+	return false;
+}
+
+/* Sponge check results for the 5 directions water spreads in (see Physics_SpreadWater) */
+#define SPONGE_CHECKED(dir) (0x01 << (dir))
+#define SPONGE_FOUND(dir)   (0x20 << (dir))
+
+static void Physics_PropagateWater(int posIndex, int x, int y, int z, int checks, int dir) {
+	BlockID block = World.Blocks[posIndex];
+
 	if (block >= BLOCK_WATER && block <= BLOCK_STILL_LAVA) {
 		/* Water spreading into lava turns the lava solid */
 		if (block == BLOCK_LAVA || block == BLOCK_STILL_LAVA) {
 			Game_UpdateBlock(x, y, z, BLOCK_STONE);
 		}
 	} else if (Blocks.Collide[block] == COLLIDE_NONE) {
-		/* Sponge check */		
-		for (yy = (y < 2 ? 0 : y - 2); yy <= (y > physics_maxWaterY ? World.MaxY : y + 2); yy++) {
-			for (zz = (z < 2 ? 0 : z - 2); zz <= (z > physics_maxWaterZ ? World.MaxZ : z + 2); zz++) {
-				for (xx = (x < 2 ? 0 : x - 2); xx <= (x > physics_maxWaterX ? World.MaxX : x + 2); xx++) {
-					block = World_GetBlock(xx, yy, zz);
-					if (block == BLOCK_SPONGE) return;
-				}
-			}
+		if (checks & SPONGE_CHECKED(dir)) {
+			if (checks & SPONGE_FOUND(dir)) return;
+		} else if (Physics_NearSponge(x, y, z)) {
+			return;
 		}
 
-		TickQueue_Enqueue(&waterQ, PHYSICS_WATER_DELAY | posIndex);
+		TickWheel_Schedule(&waterQ, posIndex, PHYSICS_WATER_DELAY, false);
 		Game_UpdateBlock(x, y, z, BLOCK_WATER);
 	}
 }
 
-static void Physics_ActivateWater(int index, BlockID block) {
+static void Physics_SpreadWater(int index, int checks) {
 	int x, y, z;
 	World_Unpack(index, x, y, z);
 
-	if (x > 0)          Physics_PropagateWater(index - 1,           x - 1, y,     z);
-	if (x < World.MaxX) Physics_PropagateWater(index + 1,           x + 1, y,     z);
-	if (z > 0)          Physics_PropagateWater(index - World.Width, x,     y,     z - 1);
-	if (z < World.MaxZ) Physics_PropagateWater(index + World.Width, x,     y,     z + 1);
-	if (y > 0)          Physics_PropagateWater(index - World.OneY,  x,     y - 1, z);
-}
-
-static void Physics_TickWater(void) {
-	int i, count = waterQ.count;
-	for (i = 0; i < count; i++) {
-		int index;
-		if (Physics_CheckItem(&waterQ, &index)) {
-			BlockID block = World.Blocks[index];
-			if (!(block == BLOCK_WATER || block == BLOCK_STILL_WATER)) continue;
-			Physics_ActivateWater(index, block);
+	if (x > 0)          Physics_PropagateWater(index - 1,           x - 1, y,     z,     checks, 0);
+	if (x < World.MaxX) Physics_PropagateWater(index + 1,           x + 1, y,     z,     checks, 1);
+	if (z > 0)          Physics_PropagateWater(index - World.Width, x,     y,     z - 1, checks, 2);
+	if (z < World.MaxZ) Physics_PropagateWater(index + World.Width, x,     y,     z + 1, checks, 3);
+	if (y > 0)          Physics_PropagateWater(index - World.OneY,  x,     y - 1, z,     checks, 4);
+}
+
+static void Physics_ActivateWater(int index, BlockID block) {
+	Physics_SpreadWater(index, 0);
+}
+
+static int Physics_CheckSponge(int posIndex, int x, int y, int z, int dir) {
+	BlockID block = World.Blocks[posIndex];
+	if (block >= BLOCK_WATER && block <= BLOCK_STILL_LAVA) return 0;
+	if (Blocks.Collide[block] != COLLIDE_NONE) return 0;
+
+	return SPONGE_CHECKED(dir) | (Physics_NearSponge(x, y, z) ? SPONGE_FOUND(dir) : 0);
+}
+
+/* Performs the sponge checks for the blocks that the given water block may spread into */
+static int Physics_CheckSponges(int index) {
+	int x, y, z, checks = 0;
+	BlockID block = World.Blocks[index];
+	if (!(block == BLOCK_WATER || block == BLOCK_STILL_WATER)) return 0;
+	World_Unpack(index, x, y, z);
+
+	if (x > 0)          checks |= Physics_CheckSponge(index - 1,           x - 1, y,     z,     0);
+	if (x < World.MaxX) checks |= Physics_CheckSponge(index + 1,           x + 1, y,     z,     1);
+	if (z > 0)          checks |= Physics_CheckSponge(index - World.Width, x,     y,     z - 1, 2);
+	if (z < World.MaxZ) checks |= Physics_CheckSponge(index + World.Width, x,     y,     z + 1, 3);
+	if (y > 0)          checks |= Physics_CheckSponge(index - World.OneY,  x,     y - 1, z,     4);
+	return checks;
+}
+
+#define SPONGE_CHECKS_PER_JOB 256
+static void Physics_CheckSpongesJob(void* obj, int job) {
+	struct TickSlot* slot = (struct TickSlot*)obj;
+	int i   = job * SPONGE_CHECKS_PER_JOB;
+	int end = min(i + SPONGE_CHECKS_PER_JOB, slot->count);
+
+	for (; i < end; i++)
+	{
+		spongeChecks[i] = (cc_uint16)Physics_CheckSponges(slot->entries[i]);
+	}
+}
+
+/* Sponge checks only read the world, so are spread across worker threads beforehand. */
+/* Water spreading doesn't add or remove sponges, so the results stay valid for the whole tick */
+/*  (if a target block changed since it was checked, it is just checked again when spreading) */
+static void Physics_TickWater(int tick) {
+	struct TickSlot* slot = Physics_TakeDue(&waterQ, tick);
+	int i, index, checks = 0;
+	BlockID block;
+	cc_bool checked = slot->count >= SPONGE_CHECKS_PER_JOB && WorkerPool_Threads() > 1;
+
+	if (checked) {
+		if (slot->count > spongeChecksCapacity) {
+			spongeChecksCapacity = slot->capacity;
+			spongeChecks = (cc_uint16*)Mem_Realloc(spongeChecks, spongeChecksCapacity, 2, "physics sponge checks");
 		}
+		WorkerPool_Run(Physics_CheckSpongesJob, slot, 
+			(slot->count + (SPONGE_CHECKS_PER_JOB - 1)) / SPONGE_CHECKS_PER_JOB);
+	}
+
+	for (i = 0; i < slot->count; i++) {
+		index = slot->entries[i];
+		if (!TickWheel_Unmark(&waterQ, index)) continue;
+
+		block = World.Blocks[index];
+		if (!(block == BLOCK_WATER || block == BLOCK_STILL_WATER)) continue;
+
+		if (checked) checks = spongeChecks[i];
+		Physics_SpreadWater(index, checks);
 	}
+	slot->count = 0;
 }
 
 
@@ -447,7 +573,7 @@ static void Physics_DeleteSponge(int index, BlockID block) {
 					index = World_Pack(xx, yy, zz);
 					block = World.Blocks[index];
 					if (block == BLOCK_WATER || block == BLOCK_STILL_WATER) {
-						TickQueue_Enqueue(&waterQ, index | PHYSICS_ONE_DELAY);
+						TickWheel_Schedule(&waterQ, index, PHYSICS_ONE_DELAY, true);
 					}
 				}
 			}
@@ -492,6 +618,7 @@ static void Physics_HandleTnt(int index, BlockID block) {
 	int dx, dy, dz, xx, yy, zz;
 
 	World_Unpack(index, x, y, z);
+	Game_BeginBlockBatch();
 	Game_UpdateBlock(x, y, z, BLOCK_AIR);
 	Physics_ActivateNeighbours(x, y, z, index);
 	
@@ -512,13 +639,14 @@ static void Physics_HandleTnt(int index, BlockID block) {
 			}
 		}
 	}
+	Game_CommitBlockBatch();
 }
 
 void Physics_Init(void) {
 	Event_Register_(&WorldEvents.MapLoaded,    NULL, Physics_OnNewMapLoaded);
 	Physics.Enabled = Options_GetBool(OPT_BLOCK_PHYSICS, true);
-	TickQueue_Init(&lavaQ);
-	TickQueue_Init(&waterQ);
+	TickWheel_Init(&lavaQ);
+	TickWheel_Init(&waterQ);
 
 	Physics.OnPlace[BLOCK_SAND]        = Physics_DoFalling;
 	Physics.OnPlace[BLOCK_GRAVEL]      = Physics_DoFalling;
@@ -559,15 +687,15 @@ void Physics_Init(void) {
 
 void Physics_Free(void) {
 	Event_Unregister_(&WorldEvents.MapLoaded,    NULL, Physics_OnNewMapLoaded);
+	Physics_FreeBuffers();
 }
 
 void Physics_Tick(void) {
+	int tick;
 	if (!Physics.Enabled || !World.Blocks) return;
+	tick = physics_tickCount++;
 
-	/*if ((tickCount % 5) == 0) {*/
-	Physics_TickLava();
-	Physics_TickWater();
-	/*}*/
-	physics_tickCount++;
-	Physics_TickRandomBlocks();
+	Physics_TickLava(tick);
+	Physics_TickWater(tick);
+	Physics_TickRandomBlocks(tick);
 }
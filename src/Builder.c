@@ -13,6 +13,7 @@
 #include "TexturePack.h"
 #include "Game.h"
 #include "Options.h"
+#include "Utils.h"
 
 int Builder_SidesLevel, Builder_EdgeLevel;
 /* Packs an index into the 16x16x16 count array. Coordinates range from 0 to 15. */
@@ -20,23 +21,8 @@ int Builder_SidesLevel, Builder_EdgeLevel;
 /* Packs an index into the 18x18x18 chunk array. Coordinates range from -1 to 16. */
 #define Builder_PackChunk(xx, yy, zz) (((yy) + 1) * EXTCHUNK_SIZE_2 + ((zz) + 1) * EXTCHUNK_SIZE + ((xx) + 1))
 
-static BlockID* Builder_Chunk;
-static cc_uint8* Builder_Counts;
-static int* Builder_BitFlags;
-static int Builder_X, Builder_Y, Builder_Z;
-static BlockID Builder_Block;
-static int Builder_ChunkIndex;
-static cc_bool Builder_FullBright;
-static int Builder_ChunkEndX, Builder_ChunkEndZ;
 static int Builder_Offsets[FACE_COUNT] = { -1,1, -EXTCHUNK_SIZE,EXTCHUNK_SIZE, -EXTCHUNK_SIZE_2,EXTCHUNK_SIZE_2 };
 
-static int (*Builder_StretchXLiquid)(int countIndex, int x, int y, int z, int chunkIndex, BlockID block);
-static int (*Builder_StretchX)(int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face);
-static int (*Builder_StretchZ)(int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face);
-static void (*Builder_RenderBlock)(int countsIndex, int x, int y, int z);
-static void (*Builder_PrePrepareChunk)(void);
-static void (*Builder_PostPrepareChunk)(void);
-
 /* Contains state for vertices for a portion of a chunk mesh (vertices that are in a 1D atlas) */
 struct Builder1DPart {
 	/* Union to save on memory, since chunk building is divided into counting then building phases */
@@ -47,10 +33,39 @@ struct Builder1DPart {
 	int sCount, sOffset;
 };
 
-/* Part builder data, for both normal and translucent parts.
-The first ATLAS1D_MAX_ATLASES parts are for normal parts, remainder are for translucent parts. */
-static struct Builder1DPart Builder_Parts[ATLAS1D_MAX_ATLASES * 2];
-static struct VertexTextured* Builder_Vertices;
+/* Contains all the state used while building the mesh of a single chunk */
+/* NOTE: Since each chunk has its own context, multiple chunks can be built at the same time */
+struct BuilderContext {
+	BlockID* chunk;
+	cc_uint8* counts;
+	int* bitFlags;
+	int x, y, z;
+	BlockID block;
+	int chunkIndex;
+	cc_bool fullBright;
+	int chunkEndX, chunkEndZ;
+	/* Part builder data, for both normal and translucent parts.
+	The first ATLAS1D_MAX_ATLASES parts are for normal parts, remainder are for translucent parts. */
+	struct Builder1DPart parts[ATLAS1D_MAX_ATLASES * 2];
+	struct VertexTextured* vertices;
+	/* Cuboid state for the normal mesh builder */
+	struct _DrawerData drawer;
+#ifdef CC_BUILD_ADVLIGHTING
+	/* State for the advanced and modern mesh builders */
+	Vec3 minBB, maxBB;
+	int initBitFlags, baseOffset;
+	float x1, y1, z1, x2, y2, z2;
+	PackedCol lerp[5], lerpX[5], lerpZ[5], lerpY[5];
+	cc_bool tinted;
+#endif
+};
+
+static int (*Builder_StretchXLiquid)(struct BuilderContext* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block);
+static int (*Builder_StretchX)(struct BuilderContext* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face);
+static int (*Builder_StretchZ)(struct BuilderContext* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face);
+static void (*Builder_RenderBlock)(struct BuilderContext* ctx, int countsIndex, int x, int y, int z);
+static void (*Builder_PrePrepareChunk)(struct BuilderContext* ctx);
+static void (*Builder_PostPrepareChunk)(struct BuilderContext* ctx);
 
 static int Builder1DPart_VerticesCount(struct Builder1DPart* part) {
 	int i, count = part->sCount;
@@ -58,7 +73,7 @@ static int Builder1DPart_VerticesCount(struct Builder1DPart* part) {
 	return count;
 }
 
-static int Builder1DPart_CalcOffsets(struct Builder1DPart* part, int offset) {
+static int Builder1DPart_CalcOffsets(struct BuilderContext* ctx, struct Builder1DPart* part, int offset) {
 	int i, counts[FACE_COUNT];
 	part->sOffset = offset;
 
@@ -71,16 +86,16 @@ static int Builder1DPart_CalcOffsets(struct Builder1DPart* part, int offset) {
 	offset += part->sCount;
 	for (i = 0; i < FACE_COUNT; i++) 
 	{
-		part->faces.vertices[i] = &Builder_Vertices[offset];
+		part->faces.vertices[i] = &ctx->vertices[offset];
 		offset += counts[i];
 	}
 	return offset;
 }
 
-static int Builder_TotalVerticesCount(void) {
+static int Builder_TotalVerticesCount(struct BuilderContext* ctx) {
 	int i, count = 0;
 	for (i = 0; i < ATLAS1D_MAX_ATLASES * 2; i++) {
-		count += Builder1DPart_VerticesCount(&Builder_Parts[i]);
+		count += Builder1DPart_VerticesCount(&ctx->parts[i]);
 	}
 	return count;
 }
@@ -89,28 +104,28 @@ static int Builder_TotalVerticesCount(void) {
 /*########################################################################################################################*
 *----------------------------------------------------Base mesh builder----------------------------------------------------*
 *#########################################################################################################################*/
-static void AddSpriteVertices(BlockID block) {
+static void AddSpriteVertices(struct BuilderContext* ctx, BlockID block) {
 	int i = Atlas1D_Index(Block_Tex(block, FACE_XMAX));
-	struct Builder1DPart* part = &Builder_Parts[i];
+	struct Builder1DPart* part = &ctx->parts[i];
 	part->sCount += 4 * 4;
 }
 
-static void AddVertices(BlockID block, Face face) {
+static void AddVertices(struct BuilderContext* ctx, BlockID block, Face face) {
 	int baseOffset = (Blocks.Draw[block] == DRAW_TRANSLUCENT) * ATLAS1D_MAX_ATLASES;
 	int i = Atlas1D_Index(Block_Tex(block, face));
-	struct Builder1DPart* part = &Builder_Parts[baseOffset + i];
+	struct Builder1DPart* part = &ctx->parts[baseOffset + i];
 	part->faces.count[face] += 4;
 }
 
 #ifdef CC_BUILD_GL11
-static void BuildPartVbs(struct ChunkPartInfo* info) {
+static void BuildPartVbs(struct BuilderContext* ctx, struct ChunkPartInfo* info) {
 	/* Sprites vertices are stored before chunk face sides */
 	int i, count, offset = info->offset + info->spriteCount;
 	for (i = 0; i < FACE_COUNT; i++) {
 		count = info->counts[i];
 
 		if (count) {
-			info->vbs[i] = Gfx_CreateVb2(&Builder_Vertices[offset], VERTEX_FORMAT_TEXTURED, count);
+			info->vbs[i] = Gfx_CreateVb2(&ctx->vertices[offset], VERTEX_FORMAT_TEXTURED, count);
 			offset += count;
 		} else {
 			info->vbs[i] = 0;
@@ -120,7 +135,7 @@ static void BuildPartVbs(struct ChunkPartInfo* info) {
 	count  = info->spriteCount;
 	offset = info->offset;
 	if (count) {
-		info->vbs[i] = Gfx_CreateVb2(&Builder_Vertices[offset], VERTEX_FORMAT_TEXTURED, count);
+		info->vbs[i] = Gfx_CreateVb2(&ctx->vertices[offset], VERTEX_FORMAT_TEXTURED, count);
 	} else {
 		info->vbs[i] = 0;
 	}
@@ -146,7 +161,7 @@ static cc_bool SetPartInfo(struct Builder1DPart* part, int* offset, struct Chunk
 }
 
 
-static void PrepareChunk(int x1, int y1, int z1) {
+static void PrepareChunk(struct BuilderContext* ctx, int x1, int y1, int z1) {
 	int xMax = min(World.Width,  x1 + CHUNK_SIZE);
 	int yMax = min(World.Height, y1 + CHUNK_SIZE);
 	int zMax = min(World.Length, z1 + CHUNK_SIZE);
@@ -174,70 +189,70 @@ static void PrepareChunk(int x1, int y1, int z1) {
 			cIndex = Builder_PackChunk(0, yy, zz);
 
 			for (x = x1, xx = 0; x < xMax; x++, xx++, cIndex++) {
-				b = Builder_Chunk[cIndex];
+				b = ctx->chunk[cIndex];
 				if (Blocks.Draw[b] == DRAW_GAS) continue;
 				index = Builder_PackCount(xx, yy, zz);
 
 				/* Sprites can't be stretched, nor can then be they hidden by other blocks. */
 				/* Note sprites are drawn using DrawSprite and not with any of the DrawXFace. */
-				if (Blocks.Draw[b] == DRAW_SPRITE) { AddSpriteVertices(b); continue; }
+				if (Blocks.Draw[b] == DRAW_SPRITE) { AddSpriteVertices(ctx, b); continue; }
 
-				Builder_X = x; Builder_Y = y; Builder_Z = z;
-				Builder_FullBright = Blocks.Brightness[b];
+				ctx->x = x; ctx->y = y; ctx->z = z;
+				ctx->fullBright = Blocks.Brightness[b];
 				tileIdx = b * BLOCK_COUNT;
 				/* All of these function calls are inlined as they can be called tens of millions to hundreds of millions of times. */
 
-				if (Builder_Counts[index] == 0 ||
+				if (ctx->counts[index] == 0 ||
 					(x == 0 && (y < Builder_SidesLevel || (b >= BLOCK_WATER && b <= BLOCK_STILL_LAVA && y < Builder_EdgeLevel))) ||
-					(x != 0 && (Blocks.Hidden[tileIdx + Builder_Chunk[cIndex - 1]] & FACE_BIT_XMIN) != 0)) {
-					Builder_Counts[index] = 0;
+					(x != 0 && (Blocks.Hidden[tileIdx + ctx->chunk[cIndex - 1]] & FACE_BIT_XMIN) != 0)) {
+					ctx->counts[index] = 0;
 				} else {
-					Builder_Counts[index] = Builder_StretchZ(index, x, y, z, cIndex, b, FACE_XMIN);
+					ctx->counts[index] = Builder_StretchZ(ctx, index, x, y, z, cIndex, b, FACE_XMIN);
 				}
 
 				index++;
-				if (Builder_Counts[index] == 0 ||
+				if (ctx->counts[index] == 0 ||
 					(x == World.MaxX && (y < Builder_SidesLevel || (b >= BLOCK_WATER && b <= BLOCK_STILL_LAVA && y < Builder_EdgeLevel))) ||
-					(x != World.MaxX && (Blocks.Hidden[tileIdx + Builder_Chunk[cIndex + 1]] & FACE_BIT_XMAX) != 0)) {
-					Builder_Counts[index] = 0;
+					(x != World.MaxX && (Blocks.Hidden[tileIdx + ctx->chunk[cIndex + 1]] & FACE_BIT_XMAX) != 0)) {
+					ctx->counts[index] = 0;
 				} else {
-					Builder_Counts[index] = Builder_StretchZ(index, x, y, z, cIndex, b, FACE_XMAX);
+					ctx->counts[index] = Builder_StretchZ(ctx, index, x, y, z, cIndex, b, FACE_XMAX);
 				}
 
 				index++;
-				if (Builder_Counts[index] == 0 ||
+				if (ctx->counts[index] == 0 ||
 					(z == 0 && (y < Builder_SidesLevel || (b >= BLOCK_WATER && b <= BLOCK_STILL_LAVA && y < Builder_EdgeLevel))) ||
-					(z != 0 && (Blocks.Hidden[tileIdx + Builder_Chunk[cIndex - EXTCHUNK_SIZE]] & FACE_BIT_ZMIN) != 0)) {
-					Builder_Counts[index] = 0;
+					(z != 0 && (Blocks.Hidden[tileIdx + ctx->chunk[cIndex - EXTCHUNK_SIZE]] & FACE_BIT_ZMIN) != 0)) {
+					ctx->counts[index] = 0;
 				} else {
-					Builder_Counts[index] = Builder_StretchX(index, x, y, z, cIndex, b, FACE_ZMIN);
+					ctx->counts[index] = Builder_StretchX(ctx, index, x, y, z, cIndex, b, FACE_ZMIN);
 				}
 
 				index++;
-				if (Builder_Counts[index] == 0 ||
+				if (ctx->counts[index] == 0 ||
 					(z == World.MaxZ && (y < Builder_SidesLevel || (b >= BLOCK_WATER && b <= BLOCK_STILL_LAVA && y < Builder_EdgeLevel))) ||
-					(z != World.MaxZ && (Blocks.Hidden[tileIdx + Builder_Chunk[cIndex + EXTCHUNK_SIZE]] & FACE_BIT_ZMAX) != 0)) {
-					Builder_Counts[index] = 0;
+					(z != World.MaxZ && (Blocks.Hidden[tileIdx + ctx->chunk[cIndex + EXTCHUNK_SIZE]] & FACE_BIT_ZMAX) != 0)) {
+					ctx->counts[index] = 0;
 				} else {
-					Builder_Counts[index] = Builder_StretchX(index, x, y, z, cIndex, b, FACE_ZMAX);
+					ctx->counts[index] = Builder_StretchX(ctx, index, x, y, z, cIndex, b, FACE_ZMAX);
 				}
 
 				index++;
-				if (Builder_Counts[index] == 0 || y == 0 ||
-					(Blocks.Hidden[tileIdx + Builder_Chunk[cIndex - EXTCHUNK_SIZE_2]] & FACE_BIT_YMIN) != 0) {
-					Builder_Counts[index] = 0;
+				if (ctx->counts[index] == 0 || y == 0 ||
+					(Blocks.Hidden[tileIdx + ctx->chunk[cIndex - EXTCHUNK_SIZE_2]] & FACE_BIT_YMIN) != 0) {
+					ctx->counts[index] = 0;
 				} else {
-					Builder_Counts[index] = Builder_StretchX(index, x, y, z, cIndex, b, FACE_YMIN);
+					ctx->counts[index] = Builder_StretchX(ctx, index, x, y, z, cIndex, b, FACE_YMIN);
 				}
 
 				index++;
-				if (Builder_Counts[index] == 0 ||
-					(Blocks.Hidden[tileIdx + Builder_Chunk[cIndex + EXTCHUNK_SIZE_2]] & FACE_BIT_YMAX) != 0) {
-					Builder_Counts[index] = 0;
+				if (ctx->counts[index] == 0 ||
+					(Blocks.Hidden[tileIdx + ctx->chunk[cIndex + EXTCHUNK_SIZE_2]] & FACE_BIT_YMAX) != 0) {
+					ctx->counts[index] = 0;
 				} else if (b < BLOCK_WATER || b > BLOCK_STILL_LAVA) {
-					Builder_Counts[index] = Builder_StretchX(index, x, y, z, cIndex, b, FACE_YMAX);
+					ctx->counts[index] = Builder_StretchX(ctx, index, x, y, z, cIndex, b, FACE_YMAX);
 				} else {
-					Builder_Counts[index] = Builder_StretchXLiquid(index, x, y, z, cIndex, b);
+					ctx->counts[index] = Builder_StretchXLiquid(ctx, index, x, y, z, cIndex, b);
 				}
 			}
 		}
@@ -256,12 +271,12 @@ for (yy = -1; yy < 17; ++yy) {\
 			block    = get_block;\
 			allAir   = allAir   && Blocks.Draw[block] == DRAW_GAS;\
 			allSolid = allSolid && Blocks.FullOpaque[block];\
-			Builder_Chunk[cIndex] = block;\
+			ctx->chunk[cIndex] = block;\
 		}\
 	}\
 }
 
-static cc_bool ReadChunkData(int x1, int y1, int z1, cc_bool* outAllAir) {
+static cc_bool ReadChunkData(struct BuilderContext* ctx, int x1, int y1, int z1, cc_bool* outAllAir) {
 	BlockRaw* blocks = World.Blocks;
 	BlockRaw* blocks2;
 	cc_bool allAir = true, allSolid = true;
@@ -305,12 +320,12 @@ for (yy = -1; yy < 17; ++yy) {\
 \
 			block  = get_block;\
 			allAir = allAir && Blocks.Draw[block] == DRAW_GAS;\
-			Builder_Chunk[cIndex] = block;\
+			ctx->chunk[cIndex] = block;\
 		}\
 	}\
 }
 
-static cc_bool ReadBorderChunkData(int x1, int y1, int z1, cc_bool* outAllAir) {
+static cc_bool ReadBorderChunkData(struct BuilderContext* ctx, int x1, int y1, int z1, cc_bool* outAllAir) {
 	BlockRaw* blocks = World.Blocks;
 	BlockRaw* blocks2;
 	cc_bool allAir = true;
@@ -333,7 +348,7 @@ static cc_bool ReadBorderChunkData(int x1, int y1, int z1, cc_bool* outAllAir) {
 	return false;
 }
 
-static void OutputChunkPartsMeta(int x, int y, int z, struct ChunkInfo* info) {
+static void OutputChunkPartsMeta(struct BuilderContext* ctx, int x, int y, int z, struct ChunkInfo* info) {
 	cc_bool hasNorm, hasTran;
 	int partsIndex;
 	int i, j, curIdx, offset;
@@ -347,8 +362,8 @@ static void OutputChunkPartsMeta(int x, int y, int z, struct ChunkInfo* info) {
 		j = i + ATLAS1D_MAX_ATLASES;
 		curIdx = partsIndex + i * World.ChunksCount;
 
-		hasNorm |= SetPartInfo(&Builder_Parts[i], &offset, &MapRenderer_PartsNormal[curIdx]);
-		hasTran |= SetPartInfo(&Builder_Parts[j], &offset, &MapRenderer_PartsTranslucent[curIdx]);
+		hasNorm |= SetPartInfo(&ctx->parts[i], &offset, &MapRenderer_PartsNormal[curIdx]);
+		hasTran |= SetPartInfo(&ctx->parts[j], &offset, &MapRenderer_PartsTranslucent[curIdx]);
 	}
 
 	if (hasNorm) {
@@ -359,28 +374,11 @@ static void OutputChunkPartsMeta(int x, int y, int z, struct ChunkInfo* info) {
 	}
 }
 
-void Builder_MakeChunk(struct ChunkInfo* info) {
-#ifdef CC_BUILD_TINYSTACK
-	/* The Saturn build only has 16 kb stack, not large enough */
-	static BlockID chunk[EXTCHUNK_SIZE_3]; 
-	static cc_uint8 counts[CHUNK_SIZE_3 * FACE_COUNT]; 
-	static int bitFlags[1];
-#else
-	BlockID chunk[EXTCHUNK_SIZE_3]; 
-	cc_uint8 counts[CHUNK_SIZE_3 * FACE_COUNT]; 
-	int bitFlags[EXTCHUNK_SIZE_3];
-#endif
-
+/* Reads the blocks in and around the given chunk into ctx->chunk */
+/* Returns whether the chunk does not need a mesh (i.e. it is entirely air or entirely solid) */
+static cc_bool Builder_ReadChunk(struct BuilderContext* ctx, struct ChunkInfo* info) {
 	cc_bool allAir, allSolid, onBorder;
-	int xMax, yMax, zMax, totalVerts;
-	int cIndex, index;
-	int x, y, z, xx, yy, zz;
 	int x1 = info->centreX - 8, y1 = info->centreY - 8, z1 = info->centreZ - 8;
-
-	Builder_Chunk  = chunk;
-	Builder_Counts = counts;
-	Builder_BitFlags = bitFlags;
-	Builder_PrePrepareChunk();
 	
 	onBorder = 
 		x1 == 0 || y1 == 0 || z1 == 0   || x1 + CHUNK_SIZE >= World.Width ||
@@ -388,103 +386,266 @@ void Builder_MakeChunk(struct ChunkInfo* info) {
 
 	if (onBorder) {
 		/* less optimal case here */
-		Mem_Set(chunk, BLOCK_AIR, EXTCHUNK_SIZE_3 * sizeof(BlockID));
-		allSolid = ReadBorderChunkData(x1, y1, z1, &allAir);
+		Mem_Set(ctx->chunk, BLOCK_AIR, EXTCHUNK_SIZE_3 * sizeof(BlockID));
+		allSolid = ReadBorderChunkData(ctx, x1, y1, z1, &allAir);
 	} else {
-		allSolid = ReadChunkData(x1, y1, z1, &allAir);
+		allSolid = ReadChunkData(ctx, x1, y1, z1, &allAir);
 	}
 
 	info->allAir = allAir;
-	if (allAir || allSolid) return;
-	Lighting.LightHint(x1 - 1, y1 - 1, z1 - 1);
+	return allAir || allSolid;
+}
 
-	Mem_Set(counts, 1, CHUNK_SIZE_3 * FACE_COUNT);
-	xMax = min(World.Width,  x1 + CHUNK_SIZE);
-	yMax = min(World.Height, y1 + CHUNK_SIZE);
-	zMax = min(World.Length, z1 + CHUNK_SIZE);
+/* Reads the blocks in and around the given chunk, then counts how many vertices its mesh requires */
+/* Returns 0 if the chunk does not need a mesh (e.g. it is entirely air or entirely solid) */
+static int Builder_CountChunk(struct BuilderContext* ctx, struct ChunkInfo* info, cc_bool lightHint) {
+	int x1 = info->centreX - 8, y1 = info->centreY - 8, z1 = info->centreZ - 8;
+	Builder_PrePrepareChunk(ctx);
 
-	Builder_ChunkEndX = xMax; Builder_ChunkEndZ = zMax;
-	PrepareChunk(x1, y1, z1);
+	if (Builder_ReadChunk(ctx, info)) return 0;
+	if (lightHint) Lighting.LightHint(x1 - 1, y1 - 1, z1 - 1);
 
-	totalVerts = Builder_TotalVerticesCount();
-	if (!totalVerts) return;
-	
-	OutputChunkPartsMeta(x1, y1, z1, info);
+	Mem_Set(ctx->counts, 1, CHUNK_SIZE_3 * FACE_COUNT);
+	ctx->chunkEndX = min(World.Width,  x1 + CHUNK_SIZE);
+	ctx->chunkEndZ = min(World.Length, z1 + CHUNK_SIZE);
+	PrepareChunk(ctx, x1, y1, z1);
+
+	return Builder_TotalVerticesCount(ctx);
+}
+
+/* Renders the vertices of all the visible blocks in the given chunk into ctx->vertices */
+static void Builder_RenderChunk(struct BuilderContext* ctx, struct ChunkInfo* info) {
+	int x1 = info->centreX - 8, y1 = info->centreY - 8, z1 = info->centreZ - 8;
+	int xMax = ctx->chunkEndX, zMax = ctx->chunkEndZ;
+	int yMax = min(World.Height, y1 + CHUNK_SIZE);
+	int cIndex, index;
+	int x, y, z, xx, yy, zz;
+
+	OutputChunkPartsMeta(ctx, x1, y1, z1, info);
 #ifdef OCCLUSION
 	if (info.NormalParts != null || info.TranslucentParts != null)
 		info.occlusionFlags = (cc_uint8)ComputeOcclusion();
 #endif
-
-#ifndef CC_BUILD_GL11
-	/* add an extra element to fix crashing on some GPUs */
-	Builder_Vertices = (struct VertexTextured*)Gfx_RecreateAndLockVb(&info->vb,
-													VERTEX_FORMAT_TEXTURED, totalVerts + 1);
-#else
-	/* NOTE: Relies on assumption vb is ignored by GL11 Gfx_LockVb implementation */
-	Builder_Vertices = (struct VertexTextured*)Gfx_LockVb(0, 
-													VERTEX_FORMAT_TEXTURED, totalVerts + 1);
-#endif
-	Builder_PostPrepareChunk();
-	/* now render the chunk */
+	Builder_PostPrepareChunk(ctx);
 
 	for (y = y1, yy = 0; y < yMax; y++, yy++) {
 		for (z = z1, zz = 0; z < zMax; z++, zz++) {
 			cIndex = Builder_PackChunk(0, yy, zz);
 
 			for (x = x1, xx = 0; x < xMax; x++, xx++, cIndex++) {
-				Builder_Block = chunk[cIndex];
-				if (Blocks.Draw[Builder_Block] == DRAW_GAS) continue;
+				ctx->block = ctx->chunk[cIndex];
+				if (Blocks.Draw[ctx->block] == DRAW_GAS) continue;
 
 				index = Builder_PackCount(xx, yy, zz);
-				Builder_ChunkIndex = cIndex;
-				Builder_RenderBlock(index, x, y, z);
+				ctx->chunkIndex = cIndex;
+				Builder_RenderBlock(ctx, index, x, y, z);
 			}
 		}
 	}
+}
 
 #ifdef CC_BUILD_GL11
+static void Builder_BuildChunkVbs(struct BuilderContext* ctx, struct ChunkInfo* info) {
+	int x1 = info->centreX - 8, y1 = info->centreY - 8, z1 = info->centreZ - 8;
+	int i, curIdx, cIndex;
 	cIndex = World_ChunkPack(x1 >> CHUNK_SHIFT, y1 >> CHUNK_SHIFT, z1 >> CHUNK_SHIFT);
 
-	for (index = 0; index < MapRenderer_1DUsedCount; index++) {
-		int curIdx = cIndex + index * World.ChunksCount;
+	for (i = 0; i < MapRenderer_1DUsedCount; i++) {
+		curIdx = cIndex + i * World.ChunksCount;
+
+		BuildPartVbs(ctx, &MapRenderer_PartsNormal[curIdx]);
+		BuildPartVbs(ctx, &MapRenderer_PartsTranslucent[curIdx]);
+	}
+}
+#endif
+
+void Builder_MakeChunk(struct ChunkInfo* info) {
+	/* Context is quite large, so avoid putting it on the stack */
+	static struct BuilderContext context;
+	struct BuilderContext* ctx = &context;
+#ifdef CC_BUILD_TINYSTACK
+	/* The Saturn build only has 16 kb stack, not large enough */
+	static BlockID chunk[EXTCHUNK_SIZE_3]; 
+	static cc_uint8 counts[CHUNK_SIZE_3 * FACE_COUNT]; 
+	static int bitFlags[1];
+#else
+	BlockID chunk[EXTCHUNK_SIZE_3]; 
+	cc_uint8 counts[CHUNK_SIZE_3 * FACE_COUNT]; 
+	int bitFlags[EXTCHUNK_SIZE_3];
+#endif
+	int totalVerts;
+
+	ctx->chunk    = chunk;
+	ctx->counts   = counts;
+	ctx->bitFlags = bitFlags;
+
+	totalVerts = Builder_CountChunk(ctx, info, true);
+	if (!totalVerts) return;
+
+#ifndef CC_BUILD_GL11
+	/* add an extra element to fix crashing on some GPUs */
+	ctx->vertices = (struct VertexTextured*)Gfx_RecreateAndLockVb(&info->vb,
+													VERTEX_FORMAT_TEXTURED, totalVerts + 1);
+#else
+	/* NOTE: Relies on assumption vb is ignored by GL11 Gfx_LockVb implementation */
+	ctx->vertices = (struct VertexTextured*)Gfx_LockVb(0, 
+													VERTEX_FORMAT_TEXTURED, totalVerts + 1);
+#endif
+	/* now render the chunk */
+	Builder_RenderChunk(ctx, info);
+
+#ifdef CC_BUILD_GL11
+	Builder_BuildChunkVbs(ctx, info);
+#else
+	Gfx_UnlockVb(info->vb);
+#endif
+}
+
+
+/*########################################################################################################################*
+*---------------------------------------------------Parallel chunk building-----------------------------------------------*
+*#########################################################################################################################*/
+struct BuilderJob {
+	struct ChunkInfo* info;
+	/* Vertices of the chunk's mesh (NULL if chunk has no mesh) */
+	struct VertexTextured* vertices;
+	int totalVerts;
+	/* Whether lighting must be calculated before building this chunk's mesh */
+	cc_bool needsLight;
+};
+static struct BuilderJob* builder_jobs;
+static int builder_jobsCapacity;
+
+/* Determines whether the given chunk could possibly need a mesh, without calculating any lighting */
+static void Builder_CheckJob(void* obj, int index) {
+	struct BuilderJob* job = &builder_jobs[index];
+	struct BuilderContext ctx;
+	BlockID chunk[EXTCHUNK_SIZE_3];
+
+	ctx.chunk = chunk;
+	job->needsLight = !Builder_ReadChunk(&ctx, job->info);
+}
+
+/* Builds the mesh of the given chunk into a CPU side array of vertices */
+static void Builder_BuildJob(void* obj, int index) {
+	struct BuilderJob* job = &builder_jobs[index];
+	struct BuilderContext ctx;
+	BlockID chunk[EXTCHUNK_SIZE_3]; 
+	cc_uint8 counts[CHUNK_SIZE_3 * FACE_COUNT]; 
+	int bitFlags[EXTCHUNK_SIZE_3];
+
+	ctx.chunk    = chunk;
+	ctx.counts   = counts;
+	ctx.bitFlags = bitFlags;
+
+	job->vertices   = NULL;
+	job->totalVerts = Builder_CountChunk(&ctx, job->info, false);
+	if (!job->totalVerts) return;
+
+	/* add an extra element to fix crashing on some GPUs */
+	ctx.vertices = (struct VertexTextured*)Mem_TryAlloc(job->totalVerts + 1, sizeof(struct VertexTextured));
+	if (!ctx.vertices) return;
+
+	Builder_RenderChunk(&ctx, job->info);
+	job->vertices = ctx.vertices;
+}
+
+/* Calculates the lighting that building the given chunk's mesh may lazily calculate */
+static void Builder_PrepareLighting(struct ChunkInfo* info) {
+	int x1 = info->centreX - 8, y1 = info->centreY - 8, z1 = info->centreZ - 8;
+	int x, y, z;
+	Lighting.LightHint(x1 - 1, y1 - 1, z1 - 1);
+	if (Lighting_Mode == LIGHTING_MODE_CLASSIC) return;
 
-		BuildPartVbs(&MapRenderer_PartsNormal[curIdx]);
-		BuildPartVbs(&MapRenderer_PartsTranslucent[curIdx]);
+	/* Fancy lighting calculates light for neighbouring chunks on demand too */
+	for (y = y1 - CHUNK_SIZE; y <= y1 + CHUNK_SIZE; y += CHUNK_SIZE)
+		for (z = z1 - CHUNK_SIZE; z <= z1 + CHUNK_SIZE; z += CHUNK_SIZE)
+			for (x = x1 - CHUNK_SIZE; x <= x1 + CHUNK_SIZE; x += CHUNK_SIZE)
+	{
+		if (!World_Contains(x, y, z)) continue;
+		Lighting.LightHint(x - 1, y - 1, z - 1);
 	}
+}
+
+/* Uploads the vertices of the given chunk's mesh to the GPU */
+static void Builder_UploadJob(struct BuilderJob* job) {
+	struct ChunkInfo* info = job->info;
+#ifndef CC_BUILD_GL11
+	int size = (job->totalVerts + 1) * sizeof(struct VertexTextured);
+	void* data;
 #else
+	struct BuilderContext ctx;
+#endif
+
+	/* Out of memory, so fallback to building on the main thread */
+	if (!job->vertices) { Builder_MakeChunk(info); return; }
+
+#ifndef CC_BUILD_GL11
+	data = Gfx_RecreateAndLockVb(&info->vb, VERTEX_FORMAT_TEXTURED, job->totalVerts + 1);
+	Mem_Copy(data, job->vertices, size);
 	Gfx_UnlockVb(info->vb);
+#else
+	ctx.vertices = job->vertices;
+	Builder_BuildChunkVbs(&ctx, info);
 #endif
+	Mem_Free(job->vertices);
 }
 
-static cc_bool Builder_OccludedLiquid(int chunkIndex) {
+void Builder_MakeChunks(struct ChunkInfo** infos, int count) {
+	int i;
+	if (count <= 1 || WorkerPool_Threads() <= 1) {
+		for (i = 0; i < count; i++) Builder_MakeChunk(infos[i]);
+		return;
+	}
+
+	if (count > builder_jobsCapacity) {
+		Mem_Free(builder_jobs);
+		builder_jobs = (struct BuilderJob*)Mem_Alloc(count, sizeof(struct BuilderJob), "chunk build jobs");
+		builder_jobsCapacity = count;
+	}
+	for (i = 0; i < count; i++) builder_jobs[i].info = infos[i];
+
+	/* Lighting is lazily calculated and hence can't be calculated by multiple threads at once */
+	WorkerPool_Run(Builder_CheckJob, NULL, count);
+	for (i = 0; i < count; i++) {
+		if (builder_jobs[i].needsLight) Builder_PrepareLighting(infos[i]);
+	}
+
+	WorkerPool_Run(Builder_BuildJob, NULL, count);
+	for (i = 0; i < count; i++) {
+		if (builder_jobs[i].totalVerts) Builder_UploadJob(&builder_jobs[i]);
+	}
+}
+
+static cc_bool Builder_OccludedLiquid(struct BuilderContext* ctx, int chunkIndex) {
 	chunkIndex += EXTCHUNK_SIZE_2; /* Checking y above */
 	return
-		Blocks.FullOpaque[Builder_Chunk[chunkIndex]]
-		&& Blocks.Draw[Builder_Chunk[chunkIndex - EXTCHUNK_SIZE]] != DRAW_GAS
-		&& Blocks.Draw[Builder_Chunk[chunkIndex - 1]] != DRAW_GAS
-		&& Blocks.Draw[Builder_Chunk[chunkIndex + 1]] != DRAW_GAS
-		&& Blocks.Draw[Builder_Chunk[chunkIndex + EXTCHUNK_SIZE]] != DRAW_GAS;
+		Blocks.FullOpaque[ctx->chunk[chunkIndex]]
+		&& Blocks.Draw[ctx->chunk[chunkIndex - EXTCHUNK_SIZE]] != DRAW_GAS
+		&& Blocks.Draw[ctx->chunk[chunkIndex - 1]] != DRAW_GAS
+		&& Blocks.Draw[ctx->chunk[chunkIndex + 1]] != DRAW_GAS
+		&& Blocks.Draw[ctx->chunk[chunkIndex + EXTCHUNK_SIZE]] != DRAW_GAS;
 }
 
-static void DefaultPrePrepateChunk(void) {
-	Mem_Set(Builder_Parts, 0, sizeof(Builder_Parts));
+static void DefaultPrePrepateChunk(struct BuilderContext* ctx) {
+	Mem_Set(ctx->parts, 0, sizeof(ctx->parts));
 }
 
-static void DefaultPostStretchChunk(void) {
+static void DefaultPostStretchChunk(struct BuilderContext* ctx) {
 	int i, j, offset;
 	offset = 0;
 	for (i = 0; i < ATLAS1D_MAX_ATLASES; i++) {
 		j = i + ATLAS1D_MAX_ATLASES;
 
-		offset = Builder1DPart_CalcOffsets(&Builder_Parts[i], offset);
-		offset = Builder1DPart_CalcOffsets(&Builder_Parts[j], offset);
+		offset = Builder1DPart_CalcOffsets(ctx, &ctx->parts[i], offset);
+		offset = Builder1DPart_CalcOffsets(ctx, &ctx->parts[j], offset);
 	}
 }
 
-static RNGState spriteRng;
-static void Builder_DrawSprite(int x, int y, int z) {
+static void Builder_DrawSprite(struct BuilderContext* ctx, int x, int y, int z) {
 	struct Builder1DPart* part;
 	struct VertexTextured* v;
+	RNGState spriteRng;
 	cc_uint8 offsetType;
 	cc_bool bright;
 	PackedCol color;
@@ -501,11 +662,11 @@ static void Builder_DrawSprite(int x, int y, int z) {
 
 #define s_u1 0.0f
 #define s_u2 UV2_Scale
-	loc = Block_Tex(Builder_Block, FACE_XMAX);
+	loc = Block_Tex(ctx->block, FACE_XMAX);
 	v1  = Atlas1D_RowId(loc) * Atlas1D.InvTileSize;
 	v2  = v1 + Atlas1D.InvTileSize * UV2_Scale;
 
-	offsetType = Blocks.SpriteOffset[Builder_Block];
+	offsetType = Blocks.SpriteOffset[ctx->block];
 	if (offsetType >= 6 && offsetType <= 7) {
 		Random_Seed(&spriteRng, (x + 1217 * z) & 0x7fffffff);
 		valX = Random_Range(&spriteRng, -3, 3 + 1) / 16.0f;
@@ -517,13 +678,13 @@ static void Builder_DrawSprite(int x, int y, int z) {
 		if (offsetType == 7) { y1 -= valY; y2 -= valY; }
 	}
 	
-	bright = Blocks.Brightness[Builder_Block];
-	part   = &Builder_Parts[Atlas1D_Index(loc)];
+	bright = Blocks.Brightness[ctx->block];
+	part   = &ctx->parts[Atlas1D_Index(loc)];
 	color  = bright ? PACKEDCOL_WHITE : Lighting.Color_Sprite_Fast(x, y, z);
-	Block_Tint(color, Builder_Block);
+	Block_Tint(color, ctx->block);
 
 	/* Draw Z axis */
-	v = &Builder_Vertices[part->sOffset];
+	v = &ctx->vertices[part->sOffset];
 	v->x = x1; v->y = y1; v->z = z1; v->Col = color; v->U = s_u2; v->V = v2; v++;
 	v->x = x1; v->y = y2; v->z = z1; v->Col = color; v->U = s_u2; v->V = v1; v++;
 	v->x = x2; v->y = y2; v->z = z2; v->Col = color; v->U = s_u1; v->V = v1; v++;
@@ -578,72 +739,72 @@ static PackedCol Normal_LightColor(int x, int y, int z, Face face, BlockID block
 	return 0; /* should never happen */
 }
 
-static cc_bool Normal_CanStretch(BlockID initial, int chunkIndex, int x, int y, int z, Face face) {
-	BlockID cur = Builder_Chunk[chunkIndex];
+static cc_bool Normal_CanStretch(struct BuilderContext* ctx, BlockID initial, int chunkIndex, int x, int y, int z, Face face) {
+	BlockID cur = ctx->chunk[chunkIndex];
 
-	if (cur != initial || Block_IsFaceHidden(cur, Builder_Chunk[chunkIndex + Builder_Offsets[face]], face)) return false;
-	if (Builder_FullBright) return true;
+	if (cur != initial || Block_IsFaceHidden(cur, ctx->chunk[chunkIndex + Builder_Offsets[face]], face)) return false;
+	if (ctx->fullBright) return true;
 
-	return Normal_LightColor(Builder_X, Builder_Y, Builder_Z, face, initial) == Normal_LightColor(x, y, z, face, cur);
+	return Normal_LightColor(ctx->x, ctx->y, ctx->z, face, initial) == Normal_LightColor(x, y, z, face, cur);
 }
 
-static int NormalBuilder_StretchXLiquid(int countIndex, int x, int y, int z, int chunkIndex, BlockID block) {
+static int NormalBuilder_StretchXLiquid(struct BuilderContext* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block) {
 	int count = 1; cc_bool stretchTile;
-	if (Builder_OccludedLiquid(chunkIndex)) return 0;
+	if (Builder_OccludedLiquid(ctx, chunkIndex)) return 0;
 	
 	x++;
 	chunkIndex++;
 	countIndex += FACE_COUNT;
 	stretchTile = (Blocks.CanStretch[block] & (1 << FACE_YMAX)) != 0;
 
-	while (x < Builder_ChunkEndX && stretchTile && Normal_CanStretch(block, chunkIndex, x, y, z, FACE_YMAX) && !Builder_OccludedLiquid(chunkIndex)) {
-		Builder_Counts[countIndex] = 0;
+	while (x < ctx->chunkEndX && stretchTile && Normal_CanStretch(ctx, block, chunkIndex, x, y, z, FACE_YMAX) && !Builder_OccludedLiquid(ctx, chunkIndex)) {
+		ctx->counts[countIndex] = 0;
 		count++;
 		x++;
 		chunkIndex++;
 		countIndex += FACE_COUNT;
 	}
-	AddVertices(block, FACE_YMAX);
+	AddVertices(ctx, block, FACE_YMAX);
 	return count;
 }
 
-static int NormalBuilder_StretchX(int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
+static int NormalBuilder_StretchX(struct BuilderContext* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
 	int count = 1; cc_bool stretchTile;
 	x++;
 	chunkIndex++;
 	countIndex += FACE_COUNT;
 	stretchTile = (Blocks.CanStretch[block] & (1 << face)) != 0;
 
-	while (x < Builder_ChunkEndX && stretchTile && Normal_CanStretch(block, chunkIndex, x, y, z, face)) {
-		Builder_Counts[countIndex] = 0;
+	while (x < ctx->chunkEndX && stretchTile && Normal_CanStretch(ctx, block, chunkIndex, x, y, z, face)) {
+		ctx->counts[countIndex] = 0;
 		count++;
 		x++;
 		chunkIndex++;
 		countIndex += FACE_COUNT;
 	}
-	AddVertices(block, face);
+	AddVertices(ctx, block, face);
 	return count;
 }
 
-static int NormalBuilder_StretchZ(int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
+static int NormalBuilder_StretchZ(struct BuilderContext* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
 	int count = 1; cc_bool stretchTile;
 	z++;
 	chunkIndex += EXTCHUNK_SIZE;
 	countIndex += CHUNK_SIZE * FACE_COUNT;
 	stretchTile = (Blocks.CanStretch[block] & (1 << face)) != 0;
 
-	while (z < Builder_ChunkEndZ && stretchTile && Normal_CanStretch(block, chunkIndex, x, y, z, face)) {
-		Builder_Counts[countIndex] = 0;
+	while (z < ctx->chunkEndZ && stretchTile && Normal_CanStretch(ctx, block, chunkIndex, x, y, z, face)) {
+		ctx->counts[countIndex] = 0;
 		count++;
 		z++;
 		chunkIndex += EXTCHUNK_SIZE;
 		countIndex += CHUNK_SIZE * FACE_COUNT;
 	}
-	AddVertices(block, face);
+	AddVertices(ctx, block, face);
 	return count;
 }
 
-static void NormalBuilder_RenderBlock(int index, int x, int y, int z) {	
+static void NormalBuilder_RenderBlock(struct BuilderContext* ctx, int index, int x, int y, int z) {	
 	/* counters */
 	int count_XMin, count_XMax, count_ZMin;
 	int count_ZMax, count_YMin, count_YMax;
@@ -659,90 +820,90 @@ static void NormalBuilder_RenderBlock(int index, int x, int y, int z) {
 	PackedCol col;
 	int offset;
 
-	if (Blocks.Draw[Builder_Block] == DRAW_SPRITE) {
-		Builder_DrawSprite(x, y, z); return;
+	if (Blocks.Draw[ctx->block] == DRAW_SPRITE) {
+		Builder_DrawSprite(ctx, x, y, z); return;
 	}
 
-	count_XMin = Builder_Counts[index + FACE_XMIN];
-	count_XMax = Builder_Counts[index + FACE_XMAX];
-	count_ZMin = Builder_Counts[index + FACE_ZMIN];
-	count_ZMax = Builder_Counts[index + FACE_ZMAX];
-	count_YMin = Builder_Counts[index + FACE_YMIN];
-	count_YMax = Builder_Counts[index + FACE_YMAX];
+	count_XMin = ctx->counts[index + FACE_XMIN];
+	count_XMax = ctx->counts[index + FACE_XMAX];
+	count_ZMin = ctx->counts[index + FACE_ZMIN];
+	count_ZMax = ctx->counts[index + FACE_ZMAX];
+	count_YMin = ctx->counts[index + FACE_YMIN];
+	count_YMax = ctx->counts[index + FACE_YMAX];
 
 	if (!count_XMin && !count_XMax && !count_ZMin &&
 		!count_ZMax && !count_YMin && !count_YMax) return;
 
-	fullBright = Blocks.Brightness[Builder_Block];
-	baseOffset = (Blocks.Draw[Builder_Block] == DRAW_TRANSLUCENT) * ATLAS1D_MAX_ATLASES;
-	lightFlags = Blocks.LightOffset[Builder_Block];
+	fullBright = Blocks.Brightness[ctx->block];
+	baseOffset = (Blocks.Draw[ctx->block] == DRAW_TRANSLUCENT) * ATLAS1D_MAX_ATLASES;
+	lightFlags = Blocks.LightOffset[ctx->block];
 
-	Drawer.MinBB = Blocks.MinBB[Builder_Block]; Drawer.MinBB.y = 1.0f - Drawer.MinBB.y;
-	Drawer.MaxBB = Blocks.MaxBB[Builder_Block]; Drawer.MaxBB.y = 1.0f - Drawer.MaxBB.y;
+	ctx->drawer.MinBB = Blocks.MinBB[ctx->block]; ctx->drawer.MinBB.y = 1.0f - ctx->drawer.MinBB.y;
+	ctx->drawer.MaxBB = Blocks.MaxBB[ctx->block]; ctx->drawer.MaxBB.y = 1.0f - ctx->drawer.MaxBB.y;
 
-	min = Blocks.RenderMinBB[Builder_Block]; max = Blocks.RenderMaxBB[Builder_Block];
-	Drawer.X1 = x + min.x; Drawer.Y1 = y + min.y; Drawer.Z1 = z + min.z;
-	Drawer.X2 = x + max.x; Drawer.Y2 = y + max.y; Drawer.Z2 = z + max.z;
+	min = Blocks.RenderMinBB[ctx->block]; max = Blocks.RenderMaxBB[ctx->block];
+	ctx->drawer.X1 = x + min.x; ctx->drawer.Y1 = y + min.y; ctx->drawer.Z1 = z + min.z;
+	ctx->drawer.X2 = x + max.x; ctx->drawer.Y2 = y + max.y; ctx->drawer.Z2 = z + max.z;
 
-	Drawer.Tinted  = Blocks.Tinted[Builder_Block];
-	Drawer.TintCol = Blocks.FogCol[Builder_Block];
+	ctx->drawer.Tinted  = Blocks.Tinted[ctx->block];
+	ctx->drawer.TintCol = Blocks.FogCol[ctx->block];
 
 	if (count_XMin) {
-		loc    = Block_Tex(Builder_Block, FACE_XMIN);
+		loc    = Block_Tex(ctx->block, FACE_XMIN);
 		offset = (lightFlags >> FACE_XMIN) & 1;
-		part   = &Builder_Parts[baseOffset + Atlas1D_Index(loc)];
+		part   = &ctx->parts[baseOffset + Atlas1D_Index(loc)];
 
 		col = fullBright ? PACKEDCOL_WHITE :
 			x >= offset ? Lighting.Color_XSide_Fast(x - offset, y, z) : Env.SunXSide;
-		Drawer_XMin(count_XMin, col, loc, &part->faces.vertices[FACE_XMIN]);
+		Drawer_XMin2(&ctx->drawer, count_XMin, col, loc, &part->faces.vertices[FACE_XMIN]);
 	}
 
 	if (count_XMax) {
-		loc    = Block_Tex(Builder_Block, FACE_XMAX);
+		loc    = Block_Tex(ctx->block, FACE_XMAX);
 		offset = (lightFlags >> FACE_XMAX) & 1;
-		part   = &Builder_Parts[baseOffset + Atlas1D_Index(loc)];
+		part   = &ctx->parts[baseOffset + Atlas1D_Index(loc)];
 
 		col = fullBright ? PACKEDCOL_WHITE :
 			x <= (World.MaxX - offset) ? Lighting.Color_XSide_Fast(x + offset, y, z) : Env.SunXSide;
-		Drawer_XMax(count_XMax, col, loc, &part->faces.vertices[FACE_XMAX]);
+		Drawer_XMax2(&ctx->drawer, count_XMax, col, loc, &part->faces.vertices[FACE_XMAX]);
 	}
 
 	if (count_ZMin) {
-		loc    = Block_Tex(Builder_Block, FACE_ZMIN);
+		loc    = Block_Tex(ctx->block, FACE_ZMIN);
 		offset = (lightFlags >> FACE_ZMIN) & 1;
-		part   = &Builder_Parts[baseOffset + Atlas1D_Index(loc)];
+		part   = &ctx->parts[baseOffset + Atlas1D_Index(loc)];
 
 		col = fullBright ? PACKEDCOL_WHITE :
 			z >= offset ? Lighting.Color_ZSide_Fast(x, y, z - offset) : Env.SunZSide;
-		Drawer_ZMin(count_ZMin, col, loc, &part->faces.vertices[FACE_ZMIN]);
+		Drawer_ZMin2(&ctx->drawer, count_ZMin, col, loc, &part->faces.vertices[FACE_ZMIN]);
 	}
 
 	if (count_ZMax) {
-		loc    = Block_Tex(Builder_Block, FACE_ZMAX);
+		loc    = Block_Tex(ctx->block, FACE_ZMAX);
 		offset = (lightFlags >> FACE_ZMAX) & 1;
-		part   = &Builder_Parts[baseOffset + Atlas1D_Index(loc)];
+		part   = &ctx->parts[baseOffset + Atlas1D_Index(loc)];
 
 		col = fullBright ? PACKEDCOL_WHITE :
 			z <= (World.MaxZ - offset) ? Lighting.Color_ZSide_Fast(x, y, z + offset) : Env.SunZSide;
-		Drawer_ZMax(count_ZMax, col, loc, &part->faces.vertices[FACE_ZMAX]);
+		Drawer_ZMax2(&ctx->drawer, count_ZMax, col, loc, &part->faces.vertices[FACE_ZMAX]);
 	}
 
 	if (count_YMin) {
-		loc    = Block_Tex(Builder_Block, FACE_YMIN);
+		loc    = Block_Tex(ctx->block, FACE_YMIN);
 		offset = (lightFlags >> FACE_YMIN) & 1;
-		part   = &Builder_Parts[baseOffset + Atlas1D_Index(loc)];
+		part   = &ctx->parts[baseOffset + Atlas1D_Index(loc)];
 
 		col = fullBright ? PACKEDCOL_WHITE : Lighting.Color_YMin_Fast(x, y - offset, z);
-		Drawer_YMin(count_YMin, col, loc, &part->faces.vertices[FACE_YMIN]);
+		Drawer_YMin2(&ctx->drawer, count_YMin, col, loc, &part->faces.vertices[FACE_YMIN]);
 	}
 
 	if (count_YMax) {
-		loc    = Block_Tex(Builder_Block, FACE_YMAX);
+		loc    = Block_Tex(ctx->block, FACE_YMAX);
 		offset = (lightFlags >> FACE_YMAX) & 1;
-		part   = &Builder_Parts[baseOffset + Atlas1D_Index(loc)];
+		part   = &ctx->parts[baseOffset + Atlas1D_Index(loc)];
 
 		col = fullBright ? PACKEDCOL_WHITE : Lighting.Color_YMax_Fast(x, y + offset, z);
-		Drawer_YMax(count_YMax, col, loc, &part->faces.vertices[FACE_YMAX]);
+		Drawer_YMax2(&ctx->drawer, count_YMax, col, loc, &part->faces.vertices[FACE_YMAX]);
 	}
 }
 
@@ -769,13 +930,6 @@ static void NormalBuilder_SetActive(void) {
 *-------------------------------------------------Advanced mesh builder---------------------------------------------------*
 *#########################################################################################################################*/
 #ifdef CC_BUILD_ADVLIGHTING
-static Vec3 adv_minBB, adv_maxBB;
-static int adv_initBitFlags, adv_baseOffset;
-static int* adv_bitFlags;
-static float adv_x1, adv_y1, adv_z1, adv_x2, adv_y2, adv_z2;
-static PackedCol adv_lerp[5], adv_lerpX[5], adv_lerpZ[5], adv_lerpY[5];
-static cc_bool adv_tinted;
-
 enum ADV_MASK {
 	/* z-1 cube points */
 	xM1_yM1_zM1, xM1_yCC_zM1, xM1_yP1_zM1,
@@ -799,7 +953,7 @@ enum ADV_MASK {
 /* - bit 0 set: Y-1 is in light */
 /* - bit 1 set: Y   is in light */
 /* - bit 2 set: Y+1 is in light */
-static int Adv_Lit(int x, int y, int z, int cIndex) {
+static int Adv_Lit(struct BuilderContext* ctx, int x, int y, int z, int cIndex) {
 	int flags, offset, lightFlags;
 	BlockID block;
 	if (y < 0 || y >= World.Height) return LIT_M1 | LIT_CC | LIT_P1; /* all faces lit */
@@ -810,7 +964,7 @@ static int Adv_Lit(int x, int y, int z, int cIndex) {
 	}
 
 	flags = 0;
-	block = Builder_Chunk[cIndex];
+	block = ctx->chunk[cIndex];
 	lightFlags = Blocks.LightOffset[block];
 
 	/* TODO using LIGHT_FLAG_SHADES_FROM_BELOW is wrong here, */
@@ -828,26 +982,26 @@ static int Adv_Lit(int x, int y, int z, int cIndex) {
 	flags |= Lighting.IsLit_Fast(x, (y + 1) - offset, z) ? LIT_P1 : 0;
 
 	/* If a block is fullbright, it should also look as if that spot is lit */
-	if (Blocks.Brightness[Builder_Chunk[cIndex - 324]]) flags |= LIT_M1;
+	if (Blocks.Brightness[ctx->chunk[cIndex - 324]]) flags |= LIT_M1;
 	if (Blocks.Brightness[block])                       flags |= LIT_CC;
-	if (Blocks.Brightness[Builder_Chunk[cIndex + 324]]) flags |= LIT_P1;
+	if (Blocks.Brightness[ctx->chunk[cIndex + 324]]) flags |= LIT_P1;
 	
 	return flags;
 }
 
-static int Adv_ComputeLightFlags(int x, int y, int z, int cIndex) {
-	if (Builder_FullBright) return (1 << xP1_yP1_zP1) - 1; /* all faces fully bright */
+static int Adv_ComputeLightFlags(struct BuilderContext* ctx, int x, int y, int z, int cIndex) {
+	if (ctx->fullBright) return (1 << xP1_yP1_zP1) - 1; /* all faces fully bright */
 
 	return
-		Adv_Lit(x - 1, y, z - 1, cIndex - 1 - 18) << xM1_yM1_zM1 |
-		Adv_Lit(x - 1, y, z,     cIndex - 1)      << xM1_yM1_zCC |
-		Adv_Lit(x - 1, y, z + 1, cIndex - 1 + 18) << xM1_yM1_zP1 |
-		Adv_Lit(x,     y, z - 1, cIndex + 0 - 18) << xCC_yM1_zM1 |
-		Adv_Lit(x,     y, z,     cIndex + 0)      << xCC_yM1_zCC |
-		Adv_Lit(x,     y, z + 1, cIndex + 0 + 18) << xCC_yM1_zP1 |
-		Adv_Lit(x + 1, y, z - 1, cIndex + 1 - 18) << xP1_yM1_zM1 |
-		Adv_Lit(x + 1, y, z,     cIndex + 1)      << xP1_yM1_zCC |
-		Adv_Lit(x + 1, y, z + 1, cIndex + 1 + 18) << xP1_yM1_zP1;
+		Adv_Lit(ctx, x - 1, y, z - 1, cIndex - 1 - 18) << xM1_yM1_zM1 |
+		Adv_Lit(ctx, x - 1, y, z,     cIndex - 1)      << xM1_yM1_zCC |
+		Adv_Lit(ctx, x - 1, y, z + 1, cIndex - 1 + 18) << xM1_yM1_zP1 |
+		Adv_Lit(ctx, x,     y, z - 1, cIndex + 0 - 18) << xCC_yM1_zM1 |
+		Adv_Lit(ctx, x,     y, z,     cIndex + 0)      << xCC_yM1_zCC |
+		Adv_Lit(ctx, x,     y, z + 1, cIndex + 0 + 18) << xCC_yM1_zP1 |
+		Adv_Lit(ctx, x + 1, y, z - 1, cIndex + 1 - 18) << xP1_yM1_zM1 |
+		Adv_Lit(ctx, x + 1, y, z,     cIndex + 1)      << xP1_yM1_zCC |
+		Adv_Lit(ctx, x + 1, y, z + 1, cIndex + 1 + 18) << xP1_yM1_zP1;
 }
 
 static int adv_masks[FACE_COUNT] = {
@@ -878,384 +1032,383 @@ static int adv_masks[FACE_COUNT] = {
 };
 
 
-static cc_bool Adv_CanStretch(BlockID initial, int chunkIndex, int x, int y, int z, Face face) {
-	BlockID cur = Builder_Chunk[chunkIndex];
-	adv_bitFlags[chunkIndex] = Adv_ComputeLightFlags(x, y, z, chunkIndex);
+static cc_bool Adv_CanStretch(struct BuilderContext* ctx, BlockID initial, int chunkIndex, int x, int y, int z, Face face) {
+	BlockID cur = ctx->chunk[chunkIndex];
+	ctx->bitFlags[chunkIndex] = Adv_ComputeLightFlags(ctx, x, y, z, chunkIndex);
 
 	return cur == initial
-		&& !Block_IsFaceHidden(cur, Builder_Chunk[chunkIndex + Builder_Offsets[face]], face)
-		&& (adv_initBitFlags == adv_bitFlags[chunkIndex]
+		&& !Block_IsFaceHidden(cur, ctx->chunk[chunkIndex + Builder_Offsets[face]], face)
+		&& (ctx->initBitFlags == ctx->bitFlags[chunkIndex]
 		/* Check that this face is either fully bright or fully in shadow */
-		&& (adv_initBitFlags == 0 || (adv_initBitFlags & adv_masks[face]) == adv_masks[face]));
+		&& (ctx->initBitFlags == 0 || (ctx->initBitFlags & adv_masks[face]) == adv_masks[face]));
 }
 
-static int Adv_StretchXLiquid(int countIndex, int x, int y, int z, int chunkIndex, BlockID block) {
+static int Adv_StretchXLiquid(struct BuilderContext* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block) {
 	int count = 1; cc_bool stretchTile;
-	if (Builder_OccludedLiquid(chunkIndex)) return 0;
-	adv_initBitFlags = Adv_ComputeLightFlags(x, y, z, chunkIndex);
-	adv_bitFlags[chunkIndex] = adv_initBitFlags;
+	if (Builder_OccludedLiquid(ctx, chunkIndex)) return 0;
+	ctx->initBitFlags = Adv_ComputeLightFlags(ctx, x, y, z, chunkIndex);
+	ctx->bitFlags[chunkIndex] = ctx->initBitFlags;
 
 	x++;
 	chunkIndex++;
 	countIndex += FACE_COUNT;
 	stretchTile = (Blocks.CanStretch[block] & (1 << FACE_YMAX)) != 0;
 
-	while (x < Builder_ChunkEndX && stretchTile && Adv_CanStretch(block, chunkIndex, x, y, z, FACE_YMAX) && !Builder_OccludedLiquid(chunkIndex)) {
-		Builder_Counts[countIndex] = 0;
+	while (x < ctx->chunkEndX && stretchTile && Adv_CanStretch(ctx, block, chunkIndex, x, y, z, FACE_YMAX) && !Builder_OccludedLiquid(ctx, chunkIndex)) {
+		ctx->counts[countIndex] = 0;
 		count++;
 		x++;
 		chunkIndex++;
 		countIndex += FACE_COUNT;
 	}
-	AddVertices(block, FACE_YMAX);
+	AddVertices(ctx, block, FACE_YMAX);
 	return count;
 }
 
-static int Adv_StretchX(int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
+static int Adv_StretchX(struct BuilderContext* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
 	int count = 1; cc_bool stretchTile;
-	adv_initBitFlags = Adv_ComputeLightFlags(x, y, z, chunkIndex);
-	adv_bitFlags[chunkIndex] = adv_initBitFlags;
+	ctx->initBitFlags = Adv_ComputeLightFlags(ctx, x, y, z, chunkIndex);
+	ctx->bitFlags[chunkIndex] = ctx->initBitFlags;
 	
 	x++;
 	chunkIndex++;
 	countIndex += FACE_COUNT;
 	stretchTile = (Blocks.CanStretch[block] & (1 << face)) != 0;
 
-	while (x < Builder_ChunkEndX && stretchTile && Adv_CanStretch(block, chunkIndex, x, y, z, face)) {
-		Builder_Counts[countIndex] = 0;
+	while (x < ctx->chunkEndX && stretchTile && Adv_CanStretch(ctx, block, chunkIndex, x, y, z, face)) {
+		ctx->counts[countIndex] = 0;
 		count++;
 		x++;
 		chunkIndex++;
 		countIndex += FACE_COUNT;
 	}
-	AddVertices(block, face);
+	AddVertices(ctx, block, face);
 	return count;
 }
 
-static int Adv_StretchZ(int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
+static int Adv_StretchZ(struct BuilderContext* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
 	int count = 1; cc_bool stretchTile;
-	adv_initBitFlags = Adv_ComputeLightFlags(x, y, z, chunkIndex);
-	adv_bitFlags[chunkIndex] = adv_initBitFlags;
+	ctx->initBitFlags = Adv_ComputeLightFlags(ctx, x, y, z, chunkIndex);
+	ctx->bitFlags[chunkIndex] = ctx->initBitFlags;
 
 	z++;
 	chunkIndex += EXTCHUNK_SIZE;
 	countIndex += CHUNK_SIZE * FACE_COUNT;
 	stretchTile = (Blocks.CanStretch[block] & (1 << face)) != 0;
 
-	while (z < Builder_ChunkEndZ && stretchTile && Adv_CanStretch(block, chunkIndex, x, y, z, face)) {
-		Builder_Counts[countIndex] = 0;
+	while (z < ctx->chunkEndZ && stretchTile && Adv_CanStretch(ctx, block, chunkIndex, x, y, z, face)) {
+		ctx->counts[countIndex] = 0;
 		count++;
 		z++;
 		chunkIndex += EXTCHUNK_SIZE;
 		countIndex += CHUNK_SIZE * FACE_COUNT;
 	}
-	AddVertices(block, face);
+	AddVertices(ctx, block, face);
 	return count;
 }
 
 
 #define Adv_CountBits(F, a, b, c, d) (((F >> a) & 1) + ((F >> b) & 1) + ((F >> c) & 1) + ((F >> d) & 1))
 
-static void Adv_DrawXMin(int count) {
-	TextureLoc texLoc = Block_Tex(Builder_Block, FACE_XMIN);
+static void Adv_DrawXMin(struct BuilderContext* ctx, int count) {
+	TextureLoc texLoc = Block_Tex(ctx->block, FACE_XMIN);
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = adv_minBB.z, u2 = (count - 1) + adv_maxBB.z * UV2_Scale;
-	float v1 = vOrigin + adv_maxBB.y * Atlas1D.InvTileSize;
-	float v2 = vOrigin + adv_minBB.y * Atlas1D.InvTileSize * UV2_Scale;
-	struct Builder1DPart* part = &Builder_Parts[adv_baseOffset + Atlas1D_Index(texLoc)];
+	float u1 = ctx->minBB.z, u2 = (count - 1) + ctx->maxBB.z * UV2_Scale;
+	float v1 = vOrigin + ctx->maxBB.y * Atlas1D.InvTileSize;
+	float v2 = vOrigin + ctx->minBB.y * Atlas1D.InvTileSize * UV2_Scale;
+	struct Builder1DPart* part = &ctx->parts[ctx->baseOffset + Atlas1D_Index(texLoc)];
 
-	int F = adv_bitFlags[Builder_ChunkIndex];
+	int F = ctx->bitFlags[ctx->chunkIndex];
 	int aY0_Z0 = Adv_CountBits(F, xM1_yM1_zM1, xM1_yCC_zM1, xM1_yM1_zCC, xM1_yCC_zCC);
 	int aY0_Z1 = Adv_CountBits(F, xM1_yM1_zP1, xM1_yCC_zP1, xM1_yM1_zCC, xM1_yCC_zCC);
 	int aY1_Z0 = Adv_CountBits(F, xM1_yP1_zM1, xM1_yCC_zM1, xM1_yP1_zCC, xM1_yCC_zCC);
 	int aY1_Z1 = Adv_CountBits(F, xM1_yP1_zP1, xM1_yCC_zP1, xM1_yP1_zCC, xM1_yCC_zCC);
 
 	PackedCol tint, white = PACKEDCOL_WHITE;
-	PackedCol col0_0 = Builder_FullBright ? white : adv_lerpX[aY0_Z0], col1_0 = Builder_FullBright ? white : adv_lerpX[aY1_Z0];
-	PackedCol col1_1 = Builder_FullBright ? white : adv_lerpX[aY1_Z1], col0_1 = Builder_FullBright ? white : adv_lerpX[aY0_Z1];
+	PackedCol col0_0 = ctx->fullBright ? white : ctx->lerpX[aY0_Z0], col1_0 = ctx->fullBright ? white : ctx->lerpX[aY1_Z0];
+	PackedCol col1_1 = ctx->fullBright ? white : ctx->lerpX[aY1_Z1], col0_1 = ctx->fullBright ? white : ctx->lerpX[aY0_Z1];
 	struct VertexTextured* vertices, v;
 
-	if (adv_tinted) {
-		tint   = Blocks.FogCol[Builder_Block];
+	if (ctx->tinted) {
+		tint   = Blocks.FogCol[ctx->block];
 		col0_0 = PackedCol_Tint(col0_0, tint); col1_0 = PackedCol_Tint(col1_0, tint);
 		col1_1 = PackedCol_Tint(col1_1, tint); col0_1 = PackedCol_Tint(col0_1, tint);
 	}
 
 	vertices = part->faces.vertices[FACE_XMIN];
-	v.x = adv_x1;
+	v.x = ctx->x1;
 	if (aY0_Z0 + aY1_Z1 > aY0_Z1 + aY1_Z0) {
-		v.y = adv_y2; v.z = adv_z1;               v.U = u1; v.V = v1; v.Col = col1_0; *vertices++ = v;
-		v.y = adv_y1;                                       v.V = v2; v.Col = col0_0; *vertices++ = v;
-		              v.z = adv_z2 + (count - 1); v.U = u2;           v.Col = col0_1; *vertices++ = v;
-		v.y = adv_y2;                                       v.V = v1; v.Col = col1_1; *vertices++ = v;
+		v.y = ctx->y2; v.z = ctx->z1;               v.U = u1; v.V = v1; v.Col = col1_0; *vertices++ = v;
+		v.y = ctx->y1;                                       v.V = v2; v.Col = col0_0; *vertices++ = v;
+		              v.z = ctx->z2 + (count - 1); v.U = u2;           v.Col = col0_1; *vertices++ = v;
+		v.y = ctx->y2;                                       v.V = v1; v.Col = col1_1; *vertices++ = v;
 	} else {
-		v.y = adv_y2; v.z = adv_z2 + (count - 1); v.U = u2; v.V = v1; v.Col = col1_1; *vertices++ = v;
-		              v.z = adv_z1;               v.U = u1;           v.Col = col1_0; *vertices++ = v;
-		v.y = adv_y1;                                       v.V = v2; v.Col = col0_0; *vertices++ = v;
-		              v.z = adv_z2 + (count - 1); v.U = u2;           v.Col = col0_1; *vertices++ = v;
+		v.y = ctx->y2; v.z = ctx->z2 + (count - 1); v.U = u2; v.V = v1; v.Col = col1_1; *vertices++ = v;
+		              v.z = ctx->z1;               v.U = u1;           v.Col = col1_0; *vertices++ = v;
+		v.y = ctx->y1;                                       v.V = v2; v.Col = col0_0; *vertices++ = v;
+		              v.z = ctx->z2 + (count - 1); v.U = u2;           v.Col = col0_1; *vertices++ = v;
 	}
 	part->faces.vertices[FACE_XMIN] = vertices;
 }
 
-static void Adv_DrawXMax(int count) {
-	TextureLoc texLoc = Block_Tex(Builder_Block, FACE_XMAX);
+static void Adv_DrawXMax(struct BuilderContext* ctx, int count) {
+	TextureLoc texLoc = Block_Tex(ctx->block, FACE_XMAX);
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = (count - adv_minBB.z), u2 = (1 - adv_maxBB.z) * UV2_Scale;
-	float v1 = vOrigin + adv_maxBB.y * Atlas1D.InvTileSize;
-	float v2 = vOrigin + adv_minBB.y * Atlas1D.InvTileSize * UV2_Scale;
-	struct Builder1DPart* part = &Builder_Parts[adv_baseOffset + Atlas1D_Index(texLoc)];
+	float u1 = (count - ctx->minBB.z), u2 = (1 - ctx->maxBB.z) * UV2_Scale;
+	float v1 = vOrigin + ctx->maxBB.y * Atlas1D.InvTileSize;
+	float v2 = vOrigin + ctx->minBB.y * Atlas1D.InvTileSize * UV2_Scale;
+	struct Builder1DPart* part = &ctx->parts[ctx->baseOffset + Atlas1D_Index(texLoc)];
 
-	int F = adv_bitFlags[Builder_ChunkIndex];
+	int F = ctx->bitFlags[ctx->chunkIndex];
 	int aY0_Z0 = Adv_CountBits(F, xP1_yM1_zM1, xP1_yCC_zM1, xP1_yM1_zCC, xP1_yCC_zCC);
 	int aY0_Z1 = Adv_CountBits(F, xP1_yM1_zP1, xP1_yCC_zP1, xP1_yM1_zCC, xP1_yCC_zCC);
 	int aY1_Z0 = Adv_CountBits(F, xP1_yP1_zM1, xP1_yCC_zM1, xP1_yP1_zCC, xP1_yCC_zCC);
 	int aY1_Z1 = Adv_CountBits(F, xP1_yP1_zP1, xP1_yCC_zP1, xP1_yP1_zCC, xP1_yCC_zCC);
 
 	PackedCol tint, white = PACKEDCOL_WHITE;
-	PackedCol col0_0 = Builder_FullBright ? white : adv_lerpX[aY0_Z0], col1_0 = Builder_FullBright ? white : adv_lerpX[aY1_Z0];
-	PackedCol col1_1 = Builder_FullBright ? white : adv_lerpX[aY1_Z1], col0_1 = Builder_FullBright ? white : adv_lerpX[aY0_Z1];
+	PackedCol col0_0 = ctx->fullBright ? white : ctx->lerpX[aY0_Z0], col1_0 = ctx->fullBright ? white : ctx->lerpX[aY1_Z0];
+	PackedCol col1_1 = ctx->fullBright ? white : ctx->lerpX[aY1_Z1], col0_1 = ctx->fullBright ? white : ctx->lerpX[aY0_Z1];
 	struct VertexTextured* vertices, v;
 
-	if (adv_tinted) {
-		tint   = Blocks.FogCol[Builder_Block];
+	if (ctx->tinted) {
+		tint   = Blocks.FogCol[ctx->block];
 		col0_0 = PackedCol_Tint(col0_0, tint); col1_0 = PackedCol_Tint(col1_0, tint);
 		col1_1 = PackedCol_Tint(col1_1, tint); col0_1 = PackedCol_Tint(col0_1, tint);
 	}
 
 	vertices = part->faces.vertices[FACE_XMAX];
-	v.x = adv_x2;
+	v.x = ctx->x2;
 	if (aY0_Z0 + aY1_Z1 > aY0_Z1 + aY1_Z0) {
-		v.y = adv_y2; v.z = adv_z1;               v.U = u1; v.V = v1; v.Col = col1_0; *vertices++ = v;
-		              v.z = adv_z2 + (count - 1); v.U = u2;           v.Col = col1_1; *vertices++ = v;
-		v.y = adv_y1;                                       v.V = v2; v.Col = col0_1; *vertices++ = v;
-		              v.z = adv_z1;               v.U = u1;           v.Col = col0_0; *vertices++ = v;
+		v.y = ctx->y2; v.z = ctx->z1;               v.U = u1; v.V = v1; v.Col = col1_0; *vertices++ = v;
+		              v.z = ctx->z2 + (count - 1); v.U = u2;           v.Col = col1_1; *vertices++ = v;
+		v.y = ctx->y1;                                       v.V = v2; v.Col = col0_1; *vertices++ = v;
+		              v.z = ctx->z1;               v.U = u1;           v.Col = col0_0; *vertices++ = v;
 	} else {
-		v.y = adv_y2; v.z = adv_z2 + (count - 1); v.U = u2; v.V = v1; v.Col = col1_1; *vertices++ = v;
-		v.y = adv_y1;                                       v.V = v2; v.Col = col0_1; *vertices++ = v;
-		              v.z = adv_z1;               v.U = u1;           v.Col = col0_0; *vertices++ = v;
-		v.y = adv_y2;                                       v.V = v1; v.Col = col1_0; *vertices++ = v;
+		v.y = ctx->y2; v.z = ctx->z2 + (count - 1); v.U = u2; v.V = v1; v.Col = col1_1; *vertices++ = v;
+		v.y = ctx->y1;                                       v.V = v2; v.Col = col0_1; *vertices++ = v;
+		              v.z = ctx->z1;               v.U = u1;           v.Col = col0_0; *vertices++ = v;
+		v.y = ctx->y2;                                       v.V = v1; v.Col = col1_0; *vertices++ = v;
 	}
 	part->faces.vertices[FACE_XMAX] = vertices;
 }
 
-static void Adv_DrawZMin(int count) {
-	TextureLoc texLoc = Block_Tex(Builder_Block, FACE_ZMIN);
+static void Adv_DrawZMin(struct BuilderContext* ctx, int count) {
+	TextureLoc texLoc = Block_Tex(ctx->block, FACE_ZMIN);
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = (count - adv_minBB.x), u2 = (1 - adv_maxBB.x) * UV2_Scale;
-	float v1 = vOrigin + adv_maxBB.y * Atlas1D.InvTileSize;
-	float v2 = vOrigin + adv_minBB.y * Atlas1D.InvTileSize * UV2_Scale;
-	struct Builder1DPart* part = &Builder_Parts[adv_baseOffset + Atlas1D_Index(texLoc)];
+	float u1 = (count - ctx->minBB.x), u2 = (1 - ctx->maxBB.x) * UV2_Scale;
+	float v1 = vOrigin + ctx->maxBB.y * Atlas1D.InvTileSize;
+	float v2 = vOrigin + ctx->minBB.y * Atlas1D.InvTileSize * UV2_Scale;
+	struct Builder1DPart* part = &ctx->parts[ctx->baseOffset + Atlas1D_Index(texLoc)];
 
-	int F = adv_bitFlags[Builder_ChunkIndex];
+	int F = ctx->bitFlags[ctx->chunkIndex];
 	int aX0_Y0 = Adv_CountBits(F, xM1_yM1_zM1, xM1_yCC_zM1, xCC_yM1_zM1, xCC_yCC_zM1);
 	int aX0_Y1 = Adv_CountBits(F, xM1_yP1_zM1, xM1_yCC_zM1, xCC_yP1_zM1, xCC_yCC_zM1);
 	int aX1_Y0 = Adv_CountBits(F, xP1_yM1_zM1, xP1_yCC_zM1, xCC_yM1_zM1, xCC_yCC_zM1);
 	int aX1_Y1 = Adv_CountBits(F, xP1_yP1_zM1, xP1_yCC_zM1, xCC_yP1_zM1, xCC_yCC_zM1);
 
 	PackedCol tint, white = PACKEDCOL_WHITE;
-	PackedCol col0_0 = Builder_FullBright ? white : adv_lerpZ[aX0_Y0], col1_0 = Builder_FullBright ? white : adv_lerpZ[aX1_Y0];
-	PackedCol col1_1 = Builder_FullBright ? white : adv_lerpZ[aX1_Y1], col0_1 = Builder_FullBright ? white : adv_lerpZ[aX0_Y1];
+	PackedCol col0_0 = ctx->fullBright ? white : ctx->lerpZ[aX0_Y0], col1_0 = ctx->fullBright ? white : ctx->lerpZ[aX1_Y0];
+	PackedCol col1_1 = ctx->fullBright ? white : ctx->lerpZ[aX1_Y1], col0_1 = ctx->fullBright ? white : ctx->lerpZ[aX0_Y1];
 	struct VertexTextured* vertices, v;
 
-	if (adv_tinted) {
-		tint   = Blocks.FogCol[Builder_Block];
+	if (ctx->tinted) {
+		tint   = Blocks.FogCol[ctx->block];
 		col0_0 = PackedCol_Tint(col0_0, tint); col1_0 = PackedCol_Tint(col1_0, tint);
 		col1_1 = PackedCol_Tint(col1_1, tint); col0_1 = PackedCol_Tint(col0_1, tint);
 	}
 
 	vertices = part->faces.vertices[FACE_ZMIN];
-	v.z = adv_z1;
+	v.z = ctx->z1;
 	if (aX1_Y1 + aX0_Y0 > aX0_Y1 + aX1_Y0) {
-		v.x = adv_x2 + (count - 1); v.y = adv_y1; v.U = u2; v.V = v2; v.Col = col1_0; *vertices++ = v;
-		v.x = adv_x1;                             v.U = u1;           v.Col = col0_0; *vertices++ = v;
-		                            v.y = adv_y2;           v.V = v1; v.Col = col0_1; *vertices++ = v;
-		v.x = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
+		v.x = ctx->x2 + (count - 1); v.y = ctx->y1; v.U = u2; v.V = v2; v.Col = col1_0; *vertices++ = v;
+		v.x = ctx->x1;                             v.U = u1;           v.Col = col0_0; *vertices++ = v;
+		                            v.y = ctx->y2;           v.V = v1; v.Col = col0_1; *vertices++ = v;
+		v.x = ctx->x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
 	} else {
-		v.x = adv_x1;               v.y = adv_y1; v.U = u1; v.V = v2; v.Col = col0_0; *vertices++ = v;
-		                            v.y = adv_y2;           v.V = v1; v.Col = col0_1; *vertices++ = v;
-		v.x = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
-		                            v.y = adv_y1;           v.V = v2; v.Col = col1_0; *vertices++ = v;
+		v.x = ctx->x1;               v.y = ctx->y1; v.U = u1; v.V = v2; v.Col = col0_0; *vertices++ = v;
+		                            v.y = ctx->y2;           v.V = v1; v.Col = col0_1; *vertices++ = v;
+		v.x = ctx->x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
+		                            v.y = ctx->y1;           v.V = v2; v.Col = col1_0; *vertices++ = v;
 	}
 	part->faces.vertices[FACE_ZMIN] = vertices;
 }
 
-static void Adv_DrawZMax(int count) {
-	TextureLoc texLoc = Block_Tex(Builder_Block, FACE_ZMAX);
+static void Adv_DrawZMax(struct BuilderContext* ctx, int count) {
+	TextureLoc texLoc = Block_Tex(ctx->block, FACE_ZMAX);
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = adv_minBB.x, u2 = (count - 1) + adv_maxBB.x * UV2_Scale;
-	float v1 = vOrigin + adv_maxBB.y * Atlas1D.InvTileSize;
-	float v2 = vOrigin + adv_minBB.y * Atlas1D.InvTileSize * UV2_Scale;
-	struct Builder1DPart* part = &Builder_Parts[adv_baseOffset + Atlas1D_Index(texLoc)];
+	float u1 = ctx->minBB.x, u2 = (count - 1) + ctx->maxBB.x * UV2_Scale;
+	float v1 = vOrigin + ctx->maxBB.y * Atlas1D.InvTileSize;
+	float v2 = vOrigin + ctx->minBB.y * Atlas1D.InvTileSize * UV2_Scale;
+	struct Builder1DPart* part = &ctx->parts[ctx->baseOffset + Atlas1D_Index(texLoc)];
 
-	int F = adv_bitFlags[Builder_ChunkIndex];
+	int F = ctx->bitFlags[ctx->chunkIndex];
 	int aX0_Y0 = Adv_CountBits(F, xM1_yM1_zP1, xM1_yCC_zP1, xCC_yM1_zP1, xCC_yCC_zP1);
 	int aX1_Y0 = Adv_CountBits(F, xP1_yM1_zP1, xP1_yCC_zP1, xCC_yM1_zP1, xCC_yCC_zP1);
 	int aX0_Y1 = Adv_CountBits(F, xM1_yP1_zP1, xM1_yCC_zP1, xCC_yP1_zP1, xCC_yCC_zP1);
 	int aX1_Y1 = Adv_CountBits(F, xP1_yP1_zP1, xP1_yCC_zP1, xCC_yP1_zP1, xCC_yCC_zP1);
 
 	PackedCol tint, white = PACKEDCOL_WHITE;
-	PackedCol col1_1 = Builder_FullBright ? white : adv_lerpZ[aX1_Y1], col1_0 = Builder_FullBright ? white : adv_lerpZ[aX1_Y0];
-	PackedCol col0_0 = Builder_FullBright ? white : adv_lerpZ[aX0_Y0], col0_1 = Builder_FullBright ? white : adv_lerpZ[aX0_Y1];
+	PackedCol col1_1 = ctx->fullBright ? white : ctx->lerpZ[aX1_Y1], col1_0 = ctx->fullBright ? white : ctx->lerpZ[aX1_Y0];
+	PackedCol col0_0 = ctx->fullBright ? white : ctx->lerpZ[aX0_Y0], col0_1 = ctx->fullBright ? white : ctx->lerpZ[aX0_Y1];
 	struct VertexTextured* vertices, v;
 
-	if (adv_tinted) {
-		tint   = Blocks.FogCol[Builder_Block];
+	if (ctx->tinted) {
+		tint   = Blocks.FogCol[ctx->block];
 		col0_0 = PackedCol_Tint(col0_0, tint); col1_0 = PackedCol_Tint(col1_0, tint);
 		col1_1 = PackedCol_Tint(col1_1, tint); col0_1 = PackedCol_Tint(col0_1, tint);
 	}
 
 	vertices = part->faces.vertices[FACE_ZMAX];
-	v.z = adv_z2;
+	v.z = ctx->z2;
 	if (aX1_Y1 + aX0_Y0 > aX0_Y1 + aX1_Y0) {
-		v.x = adv_x1;               v.y = adv_y2; v.U = u1; v.V = v1; v.Col = col0_1; *vertices++ = v;
-		                            v.y = adv_y1;           v.V = v2; v.Col = col0_0; *vertices++ = v;
-		v.x = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
-		                            v.y = adv_y2;           v.V = v1; v.Col = col1_1; *vertices++ = v;
+		v.x = ctx->x1;               v.y = ctx->y2; v.U = u1; v.V = v1; v.Col = col0_1; *vertices++ = v;
+		                            v.y = ctx->y1;           v.V = v2; v.Col = col0_0; *vertices++ = v;
+		v.x = ctx->x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
+		                            v.y = ctx->y2;           v.V = v1; v.Col = col1_1; *vertices++ = v;
 	} else {
-		v.x = adv_x2 + (count - 1); v.y = adv_y2; v.U = u2; v.V = v1; v.Col = col1_1; *vertices++ = v;
-		v.x = adv_x1;                             v.U = u1;           v.Col = col0_1; *vertices++ = v;
-		                            v.y = adv_y1;           v.V = v2; v.Col = col0_0; *vertices++ = v;
-		v.x = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
+		v.x = ctx->x2 + (count - 1); v.y = ctx->y2; v.U = u2; v.V = v1; v.Col = col1_1; *vertices++ = v;
+		v.x = ctx->x1;                             v.U = u1;           v.Col = col0_1; *vertices++ = v;
+		                            v.y = ctx->y1;           v.V = v2; v.Col = col0_0; *vertices++ = v;
+		v.x = ctx->x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
 	}
 	part->faces.vertices[FACE_ZMAX] = vertices;
 }
 
-static void Adv_DrawYMin(int count) {
-	TextureLoc texLoc = Block_Tex(Builder_Block, FACE_YMIN);
+static void Adv_DrawYMin(struct BuilderContext* ctx, int count) {
+	TextureLoc texLoc = Block_Tex(ctx->block, FACE_YMIN);
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = adv_minBB.x, u2 = (count - 1) + adv_maxBB.x * UV2_Scale;
-	float v1 = vOrigin + adv_minBB.z * Atlas1D.InvTileSize;
-	float v2 = vOrigin + adv_maxBB.z * Atlas1D.InvTileSize * UV2_Scale;
-	struct Builder1DPart* part = &Builder_Parts[adv_baseOffset + Atlas1D_Index(texLoc)];
+	float u1 = ctx->minBB.x, u2 = (count - 1) + ctx->maxBB.x * UV2_Scale;
+	float v1 = vOrigin + ctx->minBB.z * Atlas1D.InvTileSize;
+	float v2 = vOrigin + ctx->maxBB.z * Atlas1D.InvTileSize * UV2_Scale;
+	struct Builder1DPart* part = &ctx->parts[ctx->baseOffset + Atlas1D_Index(texLoc)];
 
-	int F = adv_bitFlags[Builder_ChunkIndex];
+	int F = ctx->bitFlags[ctx->chunkIndex];
 	int aX0_Z0 = Adv_CountBits(F, xM1_yM1_zM1, xM1_yM1_zCC, xCC_yM1_zM1, xCC_yM1_zCC);
 	int aX1_Z0 = Adv_CountBits(F, xP1_yM1_zM1, xP1_yM1_zCC, xCC_yM1_zM1, xCC_yM1_zCC);
 	int aX0_Z1 = Adv_CountBits(F, xM1_yM1_zP1, xM1_yM1_zCC, xCC_yM1_zP1, xCC_yM1_zCC);
 	int aX1_Z1 = Adv_CountBits(F, xP1_yM1_zP1, xP1_yM1_zCC, xCC_yM1_zP1, xCC_yM1_zCC);
 
 	PackedCol tint, white = PACKEDCOL_WHITE;
-	PackedCol col0_1 = Builder_FullBright ? white : adv_lerpY[aX0_Z1], col1_1 = Builder_FullBright ? white : adv_lerpY[aX1_Z1];
-	PackedCol col1_0 = Builder_FullBright ? white : adv_lerpY[aX1_Z0], col0_0 = Builder_FullBright ? white : adv_lerpY[aX0_Z0];
+	PackedCol col0_1 = ctx->fullBright ? white : ctx->lerpY[aX0_Z1], col1_1 = ctx->fullBright ? white : ctx->lerpY[aX1_Z1];
+	PackedCol col1_0 = ctx->fullBright ? white : ctx->lerpY[aX1_Z0], col0_0 = ctx->fullBright ? white : ctx->lerpY[aX0_Z0];
 	struct VertexTextured* vertices, v;
 
-	if (adv_tinted) {
-		tint   = Blocks.FogCol[Builder_Block];
+	if (ctx->tinted) {
+		tint   = Blocks.FogCol[ctx->block];
 		col0_0 = PackedCol_Tint(col0_0, tint); col1_0 = PackedCol_Tint(col1_0, tint);
 		col1_1 = PackedCol_Tint(col1_1, tint); col0_1 = PackedCol_Tint(col0_1, tint);
 	}
 
 	vertices = part->faces.vertices[FACE_YMIN];
-	v.y = adv_y1;
+	v.y = ctx->y1;
 	if (aX0_Z1 + aX1_Z0 > aX0_Z0 + aX1_Z1) {
-		v.x = adv_x2 + (count - 1); v.z = adv_z2; v.U = u2; v.V = v2; v.Col = col1_1; *vertices++ = v;
-		v.x = adv_x1;                             v.U = u1;           v.Col = col0_1; *vertices++ = v;
-		                            v.z = adv_z1;           v.V = v1; v.Col = col0_0; *vertices++ = v;
-		v.x = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
+		v.x = ctx->x2 + (count - 1); v.z = ctx->z2; v.U = u2; v.V = v2; v.Col = col1_1; *vertices++ = v;
+		v.x = ctx->x1;                             v.U = u1;           v.Col = col0_1; *vertices++ = v;
+		                            v.z = ctx->z1;           v.V = v1; v.Col = col0_0; *vertices++ = v;
+		v.x = ctx->x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
 	} else {
-		v.x = adv_x1;               v.z = adv_z2; v.U = u1; v.V = v2; v.Col = col0_1; *vertices++ = v;
-		                            v.z = adv_z1;           v.V = v1; v.Col = col0_0; *vertices++ = v;
-		v.x = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
-		                            v.z = adv_z2;           v.V = v2; v.Col = col1_1; *vertices++ = v;
+		v.x = ctx->x1;               v.z = ctx->z2; v.U = u1; v.V = v2; v.Col = col0_1; *vertices++ = v;
+		                            v.z = ctx->z1;           v.V = v1; v.Col = col0_0; *vertices++ = v;
+		v.x = ctx->x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
+		                            v.z = ctx->z2;           v.V = v2; v.Col = col1_1; *vertices++ = v;
 	}
 	part->faces.vertices[FACE_YMIN] = vertices;
 }
 
-static void Adv_DrawYMax(int count) {
-	TextureLoc texLoc = Block_Tex(Builder_Block, FACE_YMAX);
+static void Adv_DrawYMax(struct BuilderContext* ctx, int count) {
+	TextureLoc texLoc = Block_Tex(ctx->block, FACE_YMAX);
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = adv_minBB.x, u2 = (count - 1) + adv_maxBB.x * UV2_Scale;
-	float v1 = vOrigin + adv_minBB.z * Atlas1D.InvTileSize;
-	float v2 = vOrigin + adv_maxBB.z * Atlas1D.InvTileSize * UV2_Scale;
-	struct Builder1DPart* part = &Builder_Parts[adv_baseOffset + Atlas1D_Index(texLoc)];
+	float u1 = ctx->minBB.x, u2 = (count - 1) + ctx->maxBB.x * UV2_Scale;
+	float v1 = vOrigin + ctx->minBB.z * Atlas1D.InvTileSize;
+	float v2 = vOrigin + ctx->maxBB.z * Atlas1D.InvTileSize * UV2_Scale;
+	struct Builder1DPart* part = &ctx->parts[ctx->baseOffset + Atlas1D_Index(texLoc)];
 
-	int F = adv_bitFlags[Builder_ChunkIndex];
+	int F = ctx->bitFlags[ctx->chunkIndex];
 	int aX0_Z0 = Adv_CountBits(F, xM1_yP1_zM1, xM1_yP1_zCC, xCC_yP1_zM1, xCC_yP1_zCC);
 	int aX1_Z0 = Adv_CountBits(F, xP1_yP1_zM1, xP1_yP1_zCC, xCC_yP1_zM1, xCC_yP1_zCC);
 	int aX0_Z1 = Adv_CountBits(F, xM1_yP1_zP1, xM1_yP1_zCC, xCC_yP1_zP1, xCC_yP1_zCC);
 	int aX1_Z1 = Adv_CountBits(F, xP1_yP1_zP1, xP1_yP1_zCC, xCC_yP1_zP1, xCC_yP1_zCC);
 
 	PackedCol tint, white = PACKEDCOL_WHITE;
-	PackedCol col0_0 = Builder_FullBright ? white : adv_lerp[aX0_Z0], col1_0 = Builder_FullBright ? white : adv_lerp[aX1_Z0];
-	PackedCol col1_1 = Builder_FullBright ? white : adv_lerp[aX1_Z1], col0_1 = Builder_FullBright ? white : adv_lerp[aX0_Z1];
+	PackedCol col0_0 = ctx->fullBright ? white : ctx->lerp[aX0_Z0], col1_0 = ctx->fullBright ? white : ctx->lerp[aX1_Z0];
+	PackedCol col1_1 = ctx->fullBright ? white : ctx->lerp[aX1_Z1], col0_1 = ctx->fullBright ? white : ctx->lerp[aX0_Z1];
 	struct VertexTextured* vertices, v;
 
-	if (adv_tinted) {
-		tint   = Blocks.FogCol[Builder_Block];
+	if (ctx->tinted) {
+		tint   = Blocks.FogCol[ctx->block];
 		col0_0 = PackedCol_Tint(col0_0, tint); col1_0 = PackedCol_Tint(col1_0, tint);
 		col1_1 = PackedCol_Tint(col1_1, tint); col0_1 = PackedCol_Tint(col0_1, tint);
 	}
 
 	vertices = part->faces.vertices[FACE_YMAX];
-	v.y = adv_y2;
+	v.y = ctx->y2;
 	if (aX0_Z0 + aX1_Z1 > aX0_Z1 + aX1_Z0) {
-		v.x = adv_x2 + (count - 1); v.z = adv_z1; v.U = u2; v.V = v1; v.Col = col1_0; *vertices++ = v;
-		v.x = adv_x1;                             v.U = u1;           v.Col = col0_0; *vertices++ = v;
-		                            v.z = adv_z2;           v.V = v2; v.Col = col0_1; *vertices++ = v;
-		v.x = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
+		v.x = ctx->x2 + (count - 1); v.z = ctx->z1; v.U = u2; v.V = v1; v.Col = col1_0; *vertices++ = v;
+		v.x = ctx->x1;                             v.U = u1;           v.Col = col0_0; *vertices++ = v;
+		                            v.z = ctx->z2;           v.V = v2; v.Col = col0_1; *vertices++ = v;
+		v.x = ctx->x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
 	} else {
-		v.x = adv_x1;               v.z = adv_z1; v.U = u1; v.V = v1; v.Col = col0_0; *vertices++ = v;
-		                            v.z = adv_z2;           v.V = v2; v.Col = col0_1; *vertices++ = v;
-		v.x = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
-		                            v.z = adv_z1;           v.V = v1; v.Col = col1_0; *vertices++ = v;
+		v.x = ctx->x1;               v.z = ctx->z1; v.U = u1; v.V = v1; v.Col = col0_0; *vertices++ = v;
+		                            v.z = ctx->z2;           v.V = v2; v.Col = col0_1; *vertices++ = v;
+		v.x = ctx->x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
+		                            v.z = ctx->z1;           v.V = v1; v.Col = col1_0; *vertices++ = v;
 	}
 	part->faces.vertices[FACE_YMAX] = vertices;
 }
 
-static void Adv_RenderBlock(int index, int x, int y, int z) {
+static void Adv_RenderBlock(struct BuilderContext* ctx, int index, int x, int y, int z) {
 	Vec3 min, max;
 	int count_XMin, count_XMax, count_ZMin;
 	int count_ZMax, count_YMin, count_YMax;
 
-	if (Blocks.Draw[Builder_Block] == DRAW_SPRITE) {
-		Builder_DrawSprite(x, y, z); return;
+	if (Blocks.Draw[ctx->block] == DRAW_SPRITE) {
+		Builder_DrawSprite(ctx, x, y, z); return;
 	}
 
-	count_XMin = Builder_Counts[index + FACE_XMIN];
-	count_XMax = Builder_Counts[index + FACE_XMAX];
-	count_ZMin = Builder_Counts[index + FACE_ZMIN];
-	count_ZMax = Builder_Counts[index + FACE_ZMAX];
-	count_YMin = Builder_Counts[index + FACE_YMIN];
-	count_YMax = Builder_Counts[index + FACE_YMAX];
+	count_XMin = ctx->counts[index + FACE_XMIN];
+	count_XMax = ctx->counts[index + FACE_XMAX];
+	count_ZMin = ctx->counts[index + FACE_ZMIN];
+	count_ZMax = ctx->counts[index + FACE_ZMAX];
+	count_YMin = ctx->counts[index + FACE_YMIN];
+	count_YMax = ctx->counts[index + FACE_YMAX];
 
 	if (!count_XMin && !count_XMax && !count_ZMin &&
 		!count_ZMax && !count_YMin && !count_YMax) return;
 
-	Builder_FullBright = Blocks.Brightness[Builder_Block];
-	adv_baseOffset = (Blocks.Draw[Builder_Block] == DRAW_TRANSLUCENT) * ATLAS1D_MAX_ATLASES;
-	adv_tinted     = Blocks.Tinted[Builder_Block];
+	ctx->fullBright = Blocks.Brightness[ctx->block];
+	ctx->baseOffset = (Blocks.Draw[ctx->block] == DRAW_TRANSLUCENT) * ATLAS1D_MAX_ATLASES;
+	ctx->tinted     = Blocks.Tinted[ctx->block];
 
-	min = Blocks.RenderMinBB[Builder_Block]; max = Blocks.RenderMaxBB[Builder_Block];
-	adv_x1 = x + min.x; adv_y1 = y + min.y; adv_z1 = z + min.z;
-	adv_x2 = x + max.x; adv_y2 = y + max.y; adv_z2 = z + max.z;
+	min = Blocks.RenderMinBB[ctx->block]; max = Blocks.RenderMaxBB[ctx->block];
+	ctx->x1 = x + min.x; ctx->y1 = y + min.y; ctx->z1 = z + min.z;
+	ctx->x2 = x + max.x; ctx->y2 = y + max.y; ctx->z2 = z + max.z;
 
-	adv_minBB = Blocks.MinBB[Builder_Block]; adv_maxBB = Blocks.MaxBB[Builder_Block];
-	adv_minBB.y = 1.0f - adv_minBB.y; adv_maxBB.y = 1.0f - adv_maxBB.y;
+	ctx->minBB = Blocks.MinBB[ctx->block]; ctx->maxBB = Blocks.MaxBB[ctx->block];
+	ctx->minBB.y = 1.0f - ctx->minBB.y; ctx->maxBB.y = 1.0f - ctx->maxBB.y;
 
-	if (count_XMin) Adv_DrawXMin(count_XMin);
-	if (count_XMax) Adv_DrawXMax(count_XMax);
-	if (count_ZMin) Adv_DrawZMin(count_ZMin);
-	if (count_ZMax) Adv_DrawZMax(count_ZMax);
-	if (count_YMin) Adv_DrawYMin(count_YMin);
-	if (count_YMax) Adv_DrawYMax(count_YMax);
+	if (count_XMin) Adv_DrawXMin(ctx, count_XMin);
+	if (count_XMax) Adv_DrawXMax(ctx, count_XMax);
+	if (count_ZMin) Adv_DrawZMin(ctx, count_ZMin);
+	if (count_ZMax) Adv_DrawZMax(ctx, count_ZMax);
+	if (count_YMin) Adv_DrawYMin(ctx, count_YMin);
+	if (count_YMax) Adv_DrawYMax(ctx, count_YMax);
 }
 
-static void Adv_PrePrepareChunk(void) {
+static void Adv_PrePrepareChunk(struct BuilderContext* ctx) {
 	int i;
-	DefaultPrePrepateChunk();
-	adv_bitFlags = Builder_BitFlags;
+	DefaultPrePrepateChunk(ctx);
 
 	for (i = 0; i <= 4; i++) {
-		adv_lerp[i]  = PackedCol_Lerp(Env.ShadowCol,   Env.SunCol,   i / 4.0f);
-		adv_lerpX[i] = PackedCol_Lerp(Env.ShadowXSide, Env.SunXSide, i / 4.0f);
-		adv_lerpZ[i] = PackedCol_Lerp(Env.ShadowZSide, Env.SunZSide, i / 4.0f);
-		adv_lerpY[i] = PackedCol_Lerp(Env.ShadowYMin,  Env.SunYMin,  i / 4.0f);
+		ctx->lerp[i]  = PackedCol_Lerp(Env.ShadowCol,   Env.SunCol,   i / 4.0f);
+		ctx->lerpX[i] = PackedCol_Lerp(Env.ShadowXSide, Env.SunXSide, i / 4.0f);
+		ctx->lerpZ[i] = PackedCol_Lerp(Env.ShadowZSide, Env.SunZSide, i / 4.0f);
+		ctx->lerpY[i] = PackedCol_Lerp(Env.ShadowYMin,  Env.SunYMin,  i / 4.0f);
 	}
 }
 
@@ -1294,22 +1447,22 @@ static cc_bool Modern_CanStretch(BlockID initial, int chunkIndex, int x, int y,
 	return false;
 }
 
-static int Modern_StretchXLiquid(int countIndex, int x, int y, int z, int chunkIndex, BlockID block) {
+static int Modern_StretchXLiquid(struct BuilderContext* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block) {
 	int count = 1;
-	if (Builder_OccludedLiquid(chunkIndex)) return 0;
-	AddVertices(block, FACE_YMAX);
+	if (Builder_OccludedLiquid(ctx, chunkIndex)) return 0;
+	AddVertices(ctx, block, FACE_YMAX);
 	return count;
 }
 
-static int Modern_StretchX(int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
+static int Modern_StretchX(struct BuilderContext* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
 	int count = 1;
-	AddVertices(block, face);
+	AddVertices(ctx, block, face);
 	return count;
 }
 
-static int Modern_StretchZ(int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
+static int Modern_StretchZ(struct BuilderContext* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
 	int count = 1;
-	AddVertices(block, face);
+	AddVertices(ctx, block, face);
 	return count;
 }
 
@@ -1326,69 +1479,69 @@ static PackedCol Modern_GetColorX(PackedCol orig, int x, int y, int z, int oY, i
 	PackedCol cd = AVERAGE(CoXoZ, orig);
 	return AVERAGE(ab, cd);
 }
-static void Modern_DrawXMin(int count, int x, int y, int z) {
-	TextureLoc texLoc = Block_Tex(Builder_Block, FACE_XMIN);
+static void Modern_DrawXMin(struct BuilderContext* ctx, int count, int x, int y, int z) {
+	TextureLoc texLoc = Block_Tex(ctx->block, FACE_XMIN);
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = adv_minBB.z, u2 = (count - 1) + adv_maxBB.z * UV2_Scale;
-	float v1 = vOrigin + adv_maxBB.y * Atlas1D.InvTileSize;
-	float v2 = vOrigin + adv_minBB.y * Atlas1D.InvTileSize * UV2_Scale;
-	struct Builder1DPart* part = &Builder_Parts[adv_baseOffset + Atlas1D_Index(texLoc)];
+	float u1 = ctx->minBB.z, u2 = (count - 1) + ctx->maxBB.z * UV2_Scale;
+	float v1 = vOrigin + ctx->maxBB.y * Atlas1D.InvTileSize;
+	float v2 = vOrigin + ctx->minBB.y * Atlas1D.InvTileSize * UV2_Scale;
+	struct Builder1DPart* part = &ctx->parts[ctx->baseOffset + Atlas1D_Index(texLoc)];
 
 	PackedCol tint, white = PACKEDCOL_WHITE;
-	int offset = 1;// (Blocks.LightOffset[Builder_Block] >> FACE_XMIN) & 1;
+	int offset = 1;// (Blocks.LightOffset[ctx->block] >> FACE_XMIN) & 1;
 	PackedCol orig = Lighting.Color_XSide_Fast(x-offset, y, z);
-	PackedCol col0_0 = Builder_FullBright ? white : Modern_GetColorX(orig, x-offset, y, z, -1, -1);
-	PackedCol col1_0 = Builder_FullBright ? white : Modern_GetColorX(orig, x-offset, y, z, 1, -1);
-	PackedCol col1_1 = Builder_FullBright ? white : Modern_GetColorX(orig, x-offset, y, z, 1, 1);
-	PackedCol col0_1 = Builder_FullBright ? white : Modern_GetColorX(orig, x-offset, y, z, -1, 1);
+	PackedCol col0_0 = ctx->fullBright ? white : Modern_GetColorX(orig, x-offset, y, z, -1, -1);
+	PackedCol col1_0 = ctx->fullBright ? white : Modern_GetColorX(orig, x-offset, y, z, 1, -1);
+	PackedCol col1_1 = ctx->fullBright ? white : Modern_GetColorX(orig, x-offset, y, z, 1, 1);
+	PackedCol col0_1 = ctx->fullBright ? white : Modern_GetColorX(orig, x-offset, y, z, -1, 1);
 	struct VertexTextured* vertices, v;
 
-	if (adv_tinted) {
-		tint   = Blocks.FogCol[Builder_Block];
+	if (ctx->tinted) {
+		tint   = Blocks.FogCol[ctx->block];
 		col0_0 = PackedCol_Tint(col0_0, tint); col1_0 = PackedCol_Tint(col1_0, tint);
 		col1_1 = PackedCol_Tint(col1_1, tint); col0_1 = PackedCol_Tint(col0_1, tint);
 	}
 
 	vertices = part->faces.vertices[FACE_XMIN];
-	v.x = adv_x1;
-		v.y = adv_y2; v.z = adv_z2 + (count - 1); v.U = u2; v.V = v1; v.Col = col1_1; *vertices++ = v;
-		              v.z = adv_z1;               v.U = u1;           v.Col = col1_0; *vertices++ = v;
-		v.y = adv_y1;                                       v.V = v2; v.Col = col0_0; *vertices++ = v;
-		              v.z = adv_z2 + (count - 1); v.U = u2;           v.Col = col0_1; *vertices++ = v;
+	v.x = ctx->x1;
+		v.y = ctx->y2; v.z = ctx->z2 + (count - 1); v.U = u2; v.V = v1; v.Col = col1_1; *vertices++ = v;
+		              v.z = ctx->z1;               v.U = u1;           v.Col = col1_0; *vertices++ = v;
+		v.y = ctx->y1;                                       v.V = v2; v.Col = col0_0; *vertices++ = v;
+		              v.z = ctx->z2 + (count - 1); v.U = u2;           v.Col = col0_1; *vertices++ = v;
 	part->faces.vertices[FACE_XMIN] = vertices;
 }
 
-static void Modern_DrawXMax(int count, int x, int y, int z) {
-	TextureLoc texLoc = Block_Tex(Builder_Block, FACE_XMAX);
+static void Modern_DrawXMax(struct BuilderContext* ctx, int count, int x, int y, int z) {
+	TextureLoc texLoc = Block_Tex(ctx->block, FACE_XMAX);
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = (count - adv_minBB.z), u2 = (1 - adv_maxBB.z) * UV2_Scale;
-	float v1 = vOrigin + adv_maxBB.y * Atlas1D.InvTileSize;
-	float v2 = vOrigin + adv_minBB.y * Atlas1D.InvTileSize * UV2_Scale;
-	struct Builder1DPart* part = &Builder_Parts[adv_baseOffset + Atlas1D_Index(texLoc)];
+	float u1 = (count - ctx->minBB.z), u2 = (1 - ctx->maxBB.z) * UV2_Scale;
+	float v1 = vOrigin + ctx->maxBB.y * Atlas1D.InvTileSize;
+	float v2 = vOrigin + ctx->minBB.y * Atlas1D.InvTileSize * UV2_Scale;
+	struct Builder1DPart* part = &ctx->parts[ctx->baseOffset + Atlas1D_Index(texLoc)];
 
 	PackedCol tint, white = PACKEDCOL_WHITE;
-	int offset = 1;// (Blocks.LightOffset[Builder_Block] >> FACE_XMAX) & 1;
+	int offset = 1;// (Blocks.LightOffset[ctx->block] >> FACE_XMAX) & 1;
 	PackedCol orig = Lighting.Color_XSide_Fast(x+offset, y, z);
-	PackedCol col0_0 = Builder_FullBright ? white : Modern_GetColorX(orig, x+offset, y, z, -1, -1);
-	PackedCol col1_0 = Builder_FullBright ? white : Modern_GetColorX(orig, x+offset, y, z, 1, -1);
-	PackedCol col1_1 = Builder_FullBright ? white : Modern_GetColorX(orig, x+offset, y, z, 1, 1);
-	PackedCol col0_1 = Builder_FullBright ? white : Modern_GetColorX(orig, x+offset, y, z, -1, 1);
+	PackedCol col0_0 = ctx->fullBright ? white : Modern_GetColorX(orig, x+offset, y, z, -1, -1);
+	PackedCol col1_0 = ctx->fullBright ? white : Modern_GetColorX(orig, x+offset, y, z, 1, -1);
+	PackedCol col1_1 = ctx->fullBright ? white : Modern_GetColorX(orig, x+offset, y, z, 1, 1);
+	PackedCol col0_1 = ctx->fullBright ? white : Modern_GetColorX(orig, x+offset, y, z, -1, 1);
 	struct VertexTextured* vertices, v;
 
-	if (adv_tinted) {
-		tint   = Blocks.FogCol[Builder_Block];
+	if (ctx->tinted) {
+		tint   = Blocks.FogCol[ctx->block];
 		col0_0 = PackedCol_Tint(col0_0, tint); col1_0 = PackedCol_Tint(col1_0, tint);
 		col1_1 = PackedCol_Tint(col1_1, tint); col0_1 = PackedCol_Tint(col0_1, tint);
 	}
 
 	vertices = part->faces.vertices[FACE_XMAX];
-	v.x = adv_x2;
-		v.y = adv_y2; v.z = adv_z2 + (count - 1); v.U = u2; v.V = v1; v.Col = col1_1; *vertices++ = v;
-		v.y = adv_y1;                                       v.V = v2; v.Col = col0_1; *vertices++ = v;
-		              v.z = adv_z1;               v.U = u1;           v.Col = col0_0; *vertices++ = v;
-		v.y = adv_y2;                                       v.V = v1; v.Col = col1_0; *vertices++ = v;
+	v.x = ctx->x2;
+		v.y = ctx->y2; v.z = ctx->z2 + (count - 1); v.U = u2; v.V = v1; v.Col = col1_1; *vertices++ = v;
+		v.y = ctx->y1;                                       v.V = v2; v.Col = col0_1; *vertices++ = v;
+		              v.z = ctx->z1;               v.U = u1;           v.Col = col0_0; *vertices++ = v;
+		v.y = ctx->y2;                                       v.V = v1; v.Col = col1_0; *vertices++ = v;
 	part->faces.vertices[FACE_XMAX] = vertices;
 }
 
@@ -1405,69 +1558,69 @@ static PackedCol Modern_GetColorZ(PackedCol orig, int x, int y, int z, int oX, i
 	PackedCol cd = AVERAGE(CoXoZ, orig);
 	return AVERAGE(ab, cd);
 }
-static void Modern_DrawZMin(int count, int x, int y, int z) {
-	TextureLoc texLoc = Block_Tex(Builder_Block, FACE_ZMIN);
+static void Modern_DrawZMin(struct BuilderContext* ctx, int count, int x, int y, int z) {
+	TextureLoc texLoc = Block_Tex(ctx->block, FACE_ZMIN);
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = (count - adv_minBB.x), u2 = (1 - adv_maxBB.x) * UV2_Scale;
-	float v1 = vOrigin + adv_maxBB.y * Atlas1D.InvTileSize;
-	float v2 = vOrigin + adv_minBB.y * Atlas1D.InvTileSize * UV2_Scale;
-	struct Builder1DPart* part = &Builder_Parts[adv_baseOffset + Atlas1D_Index(texLoc)];
+	float u1 = (count - ctx->minBB.x), u2 = (1 - ctx->maxBB.x) * UV2_Scale;
+	float v1 = vOrigin + ctx->maxBB.y * Atlas1D.InvTileSize;
+	float v2 = vOrigin + ctx->minBB.y * Atlas1D.InvTileSize * UV2_Scale;
+	struct Builder1DPart* part = &ctx->parts[ctx->baseOffset + Atlas1D_Index(texLoc)];
 
 	PackedCol tint, white = PACKEDCOL_WHITE;
-	int offset = 1;// (Blocks.LightOffset[Builder_Block] >> FACE_ZMIN) & 1;
+	int offset = 1;// (Blocks.LightOffset[ctx->block] >> FACE_ZMIN) & 1;
 	PackedCol orig = Lighting.Color_ZSide_Fast(x, y, z-offset);
-	PackedCol col0_0 = Builder_FullBright ? white : Modern_GetColorZ(orig, x, y, z-offset, -1, -1);
-	PackedCol col1_0 = Builder_FullBright ? white : Modern_GetColorZ(orig, x, y, z-offset, 1, -1);
-	PackedCol col1_1 = Builder_FullBright ? white : Modern_GetColorZ(orig, x, y, z-offset, 1, 1);
-	PackedCol col0_1 = Builder_FullBright ? white : Modern_GetColorZ(orig, x, y, z-offset, -1, 1);
+	PackedCol col0_0 = ctx->fullBright ? white : Modern_GetColorZ(orig, x, y, z-offset, -1, -1);
+	PackedCol col1_0 = ctx->fullBright ? white : Modern_GetColorZ(orig, x, y, z-offset, 1, -1);
+	PackedCol col1_1 = ctx->fullBright ? white : Modern_GetColorZ(orig, x, y, z-offset, 1, 1);
+	PackedCol col0_1 = ctx->fullBright ? white : Modern_GetColorZ(orig, x, y, z-offset, -1, 1);
 	struct VertexTextured* vertices, v;
 
-	if (adv_tinted) {
-		tint   = Blocks.FogCol[Builder_Block];
+	if (ctx->tinted) {
+		tint   = Blocks.FogCol[ctx->block];
 		col0_0 = PackedCol_Tint(col0_0, tint); col1_0 = PackedCol_Tint(col1_0, tint);
 		col1_1 = PackedCol_Tint(col1_1, tint); col0_1 = PackedCol_Tint(col0_1, tint);
 	}
 
 	vertices = part->faces.vertices[FACE_ZMIN];
-	v.z = adv_z1;
-		v.x = adv_x1;               v.y = adv_y1; v.U = u1; v.V = v2; v.Col = col0_0; *vertices++ = v;
-		                            v.y = adv_y2;           v.V = v1; v.Col = col0_1; *vertices++ = v;
-		v.x = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
-		                            v.y = adv_y1;           v.V = v2; v.Col = col1_0; *vertices++ = v;
+	v.z = ctx->z1;
+		v.x = ctx->x1;               v.y = ctx->y1; v.U = u1; v.V = v2; v.Col = col0_0; *vertices++ = v;
+		                            v.y = ctx->y2;           v.V = v1; v.Col = col0_1; *vertices++ = v;
+		v.x = ctx->x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
+		                            v.y = ctx->y1;           v.V = v2; v.Col = col1_0; *vertices++ = v;
 	part->faces.vertices[FACE_ZMIN] = vertices;
 }
 
-static void Modern_DrawZMax(int count, int x, int y, int z) {
-	TextureLoc texLoc = Block_Tex(Builder_Block, FACE_ZMAX);
+static void Modern_DrawZMax(struct BuilderContext* ctx, int count, int x, int y, int z) {
+	TextureLoc texLoc = Block_Tex(ctx->block, FACE_ZMAX);
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = adv_minBB.x, u2 = (count - 1) + adv_maxBB.x * UV2_Scale;
-	float v1 = vOrigin + adv_maxBB.y * Atlas1D.InvTileSize;
-	float v2 = vOrigin + adv_minBB.y * Atlas1D.InvTileSize * UV2_Scale;
-	struct Builder1DPart* part = &Builder_Parts[adv_baseOffset + Atlas1D_Index(texLoc)];
+	float u1 = ctx->minBB.x, u2 = (count - 1) + ctx->maxBB.x * UV2_Scale;
+	float v1 = vOrigin + ctx->maxBB.y * Atlas1D.InvTileSize;
+	float v2 = vOrigin + ctx->minBB.y * Atlas1D.InvTileSize * UV2_Scale;
+	struct Builder1DPart* part = &ctx->parts[ctx->baseOffset + Atlas1D_Index(texLoc)];
 
 	PackedCol tint, white = PACKEDCOL_WHITE;
-	int offset = 1;// (Blocks.LightOffset[Builder_Block] >> FACE_ZMAX) & 1;
+	int offset = 1;// (Blocks.LightOffset[ctx->block] >> FACE_ZMAX) & 1;
 	PackedCol orig = Lighting.Color_ZSide_Fast(x, y, z+offset);
-	PackedCol col0_0 = Builder_FullBright ? white : Modern_GetColorZ(orig, x, y, z+offset, -1, -1);
-	PackedCol col1_0 = Builder_FullBright ? white : Modern_GetColorZ(orig, x, y, z+offset, 1, -1);
-	PackedCol col1_1 = Builder_FullBright ? white : Modern_GetColorZ(orig, x, y, z+offset, 1, 1);
-	PackedCol col0_1 = Builder_FullBright ? white : Modern_GetColorZ(orig, x, y, z+offset, -1, 1);
+	PackedCol col0_0 = ctx->fullBright ? white : Modern_GetColorZ(orig, x, y, z+offset, -1, -1);
+	PackedCol col1_0 = ctx->fullBright ? white : Modern_GetColorZ(orig, x, y, z+offset, 1, -1);
+	PackedCol col1_1 = ctx->fullBright ? white : Modern_GetColorZ(orig, x, y, z+offset, 1, 1);
+	PackedCol col0_1 = ctx->fullBright ? white : Modern_GetColorZ(orig, x, y, z+offset, -1, 1);
 	struct VertexTextured* vertices, v;
 
-	if (adv_tinted) {
-		tint   = Blocks.FogCol[Builder_Block];
+	if (ctx->tinted) {
+		tint   = Blocks.FogCol[ctx->block];
 		col0_0 = PackedCol_Tint(col0_0, tint); col1_0 = PackedCol_Tint(col1_0, tint);
 		col1_1 = PackedCol_Tint(col1_1, tint); col0_1 = PackedCol_Tint(col0_1, tint);
 	}
 
 	vertices = part->faces.vertices[FACE_ZMAX];
-	v.z = adv_z2;
-		v.x = adv_x2 + (count - 1); v.y = adv_y2; v.U = u2; v.V = v1; v.Col = col1_1; *vertices++ = v;
-		v.x = adv_x1;                             v.U = u1;           v.Col = col0_1; *vertices++ = v;
-		                            v.y = adv_y1;           v.V = v2; v.Col = col0_0; *vertices++ = v;
-		v.x = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
+	v.z = ctx->z2;
+		v.x = ctx->x2 + (count - 1); v.y = ctx->y2; v.U = u2; v.V = v1; v.Col = col1_1; *vertices++ = v;
+		v.x = ctx->x1;                             v.U = u1;           v.Col = col0_1; *vertices++ = v;
+		                            v.y = ctx->y1;           v.V = v2; v.Col = col0_0; *vertices++ = v;
+		v.x = ctx->x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
 	part->faces.vertices[FACE_ZMAX] = vertices;
 }
 
@@ -1484,36 +1637,36 @@ static PackedCol Modern_GetColorYMin(PackedCol orig, int x, int y, int z, int oX
 	PackedCol cd = AVERAGE(CoXoZ, orig);
 	return AVERAGE(ab, cd);
 }
-static void Modern_DrawYMin(int count, int x, int y, int z) {
-	TextureLoc texLoc = Block_Tex(Builder_Block, FACE_YMIN);
+static void Modern_DrawYMin(struct BuilderContext* ctx, int count, int x, int y, int z) {
+	TextureLoc texLoc = Block_Tex(ctx->block, FACE_YMIN);
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = adv_minBB.x, u2 = (count - 1) + adv_maxBB.x * UV2_Scale;
-	float v1 = vOrigin + adv_minBB.z * Atlas1D.InvTileSize;
-	float v2 = vOrigin + adv_maxBB.z * Atlas1D.InvTileSize * UV2_Scale;
-	struct Builder1DPart* part = &Builder_Parts[adv_baseOffset + Atlas1D_Index(texLoc)];
+	float u1 = ctx->minBB.x, u2 = (count - 1) + ctx->maxBB.x * UV2_Scale;
+	float v1 = vOrigin + ctx->minBB.z * Atlas1D.InvTileSize;
+	float v2 = vOrigin + ctx->maxBB.z * Atlas1D.InvTileSize * UV2_Scale;
+	struct Builder1DPart* part = &ctx->parts[ctx->baseOffset + Atlas1D_Index(texLoc)];
 
 	PackedCol tint, white = PACKEDCOL_WHITE;
-	int offset = 1;// (Blocks.LightOffset[Builder_Block] >> FACE_YMIN) & 1;
+	int offset = 1;// (Blocks.LightOffset[ctx->block] >> FACE_YMIN) & 1;
 	PackedCol orig = Lighting.Color_YMin_Fast(x, y-offset, z);
-	PackedCol col0_0 = Builder_FullBright ? white : Modern_GetColorYMin(orig, x, y-offset, z, -1, -1);
-	PackedCol col1_0 = Builder_FullBright ? white : Modern_GetColorYMin(orig, x, y-offset, z,  1, -1);
-	PackedCol col1_1 = Builder_FullBright ? white : Modern_GetColorYMin(orig, x, y-offset, z,  1,  1);
-	PackedCol col0_1 = Builder_FullBright ? white : Modern_GetColorYMin(orig, x, y-offset, z, -1,  1);
+	PackedCol col0_0 = ctx->fullBright ? white : Modern_GetColorYMin(orig, x, y-offset, z, -1, -1);
+	PackedCol col1_0 = ctx->fullBright ? white : Modern_GetColorYMin(orig, x, y-offset, z,  1, -1);
+	PackedCol col1_1 = ctx->fullBright ? white : Modern_GetColorYMin(orig, x, y-offset, z,  1,  1);
+	PackedCol col0_1 = ctx->fullBright ? white : Modern_GetColorYMin(orig, x, y-offset, z, -1,  1);
 	struct VertexTextured* vertices, v;
 
-	if (adv_tinted) {
-		tint   = Blocks.FogCol[Builder_Block];
+	if (ctx->tinted) {
+		tint   = Blocks.FogCol[ctx->block];
 		col0_0 = PackedCol_Tint(col0_0, tint); col1_0 = PackedCol_Tint(col1_0, tint);
 		col1_1 = PackedCol_Tint(col1_1, tint); col0_1 = PackedCol_Tint(col0_1, tint);
 	}
 
 	vertices = part->faces.vertices[FACE_YMIN];
-	v.y = adv_y1;
-		v.x = adv_x1;               v.z = adv_z2; v.U = u1; v.V = v2; v.Col = col0_1; *vertices++ = v;
-		                            v.z = adv_z1;           v.V = v1; v.Col = col0_0; *vertices++ = v;
-		v.x = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
-		                            v.z = adv_z2;           v.V = v2; v.Col = col1_1; *vertices++ = v;
+	v.y = ctx->y1;
+		v.x = ctx->x1;               v.z = ctx->z2; v.U = u1; v.V = v2; v.Col = col0_1; *vertices++ = v;
+		                            v.z = ctx->z1;           v.V = v1; v.Col = col0_0; *vertices++ = v;
+		v.x = ctx->x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
+		                            v.z = ctx->z2;           v.V = v2; v.Col = col1_1; *vertices++ = v;
 	part->faces.vertices[FACE_YMIN] = vertices;
 }
 
@@ -1530,81 +1683,80 @@ static PackedCol Modern_GetColorYMax(PackedCol orig, int x, int y, int z, int oX
 	PackedCol cd = AVERAGE(CoXoZ, orig);
 	return AVERAGE(ab, cd);
 }
-static void Modern_DrawYMax(int count, int x, int y, int z) {
-	TextureLoc texLoc = Block_Tex(Builder_Block, FACE_YMAX);
+static void Modern_DrawYMax(struct BuilderContext* ctx, int count, int x, int y, int z) {
+	TextureLoc texLoc = Block_Tex(ctx->block, FACE_YMAX);
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = adv_minBB.x, u2 = (count - 1) + adv_maxBB.x * UV2_Scale;
-	float v1 = vOrigin + adv_minBB.z * Atlas1D.InvTileSize;
-	float v2 = vOrigin + adv_maxBB.z * Atlas1D.InvTileSize * UV2_Scale;
-	struct Builder1DPart* part = &Builder_Parts[adv_baseOffset + Atlas1D_Index(texLoc)];
+	float u1 = ctx->minBB.x, u2 = (count - 1) + ctx->maxBB.x * UV2_Scale;
+	float v1 = vOrigin + ctx->minBB.z * Atlas1D.InvTileSize;
+	float v2 = vOrigin + ctx->maxBB.z * Atlas1D.InvTileSize * UV2_Scale;
+	struct Builder1DPart* part = &ctx->parts[ctx->baseOffset + Atlas1D_Index(texLoc)];
 
 	PackedCol tint, white = PACKEDCOL_WHITE;
-	int offset = 1;// (Blocks.LightOffset[Builder_Block] >> FACE_YMAX) & 1;
+	int offset = 1;// (Blocks.LightOffset[ctx->block] >> FACE_YMAX) & 1;
 	PackedCol orig = Lighting.Color(x, y+offset, z);
-	PackedCol col0_0 = Builder_FullBright ? white : Modern_GetColorYMax(orig, x, y+offset, z, -1, -1);
-	PackedCol col1_0 = Builder_FullBright ? white : Modern_GetColorYMax(orig, x, y+offset, z,  1, -1);
-	PackedCol col1_1 = Builder_FullBright ? white : Modern_GetColorYMax(orig, x, y+offset, z,  1,  1);
-	PackedCol col0_1 = Builder_FullBright ? white : Modern_GetColorYMax(orig, x, y+offset, z, -1,  1);
+	PackedCol col0_0 = ctx->fullBright ? white : Modern_GetColorYMax(orig, x, y+offset, z, -1, -1);
+	PackedCol col1_0 = ctx->fullBright ? white : Modern_GetColorYMax(orig, x, y+offset, z,  1, -1);
+	PackedCol col1_1 = ctx->fullBright ? white : Modern_GetColorYMax(orig, x, y+offset, z,  1,  1);
+	PackedCol col0_1 = ctx->fullBright ? white : Modern_GetColorYMax(orig, x, y+offset, z, -1,  1);
 
 	struct VertexTextured* vertices, v;
 
-	if (adv_tinted) {
-		tint   = Blocks.FogCol[Builder_Block];
+	if (ctx->tinted) {
+		tint   = Blocks.FogCol[ctx->block];
 		col0_0 = PackedCol_Tint(col0_0, tint); col1_0 = PackedCol_Tint(col1_0, tint);
 		col1_1 = PackedCol_Tint(col1_1, tint); col0_1 = PackedCol_Tint(col0_1, tint);
 	}
 
 	vertices = part->faces.vertices[FACE_YMAX];
-	v.y = adv_y2;
-		v.x = adv_x1;               v.z = adv_z1; v.U = u1; v.V = v1; v.Col = col0_0; *vertices++ = v;
-		                            v.z = adv_z2;           v.V = v2; v.Col = col0_1; *vertices++ = v;
-		v.x = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
-		                            v.z = adv_z1;           v.V = v1; v.Col = col1_0; *vertices++ = v;
+	v.y = ctx->y2;
+		v.x = ctx->x1;               v.z = ctx->z1; v.U = u1; v.V = v1; v.Col = col0_0; *vertices++ = v;
+		                            v.z = ctx->z2;           v.V = v2; v.Col = col0_1; *vertices++ = v;
+		v.x = ctx->x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
+		                            v.z = ctx->z1;           v.V = v1; v.Col = col1_0; *vertices++ = v;
 	part->faces.vertices[FACE_YMAX] = vertices;
 }
 
-static void Modern_RenderBlock(int index, int x, int y, int z) {
+static void Modern_RenderBlock(struct BuilderContext* ctx, int index, int x, int y, int z) {
 	Vec3 min, max;
 	int count_XMin, count_XMax, count_ZMin;
 	int count_ZMax, count_YMin, count_YMax;
 
-	if (Blocks.Draw[Builder_Block] == DRAW_SPRITE) {
-		Builder_DrawSprite(x, y, z); return;
+	if (Blocks.Draw[ctx->block] == DRAW_SPRITE) {
+		Builder_DrawSprite(ctx, x, y, z); return;
 	}
 
-	count_XMin = Builder_Counts[index + FACE_XMIN];
-	count_XMax = Builder_Counts[index + FACE_XMAX];
-	count_ZMin = Builder_Counts[index + FACE_ZMIN];
-	count_ZMax = Builder_Counts[index + FACE_ZMAX];
-	count_YMin = Builder_Counts[index + FACE_YMIN];
-	count_YMax = Builder_Counts[index + FACE_YMAX];
+	count_XMin = ctx->counts[index + FACE_XMIN];
+	count_XMax = ctx->counts[index + FACE_XMAX];
+	count_ZMin = ctx->counts[index + FACE_ZMIN];
+	count_ZMax = ctx->counts[index + FACE_ZMAX];
+	count_YMin = ctx->counts[index + FACE_YMIN];
+	count_YMax = ctx->counts[index + FACE_YMAX];
 
 	if (!count_XMin && !count_XMax && !count_ZMin &&
 		!count_ZMax && !count_YMin && !count_YMax) return;
 
-	Builder_FullBright = Blocks.Brightness[Builder_Block];
-	adv_baseOffset = (Blocks.Draw[Builder_Block] == DRAW_TRANSLUCENT) * ATLAS1D_MAX_ATLASES;
-	adv_tinted = Blocks.Tinted[Builder_Block];
+	ctx->fullBright = Blocks.Brightness[ctx->block];
+	ctx->baseOffset = (Blocks.Draw[ctx->block] == DRAW_TRANSLUCENT) * ATLAS1D_MAX_ATLASES;
+	ctx->tinted = Blocks.Tinted[ctx->block];
 
-	min = Blocks.RenderMinBB[Builder_Block]; max = Blocks.RenderMaxBB[Builder_Block];
-	adv_x1 = x + min.x; adv_y1 = y + min.y; adv_z1 = z + min.z;
-	adv_x2 = x + max.x; adv_y2 = y + max.y; adv_z2 = z + max.z;
+	min = Blocks.RenderMinBB[ctx->block]; max = Blocks.RenderMaxBB[ctx->block];
+	ctx->x1 = x + min.x; ctx->y1 = y + min.y; ctx->z1 = z + min.z;
+	ctx->x2 = x + max.x; ctx->y2 = y + max.y; ctx->z2 = z + max.z;
 
-	adv_minBB = Blocks.MinBB[Builder_Block]; adv_maxBB = Blocks.MaxBB[Builder_Block];
-	adv_minBB.y = 1.0f - adv_minBB.y; adv_maxBB.y = 1.0f - adv_maxBB.y;
+	ctx->minBB = Blocks.MinBB[ctx->block]; ctx->maxBB = Blocks.MaxBB[ctx->block];
+	ctx->minBB.y = 1.0f - ctx->minBB.y; ctx->maxBB.y = 1.0f - ctx->maxBB.y;
 
-	if (count_XMin) Modern_DrawXMin(count_XMin, x, y, z);
-	if (count_XMax) Modern_DrawXMax(count_XMax, x, y, z);
-	if (count_ZMin) Modern_DrawZMin(count_ZMin, x, y, z);
-	if (count_ZMax) Modern_DrawZMax(count_ZMax, x, y, z);
-	if (count_YMin) Modern_DrawYMin(count_YMin, x, y, z);
-	if (count_YMax) Modern_DrawYMax(count_YMax, x, y, z);
+	if (count_XMin) Modern_DrawXMin(ctx, count_XMin, x, y, z);
+	if (count_XMax) Modern_DrawXMax(ctx, count_XMax, x, y, z);
+	if (count_ZMin) Modern_DrawZMin(ctx, count_ZMin, x, y, z);
+	if (count_ZMax) Modern_DrawZMax(ctx, count_ZMax, x, y, z);
+	if (count_YMin) Modern_DrawYMin(ctx, count_YMin, x, y, z);
+	if (count_YMax) Modern_DrawYMax(ctx, count_YMax, x, y, z);
 }
 
-static void Modern_PrePrepareChunk(void) {
-	DefaultPrePrepateChunk();
-	adv_bitFlags = Builder_BitFlags;
+static void Modern_PrePrepareChunk(struct BuilderContext* ctx) {
+	DefaultPrePrepateChunk(ctx);
 }
 
 static void ModernBuilder_SetActive(void) {
@@ -1653,9 +1805,15 @@ static void OnNewMapLoaded(void) {
 	Builder_EdgeLevel  = max(0, Env.EdgeHeight);
 }
 
+static void OnFree(void) {
+	Mem_Free(builder_jobs);
+	builder_jobs = NULL;
+	builder_jobsCapacity = 0;
+}
+
 struct IGameComponent Builder_Component = {
 	OnInit, /* Init */
-	NULL, /* Free */
+	OnFree, /* Free */
 	NULL, /* Reset */
 	NULL, /* OnNewMap */
 	OnNewMapLoaded /* OnNewMapLoaded */
@@ -21,6 +21,9 @@ extern cc_bool Builder_SmoothLighting;
 
 /* Builds the mesh of vertices for the given chunk. */
 void Builder_MakeChunk(struct ChunkInfo* info);
+/* Builds the meshes of vertices for the given chunks. */
+/* NOTE: Meshes are built in parallel using the worker pool when possible. */
+void Builder_MakeChunks(struct ChunkInfo** infos, int count);
 
 void Builder_ApplyActive(void);
 
@@ -141,6 +141,10 @@ cc_result ZLibHeader_Read(struct Stream* s, struct ZLibHeader* header) {
 /*########################################################################################################################*
 *--------------------------------------------------Inflate (decompress)---------------------------------------------------*
 *#########################################################################################################################*/
+#ifdef CC_BUILD_BENCHMARK
+cc_bool Inflate_ReferenceFast;
+#endif
+
 enum INFLATE_STATE_ {
 	INFLATE_STATE_HEADER, INFLATE_STATE_UNCOMPRESSED_HEADER,
 	INFLATE_STATE_UNCOMPRESSED_DATA, INFLATE_STATE_DYNAMIC_HEADER,
@@ -174,8 +178,9 @@ enum INFLATE_STATE_ {
 #define Inflate_NextCompressState(state) ((state->AvailIn >= INFLATE_FASTINF_IN && state->AvailOut >= INFLATE_FASTINF_OUT) ? INFLATE_STATE_FASTCOMPRESSED : INFLATE_STATE_COMPRESSED_LIT)
 /* The maximum amount of bytes that can be output is 258 */
 #define INFLATE_FASTINF_OUT 258
-/* The most input bytes required for huffman codes and extra data is 16 + 5 + 16 + 13 bits. Add 3 extra bytes to account for putting data into the bit buffer. */
-#define INFLATE_FASTINF_IN 10
+/* The most input bits required for huffman codes and extra data is 15 + 5 + 15 + 13 bits. */
+/* Add 8 extra bytes to account for bit buffer refills reading ahead of the data actually consumed. */
+#define INFLATE_FASTINF_IN 16
 
 static cc_uint32 Huffman_ReverseBits(cc_uint32 n, cc_uint8 bits) {
 	n = ((n & 0xAAAA) >> 1) | ((n & 0x5555) << 1);
@@ -306,46 +311,6 @@ static int Huffman_Decode(struct InflateState* state, struct HuffmanTable* table
 	return -1;
 }
 
-/* Inline the common <= 9 bits case */
-#define Huffman_UNSAFE_Decode(state, table, result) \
-{\
-	Inflate_UNSAFE_EnsureBits(state, INFLATE_MAX_BITS);\
-	packed = table.fast[Inflate_PeekBits(state, INFLATE_FAST_BITS)];\
-	if (packed >= 0) {\
-		consumedBits = packed >> INFLATE_FAST_BITS;\
-		Inflate_ConsumeBits(state, consumedBits);\
-		result = packed & 0x1FF;\
-	} else {\
-		result = Huffman_UNSAFE_Decode_Slow(state, &table);\
-	}\
-}
-
-static int Huffman_UNSAFE_Decode_Slow(struct InflateState* state, struct HuffmanTable* table) {
-	cc_uint32 i, j, codeword;
-	int offset;
-
-	/* Slow, bit by bit lookup. Need to reverse order for huffman. */
-	codeword = Inflate_PeekBits(state,       INFLATE_FAST_BITS);
-	codeword = Huffman_ReverseBits(codeword, INFLATE_FAST_BITS);
-
-	for (i = INFLATE_FAST_BITS + 1, j = INFLATE_FAST_BITS; i < INFLATE_MAX_BITS; i++, j++) {
-		codeword = (codeword << 1) | ((state->Bits >> j) & 1);
-
-		if (codeword < table->endCodewords[i]) {
-			offset = table->firstOffsets[i] + (codeword - table->firstCodewords[i]);
-			Inflate_ConsumeBits(state, i);
-			return table->values[offset];
-		}
-	}
-
-	Inflate_Fail(state, INF_ERR_INVALID_CODE);
-	/* Need to exit the fast decode loop */
-	/* TODO: This means a few garbage bytes can get written */
-	/* to the output, but it probably doesn't matter */
-	state->AvailIn = 0;
-	return 0;
-}
-
 void Inflate_Init2(struct InflateState* state, struct Stream* source) {
 	state->State = INFLATE_STATE_HEADER;
 	state->LastBlock = false;
@@ -399,7 +364,333 @@ static const cc_uint8 codelens_order[INFLATE_MAX_CODELENS] = {
 	16,17,18,0,8,7,9,6,10,5,11,4,12,3,13,2,14,1,15 
 };
 
+/* Reads the next huffman encoded value from the given bits, for codewords longer than INFLATE_FAST_BITS */
+/* Returns -1 if the bits do not correspond to any valid codeword */
+static int Huffman_DecodeSlow(struct HuffmanTable* table, cc_uint32 bits, int* bitsLen) {
+	cc_uint32 i, codeword;
+	int offset;
+
+	/* Slow, bit by bit lookup. Need to reverse order for huffman. */
+	codeword = bits & ((1UL << INFLATE_FAST_BITS) - 1);
+	codeword = Huffman_ReverseBits(codeword, INFLATE_FAST_BITS);
+
+	for (i = INFLATE_FAST_BITS + 1; i < INFLATE_MAX_BITS; i++) {
+		codeword = (codeword << 1) | ((bits >> (i - 1)) & 1);
+
+		if (codeword < table->endCodewords[i]) {
+			offset   = table->firstOffsets[i] + (codeword - table->firstCodewords[i]);
+			*bitsLen = i;
+			return table->values[offset];
+		}
+	}
+	return -1;
+}
+
+/* Fast lookup table entries resolve as much as possible from the next INFLATE_FAST_BITS bits: */
+/*   bits 0-4 = total number of bits consumed (0 means cannot be resolved from the lookup table) */
+/*   bits 5-6 = type of entry, bit 7 = whether literal entry has a second literal */
+/*   bits 8-15 = first literal, bits 16-23 = second literal  OR  bits 8-16 = match length */
+/* For distance entries, bits 0-4 are the same, and bits 16-31 = match distance */
+#define INFLATE_ENTRY_LIT 0x20
+#define INFLATE_ENTRY_LEN 0x40
+#define INFLATE_ENTRY_END 0x60
+#define INFLATE_ENTRY_TWOLITS 0x80
+#define Inflate_EntryBits(entry) ((entry) & 0x1F)
+#define Inflate_EntryType(entry) ((entry) & 0x60)
+
+/* Computes the fast lookup tables for the current literals/lengths and distances huffman tables */
+static void Inflate_BuildFastTables(struct InflateState* s) {
+	struct HuffmanTable* lits  = &s->Table.Lits;
+	struct HuffmanTable* dists = &s->TableDists;
+	cc_uint32 entry, extra;
+	int i, packed, next, sym, len, nextLen, idx;
+
+	for (i = 0; i < (1 << INFLATE_FAST_BITS); i++) {
+		packed = lits->fast[i];
+		entry  = 0;
+
+		if (packed >= 0) {
+			len = packed >> INFLATE_FAST_LEN_SHIFT;
+			sym = packed & INFLATE_FAST_VAL_MASK;
+
+			if (sym < 256) {
+				entry = len | INFLATE_ENTRY_LIT | (sym << 8);
+				/* Try to also decode a second literal from the remaining bits */
+				next  = lits->fast[i >> len];
+
+				if (next >= 0) {
+					nextLen = next >> INFLATE_FAST_LEN_SHIFT;
+					sym     = next & INFLATE_FAST_VAL_MASK;
+
+					if (sym < 256 && len + nextLen <= INFLATE_FAST_BITS) {
+						entry = (len + nextLen) | INFLATE_ENTRY_LIT | INFLATE_ENTRY_TWOLITS | (entry & 0xFF00) | (sym << 16);
+					}
+				}
+			} else if (sym == 256) {
+				entry = len | INFLATE_ENTRY_END;
+			} else if (sym <= 285) {
+				/* Try to also resolve the extra length bits */
+				idx   = sym - 257;
+				extra = len_bits[idx];
+
+				if (len + extra <= INFLATE_FAST_BITS) {
+					extra = (i >> len) & ((1 << extra) - 1);
+					entry = (len + len_bits[idx]) | INFLATE_ENTRY_LEN | ((len_base[idx] + extra) << 8);
+				}
+			}
+		}
+		s->FastLits[i] = entry;
+
+		packed = dists->fast[i];
+		entry  = 0;
+
+		if (packed >= 0) {
+			len = packed >> INFLATE_FAST_LEN_SHIFT;
+			idx = packed & INFLATE_FAST_VAL_MASK;
+
+			/* Try to also resolve the extra distance bits */
+			if (idx < 30 && len + dist_bits[idx] <= INFLATE_FAST_BITS) {
+				extra = (i >> len) & ((1 << dist_bits[idx]) - 1);
+				entry = (len + dist_bits[idx]) | ((cc_uint32)(dist_base[idx] + extra) << 16);
+			}
+		}
+		s->FastDists[i] = entry;
+	}
+}
+
+#if (defined __x86_64__ || defined __aarch64__ || defined _M_X64 || defined _M_ARM64) && !defined CC_BIG_ENDIAN
+/* 64 bit bit buffer means only one refill is needed per decoded literal/length + distance */
+typedef cc_uint64 inflate_bitbuf;
+#define INFLATE_BITBUF_64
+#else
+typedef cc_uint32 inflate_bitbuf;
+#endif
+#define INFLATE_BITBUF_BITS ((int)sizeof(inflate_bitbuf) * 8)
+
+#if defined INFLATE_BITBUF_64 && defined __GNUC__
+/* Reads 8 bytes at once, but only advances input by the number of whole bytes that fit in bit buffer */
+/* (bits above numBits may have partial data from next byte, which get ORed with the same value later) */
+#define Inflate_FastRefill() { cc_uint64 word; __builtin_memcpy(&word, in, 8); bitbuf |= word << numBits; in += (63 - numBits) >> 3; numBits |= 56; }
+#else
+#define Inflate_FastRefill() while (numBits <= INFLATE_BITBUF_BITS - 8) { bitbuf |= (inflate_bitbuf)(*in++) << numBits; numBits += 8; }
+#endif
+
+#ifdef INFLATE_BITBUF_64
+/* A full bit buffer always has enough bits for literal/length + extra + distance + extra */
+#define Inflate_FastEnsure(bits)
+#else
+#define Inflate_FastEnsure(bits) if (numBits < (bits)) Inflate_FastRefill();
+#endif
+#define Inflate_FastConsume(bits) bitbuf >>= (bits); numBits -= (bits);
+#define Inflate_FastReadBits(bits) ((cc_uint32)bitbuf & ((1UL << (bits)) - 1UL))
+
+#ifdef __GNUC__
+#define Inflate_Copy8(dst, src) __builtin_memcpy(dst, src, 8)
+#else
+#define Inflate_Copy8(dst, src) dst[0] = src[0]; dst[1] = src[1]; dst[2] = src[2]; dst[3] = src[3]; dst[4] = src[4]; dst[5] = src[5]; dst[6] = src[6]; dst[7] = src[7];
+#endif
+
+/* Decodes a literal/length or distance that could not be fully resolved using the fast lookup tables */
+static int Inflate_FastDecode(struct HuffmanTable* table, cc_uint32 bits, int* bitsLen) {
+	int packed = table->fast[bits & ((1UL << INFLATE_FAST_BITS) - 1)];
+	if (packed < 0) return Huffman_DecodeSlow(table, bits, bitsLen);
+
+	*bitsLen = packed >> INFLATE_FAST_LEN_SHIFT;
+	return packed & INFLATE_FAST_VAL_MASK;
+}
+
 static void Inflate_InflateFast(struct InflateState* s) {
+	/* huffman variables */
+	cc_uint32 entry, len, dist, i;
+	int sym, bits;
+
+	/* bit buffer variables */
+	inflate_bitbuf bitbuf;
+	int numBits;
+	cc_uint8* in;
+	cc_uint8* inEnd;
+	cc_uint32 rewind;
+
+	/* window variables */
+	cc_uint8* window;
+	cc_uint8* src;
+	cc_uint8* dst;
+	cc_uint32 curIdx, startIdx;
+	cc_uint32 copyStart, copyLen, partLen;
+
+	window = s->Window;
+	curIdx = s->WindowIndex;
+	copyStart = s->WindowIndex;
+	copyLen   = 0;
+
+	bitbuf  = s->Bits;
+	numBits = s->NumBits;
+	in      = s->NextIn;
+	inEnd   = s->NextIn + s->AvailIn;
+
+#define INFLATE_FAST_COPY_MAX (INFLATE_WINDOW_SIZE - INFLATE_FASTINF_OUT)
+	while (copyLen + INFLATE_FASTINF_OUT <= s->AvailOut && in + INFLATE_FASTINF_IN <= inEnd && copyLen < INFLATE_FAST_COPY_MAX) {
+#ifdef INFLATE_BITBUF_64
+		Inflate_FastRefill();
+#else
+		Inflate_FastEnsure(INFLATE_MAX_BITS - 1);
+#endif
+		entry = s->FastLits[bitbuf & ((1UL << INFLATE_FAST_BITS) - 1)];
+
+		if (Inflate_EntryType(entry) == INFLATE_ENTRY_LIT) {
+			Inflate_FastConsume(Inflate_EntryBits(entry));
+			window[curIdx] = (cc_uint8)(entry >> 8);
+			curIdx = (curIdx + 1) & INFLATE_WINDOW_MASK;
+			copyLen++;
+
+			if (!(entry & INFLATE_ENTRY_TWOLITS)) continue;
+			window[curIdx] = (cc_uint8)(entry >> 16);
+			curIdx = (curIdx + 1) & INFLATE_WINDOW_MASK;
+			copyLen++;
+			continue;
+		} else if (Inflate_EntryType(entry) == INFLATE_ENTRY_LEN) {
+			Inflate_FastConsume(Inflate_EntryBits(entry));
+			len = (entry >> 8) & 0x1FF;
+		} else if (Inflate_EntryType(entry) == INFLATE_ENTRY_END) {
+			Inflate_FastConsume(Inflate_EntryBits(entry));
+			s->State = Inflate_NextBlockState(s);
+			break;
+		} else {
+			sym = Inflate_FastDecode(&s->Table.Lits, (cc_uint32)bitbuf, &bits);
+			if (sym < 0 || sym > 285) { Inflate_Fail(s, INF_ERR_INVALID_CODE); break; }
+			Inflate_FastConsume(bits);
+
+			if (sym < 256) {
+				window[curIdx] = (cc_uint8)sym;
+				curIdx = (curIdx + 1) & INFLATE_WINDOW_MASK;
+				copyLen++;
+				continue;
+			} else if (sym == 256) {
+				s->State = Inflate_NextBlockState(s);
+				break;
+			}
+
+			sym -= 257;
+			Inflate_FastEnsure(len_bits[sym]);
+			len = len_base[sym] + Inflate_FastReadBits(len_bits[sym]);
+			Inflate_FastConsume(len_bits[sym]);
+		}
+
+		Inflate_FastEnsure(INFLATE_MAX_BITS - 1);
+		entry = s->FastDists[bitbuf & ((1UL << INFLATE_FAST_BITS) - 1)];
+
+		if (entry) {
+			Inflate_FastConsume(Inflate_EntryBits(entry));
+			dist = entry >> 16;
+		} else {
+			sym = Inflate_FastDecode(&s->TableDists, (cc_uint32)bitbuf, &bits);
+			if (sym < 0 || sym >= 30) { Inflate_Fail(s, INF_ERR_INVALID_CODE); break; }
+			Inflate_FastConsume(bits);
+
+			Inflate_FastEnsure(dist_bits[sym]);
+			dist = dist_base[sym] + Inflate_FastReadBits(dist_bits[sym]);
+			Inflate_FastConsume(dist_bits[sym]);
+		}
+
+		/* Window infinitely repeats like ...xyz|uvwxyz|uvwxyz|uvw... */
+		/* If start and end don't cross a boundary, can avoid masking index */
+		startIdx = (curIdx - dist) & INFLATE_WINDOW_MASK;
+		if (curIdx >= startIdx && (curIdx + len) < INFLATE_WINDOW_SIZE) {
+			src = &window[startIdx];
+			dst = &window[curIdx];
+
+			/* Source and destination 8 byte blocks can't overlap when distance is at least 8 */
+			/* NOTE: Must not write past end of match, as window data after is still needed */
+			if (dist >= 8) {
+				for (i = 0; i + 8 <= len; i += 8, dst += 8, src += 8) { Inflate_Copy8(dst, src); }
+				for (; i < len; i++) { *dst++ = *src++; }
+			} else if (dist == 1) {
+				Mem_Set(dst, *src, len);
+			} else {
+				for (i = 0; i < len; i++) { *dst++ = *src++; }
+			}
+		} else {
+			for (i = 0; i < len; i++) {
+				window[(curIdx + i) & INFLATE_WINDOW_MASK] = window[(startIdx + i) & INFLATE_WINDOW_MASK];
+			}
+		}
+		curIdx   = (curIdx + len) & INFLATE_WINDOW_MASK;
+		copyLen += len;
+	}
+
+	/* Give back whole bytes that were read into the bit buffer but not used yet */
+	rewind   = min((cc_uint32)numBits >> 3, (cc_uint32)(in - s->NextIn));
+	in      -= rewind;
+	numBits -= rewind * 8;
+
+#ifdef INFLATE_BITBUF_64
+	bitbuf &= ((cc_uint64)1 << numBits) - 1;
+#endif
+	s->Bits    = (cc_uint32)bitbuf;
+	s->NumBits = numBits;
+	s->AvailIn = (cc_uint32)(inEnd - in);
+	s->NextIn  = in;
+
+	s->WindowIndex = curIdx;
+	s->AvailOut   -= copyLen;
+	if (!copyLen) return;
+
+	if (copyStart + copyLen < INFLATE_WINDOW_SIZE) {
+		Mem_Copy(s->Output, &s->Window[copyStart], copyLen);
+		s->Output += copyLen;
+	} else {
+		partLen = INFLATE_WINDOW_SIZE - copyStart;
+		Mem_Copy(s->Output, &s->Window[copyStart], partLen);
+		s->Output += partLen;
+		Mem_Copy(s->Output, s->Window, copyLen - partLen);
+		s->Output += (copyLen - partLen);
+	}
+}
+
+#ifdef CC_BUILD_BENCHMARK
+/* Inline the common <= INFLATE_FAST_BITS case */
+#define Huffman_UNSAFE_Decode(state, table, result) \
+{\
+	Inflate_UNSAFE_EnsureBits(state, INFLATE_MAX_BITS);\
+	packed = table.fast[Inflate_PeekBits(state, INFLATE_FAST_BITS)];\
+	if (packed >= 0) {\
+		consumedBits = packed >> INFLATE_FAST_LEN_SHIFT;\
+		Inflate_ConsumeBits(state, consumedBits);\
+		result = packed & INFLATE_FAST_VAL_MASK;\
+	} else {\
+		result = Huffman_UNSAFE_Decode_Slow(state, &table);\
+	}\
+}
+
+static int Huffman_UNSAFE_Decode_Slow(struct InflateState* state, struct HuffmanTable* table) {
+	cc_uint32 i, j, codeword;
+	int offset;
+
+	/* Slow, bit by bit lookup. Need to reverse order for huffman. */
+	codeword = Inflate_PeekBits(state,       INFLATE_FAST_BITS);
+	codeword = Huffman_ReverseBits(codeword, INFLATE_FAST_BITS);
+
+	for (i = INFLATE_FAST_BITS + 1, j = INFLATE_FAST_BITS; i < INFLATE_MAX_BITS; i++, j++) {
+		codeword = (codeword << 1) | ((state->Bits >> j) & 1);
+
+		if (codeword < table->endCodewords[i]) {
+			offset = table->firstOffsets[i] + (codeword - table->firstCodewords[i]);
+			Inflate_ConsumeBits(state, i);
+			return table->values[offset];
+		}
+	}
+
+	Inflate_Fail(state, INF_ERR_INVALID_CODE);
+	/* Need to exit the fast decode loop */
+	/* TODO: This means a few garbage bytes can get written */
+	/* to the output, but it probably doesn't matter */
+	state->AvailIn = 0;
+	return 0;
+}
+
+/* The previous fast path, which decodes one huffman code at a time using the state's bit buffer */
+/*  (only kept so the benchmark can compare the output and speed of the current fast path against it) */
+static void Inflate_InflateFastReference(struct InflateState* s) {
 	/* huffman variables */
 	cc_uint32 lit, len, dist;
 	cc_uint32 bits, lenIdx, distIdx;
@@ -415,7 +706,6 @@ static void Inflate_InflateFast(struct InflateState* s) {
 	copyStart = s->WindowIndex;
 	copyLen   = 0;
 
-#define INFLATE_FAST_COPY_MAX (INFLATE_WINDOW_SIZE - INFLATE_FASTINF_OUT)
 	while (s->AvailOut >= INFLATE_FASTINF_OUT && s->AvailIn >= INFLATE_FASTINF_IN && copyLen < INFLATE_FAST_COPY_MAX) {
 		Huffman_UNSAFE_Decode(s, s->Table.Lits, lit);
 
@@ -474,6 +764,7 @@ static void Inflate_InflateFast(struct InflateState* s) {
 		s->Output += (copyLen - partLen);
 	}
 }
+#endif
 
 void Inflate_Process(struct InflateState* s) {
 	cc_uint32 len, dist, nlen;
@@ -507,6 +798,7 @@ void Inflate_Process(struct InflateState* s) {
 			case 1: { /* Fixed/static huffman compressed */
 				(void)Huffman_Build(&s->Table.Lits, fixed_lits,  INFLATE_MAX_LITS);
 				(void)Huffman_Build(&s->TableDists, fixed_dists, INFLATE_MAX_DISTS);
+				Inflate_BuildFastTables(s);
 				s->State = Inflate_NextCompressState(s);
 			} break;
 
@@ -619,6 +911,7 @@ void Inflate_Process(struct InflateState* s) {
 				if (res) { Inflate_Fail(s, res); return; }
 				res = Huffman_Build(&s->TableDists, s->Buffer + s->NumLits, s->NumDists);
 				if (res) { Inflate_Fail(s, res); return; }
+				Inflate_BuildFastTables(s);
 			}
 			break;
 		}
@@ -728,7 +1021,15 @@ void Inflate_Process(struct InflateState* s) {
 		}
 
 		case INFLATE_STATE_FASTCOMPRESSED: {
+#ifdef CC_BUILD_BENCHMARK
+			if (Inflate_ReferenceFast) {
+				Inflate_InflateFastReference(s);
+			} else {
+				Inflate_InflateFast(s);
+			}
+#else
 			Inflate_InflateFast(s);
+#endif
 			if (s->State == INFLATE_STATE_FASTCOMPRESSED) {
 				s->State = Inflate_NextCompressState(s);
 			}
@@ -792,161 +1093,526 @@ void Inflate_MakeStream2(struct Stream* stream, struct InflateState* state, stru
 /*########################################################################################################################*
 *---------------------------------------------------Deflate (compress)----------------------------------------------------*
 *#########################################################################################################################*/
-/* these are copies of len_base and dist_base, with UINT16_MAX instead of 0 for sentinel cutoff */
-static const cc_uint16 deflate_len[30] = {
-	3,4,5,6,7,8,9,10,11,13,
-	15,17,19,23,27,31,35,43,51,59,
-	67,83,99,115,131,163,195,227,258,UInt16_MaxValue
-};
-static const cc_uint16 deflate_dist[31] = {
-	1,2,3,4,5,7,9,13,17,25,
-	33,49,65,97,129,193,257,385,513,769,
-	1025,1537,2049,3073,4097,6145,8193,12289,16385,24577,UInt16_MaxValue
-};
-
 /* Pushes given bits, but does not write them */
 #define Deflate_PushBits(state, value, bits) state->Bits |= (value) << state->NumBits; state->NumBits += (bits);
-/* Pushes bits of the huffman codeword bits for the given literal, but does not write them */
-#define Deflate_PushLit(state, value) Deflate_PushBits(state, state->LitsCodewords[value], state->LitsLens[value])
-/* Pushes given bits (reversing for huffman code), but does not write them */
-#define Deflate_PushHuff(state, value, bits) Deflate_PushBits(state, Huffman_ReverseBits(value, bits), bits)
 /* Writes given byte to output */
 #define Deflate_WriteByte(state) *state->NextOut++ = state->Bits; state->AvailOut--; state->Bits >>= 8; state->NumBits -= 8;
 /* Flushes bits in buffer to output buffer */
 #define Deflate_FlushBits(state) while (state->NumBits >= 8) { Deflate_WriteByte(state); }
+/* Writes given bits to output buffer */
+#define Deflate_WriteBits(state, value, bits) Deflate_PushBits(state, value, bits); Deflate_FlushBits(state);
 
 #define MIN_MATCH_LEN 3
 #define MAX_MATCH_LEN 258
+/* Maximum number of literal/length codes that can actually be used */
+#define DEFLATE_MAX_LITS  286
+/* Maximum number of distance codes that can actually be used */
+#define DEFLATE_MAX_DISTS 30
+/* Maximum bit length of a codeword for the codeword lengths huffman table */
+#define DEFLATE_MAX_CODELEN_BITS 7
+/* Token values with this bit set represent a length (followed by a distance token) */
+#define DEFLATE_TOKEN_MATCH 0x8000
+
+/* Parameters that control how hard the compressor tries to find longer matches */
+static const struct DeflateParams {
+	cc_uint16 maxChain; /* Maximum number of previous matches to explore */
+	cc_uint16 niceLen;  /* Stop searching for longer matches once a match is at least this long */
+	cc_uint16 lazyLen;  /* Only check for a longer match at the next byte when match is shorter than this */
+	cc_bool insertAll;  /* Whether to add every byte of a match to the hash chains, instead of just first byte */
+} deflate_params[DEFLATE_LEVEL_COUNT] = {
+	{    5,  32,   8, false }, /* DEFLATE_LEVEL_FAST */
+	{   32, 128,  32, true  }, /* DEFLATE_LEVEL_DEFAULT */
+	{ 1024, 258, 258, true  }, /* DEFLATE_LEVEL_MAX */
+};
+
+/* Lookup tables for the length code (minus 257) of each match length, and code of each distance */
+/* NOTE: Distance codes of distances > 256 are looked up using ((distance - 1) >> 7) + 256 */
+static cc_uint8 deflate_lenCodes[MAX_MATCH_LEN + 1];
+static cc_uint8 deflate_distCodes[512];
+static cc_bool deflate_codesInited;
+
+void Deflate_Init(void) {
+	int i, j, dist;
+	if (deflate_codesInited) return;
+
+	for (i = 0; i < DEFLATE_MAX_LITS - 257; i++) {
+		for (j = 0; j < (1 << len_bits[i]); j++) {
+			deflate_lenCodes[len_base[i] + j] = i;
+		}
+	}
+	/* Length 258 can be represented by code 284 too, but code 285 is shorter */
+	deflate_lenCodes[MAX_MATCH_LEN] = 28;
+
+	for (i = 0; i < DEFLATE_MAX_DISTS; i++) {
+		for (j = 0; j < (1 << dist_bits[i]); j++) {
+			dist = dist_base[i] + j - 1;
+			if (dist < 256) {
+				deflate_distCodes[dist] = i;
+			} else {
+				deflate_distCodes[256 + (dist >> 7)] = i;
+			}
+		}
+	}
+	deflate_codesInited = true;
+}
+
+#define Deflate_LenCode(len)   deflate_lenCodes[len]
+#define Deflate_DistCode(dist) ((dist) <= 256 ? deflate_distCodes[(dist) - 1] : deflate_distCodes[256 + (((dist) - 1) >> 7)])
 
+#if defined __GNUC__ && !defined CC_BIG_ENDIAN && (defined __x86_64__ || defined __i386__ || defined __aarch64__)
+/* Number of bytes that match (are the same) from a and b */
+/* NOTE: Compares 8 bytes at a time, using position of lowest differing bit to find first mismatching byte */
+static int Deflate_MatchLen(cc_uint8* a, cc_uint8* b, int maxLen) {
+	cc_uint64 x, y;
+	int i = 0;
+
+	for (; i + 8 <= maxLen; i += 8) {
+		__builtin_memcpy(&x, a + i, 8);
+		__builtin_memcpy(&y, b + i, 8);
+		if (x != y) return i + (__builtin_ctzll(x ^ y) >> 3);
+	}
+	while (i < maxLen && a[i] == b[i]) i++;
+	return i;
+}
+#else
 /* Number of bytes that match (are the same) from a and b */
 static int Deflate_MatchLen(cc_uint8* a, cc_uint8* b, int maxLen) {
 	int i = 0;
 	while (i < maxLen && *a == *b) { i++; a++; b++; }
 	return i;
 }
+#endif
 
 /* Hashes 3 bytes of data */
 static cc_uint32 Deflate_Hash(cc_uint8* src) {
-	return (cc_uint32)((src[0] << 8) ^ (src[1] << 4) ^ (src[2])) & DEFLATE_HASH_MASK;
+	cc_uint32 value = (src[0] << 16) | (src[1] << 8) | src[2];
+	return (cc_uint32)(value * 0x9E3779B1U) >> (32 - DEFLATE_HASH_BITS);
 }
 
-/* Writes a literal to state->Output */
-static void Deflate_Lit(struct DeflateState* state, int lit) {
-	Deflate_PushLit(state, lit);
-	Deflate_FlushBits(state);
-}
+/* Finds the longest earlier match (at most maxLen bytes) for the data at given position */
+/* Returns length of the longest match, or bestLen if there are no matches longer than it */
+static int Deflate_LongestMatch(struct DeflateState* state, cc_uint32 hash, int pos, int maxLen, int bestLen, int* matchPos) {
+	const struct DeflateParams* params = &deflate_params[state->Level];
+	cc_uint8* input = state->Input;
+	cc_uint8* cur   = input + pos;
+	int chain = params->maxChain;
+	int candidate, len;
+
+	*matchPos = 0;
+	if (bestLen >= maxLen) return bestLen;
 
-/* Writes a length-distance pair to state->Output */
-static void Deflate_LenDist(struct DeflateState* state, int len, int dist) {
-	int j;
-	/* TODO: Do we actually need the if (len_bits[j]) ????????? does writing 0 bits matter??? */
+	for (candidate = state->Head[hash]; candidate && chain; chain--, candidate = state->Prev[candidate]) {
+		/* Quickly skip matches which can't be longer than the current best match */
+		if (input[candidate + bestLen] != cur[bestLen] || input[candidate] != cur[0]) continue;
 
-	for (j = 0; len >= deflate_len[j + 1]; j++);
-	Deflate_PushLit(state, j + 257);
-	if (len_bits[j]) { Deflate_PushBits(state, len - deflate_len[j], len_bits[j]); }
-	Deflate_FlushBits(state);
+		len = Deflate_MatchLen(&input[candidate], cur, maxLen);
+		if (len <= bestLen) continue;
 
-	for (j = 0; dist >= deflate_dist[j + 1]; j++);
-	Deflate_PushHuff(state, j, 5);
-	if (dist_bits[j]) { Deflate_PushBits(state, dist - deflate_dist[j], dist_bits[j]); }
-	Deflate_FlushBits(state);
+		bestLen   = len;
+		*matchPos = candidate;
+		if (len >= params->niceLen || len >= maxLen) break;
+	}
+	return bestLen;
 }
 
-/* Moves "current block" to "previous block", adjusting state if needed. */
-static void Deflate_MoveBlock(struct DeflateState* state) {
-	int i;
-	Mem_Copy(state->Input, state->Input + DEFLATE_BLOCK_SIZE, DEFLATE_BLOCK_SIZE);
-	state->InputPosition = DEFLATE_BLOCK_SIZE;
+/* Inserts the data at given position into the hash chains */
+static void Deflate_Insert(struct DeflateState* state, cc_uint32 hash, int pos) {
+	state->Prev[pos]  = state->Head[hash];
+	state->Head[hash] = pos;
+}
 
-	/* adjust hash table offsets, removing offsets that are no longer in data at all */
-	for (i = 0; i < Array_Elems(state->Head); i++) {
-		state->Head[i] = state->Head[i] < DEFLATE_BLOCK_SIZE ? 0 : (state->Head[i] - DEFLATE_BLOCK_SIZE);
-	}
-	for (i = 0; i < Array_Elems(state->Prev); i++) {
-		state->Prev[i] = state->Prev[i] < DEFLATE_BLOCK_SIZE ? 0 : (state->Prev[i] - DEFLATE_BLOCK_SIZE);
-	}
+static void Deflate_AddLit(struct DeflateState* state, int lit) {
+	state->Tokens[state->NumTokens++] = lit;
+	state->LitsFreqs[lit]++;
 }
 
-/* Compresses current block of data */
-static cc_result Deflate_FlushBlock(struct DeflateState* state, int len) {
-	cc_uint32 hash, nextHash;
-	int bestLen, maxLen, matchLen, depth;
-	int bestPos, pos, nextPos;
-	cc_uint16 oldHead;
-	cc_uint8* input;
-	cc_uint8* cur;
-	cc_result res;
+static void Deflate_AddMatch(struct DeflateState* state, int len, int dist) {
+	state->Tokens[state->NumTokens++] = DEFLATE_TOKEN_MATCH | len;
+	state->Tokens[state->NumTokens++] = dist;
+	state->LitsFreqs[257 + Deflate_LenCode(len)]++;
+	state->DistsFreqs[Deflate_DistCode(dist)]++;
+}
 
-	if (!state->WroteHeader) {
-		state->WroteHeader = true;
-		Deflate_PushBits(state, 3, 3); /* final block TRUE, block type FIXED */
-	}
+/* Converts current block of data into literals and length-distance pairs */
+static void Deflate_FindMatches(struct DeflateState* state, int len) {
+	const struct DeflateParams* params = &deflate_params[state->Level];
+	cc_uint8* input = state->Input;
+	int pos = DEFLATE_BLOCK_SIZE, end = DEFLATE_BLOCK_SIZE + len;
+	int bestLen, bestPos, nextPos, maxLen, i;
+	cc_uint32 hash;
 
 	/* Based off descriptions from http://www.gzip.org/algorithm.txt and
 	https://github.com/nothings/stb/blob/master/stb_image_write.h */
-	input = state->Input;
-	cur   = input + DEFLATE_BLOCK_SIZE;
+	state->NumTokens = 0;
+	Mem_Set(state->LitsFreqs,  0, sizeof(state->LitsFreqs));
+	Mem_Set(state->DistsFreqs, 0, sizeof(state->DistsFreqs));
 
-	/* Compress current block of data */
 	/* Use > instead of >=, because also try match at one byte after current */
-	while (len > MIN_MATCH_LEN) {
-		hash   = Deflate_Hash(cur);
-		maxLen = min(len, MAX_MATCH_LEN);
-
-		bestLen = MIN_MATCH_LEN - 1; /* Match must be at least 3 bytes */
-		bestPos = 0;
-
-		/* Find longest match starting at this byte */
-		/* Only explore up to 5 previous matches, to avoid slow performance */
-		/* (i.e prefer quickly saving maps/screenshots to completely optimal filesize) */
-		pos = state->Head[hash];
-		for (depth = 0; pos != 0 && depth < 5; depth++) {
-			matchLen = Deflate_MatchLen(&input[pos], cur, maxLen);
-			if (matchLen > bestLen) { bestLen = matchLen; bestPos = pos; }
-			pos = state->Prev[pos];
-		}
-
-		/* Insert this entry into the hash chain */
-		pos = (int)(cur - input);
-		oldHead = state->Head[hash];
-		state->Head[hash] = pos;
-		state->Prev[pos]  = oldHead;
+	while (end - pos > MIN_MATCH_LEN) {
+		hash    = Deflate_Hash(&input[pos]);
+		maxLen  = min(end - pos, MAX_MATCH_LEN);
+		bestLen = Deflate_LongestMatch(state, hash, pos, maxLen, MIN_MATCH_LEN - 1, &bestPos);
+		Deflate_Insert(state, hash, pos);
 
 		/* Lazy evaluation: Find longest match starting at next byte */
 		/* If that's longer than the longest match at current byte, throwaway this match */
-		if (bestPos) {
-			nextHash = Deflate_Hash(cur + 1);
-			nextPos  = state->Head[nextHash];
-			maxLen   = min(len - 1, MAX_MATCH_LEN);
-
-			for (depth = 0; nextPos != 0 && depth < 5; depth++) {
-				matchLen = Deflate_MatchLen(&input[nextPos], cur + 1, maxLen);
-				if (matchLen > bestLen) { bestPos = 0; break; }
-				nextPos = state->Prev[nextPos];
+		if (bestPos && bestLen < params->lazyLen) {
+			hash   = Deflate_Hash(&input[pos + 1]);
+			maxLen = min(end - pos - 1, MAX_MATCH_LEN);
+			Deflate_LongestMatch(state, hash, pos + 1, maxLen, bestLen, &nextPos);
+			if (nextPos) bestPos = 0;
+		}
+
+		if (!bestPos) {
+			Deflate_AddLit(state, input[pos]);
+			pos++; continue;
+		}
+		Deflate_AddMatch(state, bestLen, pos - bestPos);
+
+		/* Adding rest of match makes it more likely to find long matches later */
+		if (params->insertAll) {
+			for (i = 1; i < bestLen && pos + i + MIN_MATCH_LEN <= end; i++) {
+				Deflate_Insert(state, Deflate_Hash(&input[pos + i]), pos + i);
 			}
 		}
+		pos += bestLen;
+	}
 
-		if (bestPos) {
-			Deflate_LenDist(state, bestLen, pos - bestPos);
-			len -= bestLen; cur += bestLen;
+	/* literals for last few bytes */
+	for (; pos < end; pos++) {
+		Deflate_AddLit(state, input[pos]);
+	}
+}
+
+/* Calculates minimum redundancy codeword lengths for the given frequencies, which must be in ascending order */
+/* NOTE: Lengths replace the frequencies in-place, with the first (least frequent) getting longest length */
+/*  Based off "In-Place Calculation of Minimum-Redundancy Codes" by Moffat and Katajainen */
+static void Deflate_CalcMinRedundancy(int* A, int n) {
+	int root, leaf, next, avail, used, depth;
+	if (n == 0) return;
+	if (n == 1) { A[0] = 1; return; }
+
+	/* First pass, left to right, setting parent pointers */
+	A[0] += A[1]; root = 0; leaf = 2;
+	for (next = 1; next < n - 1; next++) {
+		if (leaf >= n || A[root] < A[leaf]) {
+			A[next] = A[root]; A[root++] = next;
 		} else {
-			Deflate_Lit(state, *cur);
-			len--; cur++;
+			A[next] = A[leaf++];
 		}
 
-		/* leave room for a few bytes and literals at end */
-		if (state->AvailOut >= 20) continue;
-		res = Stream_Write(state->Dest, state->Output, DEFLATE_OUT_SIZE - state->AvailOut);
-		state->NextOut  = state->Output;
-		state->AvailOut = DEFLATE_OUT_SIZE;
-		if (res) return res;
+		if (leaf >= n || (root < next && A[root] < A[leaf])) {
+			A[next] += A[root]; A[root++] = next;
+		} else {
+			A[next] += A[leaf++];
+		}
 	}
 
-	/* literals for last few bytes */
+	/* Second pass, right to left, setting internal depths */
+	A[n - 2] = 0;
+	for (next = n - 3; next >= 0; next--) A[next] = A[A[next]] + 1;
+
+	/* Third pass, right to left, setting leaf depths */
+	avail = 1; used = 0; depth = 0;
+	root  = n - 2; next = n - 1;
+	while (avail > 0) {
+		while (root >= 0 && A[root] == depth) { used++; root--; }
+		while (avail > used) { A[next--] = depth; avail--; }
+		avail = 2 * used; depth++; used = 0;
+	}
+}
+
+/* Calculates the huffman codeword lengths (up to maxBits long) for the given symbol frequencies */
+static void Deflate_CalcLengths(cc_uint16* freqs, int count, int maxBits, cc_uint8* lens) {
+	int syms[INFLATE_MAX_LITS], lengths[INFLATE_MAX_LITS];
+	int numLens[33] = { 0 };
+	int i, j, n = 0, sym, total;
+
+	/* Sort used symbols by ascending frequency */
+	for (i = 0; i < count; i++) {
+		lens[i] = 0;
+		if (!freqs[i]) continue;
+
+		for (j = n; j > 0 && freqs[syms[j - 1]] > freqs[i]; j--) syms[j] = syms[j - 1];
+		syms[j] = i; n++;
+	}
+	for (i = 0; i < n; i++) lengths[i] = freqs[syms[i]];
+	Deflate_CalcMinRedundancy(lengths, n);
+
+	/* Limit codeword lengths to maxBits, then fixup lengths so the code is still complete */
+	for (i = 0; i < n; i++) numLens[min(lengths[i], maxBits)]++;
+
+	total = 0;
+	for (i = maxBits; i > 0; i--) total += numLens[i] << (maxBits - i);
+	while (total > (1 << maxBits)) {
+		numLens[maxBits]--;
+		for (i = maxBits - 1; i > 0; i--) {
+			if (!numLens[i]) continue;
+			numLens[i]--; numLens[i + 1] += 2; break;
+		}
+		total--;
+	}
+
+	/* Longest codewords are assigned to least frequent symbols */
+	for (i = maxBits, j = 0; i > 0; i--) {
+		for (sym = numLens[i]; sym > 0; sym--) lens[syms[j++]] = i;
+	}
+}
+
+/* Ensures at least 2 symbols have a non-zero frequency, so the huffman code is always complete */
+static void Deflate_EnsureTwoSymbols(cc_uint16* freqs, int count) {
+	int i, used = 0;
+	for (i = 0; i < count; i++) { if (freqs[i]) used++; }
+
+	for (i = 0; i < count && used < 2; i++) {
+		if (freqs[i]) continue;
+		freqs[i] = 1; used++;
+	}
+}
+
+/* Constructs a huffman encoding table (for values to codewords) */
+static void Deflate_BuildTable(const cc_uint8* lens, int count, cc_uint16* codewords, cc_uint8* bitlens) {
+	int i, j, offset, codeword;
+	struct HuffmanTable table;
+
+	/* NOTE: Can ignore since lens table is not user controlled */
+	(void)Huffman_Build(&table, lens, count);
+	for (i = 0; i < INFLATE_MAX_BITS; i++) {
+		if (!table.endCodewords[i]) continue;
+		count = table.endCodewords[i] - table.firstCodewords[i];
+
+		for (j = 0; j < count; j++) {
+			offset   = table.values[table.firstOffsets[i] + j];
+			codeword = table.firstCodewords[i] + j;
+			bitlens[offset]   = i;
+			codewords[offset] = Huffman_ReverseBits(codeword, i);
+		}
+	}
+}
+
+/* Run length encodes the combined lits and dists codeword lengths */
+/* Returns number of codeword length symbols written to syms */
+static int Deflate_EncodeLens(const cc_uint8* lens, int count, cc_uint8* syms, cc_uint8* extra, cc_uint16* freqs) {
+	int i = 0, n = 0, run, cur, rep;
+
+	while (i < count) {
+		cur = lens[i];
+		for (run = 1; i + run < count && lens[i + run] == cur; ) run++;
+		i += run;
+
+		if (cur == 0) {
+			for (; run >= 11; run -= rep) {
+				rep = min(run, 138);
+				syms[n] = 18; extra[n++] = rep - 11;
+			}
+			if (run >= 3) {
+				syms[n] = 17; extra[n++] = run - 3;
+				run = 0;
+			}
+		} else {
+			syms[n] = cur; extra[n++] = 0;
+			run--;
+
+			for (; run >= 3; run -= rep) {
+				rep = min(run, 6);
+				syms[n] = 16; extra[n++] = rep - 3;
+			}
+		}
+
+		for (; run > 0; run--) { syms[n] = cur; extra[n++] = 0; }
+	}
+
+	for (i = 0; i < n; i++) freqs[syms[i]]++;
+	return n;
+}
+
+/* Writes output buffer to destination stream once it is nearly full */
+static cc_result Deflate_CheckOutput(struct DeflateState* state) {
+	cc_result res;
+	/* leave room for a few bytes and literals at end */
+	if (state->AvailOut >= 64) return 0;
+
+	res = Stream_Write(state->Dest, state->Output, DEFLATE_OUT_SIZE - state->AvailOut);
+	state->NextOut  = state->Output;
+	state->AvailOut = DEFLATE_OUT_SIZE;
+	return res;
+}
+
+/* Number of bits needed to encode all the symbols of the current block with the given codeword lengths */
+static cc_uint32 Deflate_SymbolsCost(struct DeflateState* state, const cc_uint8* litLens, const cc_uint8* distLens) {
+	cc_uint32 cost = 0;
+	int i;
+
+	for (i = 0; i < 256; i++) {
+		cost += state->LitsFreqs[i] * litLens[i];
+	}
+	for (i = 256; i < DEFLATE_MAX_LITS; i++) {
+		cost += state->LitsFreqs[i] * (litLens[i] + (i > 256 ? len_bits[i - 257] : 0));
+	}
+	for (i = 0; i < DEFLATE_MAX_DISTS; i++) {
+		cost += state->DistsFreqs[i] * (distLens[i] + dist_bits[i]);
+	}
+	return cost;
+}
+
+/* Writes the symbols of the current block using the given huffman codewords */
+static cc_result Deflate_WriteSymbols(struct DeflateState* state) {
+	cc_uint16* litCodes  = state->LitsCodewords;
+	cc_uint8*  litLens   = state->LitsLens;
+	cc_uint16* distCodes = state->DistsCodewords;
+	cc_uint8*  distLens  = state->DistsLens;
+	int i, token, code, dist;
+	cc_result res;
+
+	for (i = 0; i < state->NumTokens; i++) {
+		token = state->Tokens[i];
+
+		if (!(token & DEFLATE_TOKEN_MATCH)) {
+			Deflate_WriteBits(state, litCodes[token], litLens[token]);
+		} else {
+			token &= ~DEFLATE_TOKEN_MATCH;
+			code   = Deflate_LenCode(token);
+			Deflate_WriteBits(state, litCodes[code + 257], litLens[code + 257]);
+			Deflate_WriteBits(state, token - len_base[code], len_bits[code]);
+
+			dist = state->Tokens[++i];
+			code = Deflate_DistCode(dist);
+			Deflate_WriteBits(state, distCodes[code], distLens[code]);
+			Deflate_WriteBits(state, dist - dist_base[code], dist_bits[code]);
+		}
+		if ((res = Deflate_CheckOutput(state))) return res;
+	}
+
+	/* Write huffman encoded "literal 256" to terminate symbols */
+	Deflate_WriteBits(state, litCodes[256], litLens[256]);
+	return 0;
+}
+
+/* Writes the current block as uncompressed data */
+static cc_result Deflate_WriteStored(struct DeflateState* state, int len) {
+	cc_uint8* data = state->Input + DEFLATE_BLOCK_SIZE;
+	cc_uint32 count;
+	cc_result res;
+
+	/* Uncompressed data starts on a byte boundary */
+	if (state->NumBits) { Deflate_WriteBits(state, 0, 8 - state->NumBits); }
+	Deflate_WriteBits(state, len, 16);
+	Deflate_WriteBits(state, len ^ 0xFFFF, 16);
+
 	while (len > 0) {
-		Deflate_Lit(state, *cur);
-		len--; cur++;
+		if ((res = Deflate_CheckOutput(state))) return res;
+		count = min(len, state->AvailOut);
+		Mem_Copy(state->NextOut, data, count);
+
+		state->NextOut  += count; state->AvailOut -= count;
+		data += count; len -= count;
+	}
+	return 0;
+}
+
+/* Writes the current block using fixed, dynamic huffman, or no compression (whichever is smallest) */
+static cc_result Deflate_WriteBlock(struct DeflateState* state, int len, cc_bool last) {
+	cc_uint8 lens[DEFLATE_MAX_LITS + DEFLATE_MAX_DISTS];
+	cc_uint8* litLens  = lens;
+	cc_uint8* distLens;
+	cc_uint8 codeLens[INFLATE_MAX_CODELENS];
+	cc_uint16 codeFreqs[INFLATE_MAX_CODELENS] = { 0 };
+	cc_uint8 syms[DEFLATE_MAX_LITS + DEFLATE_MAX_DISTS], extra[DEFLATE_MAX_LITS + DEFLATE_MAX_DISTS];
+	cc_uint16 codeCodes[INFLATE_MAX_CODELENS];
+	cc_uint8  codeBits[INFLATE_MAX_CODELENS];
+	int numLits, numDists, numCodeLens, numSyms, i;
+	cc_uint32 fixedCost, dynamicCost, storedCost;
+	cc_result res;
+
+	state->LitsFreqs[256] = 1;
+	Deflate_EnsureTwoSymbols(state->LitsFreqs,  DEFLATE_MAX_LITS);
+	Deflate_EnsureTwoSymbols(state->DistsFreqs, DEFLATE_MAX_DISTS);
+
+	Deflate_CalcLengths(state->LitsFreqs, DEFLATE_MAX_LITS, 15, litLens);
+	for (numLits = DEFLATE_MAX_LITS; numLits > 257 && !litLens[numLits - 1]; numLits--) { }
+
+	distLens = lens + numLits;
+	Deflate_CalcLengths(state->DistsFreqs, DEFLATE_MAX_DISTS, 15, distLens);
+	for (numDists = DEFLATE_MAX_DISTS; numDists > 1 && !distLens[numDists - 1]; numDists--) { }
+
+	/* Lits and dists codeword lengths are encoded together */
+	numSyms = Deflate_EncodeLens(lens, numLits + numDists, syms, extra, codeFreqs);
+	Deflate_EnsureTwoSymbols(codeFreqs, INFLATE_MAX_CODELENS);
+	Deflate_CalcLengths(codeFreqs, INFLATE_MAX_CODELENS, DEFLATE_MAX_CODELEN_BITS, codeLens);
+	for (numCodeLens = INFLATE_MAX_CODELENS; numCodeLens > 4 && !codeLens[codelens_order[numCodeLens - 1]]; numCodeLens--) { }
+
+	dynamicCost = 5 + 5 + 4 + 3 * numCodeLens + Deflate_SymbolsCost(state, litLens, distLens);
+	for (i = 0; i < numSyms; i++) {
+		dynamicCost += codeLens[syms[i]];
+		if (syms[i] >= 16) dynamicCost += syms[i] == 16 ? 2 : (syms[i] == 17 ? 3 : 7);
+	}
+	fixedCost  = Deflate_SymbolsCost(state, fixed_lits, fixed_dists);
+	storedCost = ((state->NumBits + 3 + 7) & ~7) + 32 + len * 8;
+
+	if (storedCost <= fixedCost && storedCost <= dynamicCost) {
+		Deflate_WriteBits(state, last, 1);
+		Deflate_WriteBits(state, 0, 2); /* block type UNCOMPRESSED */
+		return Deflate_WriteStored(state, len);
+	}
+
+	if (fixedCost <= dynamicCost) {
+		Deflate_WriteBits(state, last, 1);
+		Deflate_WriteBits(state, 1, 2); /* block type FIXED */
+
+		Deflate_BuildTable(fixed_lits,  INFLATE_MAX_LITS,  state->LitsCodewords,  state->LitsLens);
+		Deflate_BuildTable(fixed_dists, INFLATE_MAX_DISTS, state->DistsCodewords, state->DistsLens);
+		return Deflate_WriteSymbols(state);
+	}
+
+	Deflate_WriteBits(state, last, 1);
+	Deflate_WriteBits(state, 2, 2); /* block type DYNAMIC */
+	Deflate_WriteBits(state, numLits  - 257, 5);
+	Deflate_WriteBits(state, numDists - 1,   5);
+	Deflate_WriteBits(state, numCodeLens - 4, 4);
+
+	for (i = 0; i < numCodeLens; i++) {
+		Deflate_WriteBits(state, codeLens[codelens_order[i]], 3);
+	}
+	if ((res = Deflate_CheckOutput(state))) return res;
+
+	Deflate_BuildTable(codeLens, INFLATE_MAX_CODELENS, codeCodes, codeBits);
+	for (i = 0; i < numSyms; i++) {
+		Deflate_WriteBits(state, codeCodes[syms[i]], codeBits[syms[i]]);
+		if (syms[i] == 16) { Deflate_WriteBits(state, extra[i], 2); }
+		if (syms[i] == 17) { Deflate_WriteBits(state, extra[i], 3); }
+		if (syms[i] == 18) { Deflate_WriteBits(state, extra[i], 7); }
+		if ((res = Deflate_CheckOutput(state))) return res;
+	}
+
+	Deflate_BuildTable(litLens,  numLits,  state->LitsCodewords,  state->LitsLens);
+	Deflate_BuildTable(distLens, numDists, state->DistsCodewords, state->DistsLens);
+	return Deflate_WriteSymbols(state);
+}
+
+/* Moves "current block" to "previous block", adjusting state if needed. */
+static void Deflate_MoveBlock(struct DeflateState* state) {
+	int i;
+	Mem_Copy(state->Input, state->Input + DEFLATE_BLOCK_SIZE, DEFLATE_BLOCK_SIZE);
+	state->InputPosition = DEFLATE_BLOCK_SIZE;
+
+	/* adjust hash table offsets, removing offsets that are no longer in data at all */
+	for (i = 0; i < Array_Elems(state->Head); i++) {
+		state->Head[i] = state->Head[i] < DEFLATE_BLOCK_SIZE ? 0 : (state->Head[i] - DEFLATE_BLOCK_SIZE);
 	}
+	/* chain entries also move along with the data they are for */
+	for (i = 0; i < DEFLATE_BLOCK_SIZE; i++) {
+		int prev = state->Prev[i + DEFLATE_BLOCK_SIZE];
+		state->Prev[i] = prev < DEFLATE_BLOCK_SIZE ? 0 : (prev - DEFLATE_BLOCK_SIZE);
+	}
+}
+
+/* Compresses current block of data */
+static cc_result Deflate_FlushBlock(struct DeflateState* state, int len, cc_bool last) {
+	cc_result res;
+	Deflate_FindMatches(state, len);
+
+	res = Deflate_WriteBlock(state, len, last);
+	if (res) return res;
 
 	res = Stream_Write(state->Dest, state->Output, DEFLATE_OUT_SIZE - state->AvailOut);
 	state->NextOut  = state->Output;
@@ -978,26 +1644,22 @@ static cc_result Deflate_StreamWrite(struct Stream* stream, const cc_uint8* data
 		data += len;
 
 		if (state->InputPosition == DEFLATE_BUFFER_SIZE) {
-			res = Deflate_FlushBlock(state, DEFLATE_BLOCK_SIZE);
+			res = Deflate_FlushBlock(state, DEFLATE_BLOCK_SIZE, false);
 			if (res) return res;
 		}
 	}
 	return 0;
 }
 
-/* Flushes any buffered data, then writes terminating symbol */
+/* Flushes any buffered data as the final block */
 static cc_result Deflate_StreamClose(struct Stream* stream) {
 	struct DeflateState* state;
 	cc_result res;
 
 	state = (struct DeflateState*)stream->meta.inflate;
-	res   = Deflate_FlushBlock(state, state->InputPosition - DEFLATE_BLOCK_SIZE);
+	res   = Deflate_FlushBlock(state, state->InputPosition - DEFLATE_BLOCK_SIZE, true);
 	if (res) return res;
 
-	/* Write huffman encoded "literal 256" to terminate symbols */
-	Deflate_PushLit(state, 256);
-	Deflate_FlushBits(state);
-
 	/* In case last byte still has a few extra bits */
 	if (state->NumBits) {
 		while (state->NumBits < 8) { Deflate_PushBits(state, 0, 1); }
@@ -1007,27 +1669,7 @@ static cc_result Deflate_StreamClose(struct Stream* stream) {
 	return Stream_Write(state->Dest, state->Output, DEFLATE_OUT_SIZE - state->AvailOut);
 }
 
-/* Constructs a huffman encoding table (for values to codewords) */
-static void Deflate_BuildTable(const cc_uint8* lens, int count, cc_uint16* codewords, cc_uint8* bitlens) {
-	int i, j, offset, codeword;
-	struct HuffmanTable table;
-
-	/* NOTE: Can ignore since lens table is not user controlled */
-	(void)Huffman_Build(&table, lens, count);
-	for (i = 0; i < INFLATE_MAX_BITS; i++) {
-		if (!table.endCodewords[i]) continue;
-		count = table.endCodewords[i] - table.firstCodewords[i];
-
-		for (j = 0; j < count; j++) {
-			offset   = table.values[table.firstOffsets[i] + j];
-			codeword = table.firstCodewords[i] + j;
-			bitlens[offset]   = i;
-			codewords[offset] = Huffman_ReverseBits(codeword, i);
-		}
-	}
-}
-
-void Deflate_MakeStream(struct Stream* stream, struct DeflateState* state, struct Stream* underlying) {
+void Deflate_MakeStream2(struct Stream* stream, struct DeflateState* state, struct Stream* underlying, int level) {
 	Stream_Init(stream);
 	stream->meta.inflate = state;
 	stream->Write = Deflate_StreamWrite;
@@ -1041,11 +1683,14 @@ void Deflate_MakeStream(struct Stream* stream, struct DeflateState* state, struc
 	state->NextOut  = state->Output;
 	state->AvailOut = DEFLATE_OUT_SIZE;
 	state->Dest     = underlying;
-	state->WroteHeader = false;
+	state->Level    = level;
 
 	Mem_Set(state->Head, 0, sizeof(state->Head));
 	Mem_Set(state->Prev, 0, sizeof(state->Prev));
-	Deflate_BuildTable(fixed_lits, INFLATE_MAX_LITS, state->LitsCodewords, state->LitsLens);
+}
+
+void Deflate_MakeStream(struct Stream* stream, struct DeflateState* state, struct Stream* underlying) {
+	Deflate_MakeStream2(stream, state, underlying, DEFLATE_LEVEL_DEFAULT);
 }
 
 
@@ -1087,14 +1732,18 @@ static cc_result GZip_StreamWriteFirst(struct Stream* stream, const cc_uint8* da
 	return GZip_StreamWrite(stream, data, count, modified);
 }
 
-void GZip_MakeStream(struct Stream* stream, struct GZipState* state, struct Stream* underlying) {
-	Deflate_MakeStream(stream, &state->Base, underlying);
+void GZip_MakeStream2(struct Stream* stream, struct GZipState* state, struct Stream* underlying, int level) {
+	Deflate_MakeStream2(stream, &state->Base, underlying, level);
 	state->Crc32  = 0xFFFFFFFFUL;
 	state->Size   = 0;
 	stream->Write = GZip_StreamWriteFirst;
 	stream->Close = GZip_StreamClose;
 }
 
+void GZip_MakeStream(struct Stream* stream, struct GZipState* state, struct Stream* underlying) {
+	GZip_MakeStream2(stream, state, underlying, DEFLATE_LEVEL_DEFAULT);
+}
+
 
 /*########################################################################################################################*
 *-----------------------------------------------------ZLib (compress)-----------------------------------------------------*
@@ -1125,23 +1774,32 @@ static cc_result ZLib_StreamWrite(struct Stream* stream, const cc_uint8* data, c
 	return Deflate_StreamWrite(stream, data, count, modified);
 }
 
+/* Second byte of ZLib header, indicating compression level used */
+static const cc_uint8 zlib_levelFlags[DEFLATE_LEVEL_COUNT] = { 0x01, 0x9C, 0xDA };
+
 static cc_result ZLib_StreamWriteFirst(struct Stream* stream, const cc_uint8* data, cc_uint32 count, cc_uint32* modified) {
-	static cc_uint8 header[2] = { 0x78, 0x9C }; /* ZLib header */
 	struct ZLibState* state = (struct ZLibState*)stream->meta.inflate;
+	cc_uint8 header[2] = { 0x78 }; /* ZLib header */
 	cc_result res;
 
+	header[1] = zlib_levelFlags[state->Base.Level];
+
 	if ((res = Stream_Write(state->Base.Dest, header, sizeof(header)))) return res;
 	stream->Write = ZLib_StreamWrite;
 	return ZLib_StreamWrite(stream, data, count, modified);
 }
 
-void ZLib_MakeStream(struct Stream* stream, struct ZLibState* state, struct Stream* underlying) {
-	Deflate_MakeStream(stream, &state->Base, underlying);
+void ZLib_MakeStream2(struct Stream* stream, struct ZLibState* state, struct Stream* underlying, int level) {
+	Deflate_MakeStream2(stream, &state->Base, underlying, level);
 	state->Adler32 = 1;
 	stream->Write = ZLib_StreamWriteFirst;
 	stream->Close = ZLib_StreamClose;
 }
 
+void ZLib_MakeStream(struct Stream* stream, struct ZLibState* state, struct Stream* underlying) {
+	ZLib_MakeStream2(stream, state, underlying, DEFLATE_LEVEL_DEFAULT);
+}
+
 
 /*########################################################################################################################*
 *--------------------------------------------------------ZipReader--------------------------------------------------------*
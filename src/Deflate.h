@@ -30,7 +30,11 @@ cc_result ZLibHeader_Read(struct Stream* s, struct ZLibHeader* header);
 #define INFLATE_MAX_LITS_DISTS (INFLATE_MAX_LITS + INFLATE_MAX_DISTS)
 #define INFLATE_MAX_BITS 16
 
+#ifdef CC_BUILD_LOWMEM
 #define INFLATE_FAST_BITS 9
+#else
+#define INFLATE_FAST_BITS 10
+#endif
 #define INFLATE_FAST_LEN_SHIFT 9
 #define INFLATE_FAST_VAL_MASK  0x1FF
 
@@ -69,6 +73,8 @@ struct InflateState {
 		struct HuffmanTable Lits;           /* Values represent literal or lengths */
 	} Table; /* union to save on memory */
 	struct HuffmanTable TableDists;         /* Values represent distances back */
+	cc_uint32 FastLits[1 << INFLATE_FAST_BITS];  /* Resolves up to two literals, or length + extra bits, per lookup */
+	cc_uint32 FastDists[1 << INFLATE_FAST_BITS]; /* Resolves distance + extra bits per lookup */
 	cc_uint8 Window[INFLATE_WINDOW_SIZE];    /* Holds circular buffer of recent output data, used for LZ77 */
 	cc_result result;
 };
@@ -83,12 +89,27 @@ void Inflate_Process(struct InflateState* s);
 /* If data starts with a GZIP or ZLIB header, use GZipHeader_Read or ZLibHeader_Read to first skip it. */
 CC_API void Inflate_MakeStream2(struct Stream* stream, struct InflateState* state, struct Stream* underlying);
 
+#ifdef CC_BUILD_BENCHMARK
+/* Whether to decode compressed blocks using the previous fast path, instead of the lookup tables fast path */
+/*  (so the benchmark can check both produce exactly the same output, and compare their speed) */
+extern cc_bool Inflate_ReferenceFast;
+#endif
+
 
 #define DEFLATE_BLOCK_SIZE  16384
 #define DEFLATE_BUFFER_SIZE 32768
 #define DEFLATE_OUT_SIZE 8192
-#define DEFLATE_HASH_SIZE 0x1000UL
-#define DEFLATE_HASH_MASK 0x0FFFUL
+#define DEFLATE_HASH_BITS 14
+#define DEFLATE_HASH_SIZE (1UL << DEFLATE_HASH_BITS)
+
+/* How much effort the compressor spends finding matches (i.e. speed vs size tradeoff) */
+enum DeflateLevel {
+	DEFLATE_LEVEL_FAST,    /* Short match searches, only first byte of each match hashed */
+	DEFLATE_LEVEL_DEFAULT, /* Moderate match searches, with lazy matching */
+	DEFLATE_LEVEL_MAX,     /* Exhaustive match searches, with lazy matching */
+	DEFLATE_LEVEL_COUNT
+};
+
 struct DeflateState {
 	cc_uint32 Bits;         /* Holds bits across byte boundaries */
 	cc_uint32 NumBits;      /* Number of bits in Bits buffer */
@@ -100,6 +121,11 @@ struct DeflateState {
 
 	cc_uint16 LitsCodewords[INFLATE_MAX_LITS]; /* Codewords for each value */
 	cc_uint8 LitsLens[INFLATE_MAX_LITS];       /* Bit lengths of each codeword */
+	cc_uint16 DistsCodewords[INFLATE_MAX_DISTS]; /* Codewords for each distance */
+	cc_uint8 DistsLens[INFLATE_MAX_DISTS];       /* Bit lengths of each codeword */
+	cc_uint16 LitsFreqs[INFLATE_MAX_LITS];   /* Number of times each literal/length code used in current block */
+	cc_uint16 DistsFreqs[INFLATE_MAX_DISTS]; /* Number of times each distance code used in current block */
+	cc_uint8 Level; /* DEFLATE_LEVEL_ compression level */
 	
 	cc_uint8 Input[DEFLATE_BUFFER_SIZE];
 	cc_uint8 Output[DEFLATE_OUT_SIZE];
@@ -107,23 +133,37 @@ struct DeflateState {
 	cc_uint16 Prev[DEFLATE_BUFFER_SIZE];
 	/* NOTE: The largest possible value that can get */
 	/*  stored in Head/Prev is <= DEFLATE_BUFFER_SIZE */
-	cc_bool WroteHeader;
+
+	/* Literals and matches found in current block */
+	/* NOTE: A match is stored as (0x8000 | length), followed by the distance */
+	cc_uint16 Tokens[DEFLATE_BLOCK_SIZE];
+	int NumTokens;
 };
+/* Initialises the lookup tables used when compressing. Must be called before any of the _MakeStream functions */
+/* NOTE: Called on the main thread at startup, as the tables are shared by all threads compressing at once */
+void Deflate_Init(void);
 /* Compresses input data using DEFLATE, then writes compressed output to another stream. Write only stream. */
 /* DEFLATE compression is pure compressed data, there is no header or footer. */
 CC_API void Deflate_MakeStream(struct Stream* stream, struct DeflateState* state, struct Stream* underlying);
+/* Compresses input data using DEFLATE, using the given DEFLATE_LEVEL_ compression level. */
+/* Each block is written using whichever of fixed huffman, dynamic huffman, or no compression is smallest. */
+CC_API void Deflate_MakeStream2(struct Stream* stream, struct DeflateState* state, struct Stream* underlying, int level);
 
 struct GZipState { struct DeflateState Base; cc_uint32 Crc32, Size; };
 /* Compresses input data using GZIP, then writes compressed output to another stream. Write only stream. */
 /* GZIP compression is GZIP header, followed by DEFLATE compressed data, followed by GZIP footer. */
 CC_API  void GZip_MakeStream(      struct Stream* stream, struct GZipState* state, struct Stream* underlying);
 typedef void (*FP_GZip_MakeStream)(struct Stream* stream, struct GZipState* state, struct Stream* underlying);
+/* Compresses input data using GZIP, using the given DEFLATE_LEVEL_ compression level. */
+CC_API void GZip_MakeStream2(struct Stream* stream, struct GZipState* state, struct Stream* underlying, int level);
 
 struct ZLibState { struct DeflateState Base; cc_uint32 Adler32; };
 /* Compresses input data using ZLIB, then writes compressed output to another stream. Write only stream. */
 /* ZLIB compression is ZLIB header, followed by DEFLATE compressed data, followed by ZLIB footer. */
 CC_API  void ZLib_MakeStream(      struct Stream* stream, struct ZLibState* state, struct Stream* underlying);
 typedef void (*FP_ZLib_MakeStream)(struct Stream* stream, struct ZLibState* state, struct Stream* underlying);
+/* Compresses input data using ZLIB, using the given DEFLATE_LEVEL_ compression level. */
+CC_API void ZLib_MakeStream2(struct Stream* stream, struct ZLibState* state, struct Stream* underlying, int level);
 
 /* Minimal data needed to describe an entry in a .zip archive */
 struct ZipEntry { cc_uint32 CompressedSize, UncompressedSize, LocalHeaderOffset; };
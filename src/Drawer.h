@@ -38,5 +38,14 @@ CC_API void Drawer_YMin(int count, PackedCol col, TextureLoc texLoc, struct Vert
 /* Draws maximum Y face of the cuboid. (i.e. at Y2) */
 CC_API void Drawer_YMax(int count, PackedCol col, TextureLoc texLoc, struct VertexTextured** vertices);
 
+/* Same as Drawer_XMin etc, but uses the given cuboid state instead of the global Drawer state */
+/* NOTE: Allows drawing cuboids from multiple threads at the same time (e.g. in chunk mesh builder) */
+CC_API void Drawer_XMin2(struct _DrawerData* d, int count, PackedCol col, TextureLoc texLoc, struct VertexTextured** vertices);
+CC_API void Drawer_XMax2(struct _DrawerData* d, int count, PackedCol col, TextureLoc texLoc, struct VertexTextured** vertices);
+CC_API void Drawer_ZMin2(struct _DrawerData* d, int count, PackedCol col, TextureLoc texLoc, struct VertexTextured** vertices);
+CC_API void Drawer_ZMax2(struct _DrawerData* d, int count, PackedCol col, TextureLoc texLoc, struct VertexTextured** vertices);
+CC_API void Drawer_YMin2(struct _DrawerData* d, int count, PackedCol col, TextureLoc texLoc, struct VertexTextured** vertices);
+CC_API void Drawer_YMax2(struct _DrawerData* d, int count, PackedCol col, TextureLoc texLoc, struct VertexTextured** vertices);
+
 CC_END_HEADER
 #endif
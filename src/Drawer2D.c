@@ -644,20 +644,14 @@ void Drawer2D_DrawClippedText(struct Context2D* ctx, struct DrawTextArgs* args,
 /*########################################################################################################################*
 *---------------------------------------------------Drawer2D component----------------------------------------------------*
 *#########################################################################################################################*/
-static void DefaultPngProcess(struct Stream* stream, const cc_string* name) {
-	struct Bitmap bmp;
-	cc_result res;
-
-	if ((res = Png_Decode(&bmp, stream))) {
-		Logger_SysWarn2(res, "decoding", name);
-		Mem_Free(bmp.scan0);
-	} else if (Font_SetBitmapAtlas(&bmp)) {
+static void DefaultPngProcess(struct Bitmap* bmp, const cc_string* name) {
+	if (Font_SetBitmapAtlas(bmp)) {
 		Event_RaiseVoid(&ChatEvents.FontChanged);
 	} else {
-		Mem_Free(bmp.scan0);
+		Mem_Free(bmp->scan0);
 	}
 }
-static struct TextureEntry default_entry = { "default.png", DefaultPngProcess };
+static struct TextureEntry default_entry = { "default.png", NULL, DefaultPngProcess };
 
 
 /* The default 16 colours are the CGA 16 color palette (without special brown colour) */
@@ -22,6 +22,7 @@
 #include "Errors.h"
 #include "Utils.h"
 #include "EntityRenderers.h"
+#include "TexturePack.h"
 
 const char* const NameMode_Names[NAME_MODE_COUNT]   = { "None", "Hovered", "All", "AllHovered", "AllUnscaled" };
 const char* const ShadowMode_Names[SHADOW_MODE_COUNT] = { "None", "SnapToBlock", "Circle", "CircleAll" };
@@ -318,13 +319,7 @@ static cc_result EnsurePow2Skin(struct Entity* e, struct Bitmap* bmp) {
 	return 0;
 }
 
-static cc_result ApplySkin(struct Entity* e, struct Bitmap* bmp, struct Stream* src, cc_string* skin) {
-	cc_result res;
-	if ((res = Png_Decode(bmp, src))) return res;
-
-	Gfx_DeleteTexture(&e->TextureId);
-	Entity_SetSkinAll(e, true);
-	if ((res = EnsurePow2Skin(e, bmp))) return res;
+static void CreateSkinTexture(struct Entity* e, struct Bitmap* bmp, cc_string* skin) {
 	e->SkinType = Utils_CalcSkinType(bmp);
 
 	if (!Gfx_CheckTextureSize(bmp->width, bmp->height, 0)) {
@@ -336,9 +331,41 @@ static cc_result ApplySkin(struct Entity* e, struct Bitmap* bmp, struct Stream*
 		e->TextureId = Gfx_CreateTexture(bmp, TEXTURE_FLAG_MANAGED, false);
 		Entity_SetSkinAll(e, false);
 	}
+}
+
+static cc_result ApplySkin(struct Entity* e, struct Bitmap* bmp, struct HttpRequest* item, cc_string* skin) {
+	struct Stream mem;
+	int srcWidth, srcHeight;
+	cc_result res;
+
+	Stream_ReadonlyMemory(&mem, item->data, item->size);
+	if ((res = Png_Decode(bmp, &mem))) return res;
+	srcWidth = bmp->width; srcHeight = bmp->height;
+
+	Gfx_DeleteTexture(&e->TextureId);
+	Entity_SetSkinAll(e, true);
+	if ((res = EnsurePow2Skin(e, bmp))) return res;
+
+	/* Cache before clearing hat, since that depends on the entity's model */
+	SkinCache_Update(skin, item, bmp, srcWidth, srcHeight);
+	CreateSkinTexture(e, bmp, skin);
 	return 0;
 }
 
+/* Applies the skin from the skin cache, avoiding having to decode the PNG again */
+static cc_bool ApplyCachedSkin(struct Entity* e, struct Bitmap* bmp, cc_string* skin) {
+	int srcWidth, srcHeight;
+	if (!SkinCache_Load(skin, bmp, &srcWidth, &srcHeight)) return false;
+
+	Gfx_DeleteTexture(&e->TextureId);
+	Entity_SetSkinAll(e, true);
+	e->uScale = (float)srcWidth  / bmp->width;
+	e->vScale = (float)srcHeight / bmp->height;
+
+	CreateSkinTexture(e, bmp, skin);
+	return true;
+}
+
 static void LogInvalidSkin(cc_result res, const cc_string* skin, const cc_uint8* data, int size) {
 	cc_string msg; char msgBuffer[256];
 	String_InitArray(msg, msgBuffer);
@@ -355,7 +382,6 @@ static void LogInvalidSkin(cc_result res, const cc_string* skin, const cc_uint8*
 static void Entity_CheckSkin(struct Entity* e) {
 	struct Entity* first;
 	struct HttpRequest item;
-	struct Stream mem;
 	struct Bitmap bmp;
 	cc_string skin;
 	cc_uint8 flags;
@@ -364,14 +390,14 @@ static void Entity_CheckSkin(struct Entity* e) {
 	/* Don't check skin if don't have to */
 	if (!e->Model->usesSkin) return;
 	if (e->SkinFetchState == SKIN_FETCH_COMPLETED) return;
-	skin = String_FromRawArray(e->SkinRaw);
+	skin  = String_FromRawArray(e->SkinRaw);
+	flags = e == &LocalPlayer_Instances[0].Base ? HTTP_FLAG_NOCACHE : 0;
 
 	if (!e->SkinFetchState) {
 		first = Entity_FirstOtherWithSameSkinAndFetchedSkin(e);
-		flags = e == &LocalPlayer_Instances[0].Base ? HTTP_FLAG_NOCACHE : 0;
 
 		if (!first) {
-			e->_skinReqID     = Http_AsyncGetSkin(&skin, flags);
+			e->_skinReqID     = SkinCache_Request(&skin, flags);
 			e->SkinFetchState = SKIN_FETCH_DOWNLOADING;
 		} else {
 			Entity_CopySkin(e, first);
@@ -381,17 +407,20 @@ static void Entity_CheckSkin(struct Entity* e) {
 	}
 
 	if (!Http_GetResult(e->_skinReqID, &item)) return;
+	bmp.scan0 = NULL;
 
-	if (!item.success) {
-		Entity_SetSkinAll(e, true);
-	} else {
-		Stream_ReadonlyMemory(&mem, item.data, item.size);
-
-		if ((res = ApplySkin(e, &bmp, &mem, &skin))) {
-			LogInvalidSkin(res, &skin, item.data, item.size);
+	if (item.statusCode == 304 && !item.result) {
+		/* Cached skin is unusable (e.g. deleted), so redownload it */
+		if (!ApplyCachedSkin(e, &bmp, &skin)) {
+			e->_skinReqID = SkinCache_Request(&skin, flags);
 		}
-		Mem_Free(bmp.scan0);
+	} else if (!item.success) {
+		Entity_SetSkinAll(e, true);
+	} else if ((res = ApplySkin(e, &bmp, &item, &skin))) {
+		LogInvalidSkin(res, &skin, item.data, item.size);
 	}
+
+	Mem_Free(bmp.scan0);
 	HttpRequest_Free(&item);
 }
 
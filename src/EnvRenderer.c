@@ -787,25 +787,25 @@ static void UpdateMapEdges(void) {
 /*########################################################################################################################*
 *---------------------------------------------------------General---------------------------------------------------------*
 *#########################################################################################################################*/
-static void CloudsPngProcess(struct Stream* stream, const cc_string* name) {
-	Game_UpdateTexture(&clouds_tex, stream, name, NULL, NULL);
+static void CloudsPngProcess(struct Bitmap* bmp, const cc_string* name) {
+	Game_UpdateTextureBitmap(&clouds_tex, bmp, name, NULL, NULL);
 }
-static struct TextureEntry clouds_entry = { "clouds.png", CloudsPngProcess };
+static struct TextureEntry clouds_entry = { "clouds.png", NULL, CloudsPngProcess };
 
-static void SkyboxPngProcess(struct Stream* stream, const cc_string* name) {
-	Game_UpdateTexture(&skybox_tex, stream, name, NULL, NULL);
+static void SkyboxPngProcess(struct Bitmap* bmp, const cc_string* name) {
+	Game_UpdateTextureBitmap(&skybox_tex, bmp, name, NULL, NULL);
 }
-static struct TextureEntry skybox_entry = { "skybox.png", SkyboxPngProcess };
+static struct TextureEntry skybox_entry = { "skybox.png", NULL, SkyboxPngProcess };
 
-static void SnowPngProcess(struct Stream* stream, const cc_string* name) {
-	Game_UpdateTexture(&snow_tex, stream, name, NULL, NULL);
+static void SnowPngProcess(struct Bitmap* bmp, const cc_string* name) {
+	Game_UpdateTextureBitmap(&snow_tex, bmp, name, NULL, NULL);
 }
-static struct TextureEntry snow_entry = { "snow.png", SnowPngProcess };
+static struct TextureEntry snow_entry = { "snow.png", NULL, SnowPngProcess };
 
-static void RainPngProcess(struct Stream* stream, const cc_string* name) {
-	Game_UpdateTexture(&rain_tex, stream, name, NULL, NULL);
+static void RainPngProcess(struct Bitmap* bmp, const cc_string* name) {
+	Game_UpdateTextureBitmap(&rain_tex, bmp, name, NULL, NULL);
 }
-static struct TextureEntry rain_entry = { "rain.png", RainPngProcess };
+static struct TextureEntry rain_entry = { "rain.png", NULL, RainPngProcess };
 
 
 static void DeleteVbs(void) {
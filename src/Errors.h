@@ -138,5 +138,10 @@ enum CC_ERRORS {
 	SSL_ERR_CONTEXT_DEAD = 0xCCDED070UL, /* Server shutdown the SSL context and it must be recreated */
 	PNG_ERR_16BITSAMPLES = 0xCCDED071UL, /* Image uses 16 bit samples, which is unimplemented */
 	ERR_NO_NETWORKING    = 0xCCDED072UL, /* No working network connection */
+
+	CCW_ERR_IDENTIFIER    = 0xCCDED073UL, /* Map file doesn't start with "CCWN" */
+	CCW_ERR_VERSION       = 0xCCDED074UL, /* Map file was saved in an unsupported version of the format */
+	CCW_ERR_CORRUPT       = 0xCCDED075UL, /* Map file header or chunk index is invalid */
+	CCW_ERR_WORLD_CHANGED = 0xCCDED076UL, /* Map file is for a world with different dimensions */
 };
 #endif
@@ -12,6 +12,13 @@
 #include "ExtMath.h"
 #include "Options.h"
 #include "Queue.h"
+#include "Utils.h"
+
+#if (defined __x86_64__ || defined _M_X64) && !defined FANCY_LIGHTING_DISABLE_SIMD
+	/* SSE2 is always available on x86_64 */
+	#define FANCY_LIGHTING_SIMD
+	#include <emmintrin.h>
+#endif
 
 struct LightNode {
 	IVec3 coords; /* 12 bytes */
@@ -269,95 +276,271 @@ cc_uint8 GetBlockBrightness(BlockID curBlock, cc_bool isLamp) {
 #define LightNode_Init(node, X, Y, Z, bright) \
 	node.coords.x = X; node.coords.y = Y; node.coords.z = Z; node.brightness = bright;
 
-static void CalculateChunkLightingSelf(int chunkIndex, int cx, int cy, int cz) {
-	int x, y, z;
-	/* Block coordinates */
-	int chunkStartX, chunkStartY, chunkStartZ, chunkEndX, chunkEndY, chunkEndZ;
-	cc_uint8 brightness;
-	BlockID curBlock;
-	struct LightNode entry;
+/*########################################################################################################################*
+*----------------------------------------------------Chunk light casting--------------------------------------------------*
+*#########################################################################################################################*/
+/* Light cast by a block can spread at most FANCY_LIGHTING_MAX_LEVEL - 1 cells, which means light cast by the */
+/*  blocks in a chunk can never reach further than the chunks directly surrounding it. So the light cast by */
+/*  a chunk is calculated into a private 3x3x3 chunks region, and then merged into the world's light data. */
+/* Since light levels are merged by taking the highest level, chunks can be calculated in any order (or in parallel) */
+#define REGION_CHUNKS 3
+#define REGION_SIZE (REGION_CHUNKS * CHUNK_SIZE)
+#define REGION_COUNT (REGION_CHUNKS * REGION_CHUNKS * REGION_CHUNKS)
+
+/* Light nodes are packed into 32 bits as 0b_S_L_YYYYYY_ZZZZZZ_XXXXXX, where L is set for lamp light, */
+/*  and S is set for light casting blocks (whose cells have not been lit yet, unlike all other nodes) */
+#define REGION_NODE_LAMP   (1 << 18)
+#define REGION_NODE_SOURCE (1 << 19)
+#define RegionNode_Pack(rx, ry, rz) ((rx) | ((rz) << 6) | ((ry) << 12))
+#define RegionNode_X(node) ((node)         & 0x3F)
+#define RegionNode_Z(node) (((node) >>  6) & 0x3F)
+#define RegionNode_Y(node) (((node) >> 12) & 0x3F)
+
+struct LightRegion {
+	int chunkIndex, cx, cy, cz;
+	/* World coordinates of the region's origin */
+	int baseX, baseY, baseZ;
+	/* Region coordinates of cells that are inside the world */
+	int minX, minY, minZ, maxX, maxY, maxZ;
+	LightingChunk chunks[REGION_COUNT];
+	/* Nodes to spread light from, for each light level */
+	cc_uint32* nodes[FANCY_LIGHTING_LEVELS];
+	int count[FANCY_LIGHTING_LEVELS], capacity[FANCY_LIGHTING_LEVELS];
+};
+
+#define Region_ChunkIndex(rx, ry, rz) (((ry) >> CHUNK_SHIFT) * (REGION_CHUNKS * REGION_CHUNKS) + ((rz) >> CHUNK_SHIFT) * REGION_CHUNKS + ((rx) >> CHUNK_SHIFT))
+
+static int Region_GetBrightness(struct LightRegion* r, int rx, int ry, int rz, int shift) {
+	LightingChunk chunk = r->chunks[Region_ChunkIndex(rx, ry, rz)];
+	if (!chunk) return 0;
+	return (chunk[GlobalCoordsToChunkCoordsIndex(rx, ry, rz)] >> shift) & FANCY_LIGHTING_MAX_LEVEL;
+}
+
+/* Sets the light level at this cell, returning false if the light data could not be allocated */
+static cc_bool Region_SetBrightness(struct LightRegion* r, int rx, int ry, int rz, int shift, int brightness) {
+	int index = Region_ChunkIndex(rx, ry, rz);
+	cc_uint8* value;
+
+	if (!r->chunks[index]) {
+		r->chunks[index] = (cc_uint8*)Mem_TryAllocCleared(CHUNK_SIZE_3, sizeof(cc_uint8));
+		if (!r->chunks[index]) return false;
+	}
+
+	value  = &r->chunks[index][GlobalCoordsToChunkCoordsIndex(rx, ry, rz)];
+	*value = (*value & ~(FANCY_LIGHTING_MAX_LEVEL << shift)) | (brightness << shift);
+	return true;
+}
 
-	chunkStartX = cx * CHUNK_SIZE;
-	chunkStartY = cy * CHUNK_SIZE;
-	chunkStartZ = cz * CHUNK_SIZE;
-	chunkEndX = chunkStartX + CHUNK_SIZE;
-	chunkEndY = chunkStartY + CHUNK_SIZE;
-	chunkEndZ = chunkStartZ + CHUNK_SIZE;
-
-	if (chunkEndX > World.Width ) { chunkEndX = World.Width;  }
-	if (chunkEndY > World.Height) { chunkEndY = World.Height; }
-	if (chunkEndZ > World.Length) { chunkEndZ = World.Length; }
-
-	for (y = chunkStartY; y < chunkEndY; y++) {
-		for (z = chunkStartZ; z < chunkEndZ; z++) {
-			for (x = chunkStartX; x < chunkEndX; x++) {
-
-				curBlock = World_GetBlock(x, y, z);
-				
-				if (Blocks.Brightness[curBlock] > 0) {
-
-					brightness = GetBlockBrightness(curBlock, false);
-
-					if (brightness > 0) {
-						LightNode_Init(entry, x, y, z, brightness);
-						Queue_Enqueue(&lightQueue, &entry);
-						FlushLightQueue(false, false);
-					}
-					else {
-						/* If no lava brightness, it must use lamp brightness */
-						brightness = Blocks.Brightness[curBlock] >> FANCY_LIGHTING_LAMP_SHIFT;
-						LightNode_Init(entry, x, y, z, brightness);
-						Queue_Enqueue(&lightQueue, &entry);
-						FlushLightQueue(true, false);
-					}
+static void Region_AddNode(struct LightRegion* r, int level, cc_uint32 node) {
+	cc_uint32* nodes;
+	int capacity;
+
+	if (r->count[level] == r->capacity[level]) {
+		capacity = max(256, r->capacity[level] * 2);
+		nodes    = (cc_uint32*)Mem_TryRealloc(r->nodes[level], capacity, sizeof(cc_uint32));
+		/* Out of memory, so just drop the light */
+		if (!nodes) return;
+
+		r->nodes[level]    = nodes;
+		r->capacity[level] = capacity;
+	}
+	r->nodes[level][r->count[level]++] = node;
+}
+
+/* Adds a node for every light casting block in the region's center chunk */
+static cc_bool Region_AddSources(struct LightRegion* r) {
+	int x, y, z, startX, startY, startZ, endX, endY, endZ;
+	cc_bool anySources = false;
+	cc_uint8 brightness;
+	cc_uint32 node;
+	BlockID block;
+
+	startX = r->cx * CHUNK_SIZE; endX = min(startX + CHUNK_SIZE, World.Width);
+	startY = r->cy * CHUNK_SIZE; endY = min(startY + CHUNK_SIZE, World.Height);
+	startZ = r->cz * CHUNK_SIZE; endZ = min(startZ + CHUNK_SIZE, World.Length);
+
+	for (y = startY; y < endY; y++) {
+		for (z = startZ; z < endZ; z++) {
+			for (x = startX; x < endX; x++)
+			{
+				block      = World_GetBlock(x, y, z);
+				brightness = Blocks.Brightness[block];
+				if (!brightness) continue;
+				node = RegionNode_Pack(x - r->baseX, y - r->baseY, z - r->baseZ) | REGION_NODE_SOURCE;
+
+				/* If no lava brightness, it must use lamp brightness */
+				if (brightness & FANCY_LIGHTING_MAX_LEVEL) {
+					Region_AddNode(r, brightness & FANCY_LIGHTING_MAX_LEVEL, node);
+				} else {
+					Region_AddNode(r, brightness >> FANCY_LIGHTING_LAMP_SHIFT, node | REGION_NODE_LAMP);
 				}
+				anySources = true;
+			}
+		}
+	}
+	return anySources;
+}
+
+#define Region_TrySpreadInto(cond, nx, ny, nz, thisFace, thatFace) \
+	if ((cond) && Region_GetBrightness(r, nx, ny, nz, shift) < level - 1 && \
+		CanLightPass(thisBlock, thisFace) && \
+		CanLightPass(World_GetBlock(r->baseX + (nx), r->baseY + (ny), r->baseZ + (nz)), thatFace) && \
+		Region_SetBrightness(r, nx, ny, nz, shift, level - 1)) { \
+		Region_AddNode(r, level - 1, RegionNode_Pack(nx, ny, nz) | lampBit); \
+	}
 
-				/* Note: This code only deals with generating light from block sources.
-				Regular sun light is added on as a "post process" step when returning light color in the exposed API.
-				This has the added benefit of being able to skip allocating chunk lighting data in regions that have no light-casting blocks*/
+/* Spreads light out from all of the nodes, starting with the brightest nodes. Because of this, */
+/*  a cell's light level is final the first time it is set, so it is lit when its node is added */
+static void Region_Spread(struct LightRegion* r) {
+	int level, i, rx, ry, rz, shift;
+	cc_uint32 node, lampBit;
+	BlockID thisBlock;
+
+	for (level = FANCY_LIGHTING_MAX_LEVEL; level > 0; level--)
+	{
+		/* Spreading into a cell only ever adds nodes to the next lower level */
+		for (i = 0; i < r->count[level]; i++)
+		{
+			node    = r->nodes[level][i];
+			lampBit = node & REGION_NODE_LAMP;
+			shift   = lampBit ? FANCY_LIGHTING_LAMP_SHIFT : 0;
+			rx = RegionNode_X(node); ry = RegionNode_Y(node); rz = RegionNode_Z(node);
+
+			/* If this cell is already at least as lit, its neighbours have been accounted for */
+			if (node & REGION_NODE_SOURCE) {
+				if (Region_GetBrightness(r, rx, ry, rz, shift) >= level) continue;
+				if (!Region_SetBrightness(r, rx, ry, rz, shift, level)) continue;
 			}
+			if (level == 1) continue;
+
+			thisBlock = World_GetBlock(r->baseX + rx, r->baseY + ry, r->baseZ + rz);
+			Region_TrySpreadInto(rx > r->minX, rx - 1, ry, rz, FACE_XMAX, FACE_XMIN)
+			Region_TrySpreadInto(rx < r->maxX, rx + 1, ry, rz, FACE_XMIN, FACE_XMAX)
+			Region_TrySpreadInto(ry > r->minY, rx, ry - 1, rz, FACE_YMAX, FACE_YMIN)
+			Region_TrySpreadInto(ry < r->maxY, rx, ry + 1, rz, FACE_YMIN, FACE_YMAX)
+			Region_TrySpreadInto(rz > r->minZ, rx, ry, rz - 1, FACE_ZMAX, FACE_ZMIN)
+			Region_TrySpreadInto(rz < r->maxZ, rx, ry, rz + 1, FACE_ZMIN, FACE_ZMAX)
 		}
+		r->count[level] = 0;
+	}
+}
+
+/* Calculates the light cast by the blocks in a chunk into its region. Can be run on any thread. */
+static void CalculateChunkLightingSelf(void* obj, int index) {
+	struct LightRegion* r = &((struct LightRegion*)obj)[index];
+	int i;
+
+	r->baseX = (r->cx - 1) * CHUNK_SIZE;
+	r->baseY = (r->cy - 1) * CHUNK_SIZE;
+	r->baseZ = (r->cz - 1) * CHUNK_SIZE;
+
+	r->minX = max(0, -r->baseX); r->maxX = min(REGION_SIZE, World.Width  - r->baseX) - 1;
+	r->minY = max(0, -r->baseY); r->maxY = min(REGION_SIZE, World.Height - r->baseY) - 1;
+	r->minZ = max(0, -r->baseZ); r->maxZ = min(REGION_SIZE, World.Length - r->baseZ) - 1;
+
+	if (Region_AddSources(r)) Region_Spread(r);
+
+	for (i = 0; i < FANCY_LIGHTING_LEVELS; i++)
+	{
+		Mem_Free(r->nodes[i]);
+	}
+}
+
+/* Merges light levels into the existing light levels, keeping the brightest of the lamp and lava levels */
+static void MergeChunkLighting(cc_uint8* dst, const cc_uint8* src) {
+	int i;
+#ifdef FANCY_LIGHTING_SIMD
+	__m128i lavaMask = _mm_set1_epi8(FANCY_LIGHTING_MAX_LEVEL);
+	__m128i lampMask = _mm_set1_epi8((char)(FANCY_LIGHTING_MAX_LEVEL << FANCY_LIGHTING_LAMP_SHIFT));
+	__m128i a, b, lava, lamp;
+
+	for (i = 0; i < CHUNK_SIZE_3; i += 16)
+	{
+		a = _mm_loadu_si128((const __m128i*)(dst + i));
+		b = _mm_loadu_si128((const __m128i*)(src + i));
+
+		lava = _mm_max_epu8(_mm_and_si128(a, lavaMask), _mm_and_si128(b, lavaMask));
+		lamp = _mm_max_epu8(_mm_and_si128(a, lampMask), _mm_and_si128(b, lampMask));
+		_mm_storeu_si128((__m128i*)(dst + i), _mm_or_si128(lava, lamp));
+	}
+#else
+	int lava, lamp;
+	for (i = 0; i < CHUNK_SIZE_3; i++)
+	{
+		lava = max(dst[i] & FANCY_LIGHTING_MAX_LEVEL, src[i] & FANCY_LIGHTING_MAX_LEVEL);
+		lamp = max(dst[i] >> FANCY_LIGHTING_LAMP_SHIFT, src[i] >> FANCY_LIGHTING_LAMP_SHIFT);
+		dst[i] = (cc_uint8)(lava | (lamp << FANCY_LIGHTING_LAMP_SHIFT));
 	}
+#endif
+}
 
-	chunkLightingDataFlags[chunkIndex] = CHUNK_SELF_CALCULATED;
+/* Merges the light cast by the region's center chunk into the world's light data */
+static void MergeRegionLighting(struct LightRegion* r) {
+	int i, chunkIndex;
+	int cx, cy, cz;
+
+	for (i = 0; i < REGION_COUNT; i++)
+	{
+		/* Only chunks inside the world ever have light data allocated */
+		if (!r->chunks[i]) continue;
+
+		cx = r->cx - 1 + (i % REGION_CHUNKS);
+		cz = r->cz - 1 + (i / REGION_CHUNKS) % REGION_CHUNKS;
+		cy = r->cy - 1 + (i / (REGION_CHUNKS * REGION_CHUNKS));
+		chunkIndex = ChunkCoordsToIndex(cx, cy, cz);
+
+		if (!chunkLightingData[chunkIndex]) {
+			chunkLightingData[chunkIndex] = r->chunks[i];
+		} else {
+			MergeChunkLighting(chunkLightingData[chunkIndex], r->chunks[i]);
+			Mem_Free(r->chunks[i]);
+		}
+	}
+	chunkLightingDataFlags[r->chunkIndex] = CHUNK_SELF_CALCULATED;
 }
 
+/* Only ever used from the main thread, so can be static to reduce stack usage */
+static struct LightRegion regions[REGION_COUNT];
+
 static void CalculateChunkLightingAll(int chunkIndex, int cx, int cy, int cz) {
-	int x, y, z;
+	int x, y, z, i, count = 0;
 	/* Chunk coordinates */
 	int chunkStartX, chunkStartY, chunkStartZ;
 	int chunkEndX, chunkEndY, chunkEndZ;
 	int curChunkIndex;
 
-	chunkStartX = cx - 1;
-	chunkStartY = cy - 1;
-	chunkStartZ = cz - 1;
-	chunkEndX = cx + 1;
-	chunkEndY = cy + 1;
-	chunkEndZ = cz + 1;
-
-	if (chunkStartX == -1) { chunkStartX++; }
-	if (chunkStartY == -1) { chunkStartY++; }
-	if (chunkStartZ == -1) { chunkStartZ++; }
-	if (chunkEndX == World.ChunksX) { chunkEndX--; }
-	if (chunkEndY == World.ChunksY) { chunkEndY--; }
-	if (chunkEndZ == World.ChunksZ) { chunkEndZ--; }
+	chunkStartX = max(cx - 1, 0);
+	chunkStartY = max(cy - 1, 0);
+	chunkStartZ = max(cz - 1, 0);
+	chunkEndX = min(cx + 1, World.ChunksX - 1);
+	chunkEndY = min(cy + 1, World.ChunksY - 1);
+	chunkEndZ = min(cz + 1, World.ChunksZ - 1);
 
 	for (y = chunkStartY; y <= chunkEndY; y++) {
 		for (z = chunkStartZ; z <= chunkEndZ; z++) {
-			for (x = chunkStartX; x <= chunkEndX; x++) {
+			for (x = chunkStartX; x <= chunkEndX; x++)
+			{
 				curChunkIndex = ChunkCoordsToIndex(x, y, z);
+				if (chunkLightingDataFlags[curChunkIndex] != CHUNK_UNCALCULATED) continue;
 
-				if (chunkLightingDataFlags[curChunkIndex] == CHUNK_UNCALCULATED) {
-					CalculateChunkLightingSelf(curChunkIndex, x, y, z);
-				}
+				Mem_Set(&regions[count], 0, sizeof(struct LightRegion));
+				regions[count].chunkIndex = curChunkIndex;
+				regions[count].cx = x; regions[count].cy = y; regions[count].cz = z;
+				count++;
 			}
 		}
 	}
+
+	/* Each chunk's light is independently calculated on worker threads, */
+	/*  then merged into the world's light data on this thread afterwards */
+	WorkerPool_Run(CalculateChunkLightingSelf, regions, count);
+	for (i = 0; i < count; i++)
+	{
+		MergeRegionLighting(&regions[i]);
+	}
 	chunkLightingDataFlags[chunkIndex] = CHUNK_ALL_CALCULATED;
 }
 
-
 #define Light_TryUnSpreadInto(axis, dir, limit, AXIS, thisFace, thatFace) \
 		if (neighborCoords.axis dir ## = limit && \
 			CanLightPass(thisBlock, FACE_ ## AXIS ## thisFace) && \
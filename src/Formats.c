@@ -16,6 +16,7 @@
 #include "Chat.h"
 #include "TexturePack.h"
 #include "Utils.h"
+#include "Options.h"
 
 #ifdef CC_BUILD_FILESYSTEM
 static struct LocationUpdate* spawn_point;
@@ -61,24 +62,27 @@ struct MapImporter* MapImporter_Find(const cc_string* path) {
 	return NULL;
 }
 
+cc_result Map_Import(const cc_string* path, struct Stream* stream, struct LocationUpdate* spawn) {
+	struct MapImporter* imp = MapImporter_Find(path);
+	cc_result res;
+	if (!imp) return ERR_NOT_SUPPORTED;
+	
+	spawn_point = spawn;
+	if ((res = imp->import(stream))) World_Reset();
+	return res;
+}
+
 cc_result Map_LoadFrom(const cc_string* path) {
 	cc_string relPath, fileName, fileExt;
 	struct LocationUpdate update = { 0 };
-	struct MapImporter* imp;
 	struct Stream stream;
 	cc_result res;
 	Game_Reset();
 	
 	spawn_point = &update;
-	res = Stream_OpenFile(&stream, path);
+	res = Stream_OpenMappedFile(&stream, path);
 	if (res) { Logger_SysWarn2(res, "opening", path); return res; }
-
-	imp = MapImporter_Find(path);
-	if (!imp) {
-		res = ERR_NOT_SUPPORTED;
-	} else if ((res = imp->import(&stream))) {
-		World_Reset();
-	}
+	res = Map_Import(path, &stream, &update);
 
 	/* No point logging error for closing readonly file */
 	(void)stream.Close(&stream);
@@ -414,6 +418,10 @@ static cc_result Nbt_ReadString(struct Stream* stream, cc_string* str) {
 }
 
 typedef void (*Nbt_Callback)(struct NbtTag* tag);
+/* Returns whether the contents of a byte array too large to be stored inline in the tag are needed */
+typedef cc_bool (*Nbt_ArrayFilter)(struct NbtTag* tag);
+static Nbt_ArrayFilter nbt_keepArray;
+
 static cc_result Nbt_ReadTag(cc_uint8 typeId, cc_bool readTagName, struct Stream* stream, 
 							struct NbtTag* parent, Nbt_Callback callback, int listIndex) {
 	struct NbtTag tag;
@@ -456,6 +464,10 @@ static cc_result Nbt_ReadTag(cc_uint8 typeId, cc_bool readTagName, struct Stream
 
 		if (NbtTag_IsSmall(&tag)) {
 			res = Stream_Read(stream, tag.value.small, tag.dataSize);
+		} else if (!nbt_keepArray(&tag)) {
+			/* Skip over unneeded arrays without ever buffering them */
+			res = stream->Skip(stream, tag.dataSize);
+			tag.dataSize = 0;
 		} else {
 			tag.value.big = (cc_uint8*)Mem_TryAlloc(tag.dataSize, 1);
 			if (!tag.value.big) return ERR_OUT_OF_MEMORY;
@@ -515,12 +527,13 @@ static BlockRaw* Nbt_TakeArray(struct NbtTag* tag, const char* type) {
 	return ptr;
 }
 
-static cc_result Nbt_Read(struct Stream* stream, Nbt_Callback callback) {
+static cc_result Nbt_Read(struct Stream* stream, Nbt_Callback callback, Nbt_ArrayFilter keepArray) {
 	struct Stream compStream;
 	struct InflateState state;
 	cc_result res;
 	cc_uint8 tag;
 
+	nbt_keepArray = keepArray;
 	Inflate_MakeStream2(&compStream, &state, stream);
 	if ((res = Map_SkipGZipHeader(stream))) return res;
 	if ((res = compStream.ReadU8(&compStream, &tag))) return res;
@@ -871,10 +884,21 @@ static void Cw_Callback(struct NbtTag* tag) {
 	        0             1         2        3          4   */
 }
 
+/* Only the block arrays are ever too large to be stored inline in a tag */
+static cc_bool Cw_KeepArray(struct NbtTag* tag) {
+	/* ClassicWorld -> [array] */
+	if (tag->parent->parent) return false;
+	if (IsTag(tag, "BlockArray"))  return true;
+#ifdef EXTENDED_BLOCKS
+	if (IsTag(tag, "BlockArray2")) return true;
+#endif
+	return false;
+}
+
 /* Imports a world from a .cw ClassicWorld map file */
 /* Used by ClassiCube/ClassicalSharp */
 static cc_result Cw_Load(struct Stream* stream) {
-	return Nbt_Read(stream, Cw_Callback);
+	return Nbt_Read(stream, Cw_Callback, Cw_KeepArray);
 }
 
 
@@ -1471,10 +1495,17 @@ static void MCLevel_Callback(struct NbtTag* tag) {
 			0					1				 2 */
 }
 
+/* Only the block array is needed (e.g. the Map "Data" array is skipped) */
+static cc_bool MCLevel_KeepArray(struct NbtTag* tag) {
+	/* MinecraftLevel -> Map -> blocks */
+	struct NbtTag* group = tag->parent;
+	return group->parent && !group->parent->parent && IsTag(group, "Map") && IsTag(tag, "blocks");
+}
+
 /* Imports a world from a .mclevel NBT map file */
 /* Used by Minecraft Indev client */
 static cc_result MCLevel_Load(struct Stream* stream) {
-	cc_result res = Nbt_Read(stream, MCLevel_Callback);
+	cc_result res = Nbt_Read(stream, MCLevel_Callback, MCLevel_KeepArray);
 
 	Env.EdgeHeight  = mcl_edgeHeight;
 	Env.SidesOffset = mcl_sidesHeight - mcl_edgeHeight;
@@ -1482,6 +1513,351 @@ static cc_result MCLevel_Load(struct Stream* stream) {
 }
 
 
+/*########################################################################################################################*
+*---------------------------------------------ClassiCube chunked world format---------------------------------------------*
+*#########################################################################################################################*/
+/* Native format for quickly saving/loading worlds, where each 16x16x16 chunk is separately stored
+   (so chunks can be individually verified, and also rewritten without having to rewrite the whole file)
+Header (32 bytes, all values little endian) {
+	U8[4] "CCWN",  U8 version, U8 flags, U16 reserved
+	U16 "width", "height", "length", U16 reserved
+	U32 "chunkCount", "indexOffset", "metadataOffset", "journalOffset" (0 if no journal)
+}
+Index entry (16 bytes, one per chunk in World_ChunkPack order) {
+	U32 "offset", "crc32" (of the stored bytes)
+	U16 "size", "capacity" (size available for rewriting the chunk in place)
+	U8  "mode", U8[3] reserved
+}
+Chunk data {
+	U8* lower 8 bits of block IDs in the chunk (only blocks inside the world, in x-z-y order)
+	U8* upper 8 bits of block IDs (only when flags has CCW_FLAG_UPPER)
+}
+Metadata is ClassicWorld NBT (without the block arrays), stored uncompressed
+Journal records (appended after the metadata, until the end of the file) {
+	U32 "chunk" (CCW_JOURNAL_METADATA for the metadata), "size", "crc32" (of the stored bytes)
+	U8  "mode", U8[3] reserved, U8* stored bytes
+}
+Records are applied in order on top of the chunks/metadata, stopping at the first incomplete record */
+#define CCW_HEADER_SIZE  32
+#define CCW_ENTRY_SIZE   16
+#define CCW_RECORD_SIZE  16
+#define CCW_VERSION      1
+#define CCW_FLAG_UPPER   0x01
+#define CCW_MODE_RAW     0 /* Chunk data is stored as is */
+#define CCW_MODE_LZ      1 /* Chunk data is compressed with Ccw_Compress */
+#define CCW_JOURNAL_METADATA 0xFFFFFFFFUL
+
+#define CCW_MAX_CHUNK    (CHUNK_SIZE_3 * 2)
+/* Worst case size of compressing CCW_MAX_CHUNK bytes of data */
+#define CCW_MAX_STORED   (CCW_MAX_CHUNK + CCW_MAX_CHUNK / 255 + 16)
+#define CCW_LZ_MIN_MATCH 4
+
+struct CcwHeader {
+	int flags, width, height, length;
+	cc_uint32 chunkCount, indexOffset, metaOffset, journalOffset;
+};
+struct CcwChunk { int x, y, z, width, height, length, oneY, oneZ; };
+
+static int Ccw_CountChunks(int width, int height, int length) {
+	return ((width  + CHUNK_MAX) >> CHUNK_SHIFT) * ((height + CHUNK_MAX) >> CHUNK_SHIFT) 
+		* ((length + CHUNK_MAX) >> CHUNK_SHIFT);
+}
+
+static cc_result Ccw_ParseHeader(struct CcwHeader* h, const cc_uint8* data) {
+	if (data[0] != 'C' || data[1] != 'C' || data[2] != 'W' || data[3] != 'N') return CCW_ERR_IDENTIFIER;
+	if (data[4] != CCW_VERSION) return CCW_ERR_VERSION;
+
+	h->flags  = data[5];
+	h->width  = Stream_GetU16_LE(data + 8);
+	h->height = Stream_GetU16_LE(data + 10);
+	h->length = Stream_GetU16_LE(data + 12);
+
+	h->chunkCount    = Stream_GetU32_LE(data + 16);
+	h->indexOffset   = Stream_GetU32_LE(data + 20);
+	h->metaOffset    = Stream_GetU32_LE(data + 24);
+	h->journalOffset = Stream_GetU32_LE(data + 28);
+
+	/* Chunks are copied into the block array by coordinates, so the dimensions must be valid */
+	if (!h->width || !h->height || !h->length) return CCW_ERR_CORRUPT;
+	if (!World_CheckVolume(h->width, h->height, h->length)) return CCW_ERR_CORRUPT;
+
+	if (h->chunkCount  != (cc_uint32)Ccw_CountChunks(h->width, h->height, h->length)) return CCW_ERR_CORRUPT;
+	if (h->indexOffset < CCW_HEADER_SIZE) return CCW_ERR_CORRUPT;
+	return 0;
+}
+
+/* Calculates the area of the world that is covered by the given chunk */
+static void Ccw_GetChunk(struct CcwChunk* c, int index, int width, int height, int length) {
+	int chunksX = (width  + CHUNK_MAX) >> CHUNK_SHIFT;
+	int chunksY = (height + CHUNK_MAX) >> CHUNK_SHIFT;
+
+	c->x = (index % chunksX) << CHUNK_SHIFT; index /= chunksX;
+	c->y = (index % chunksY) << CHUNK_SHIFT; index /= chunksY;
+	c->z = index << CHUNK_SHIFT;
+
+	c->width  = min(CHUNK_SIZE, width  - c->x);
+	c->height = min(CHUNK_SIZE, height - c->y);
+	c->length = min(CHUNK_SIZE, length - c->z);
+	c->oneZ   = width;
+	c->oneY   = width * length;
+}
+
+/* Copies the blocks in the given chunk from (or to when store is true) the given block array */
+static cc_uint8* Ccw_CopyChunk(const struct CcwChunk* c, BlockRaw* blocks, cc_uint8* data, cc_bool store) {
+	int y, z, index;
+
+	for (y = c->y; y < c->y + c->height; y++)
+	{
+		for (z = c->z; z < c->z + c->length; z++)
+		{
+			index = y * c->oneY + z * c->oneZ + c->x;
+			if (store) {
+				Mem_Copy(blocks + index, data, c->width);
+			} else {
+				Mem_Copy(data, blocks + index, c->width);
+			}
+			data += c->width;
+		}
+	}
+	return data;
+}
+
+/* Decompresses data compressed by Ccw_Compress, returning false if the data is invalid */
+/* Sequences are a token (high 4 bits literals length, low 4 bits match length - 4), then
+   optional extra literals length bytes, the literals, U16 match offset, optional extra match length bytes
+   Lengths of 15 in the token are extended by the following bytes, until a byte that isn't 255 */
+static cc_bool Ccw_Decompress(const cc_uint8* src, int srcLen, cc_uint8* dst, int dstLen) {
+	const cc_uint8* end = src + srcLen;
+	int pos = 0, len, offset;
+	cc_uint8 token;
+
+	while (src < end) {
+		token = *src++;
+		len   = token >> 4;
+
+		if (len == 15) {
+			do {
+				if (src >= end) return false;
+				len += *src;
+			} while (*src++ == 255);
+		}
+		if (len > end - src || len > dstLen - pos) return false;
+
+		Mem_Copy(dst + pos, src, len);
+		src += len; pos += len;
+		/* Last sequence never has a match */
+		if (src == end) break;
+
+		if (end - src < 2) return false;
+		offset = Stream_GetU16_LE(src); src += 2;
+		len    = (token & 0x0F) + CCW_LZ_MIN_MATCH;
+
+		if ((token & 0x0F) == 15) {
+			do {
+				if (src >= end) return false;
+				len += *src;
+			} while (*src++ == 255);
+		}
+		if (!offset || offset > pos || len > dstLen - pos) return false;
+
+		if (offset >= len) {
+			Mem_Copy(dst + pos, dst + pos - offset, len);
+			pos += len;
+		} else {
+			/* Overlapping match (e.g. runs of the same block) */
+			for (; len; len--, pos++) dst[pos] = dst[pos - offset];
+		}
+	}
+	return pos == dstLen;
+}
+
+
+/* Verifies and decodes the stored data for a chunk, returning NULL if the data is corrupted */
+static cc_uint8* Ccw_DecodeChunk(const struct CcwHeader* h, const struct CcwChunk* c, cc_uint8* stored, 
+								int size, cc_uint32 crc, int mode, cc_uint8* data) {
+	int volume = c->width * c->height * c->length;
+	if (h->flags & CCW_FLAG_UPPER) volume *= 2;
+	if (Utils_CRC32(stored, size) != crc) return NULL;
+
+	if (mode == CCW_MODE_LZ) {
+		return Ccw_Decompress(stored, size, data, volume) ? data : NULL;
+	} else if (mode == CCW_MODE_RAW) {
+		return size == volume ? stored : NULL;
+	}
+	return NULL;
+}
+
+static void Ccw_StoreChunk(const struct CcwHeader* h, const struct CcwChunk* c, cc_uint8* data) {
+	data = Ccw_CopyChunk(c, World.Blocks, data, true);
+#ifdef EXTENDED_BLOCKS
+	if (h->flags & CCW_FLAG_UPPER) Ccw_CopyChunk(c, World.Blocks2, data, true);
+#endif
+}
+
+/* The dimensions and blocks were already loaded from the header and chunks, */
+/*  so ignore any dimensions or block arrays in the metadata */
+static void Ccw_Callback(struct NbtTag* tag) {
+	/* ClassicWorld -> [value] */
+	if (tag->parent && !tag->parent->parent) {
+		if (IsTag(tag, "X") || IsTag(tag, "Y") || IsTag(tag, "Z")) return;
+		if (IsTag(tag, "BlockArray") || IsTag(tag, "BlockArray2")) return;
+	}
+	Cw_Callback(tag);
+}
+
+static cc_bool Ccw_KeepArray(struct NbtTag* tag) { return false; }
+
+/* Reads the ClassicWorld metadata */
+static cc_result Ccw_ReadMetadata(struct Stream* stream) {
+	cc_uint8 buffer[1024];
+	struct Stream buffered;
+	cc_result res;
+	cc_uint8 tag;
+	Stream_ReadonlyBuffered(&buffered, stream, buffer, sizeof(buffer));
+
+	if ((res = buffered.ReadU8(&buffered, &tag))) return res;
+	if (tag != NBT_DICT) return CW_ERR_ROOT_TAG;
+
+	nbt_keepArray = Ccw_KeepArray;
+	return Nbt_ReadTag(NBT_DICT, true, &buffered, NULL, Ccw_Callback, 0);
+}
+
+/* Applies the records in the journal, returning the latest metadata record (if any) */
+/* Chunks are decoded using the buffers following the index */
+static cc_result Ccw_ReadJournal(struct Stream* stream, const struct CcwHeader* h, cc_uint8* stored, 
+								cc_uint8** metadata, cc_uint32* metadataSize) {
+	cc_uint8 tmp[CCW_RECORD_SIZE];
+	struct CcwChunk c;
+	cc_uint32 pos, length, index, crc, size = 0;
+	cc_uint8* data;
+	cc_result res;
+
+	if ((res = stream->Length(stream, &length))) return res;
+	if (h->journalOffset + CCW_RECORD_SIZE > length) return 0;
+
+	if ((res = stream->Seek(stream, h->journalOffset))) return res;
+	pos = h->journalOffset;
+
+	/* The last record may be incomplete when the game crashed while writing it */
+	for (; pos + CCW_RECORD_SIZE <= length; pos += CCW_RECORD_SIZE + size)
+	{
+		if ((res = Stream_Read(stream, tmp, CCW_RECORD_SIZE))) return res;
+		index = Stream_GetU32_LE(tmp + 0);
+		size  = Stream_GetU32_LE(tmp + 4);
+		crc   = Stream_GetU32_LE(tmp + 8);
+		if (size > length - pos - CCW_RECORD_SIZE) break;
+
+		if (index == CCW_JOURNAL_METADATA) {
+			data = (cc_uint8*)Mem_TryAlloc(size, 1);
+			if (!data) return ERR_OUT_OF_MEMORY;
+
+			if ((res = Stream_Read(stream, data, size))) { Mem_Free(data); return res; }
+			if (Utils_CRC32(data, size) != crc)         { Mem_Free(data); break; }
+
+			Mem_Free(*metadata);
+			*metadata     = data;
+			*metadataSize = size;
+		} else {
+			if (index >= h->chunkCount || size > CCW_MAX_STORED) break;
+			if ((res = Stream_Read(stream, stored, size))) return res;
+
+			Ccw_GetChunk(&c, index, h->width, h->height, h->length);
+			data = Ccw_DecodeChunk(h, &c, stored, size, crc, tmp[12], stored + CCW_MAX_STORED);
+			if (!data) break;
+			Ccw_StoreChunk(h, &c, data);
+		}
+	}
+	return 0;
+}
+
+/* Imports a world from a .ccw ClassiCube chunked world file */
+/* Used by ClassiCube for quickly saving/loading singleplayer worlds */
+static cc_result Ccw_Load(struct Stream* stream) {
+	cc_uint8 tmp[CCW_HEADER_SIZE];
+	struct Stream memStream;
+	struct CcwHeader h;
+	struct CcwChunk c;
+	cc_uint8* index;
+	cc_uint8* entry;
+	cc_uint8* stored;
+	cc_uint8* data;
+	cc_uint8* metadata = NULL;
+	cc_uint32 pos, offset, metadataSize = 0;
+	int i, count, size, bad = 0;
+	cc_result res;
+
+	if ((res = Stream_Read(stream, tmp, CCW_HEADER_SIZE))) return res;
+	if ((res = Ccw_ParseHeader(&h, tmp)))                  return res;
+
+	World.Width  = h.width; World.Height = h.height; World.Length = h.length;
+	World.Volume = h.width * h.height * h.length;
+	World.Blocks = (BlockRaw*)Mem_TryAlloc(World.Volume, 1);
+	if (!World.Blocks) return ERR_OUT_OF_MEMORY;
+
+#ifdef EXTENDED_BLOCKS
+	if (h.flags & CCW_FLAG_UPPER) {
+		BlockRaw* upper = (BlockRaw*)Mem_TryAlloc(World.Volume, 1);
+		if (!upper) return ERR_OUT_OF_MEMORY;
+		World_SetMapUpper(upper);
+	}
+#endif
+	/* NOTE: Chunks still contain the upper 8 bits of block IDs when EXTENDED_BLOCKS is not defined, */
+	/*  but Ccw_StoreChunk just ignores them (since the upper 8 bits are unusable anyways) */
+
+	count = h.chunkCount;
+	/* Index, then buffer for stored chunk data, then buffer for decompressed chunk data */
+	index = (cc_uint8*)Mem_TryAlloc(count * CCW_ENTRY_SIZE + CCW_MAX_STORED + CCW_MAX_CHUNK, 1);
+	if (!index) return ERR_OUT_OF_MEMORY;
+	stored = index + count * CCW_ENTRY_SIZE;
+
+	if (h.indexOffset != CCW_HEADER_SIZE && (res = stream->Seek(stream, h.indexOffset))) goto finished;
+	if ((res = Stream_Read(stream, index, count * CCW_ENTRY_SIZE))) goto finished;
+	pos = h.indexOffset + count * CCW_ENTRY_SIZE;
+
+	for (i = 0, entry = index; i < count; i++, entry += CCW_ENTRY_SIZE)
+	{
+		offset = Stream_GetU32_LE(entry + 0);
+		size   = Stream_GetU16_LE(entry + 8);
+		if (size > CCW_MAX_STORED) { res = CCW_ERR_CORRUPT; goto finished; }
+
+		/* Chunks are usually stored in order, so avoid seeking when possible */
+		if (offset != pos && (res = stream->Seek(stream, offset))) goto finished;
+		if ((res = Stream_Read(stream, stored, size))) goto finished;
+		pos = offset + size;
+
+		Ccw_GetChunk(&c, i, h.width, h.height, h.length);
+		data = Ccw_DecodeChunk(&h, &c, stored, size, Stream_GetU32_LE(entry + 4), entry[12], stored + CCW_MAX_STORED);
+
+		/* Corrupted chunks are left as air, so the rest of the world can still be loaded */
+		if (!data) {
+			data = stored + CCW_MAX_STORED;
+			Mem_Set(data, 0, CCW_MAX_CHUNK);
+			bad++;
+		}
+		Ccw_StoreChunk(&h, &c, data);
+	}
+
+	if (bad) {
+		Chat_Add1("&c%i chunks in the map were corrupted", &bad);
+		Chat_AddRaw("&c  These chunks have therefore been replaced with air");
+	}
+
+	if (h.journalOffset && (res = Ccw_ReadJournal(stream, &h, stored, &metadata, &metadataSize))) goto finished;
+
+	if (metadata) {
+		Stream_ReadonlyMemory(&memStream, metadata, metadataSize);
+		res = Ccw_ReadMetadata(&memStream);
+	} else if (!(res = stream->Seek(stream, h.metaOffset))) {
+		res = Ccw_ReadMetadata(stream);
+	}
+
+finished:
+	Mem_Free(metadata);
+	Mem_Free(index);
+	return res;
+}
+
+
 /*########################################################################################################################*
 *--------------------------------------------------ClassicWorld export----------------------------------------------------*
 *#########################################################################################################################*/
@@ -1570,7 +1946,27 @@ static cc_result Cw_WriteBockDef(struct Stream* stream, int b) {
 	return Stream_Write(stream, buffer, (int)(cur - buffer));
 }
 
-cc_result Cw_Save(struct Stream* stream) {
+static cc_result Cw_WriteBlocks(struct Stream* stream) {
+	cc_uint8 buffer[32];
+	cc_uint8* cur;
+	cc_result res;
+
+	cur = Nbt_WriteArray(buffer, "BlockArray", World.Volume);
+	if ((res = Stream_Write(stream, buffer, (int)(cur - buffer)))) return res;
+	if ((res = Stream_Write(stream, World.Blocks, World.Volume)))  return res;
+
+#ifdef EXTENDED_BLOCKS
+	if (World.Blocks != World.Blocks2) {
+		cur = Nbt_WriteArray(buffer, "BlockArray2", World.Volume);
+		if ((res = Stream_Write(stream, buffer, (int)(cur - buffer)))) return res;
+		if ((res = Stream_Write(stream, World.Blocks2, World.Volume))) return res;
+	}
+#endif
+	return 0;
+}
+
+/* Writes the world and its metadata, optionally omitting the block arrays */
+static cc_result Cw_WriteWorld(struct Stream* stream, cc_bool blocks) {
 	struct LocalPlayer* p = Entities.CurPlayer;
 	cc_uint8 buffer[2048];
 	cc_uint8* cur;
@@ -1600,20 +1996,8 @@ cc_result Cw_Save(struct Stream* stream) {
 		cur  = Nbt_WriteUInt8(cur,  "H", Math_Deg2Packed(p->SpawnYaw));
 		cur  = Nbt_WriteUInt8(cur,  "P", Math_Deg2Packed(p->SpawnPitch));
 	} *cur++ = NBT_END;
-	cur = Nbt_WriteArray(cur, "BlockArray", World.Volume);
-
 	if ((res = Stream_Write(stream, buffer, (int)(cur - buffer)))) return res;
-	if ((res = Stream_Write(stream, World.Blocks, World.Volume)))  return res;
-
-#ifdef EXTENDED_BLOCKS
-	if (World.Blocks != World.Blocks2) {
-		cur = buffer;
-		cur = Nbt_WriteArray(cur, "BlockArray2", World.Volume);
-
-		if ((res = Stream_Write(stream, buffer, (int)(cur - buffer)))) return res;
-		if ((res = Stream_Write(stream, World.Blocks2, World.Volume))) return res;
-	}
-#endif
+	if (blocks && (res = Cw_WriteBlocks(stream)))                  return res;
 
 	cur = buffer;
 	cur = Nbt_WriteDict(cur, "Metadata");
@@ -1677,6 +2061,10 @@ cc_result Cw_Save(struct Stream* stream) {
 	return Stream_Write(stream, cw_end, sizeof(cw_end));
 }
 
+cc_result Cw_Save(struct Stream* stream) {
+	return Cw_WriteWorld(stream, true);
+}
+
 
 /*########################################################################################################################*
 *---------------------------------------------------Schematic export------------------------------------------------------*
@@ -1856,6 +2244,706 @@ cc_result Dat_Save(struct Stream* stream) {
 }
 
 
+/*########################################################################################################################*
+*---------------------------------------------ClassiCube chunked world export---------------------------------------------*
+*#########################################################################################################################*/
+#define CCW_LZ_HASH_BITS 12
+#define Ccw_Hash(value) (((value) * 2654435761U) >> (32 - CCW_LZ_HASH_BITS))
+#define Ccw_Read32(p)   ((p)[0] | ((p)[1] << 8) | ((p)[2] << 16) | ((cc_uint32)(p)[3] << 24))
+
+/* Blocks and metadata of a world to save, which can be a copy of the current world */
+/* (so that it can be saved on a background thread, while the current world keeps changing) */
+struct CcwSnapshot {
+	struct CcwHeader header;
+	BlockRaw* blocks;
+	BlockRaw* blocks2;       /* NULL when the world only uses 8 bit block IDs */
+	cc_bool ownsBlocks;      /* Whether blocks/blocks2 are copies that must be freed */
+	cc_uint8* metadata;      /* ClassicWorld NBT metadata of the world */
+	cc_uint32 metadataSize;
+	int* chunks;             /* Chunks copied into chunksData, for journal records */
+	int numChunks;
+	cc_uint8* chunksData;
+};
+
+struct CcwEncoder {
+	cc_uint8 data[CCW_MAX_CHUNK];    /* Blocks in the chunk being encoded */
+	cc_uint8 stored[CCW_MAX_STORED]; /* Compressed blocks in the chunk being encoded */
+	cc_uint16 table[1 << CCW_LZ_HASH_BITS];
+	cc_uint8 buffer[16384];          /* Buffers writes of chunks to the output stream */
+	int used;
+	int size, mode; cc_uint32 crc;   /* Stored size/mode/checksum of the last encoded chunk */
+};
+
+static cc_uint8* Ccw_WriteLength(cc_uint8* dst, int len) {
+	for (; len >= 255; len -= 255) *dst++ = 255;
+
+	*dst++ = len;
+	return dst;
+}
+
+static cc_uint8* Ccw_WriteSequence(cc_uint8* dst, const cc_uint8* literals, int numLiterals, int offset, int matchLen) {
+	int extra  = matchLen ? matchLen - CCW_LZ_MIN_MATCH : 0;
+	*dst++ = (min(numLiterals, 15) << 4) | min(extra, 15);
+
+	if (numLiterals >= 15) dst = Ccw_WriteLength(dst, numLiterals - 15);
+	Mem_Copy(dst, literals, numLiterals);
+	dst += numLiterals;
+	if (!matchLen) return dst;
+
+	Stream_SetU16_LE(dst, offset);
+	dst += 2;
+	if (extra >= 15) dst = Ccw_WriteLength(dst, extra - 15);
+	return dst;
+}
+
+/* Compresses the given data into sequences of (literals, match), returning the compressed size */
+/* NOTE: Only the most recent position for each hash is checked, which favours speed over compression ratio */
+static int Ccw_Compress(struct CcwEncoder* e, const cc_uint8* src, int len, cc_uint8* dst) {
+	cc_uint8* cur = dst;
+	int pos = 0, literals = 0, ref, matchLen;
+	cc_uint32 value, hash;
+	/* 0xFFFF is never a valid position, as chunk data is at most 8192 bytes */
+	Mem_Set(e->table, 0xFF, sizeof(e->table));
+
+	while (pos + CCW_LZ_MIN_MATCH <= len) {
+		value = Ccw_Read32(src + pos);
+		hash  = Ccw_Hash(value);
+		ref   = e->table[hash];
+		e->table[hash] = pos;
+
+		if (ref == 0xFFFF || Ccw_Read32(src + ref) != value) { pos++; continue; }
+
+		matchLen = CCW_LZ_MIN_MATCH;
+		while (pos + matchLen < len && src[ref + matchLen] == src[pos + matchLen]) matchLen++;
+
+		cur = Ccw_WriteSequence(cur, src + literals, pos - literals, pos - ref, matchLen);
+		pos += matchLen;
+		literals = pos;
+	}
+	/* Last sequence only consists of literals */
+	cur = Ccw_WriteSequence(cur, src + literals, len - literals, 0, 0);
+	return (int)(cur - dst);
+}
+
+/* Copies the blocks in the given chunk, returning the number of bytes copied */
+static int Ccw_GatherChunk(const struct CcwSnapshot* s, int index, cc_uint8* data) {
+	const struct CcwHeader* h = &s->header;
+	struct CcwChunk c;
+	cc_uint8* cur;
+
+	Ccw_GetChunk(&c, index, h->width, h->height, h->length);
+	cur = Ccw_CopyChunk(&c, s->blocks, data, false);
+	if (s->blocks2) cur = Ccw_CopyChunk(&c, s->blocks2, cur, false);
+	return (int)(cur - data);
+}
+
+/* Encodes the blocks of a chunk, returning pointer to the data to store */
+/* NOTE: Also updates the stored size, mode and checksum in the encoder */
+static cc_uint8* Ccw_EncodeChunk(struct CcwEncoder* e, cc_uint8* data, int volume, cc_bool compress) {
+	e->size = volume;
+	e->mode = CCW_MODE_RAW;
+
+	if (compress) {
+		int size = Ccw_Compress(e, data, volume, e->stored);
+		/* Not worth compressing (e.g. random data), so store as is */
+		if (size < volume) {
+			data    = e->stored;
+			e->size = size;
+			e->mode = CCW_MODE_LZ;
+		}
+	}
+
+	e->crc = Utils_CRC32(data, e->size);
+	return data;
+}
+
+/* Reserves some extra space, so that chunk is likely to be rewritable in place after a few block changes */
+static int Ccw_CalcCapacity(int size) {
+	return min(CCW_MAX_STORED, (size + (size >> 3) + 15) & ~15);
+}
+
+static cc_result Ccw_WriteHeader(struct Stream* stream, const struct CcwHeader* h) {
+	cc_uint8 tmp[CCW_HEADER_SIZE] = { 'C','C','W','N', CCW_VERSION };
+	tmp[5] = h->flags;
+
+	Stream_SetU16_LE(tmp + 8,  h->width);
+	Stream_SetU16_LE(tmp + 10, h->height);
+	Stream_SetU16_LE(tmp + 12, h->length);
+
+	Stream_SetU32_LE(tmp + 16, h->chunkCount);
+	Stream_SetU32_LE(tmp + 20, h->indexOffset);
+	Stream_SetU32_LE(tmp + 24, h->metaOffset);
+	Stream_SetU32_LE(tmp + 28, h->journalOffset);
+	return Stream_Write(stream, tmp, CCW_HEADER_SIZE);
+}
+
+static cc_result Ccw_MetadataWrite(struct Stream* s, const cc_uint8* data, cc_uint32 count, cc_uint32* modified) {
+	cc_uint32 used, capacity;
+	cc_uint8* base;
+
+	/* Grow the buffer as needed, since metadata size depends on number of custom blocks */
+	if (count > s->meta.mem.left) {
+		used     = (cc_uint32)(s->meta.mem.cur - s->meta.mem.base);
+		capacity = max(s->meta.mem.length * 2, used + count);
+		base     = (cc_uint8*)Mem_TryRealloc(s->meta.mem.base, capacity, 1);
+		if (!base) return ERR_OUT_OF_MEMORY;
+
+		s->meta.mem.base   = base;
+		s->meta.mem.cur    = base + used;
+		s->meta.mem.left   = capacity - used;
+		s->meta.mem.length = capacity;
+	}
+
+	Mem_Copy(s->meta.mem.cur, data, count);
+	s->meta.mem.cur  += count;
+	s->meta.mem.left -= count;
+	*modified = count;
+	return 0;
+}
+
+/* Initialises a snapshot that refers to the blocks and metadata of the current world */
+static cc_result CcwSnapshot_Init(struct CcwSnapshot* s) {
+	struct CcwHeader* h = &s->header;
+	struct Stream stream;
+	cc_result res;
+
+	h->flags = 0;
+	h->width = World.Width; h->height = World.Height; h->length = World.Length;
+	h->chunkCount    = World.ChunksCount;
+	h->indexOffset   = CCW_HEADER_SIZE;
+	h->metaOffset    = 0;
+	h->journalOffset = 0;
+
+	s->blocks  = World.Blocks;
+	s->blocks2 = NULL;
+#ifdef EXTENDED_BLOCKS
+	if (World.Blocks != World.Blocks2) { s->blocks2 = World.Blocks2; h->flags |= CCW_FLAG_UPPER; }
+#endif
+	s->ownsBlocks = false;
+	s->chunks     = NULL;
+	s->chunksData = NULL;
+	s->numChunks  = 0;
+
+	Stream_Init(&stream);
+	stream.Write = Ccw_MetadataWrite;
+	stream.meta.mem.base = stream.meta.mem.cur = (cc_uint8*)Mem_TryAlloc(4096, 1);
+	stream.meta.mem.left = stream.meta.mem.length = 4096;
+
+	s->metadata = stream.meta.mem.base;
+	if (!s->metadata) return ERR_OUT_OF_MEMORY;
+
+	res = Cw_WriteWorld(&stream, false);
+	s->metadata     = stream.meta.mem.base;
+	s->metadataSize = (cc_uint32)(stream.meta.mem.cur - stream.meta.mem.base);
+	return res;
+}
+
+static void CcwSnapshot_Free(struct CcwSnapshot* s) {
+	if (s->ownsBlocks) {
+		Mem_Free(s->blocks);
+		Mem_Free(s->blocks2);
+	}
+	Mem_Free(s->metadata);
+	Mem_Free(s->chunks);
+	Mem_Free(s->chunksData);
+
+	s->blocks   = NULL; s->blocks2    = NULL;
+	s->metadata = NULL; s->chunksData = NULL;
+	s->chunks   = NULL;
+}
+
+static cc_result Ccw_Flush(struct Stream* stream, struct CcwEncoder* e) {
+	int used = e->used;
+	e->used  = 0;
+	return Stream_Write(stream, e->buffer, used);
+}
+
+static cc_result Ccw_Write(struct Stream* stream, struct CcwEncoder* e, const cc_uint8* data, int size, int capacity) {
+	cc_result res;
+	if (e->used + capacity > sizeof(e->buffer) && (res = Ccw_Flush(stream, e))) return res;
+
+	Mem_Copy(e->buffer + e->used, data, size);
+	Mem_Set(e->buffer  + e->used + size, 0, capacity - size);
+	e->used += capacity;
+	return 0;
+}
+
+/* Writes a full .ccw file containing all the blocks in the given snapshot, returning the file size */
+static cc_result Ccw_WriteSnapshot(struct Stream* stream, struct CcwSnapshot* s, cc_bool compress, cc_uint32* size) {
+	struct CcwHeader* h = &s->header;
+	struct CcwEncoder* e;
+	cc_uint8* index;
+	cc_uint8* entry;
+	cc_uint8* data;
+	cc_uint32 offset;
+	int i, volume, capacity;
+	cc_result res;
+
+	index = (cc_uint8*)Mem_TryAllocCleared(h->chunkCount, CCW_ENTRY_SIZE);
+	if (!index) return ERR_OUT_OF_MEMORY;
+
+	e = (struct CcwEncoder*)Mem_TryAlloc(1, sizeof(struct CcwEncoder));
+	if (!e) { Mem_Free(index); return ERR_OUT_OF_MEMORY; }
+	e->used = 0;
+
+	/* Header and index are rewritten once all chunks have been written */
+	if ((res = Ccw_WriteHeader(stream, h)))                                 goto finished;
+	if ((res = Stream_Write(stream, index, h->chunkCount * CCW_ENTRY_SIZE))) goto finished;
+	offset = CCW_HEADER_SIZE + h->chunkCount * CCW_ENTRY_SIZE;
+
+	for (i = 0, entry = index; i < h->chunkCount; i++, entry += CCW_ENTRY_SIZE)
+	{
+		volume = Ccw_GatherChunk(s, i, e->data);
+		data   = Ccw_EncodeChunk(e, e->data, volume, compress);
+		/* Uncompressed chunks always take up the same space, so don't need any spare capacity */
+		capacity = compress ? Ccw_CalcCapacity(e->size) : e->size;
+
+		Stream_SetU32_LE(entry + 0,  offset);
+		Stream_SetU32_LE(entry + 4,  e->crc);
+		Stream_SetU16_LE(entry + 8,  e->size);
+		Stream_SetU16_LE(entry + 10, capacity);
+		entry[12] = e->mode;
+
+		if ((res = Ccw_Write(stream, e, data, e->size, capacity))) goto finished;
+		offset += capacity;
+	}
+	if ((res = Ccw_Flush(stream, e))) goto finished;
+
+	h->metaOffset    = offset;
+	h->journalOffset = offset + s->metadataSize;
+	*size            = h->journalOffset;
+
+	if ((res = Stream_Write(stream, s->metadata, s->metadataSize))) goto finished;
+	if ((res = stream->Seek(stream, 0)))     goto finished;
+	if ((res = Ccw_WriteHeader(stream, h)))  goto finished;
+	res = Stream_Write(stream, index, h->chunkCount * CCW_ENTRY_SIZE);
+
+finished:
+	Mem_Free(e);
+	Mem_Free(index);
+	return res;
+}
+
+cc_result Ccw_Save(struct Stream* stream, cc_bool compress) {
+	struct CcwSnapshot s;
+	cc_uint32 size;
+	cc_result res;
+
+	if (!(res = CcwSnapshot_Init(&s))) {
+		res = Ccw_WriteSnapshot(stream, &s, compress, &size);
+	}
+	CcwSnapshot_Free(&s);
+	return res;
+}
+
+static cc_result Ccw_WriteRecord(struct Stream* stream, cc_uint32 chunk, const cc_uint8* data, 
+								cc_uint32 size, cc_uint32 crc, int mode) {
+	cc_uint8 tmp[CCW_RECORD_SIZE] = { 0 };
+	cc_result res;
+
+	Stream_SetU32_LE(tmp + 0, chunk);
+	Stream_SetU32_LE(tmp + 4, size);
+	Stream_SetU32_LE(tmp + 8, crc);
+	tmp[12] = mode;
+
+	if ((res = Stream_Write(stream, tmp, CCW_RECORD_SIZE))) return res;
+	return Stream_Write(stream, data, size);
+}
+
+/* Appends the chunks and metadata in the given snapshot to the journal of an existing .ccw file */
+/* NOTE: The stream must be positioned at the end of the file */
+static cc_result Ccw_AppendSnapshot(struct Stream* stream, struct CcwSnapshot* s, cc_uint32* written) {
+	struct CcwEncoder* e;
+	cc_uint8* src = s->chunksData;
+	cc_uint8* data;
+	struct CcwChunk c;
+	int i, volume;
+	cc_result res = 0;
+
+	e = (struct CcwEncoder*)Mem_TryAlloc(1, sizeof(struct CcwEncoder));
+	if (!e) return ERR_OUT_OF_MEMORY;
+	*written = 0;
+
+	for (i = 0; i < s->numChunks; i++)
+	{
+		Ccw_GetChunk(&c, s->chunks[i], s->header.width, s->header.height, s->header.length);
+		volume = c.width * c.height * c.length;
+		if (s->header.flags & CCW_FLAG_UPPER) volume *= 2;
+
+		data = Ccw_EncodeChunk(e, src, volume, true);
+		src += volume;
+
+		if ((res = Ccw_WriteRecord(stream, s->chunks[i], data, e->size, e->crc, e->mode))) break;
+		*written += CCW_RECORD_SIZE + e->size;
+	}
+
+	if (!res) {
+		res = Ccw_WriteRecord(stream, CCW_JOURNAL_METADATA, s->metadata, s->metadataSize, 
+								Utils_CRC32(s->metadata, s->metadataSize), CCW_MODE_RAW);
+		*written += CCW_RECORD_SIZE + s->metadataSize;
+	}
+
+	Mem_Free(e);
+	return res;
+}
+
+cc_result Ccw_SaveChunks(struct Stream* stream, const int* chunks, int count) {
+	cc_uint8 tmp[CCW_HEADER_SIZE];
+	struct CcwSnapshot s;
+	struct CcwHeader h;
+	struct CcwEncoder* e = NULL;
+	cc_uint8* index = NULL;
+	cc_uint8* entry;
+	cc_uint8* data;
+	cc_uint32 offset, end;
+	int i, volume, capacity;
+	cc_result res;
+
+	if ((res = CcwSnapshot_Init(&s)))                      goto finished;
+	if ((res = stream->Seek(stream, 0)))                   goto finished;
+	if ((res = Stream_Read(stream, tmp, CCW_HEADER_SIZE))) goto finished;
+	if ((res = Ccw_ParseHeader(&h, tmp)))                  goto finished;
+
+	if (h.flags != s.header.flags || h.width != s.header.width || h.height != s.header.height || h.length != s.header.length) {
+		res = CCW_ERR_WORLD_CHANGED; goto finished;
+	}
+
+	index = (cc_uint8*)Mem_TryAlloc(h.chunkCount, CCW_ENTRY_SIZE);
+	e     = (struct CcwEncoder*)Mem_TryAlloc(1, sizeof(struct CcwEncoder));
+	if (!index || !e) { res = ERR_OUT_OF_MEMORY; goto finished; }
+
+	if ((res = stream->Seek(stream, h.indexOffset)))                     goto finished;
+	if ((res = Stream_Read(stream, index, h.chunkCount * CCW_ENTRY_SIZE))) goto finished;
+
+	/* Relocated chunks and the new metadata are written after all the existing chunks */
+	end = h.metaOffset;
+	for (i = 0, entry = index; i < h.chunkCount; i++, entry += CCW_ENTRY_SIZE)
+	{
+		end = max(end, Stream_GetU32_LE(entry) + Stream_GetU16_LE(entry + 10));
+	}
+
+	for (i = 0; i < count; i++)
+	{
+		if (chunks[i] < 0 || chunks[i] >= h.chunkCount) continue;
+		entry    = index + chunks[i] * CCW_ENTRY_SIZE;
+		volume   = Ccw_GatherChunk(&s, chunks[i], e->data);
+		data     = Ccw_EncodeChunk(e, e->data, volume, true);
+		capacity = Stream_GetU16_LE(entry + 10);
+		offset   = Stream_GetU32_LE(entry);
+
+		/* Chunk grew too much to fit in its existing space */
+		if (e->size > capacity) {
+			offset   = end;
+			capacity = Ccw_CalcCapacity(e->size);
+			end     += capacity;
+		}
+
+		Stream_SetU32_LE(entry + 0,  offset);
+		Stream_SetU32_LE(entry + 4,  e->crc);
+		Stream_SetU16_LE(entry + 8,  e->size);
+		Stream_SetU16_LE(entry + 10, capacity);
+		entry[12] = e->mode;
+
+		e->used = 0;
+		if ((res = stream->Seek(stream, offset)))                  goto finished;
+		if ((res = Ccw_Write(stream, e, data, e->size, capacity))) goto finished;
+		if ((res = Ccw_Flush(stream, e)))                          goto finished;
+	}
+
+	/* Any journal records would otherwise overwrite the chunks rewritten above */
+	h.metaOffset    = end;
+	h.journalOffset = 0;
+	if ((res = stream->Seek(stream, end)))                         goto finished;
+	if ((res = Stream_Write(stream, s.metadata, s.metadataSize)))  goto finished;
+	if ((res = stream->Seek(stream, 0)))                           goto finished;
+	if ((res = Ccw_WriteHeader(stream, &h)))                       goto finished;
+	if ((res = stream->Seek(stream, h.indexOffset)))               goto finished;
+	res = Stream_Write(stream, index, h.chunkCount * CCW_ENTRY_SIZE);
+
+finished:
+	CcwSnapshot_Free(&s);
+	Mem_Free(e);
+	Mem_Free(index);
+	return res;
+}
+
+
+/*########################################################################################################################*
+*--------------------------------------------------------Autosave---------------------------------------------------------*
+*#########################################################################################################################*/
+/* Singleplayer worlds are periodically saved to maps/autosave/[world name].ccw. Normally only the chunks changed
+   since the last autosave are appended to the file's journal, with the whole world being saved again instead
+   once the journal has grown larger than the rest of the file. Files are written on a background thread, from
+   a snapshot of the changed chunks (or of the whole world) taken on the main thread
+   
+   The whole world is written to [world name].tmp first, which then replaces the previous autosave once
+   completely written (so that crashing while writing it doesn't lose the previous autosave) */
+static cc_uint8* as_dirty; /* Whether each chunk has changed since the last autosave */
+static int as_dirtyCount;
+static cc_bool as_needsFull; /* Whether the next autosave must save the whole world */
+static int as_flags;         /* Flags of the last full autosave */
+static cc_uint32 as_baseSize, as_journalSize;
+static cc_string as_path; static char as_pathBuffer[FILENAME_SIZE];
+static int as_interval;
+
+/* Copying the whole world for a full autosave doubles memory usage, so disabled by default on such systems */
+#if defined CC_BUILD_LOWMEM || defined CC_BUILD_CONSOLE
+	#define AUTOSAVE_DEF_INTERVAL 0
+#else
+	#define AUTOSAVE_DEF_INTERVAL 120
+#endif
+
+static struct AutosaveJob {
+	struct CcwSnapshot snapshot;
+	cc_string path; char pathBuffer[FILENAME_SIZE];
+	cc_bool full;
+	cc_uint32 written;
+	cc_result res;
+} as_job;
+
+void Autosave_MarkChanged(int x, int y, int z) {
+	int index;
+	if (!as_dirty) return;
+
+	index = World_ChunkPack(x >> CHUNK_SHIFT, y >> CHUNK_SHIFT, z >> CHUNK_SHIFT);
+	if (as_dirty[index]) return;
+	as_dirty[index] = true;
+	as_dirtyCount++;
+}
+
+/* Copies the blocks in all the chunks which have changed since the last autosave */
+static cc_result Autosave_TakeChanged(struct CcwSnapshot* s) {
+	cc_uint8* data;
+	int i, j = 0;
+
+	s->chunks     = (int*)Mem_TryAlloc(as_dirtyCount, sizeof(int));
+	s->chunksData = (cc_uint8*)Mem_TryAlloc(as_dirtyCount, s->blocks2 ? CCW_MAX_CHUNK : CHUNK_SIZE_3);
+	if (!s->chunks || !s->chunksData) return ERR_OUT_OF_MEMORY;
+	data = s->chunksData;
+
+	for (i = 0; i < World.ChunksCount; i++)
+	{
+		if (!as_dirty[i]) continue;
+		s->chunks[j++] = i;
+		data += Ccw_GatherChunk(s, i, data);
+	}
+	s->numChunks = j;
+	return 0;
+}
+
+/* Copies all the blocks in the world */
+static cc_result Autosave_TakeFull(struct CcwSnapshot* s) {
+	BlockRaw* blocks  = s->blocks;
+	BlockRaw* blocks2 = s->blocks2;
+
+	s->ownsBlocks = true;
+	s->blocks     = (BlockRaw*)Mem_TryAlloc(World.Volume, 1);
+	s->blocks2    = NULL;
+	if (!s->blocks) return ERR_OUT_OF_MEMORY;
+	Mem_Copy(s->blocks, blocks, World.Volume);
+
+	if (!blocks2) return 0;
+	s->blocks2 = (BlockRaw*)Mem_TryAlloc(World.Volume, 1);
+	if (!s->blocks2) return ERR_OUT_OF_MEMORY;
+	Mem_Copy(s->blocks2, blocks2, World.Volume);
+	return 0;
+}
+
+#ifdef CC_BUILD_FILERENAME
+/* Writes the whole world to a temp file, then replaces the previous autosave with it */
+static cc_result Autosave_WriteFull(struct AutosaveJob* job) {
+	cc_string tmp; char tmpBuffer[FILENAME_SIZE];
+	cc_filepath srcPath, dstPath;
+	struct Stream stream;
+	cc_result res, closeRes;
+
+	String_InitArray(tmp, tmpBuffer);
+	String_AppendString(&tmp, &job->path);
+	tmp.length -= 4; /* Remove .ccw */
+	String_AppendConst(&tmp, ".tmp");
+
+	if ((res = Stream_CreateFile(&stream, &tmp))) return res;
+	res      = Ccw_WriteSnapshot(&stream, &job->snapshot, true, &job->written);
+	closeRes = stream.Close(&stream);
+	if (res || (res = closeRes)) return res;
+
+	Platform_EncodePath(&srcPath, &tmp);
+	Platform_EncodePath(&dstPath, &job->path);
+	return File_Rename(&srcPath, &dstPath);
+}
+#else
+static cc_result Autosave_WriteFull(struct AutosaveJob* job) {
+	struct Stream stream;
+	cc_result res, closeRes;
+
+	if ((res = Stream_CreateFile(&stream, &job->path))) return res;
+	res      = Ccw_WriteSnapshot(&stream, &job->snapshot, true, &job->written);
+	closeRes = stream.Close(&stream);
+	return res ? res : closeRes;
+}
+#endif
+
+static void Autosave_Write(void) {
+	struct AutosaveJob* job = &as_job;
+	struct Stream stream;
+	cc_result res;
+
+	if (job->full) {
+		job->res = Autosave_WriteFull(job); return;
+	}
+	if ((res = Stream_AppendFile(&stream, &job->path))) { job->res = res; return; }
+
+	res      = Ccw_AppendSnapshot(&stream, &job->snapshot, &job->written);
+	job->res = stream.Close(&stream);
+	if (res) job->res = res;
+}
+
+#ifdef CC_BUILD_COOPTHREADED
+static cc_bool Autosave_Wait(cc_bool block) { return true; }
+static void Autosave_Start(void) { Autosave_Write(); }
+#else
+static void* as_thread;
+static void* as_mutex;
+static cc_bool as_done; /* NOTE: Protected by as_mutex */
+
+static void Autosave_ThreadFunc(void) {
+	Autosave_Write();
+
+	Mutex_Lock(as_mutex);
+	as_done = true;
+	Mutex_Unlock(as_mutex);
+}
+
+/* Waits for the background thread to finish writing the autosave */
+/* Returns false when not blocking and the autosave is still being written */
+static cc_bool Autosave_Wait(cc_bool block) {
+	cc_bool done;
+	if (!as_thread) return true;
+
+	if (!block) {
+		Mutex_Lock(as_mutex);
+		done = as_done;
+		Mutex_Unlock(as_mutex);
+		if (!done) return false;
+	}
+
+	Thread_Join(as_thread);
+	as_thread = NULL;
+	return true;
+}
+
+static void Autosave_Start(void) {
+	if (!as_mutex) as_mutex = Mutex_Create("Autosave");
+	as_done = false;
+	Thread_Run(&as_thread, Autosave_ThreadFunc, 128 * 1024, "Autosave");
+}
+#endif
+
+static void Autosave_Finish(void) {
+	struct AutosaveJob* job = &as_job;
+	CcwSnapshot_Free(&job->snapshot);
+
+	if (job->res) {
+		/* Changed chunks are no longer known, so have to save everything again */
+		as_needsFull = true;
+		Logger_SysWarn2(job->res, "autosaving", &job->path);
+	} else if (job->full) {
+		as_baseSize    = job->written;
+		as_journalSize = 0;
+	} else {
+		as_journalSize += job->written;
+	}
+	job->path.length = 0;
+}
+
+static void Autosave_GetPath(cc_string* path) {
+	int i;
+	String_AppendConst(path, "maps/autosave/");
+
+	if (World.Name.length) {
+		String_AppendString(path, &World.Name);
+	} else {
+		/* Unnamed worlds (e.g. just generated ones) would otherwise all overwrite the same autosave */
+		String_AppendConst(path, "world-");
+		for (i = 0; i < 4; i++) String_AppendHex(path, World.Uuid[i]);
+	}
+	String_AppendConst(path, ".ccw");
+}
+
+static void Autosave_Tick(struct ScheduledTask* task) {
+	struct AutosaveJob* job = &as_job;
+	cc_result res;
+	if (!as_dirtyCount) return;
+
+	/* Previous autosave is still being written, so try again next time */
+	if (!Autosave_Wait(false)) return;
+	if (job->path.length) Autosave_Finish();
+
+	String_InitArray(job->path, job->pathBuffer);
+	Autosave_GetPath(&job->path);
+	if (!String_Equals(&job->path, &as_path)) as_needsFull = true;
+
+	res = CcwSnapshot_Init(&job->snapshot);
+	if (job->snapshot.header.flags != as_flags) as_needsFull = true;
+	job->full = as_needsFull || as_journalSize > as_baseSize;
+
+	if (!res) {
+		res = job->full ? Autosave_TakeFull(&job->snapshot) : Autosave_TakeChanged(&job->snapshot);
+	}
+	if (res) {
+		CcwSnapshot_Free(&job->snapshot);
+		job->path.length = 0;
+		Logger_SysWarn(res, "taking autosave snapshot"); return;
+	}
+
+	if (job->full) {
+		Utils_EnsureDirectory("maps/autosave");
+		String_Copy(&as_path, &job->path);
+		as_flags = job->snapshot.header.flags;
+	}
+	Mem_Set(as_dirty, 0, World.ChunksCount);
+	as_dirtyCount = 0;
+	as_needsFull  = false;
+
+	job->res = 0;
+	Autosave_Start();
+}
+
+static void Autosave_OnNewMap(void) {
+	Mem_Free(as_dirty);
+	as_dirty      = NULL;
+	as_dirtyCount = 0;
+}
+
+static void Autosave_OnNewMapLoaded(void) {
+	Autosave_OnNewMap();
+	if (!Server.IsSinglePlayer || !as_interval) return;
+
+	/* First autosave of a world always saves the whole world */
+	as_dirty     = (cc_uint8*)Mem_TryAllocCleared(World.ChunksCount, 1);
+	as_needsFull = true;
+}
+
+static void Autosave_Init(void) {
+	String_InitArray(as_path, as_pathBuffer);
+	if (Platform_ReadonlyFilesystem) return;
+
+	as_interval = Options_GetInt(OPT_AUTOSAVE_INTERVAL, 0, 3600, AUTOSAVE_DEF_INTERVAL);
+	if (as_interval) ScheduledTask_Add(as_interval, Autosave_Tick);
+}
+
+static void Autosave_Free(void) {
+	Autosave_Wait(true);
+	if (as_job.path.length) CcwSnapshot_Free(&as_job.snapshot);
+	Autosave_OnNewMap();
+
+#ifndef CC_BUILD_COOPTHREADED
+	if (as_mutex) Mutex_Free(as_mutex);
+	as_mutex = NULL;
+#endif
+}
+
+
 /*########################################################################################################################*
 *-------------------------------------------------------Formats component-------------------------------------------------*
 *#########################################################################################################################*/
@@ -1865,6 +2953,7 @@ static struct MapImporter lvl_imp   = { ".lvl",     Lvl_Load };
 static struct MapImporter mine_imp  = { ".mine",    Dat_Load };
 static struct MapImporter fcm_imp   = { ".fcm",     Fcm_Load };
 static struct MapImporter mclvl_imp = { ".mclevel", MCLevel_Load };
+static struct MapImporter ccw_imp   = { ".ccw",     Ccw_Load };
 
 static void OnInit(void) {
 	MapImporter_Register(&cw_imp);
@@ -1873,25 +2962,43 @@ static void OnInit(void) {
 	MapImporter_Register(&mine_imp);
 	MapImporter_Register(&fcm_imp);
 	MapImporter_Register(&mclvl_imp);
+	MapImporter_Register(&ccw_imp);
+	/* Compression tables are shared, so must be initialised before other threads can compress */
+	Deflate_Init();
+	Autosave_Init();
 }
 
 static void OnFree(void) {
 	imp_head = NULL;
+	Autosave_Free();
 }
+
+static void OnNewMap(void)       { Autosave_OnNewMap(); }
+static void OnNewMapLoaded(void) { Autosave_OnNewMapLoaded(); }
 #else
 /* No point including map format code when can't save/load maps anyways */
 struct MapImporter* MapImporter_Find(const cc_string* path) { return NULL; }
+cc_result Map_Import(const cc_string* path, struct Stream* stream, struct LocationUpdate* spawn) { return ERR_NOT_SUPPORTED; }
 cc_result Map_LoadFrom(const cc_string* path) { return ERR_NOT_SUPPORTED; }
 
 cc_result Cw_Save(struct Stream* stream)  { return ERR_NOT_SUPPORTED; }
 cc_result Dat_Save(struct Stream* stream) { return ERR_NOT_SUPPORTED; }
 cc_result Schematic_Save(struct Stream* stream) { return ERR_NOT_SUPPORTED; }
+cc_result Ccw_Save(struct Stream* stream, cc_bool compress) { return ERR_NOT_SUPPORTED; }
+cc_result Ccw_SaveChunks(struct Stream* stream, const int* chunks, int count) { return ERR_NOT_SUPPORTED; }
+void Autosave_MarkChanged(int x, int y, int z) { }
 
-static void OnInit(void) { }
+/* Screenshots still need to be compressed */
+static void OnInit(void) { Deflate_Init(); }
 static void OnFree(void) { }
+static void OnNewMap(void) { }
+static void OnNewMapLoaded(void) { }
 #endif
 
 struct IGameComponent Formats_Component = {
-	OnInit, /* Init  */
-	OnFree  /* Free  */
+	OnInit,   /* Init  */
+	OnFree,   /* Free  */
+	NULL,     /* Reset */
+	OnNewMap, /* OnNewMap */
+	OnNewMapLoaded /* OnNewMapLoaded */
 };
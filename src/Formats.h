@@ -9,6 +9,7 @@ CC_BEGIN_HEADER
 
 struct Stream; 
 struct IGameComponent;
+struct LocationUpdate;
 extern struct IGameComponent Formats_Component;
 
 /* Imports a world encoded in a particular map file format */
@@ -28,6 +29,9 @@ CC_API void MapImporter_Register(struct MapImporter* imp);
 CC_API struct MapImporter* MapImporter_Find(const cc_string* path);
 /* Attempts to import a map from the given file */
 CC_API cc_result Map_LoadFrom(const cc_string* path);
+/* Decodes the map in the given stream, using the importer found for the given path */
+/* NOTE: Unlike Map_LoadFrom, this does not reset the game or raise any world events */
+cc_result Map_Import(const cc_string* path, struct Stream* stream, struct LocationUpdate* spawn);
 
 /* Exports a world to a .cw ClassicWorld map file. */
 /* Compatible with ClassiCube/ClassicalSharp */
@@ -38,6 +42,17 @@ cc_result Schematic_Save(struct Stream* stream);
 /* Exports a world to a .dat Classic map file */
 /* Used by MineCraft Classic */
 cc_result Dat_Save(struct Stream* stream);
+/* Exports a world to a .ccw ClassiCube chunked world file */
+/* NOTE: compress being false stores chunks uncompressed, which is faster but results in much larger files */
+cc_result Ccw_Save(struct Stream* stream, cc_bool compress);
+/* Rewrites only the given chunks (and the world metadata) in an existing .ccw file */
+/* NOTE: The stream must support reading, writing and seeking */
+/* NOTE: Fails with CCW_ERR_WORLD_CHANGED if the file is for a world with different dimensions */
+cc_result Ccw_SaveChunks(struct Stream* stream, const int* chunks, int count);
+
+/* Marks the chunk containing the given block as changed, so that it is saved by the next autosave */
+/* NOTE: Does nothing unless autosaving is enabled and the game is in singleplayer */
+void Autosave_MarkChanged(int x, int y, int z);
 
 CC_END_HEADER
 #endif
@@ -196,9 +196,77 @@ void Game_Reset(void) {
 	}
 }
 
+#ifdef CC_BUILD_LOWMEM
+	#define BLOCK_BATCH_SIZE 256
+#else
+	#define BLOCK_BATCH_SIZE 4096
+#endif
+static int batch_depth, batch_count;
+static IVec3 batch_coords[BLOCK_BATCH_SIZE];
+static BlockID batch_old[BLOCK_BATCH_SIZE];
+static BlockID batch_new[BLOCK_BATCH_SIZE];
+
+static void FlushBlockBatch(void) {
+	int cx, cy, cz, lastCx = -1, lastCy = -1, lastCz = -1;
+	cc_bool solid, lastSolid = false;
+	IVec3* p;
+	int i;
+
+	if (Weather_Heightmap) {
+		for (i = 0, p = batch_coords; i < batch_count; i++, p++) 
+		{
+			EnvRenderer_OnBlockChanged(p->x, p->y, p->z, batch_old[i], batch_new[i]);
+		}
+	}
+
+	/* Classic lighting only needs to recalculate each column once */
+	if (Lighting.OnBlockChanged == ClassicLighting_OnBlockChanged) {
+		ClassicLighting_OnBlocksChanged(batch_coords, batch_old, batch_new, batch_count);
+	} else {
+		for (i = 0, p = batch_coords; i < batch_count; i++, p++) 
+		{
+			Lighting.OnBlockChanged(p->x, p->y, p->z, batch_old[i], batch_new[i]);
+		}
+	}
+
+	for (i = 0, p = batch_coords; i < batch_count; i++, p++) 
+	{
+		cx = p->x >> CHUNK_SHIFT; cy = p->y >> CHUNK_SHIFT; cz = p->z >> CHUNK_SHIFT;
+		solid = Blocks.Draw[batch_new[i]] != DRAW_GAS;
+
+		/* Consecutive changes are usually in the same chunk, which only needs to be refreshed once */
+		/*  (unless the chunk was all air, and the block now makes it not all air) */
+		if (cx == lastCx && cy == lastCy && cz == lastCz && (lastSolid || !solid)) continue;
+		lastCx = cx; lastCy = cy; lastCz = cz; lastSolid = solid;
+
+		MapRenderer_OnBlockChanged(p->x, p->y, p->z, batch_new[i]);
+	}
+	batch_count = 0;
+}
+
+void Game_BeginBlockBatch(void) { batch_depth++; }
+
+void Game_CommitBlockBatch(void) {
+	if (!batch_depth || --batch_depth) return;
+	FlushBlockBatch();
+}
+
 void Game_UpdateBlock(int x, int y, int z, BlockID block) {
 	BlockID old = World_GetBlock(x, y, z);
 	World_SetBlock(x, y, z, block);
+	Autosave_MarkChanged(x, y, z);
+
+	if (batch_depth) {
+		if (batch_count == BLOCK_BATCH_SIZE) FlushBlockBatch();
+
+		batch_coords[batch_count].x = x;
+		batch_coords[batch_count].y = y;
+		batch_coords[batch_count].z = z;
+		batch_old[batch_count] = old;
+		batch_new[batch_count] = block;
+		batch_count++;
+		return;
+	}
 
 	if (Weather_Heightmap) {
 		EnvRenderer_OnBlockChanged(x, y, z, old, block);
@@ -222,23 +290,28 @@ cc_bool Game_CanPick(BlockID block) {
 cc_bool Game_UpdateTexture(GfxResourceID* texId, struct Stream* src, const cc_string* file,
 							cc_uint8* skinType, int* heightDivisor) {
 	struct Bitmap bmp;
+	cc_result res = Png_Decode(&bmp, src);
+	if (!res) return Game_UpdateTextureBitmap(texId, &bmp, file, skinType, heightDivisor);
+
+	Logger_SysWarn2(res, "decoding", file);
+	Mem_Free(bmp.scan0);
+	return false;
+}
+
+cc_bool Game_UpdateTextureBitmap(GfxResourceID* texId, struct Bitmap* bmp, const cc_string* file,
+								cc_uint8* skinType, int* heightDivisor) {
 	cc_bool success;
-	cc_result res;
-	
-	res = Png_Decode(&bmp, src);
-	if (res) { Logger_SysWarn2(res, "decoding", file); }
-	
 	/* E.g. gui.png only need top half of the texture loaded */
-	if (heightDivisor && bmp.height >= *heightDivisor)
-		bmp.height /= *heightDivisor;
+	if (heightDivisor && bmp->height >= *heightDivisor)
+		bmp->height /= *heightDivisor;
 
-	success = !res && Game_ValidateBitmap(file, &bmp);
+	success = Game_ValidateBitmap(file, bmp);
 	if (success) {
-		if (skinType) { *skinType = Utils_CalcSkinType(&bmp); }
-		Gfx_RecreateTexture(texId, &bmp, TEXTURE_FLAG_MANAGED, false);
+		if (skinType) { *skinType = Utils_CalcSkinType(bmp); }
+		Gfx_RecreateTexture(texId, bmp, TEXTURE_FLAG_MANAGED, false);
 	}
 
-	Mem_Free(bmp.scan0);
+	Mem_Free(bmp->scan0);
 	return success;
 }
 
@@ -296,6 +369,9 @@ static void Game_OnResize(void* obj) {
 
 static void HandleOnNewMap(void* obj) {
 	struct IGameComponent* comp;
+	/* Any block changes still in a batch were for the old map */
+	batch_count = 0;
+
 	for (comp = comps_head; comp; comp = comp->next) {
 		if (comp->OnNewMap) comp->OnNewMap();
 	}
@@ -354,6 +430,7 @@ static void LoadOptions(void) {
 
 	Game_ViewDistance     = Options_GetInt(OPT_VIEW_DISTANCE, 8, 4096, DEFAULT_VIEWDIST);
 	Game_UserViewDistance = Game_ViewDistance;
+	WorkerPool_Init(Options_GetInt(OPT_WORKER_THREADS, 0, WORKERPOOL_MAX_THREADS, DEFAULT_WORKER_THREADS));
 	/* TODO: Do we need to support option to skip SSL */
 	/*cc_bool skipSsl = Options_GetBool("skip-ssl-check", false);
 	if (skipSsl) {
@@ -469,6 +546,8 @@ static void Game_Load(void) {
 	}
 
 	TexturePack_ExtractCurrent(true);
+	/* Nothing to show yet anyways, so just wait for the textures */
+	TexturePack_ApplyExtracted(true);
 	if (TexturePack_DefaultMissing) {
 		Window_ShowDialog("Missing file",
 			"Both default.zip and classicube.zip are missing,\n try downloading resources first.\n\nClassiCube will still run, but without any textures.");
@@ -845,6 +924,7 @@ static void Game_Free(void) {
 
 	gameRunning     = false;
 	Logger_WarnFunc = Logger_DialogWarn;
+	WorkerPool_Free();
 	Gfx_Free();
 	Options_SaveIfChanged();
 	Window_DisableRawMouse();
@@ -46,6 +46,12 @@ extern cc_string Game_Mppass;
 #endif
 #define DEFAULT_MAX_VIEWDIST 32768
 
+#if defined CC_BUILD_CONSOLE || defined CC_BUILD_LOWMEM
+    #define DEFAULT_WORKER_THREADS 0
+#else
+    #define DEFAULT_WORKER_THREADS 3
+#endif
+
 extern int Game_ViewDistance;
 extern int Game_MaxViewDistance;
 extern int Game_UserViewDistance;
@@ -107,6 +113,14 @@ CC_API void Game_UpdateBlock(int x, int y, int z, BlockID block);
 /* In multiplayer this is sent to the server, in singleplayer just activates physics. */
 CC_API void Game_ChangeBlock(int x, int y, int z, BlockID block);
 
+/* Begins a batch of block changes. Until the batch is committed, Game_UpdateBlock only */
+/*  changes the block in the map, and updating the associated state is deferred until then */
+/*  (so e.g. lighting for each column is only recalculated once for the whole batch) */
+/* NOTE: Batches can be nested, changes are only committed by the outermost Game_CommitBlockBatch */
+CC_API void Game_BeginBlockBatch(void);
+/* Updates state associated with all the blocks changed since Game_BeginBlockBatch */
+CC_API void Game_CommitBlockBatch(void);
+
 cc_bool Game_CanPick(BlockID block);
 /* Updates Game_Width and Game_Height. */
 void Game_UpdateDimensions(void);
@@ -117,6 +131,10 @@ void Game_SetMinFrameTime(float frameTimeMS);
 
 cc_bool Game_UpdateTexture(GfxResourceID* texId, struct Stream* src, const cc_string* file, 
 							cc_uint8* skinType, int* heightDivisor);
+/* Same as Game_UpdateTexture, but with an already decoded bitmap. */
+/* NOTE: Always frees the bitmap's pixels */
+cc_bool Game_UpdateTextureBitmap(GfxResourceID* texId, struct Bitmap* bmp, const cc_string* file,
+							cc_uint8* skinType, int* heightDivisor);
 /* Checks that the given bitmap can be loaded into a native gfx texture. */
 /* (must be power of two size and be <= Gfx_MaxTexWidth/Gfx_MaxHeight) */
 cc_bool Game_ValidateBitmap(const cc_string* file, struct Bitmap* bmp);
@@ -8,6 +8,13 @@
 #include "Game.h"
 #include "Window.h"
 
+#if (defined __x86_64__ || defined _M_X64) && !defined GEN_DISABLE_SIMD
+	/* Only enabled on x86_64, as scalar float math there is also done using SSE */
+	/*  (which means the SIMD and scalar paths produce bit-identical noise) */
+	#define GEN_NOISE_SIMD
+	#include <emmintrin.h>
+#endif
+
 const struct MapGenerator* Gen_Active;
 BlockRaw* Gen_Blocks;
 int Gen_Seed;
@@ -196,6 +203,91 @@ static float ImprovedNoise_Calc(const cc_uint8* p, float x, float y) {
 }
 
 
+/* Calculates noise for multiple samples at once, adding noise(x * freq, y * freq) * amplitude to each */
+/* NOTE: Produces exactly the same results as calling ImprovedNoise_Calc for each sample */
+static void ImprovedNoise_AddN(const cc_uint8* p, const float* xs, const float* ys, float freq, float amplitude, float* dst, int count);
+
+#ifdef GEN_NOISE_SIMD
+/* Same as ImprovedNoise_Calc, but calculates 4 samples at once. Table lookups are still done */
+/*  per sample, but all the floating point math is done using SSE with the same order of operations */
+static __m128 ImprovedNoise_Calc4(const cc_uint8* p, __m128 x, __m128 y) {
+	int xFloors[4], yFloors[4];
+	float gx[4][4], gy[4][4];
+	__m128i xFloor, yFloor;
+	__m128 u, v, x1, y1, one = _mm_set1_ps(1.0f);
+	__m128 g22, g12, g21, g11, c1, c2;
+	int i, X, Y, A, B, hash;
+
+	/* (int)x truncates towards zero, so subtract 1 for negative values */
+	xFloor = _mm_add_epi32(_mm_cvttps_epi32(x), _mm_castps_si128(_mm_cmplt_ps(x, _mm_setzero_ps())));
+	yFloor = _mm_add_epi32(_mm_cvttps_epi32(y), _mm_castps_si128(_mm_cmplt_ps(y, _mm_setzero_ps())));
+	_mm_storeu_si128((__m128i*)xFloors, xFloor);
+	_mm_storeu_si128((__m128i*)yFloors, yFloor);
+	x = _mm_sub_ps(x, _mm_cvtepi32_ps(xFloor));
+	y = _mm_sub_ps(y, _mm_cvtepi32_ps(yFloor));
+
+	/* Fade(x) and Fade(y) */
+	u = _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(x, x), x), _mm_add_ps(_mm_mul_ps(x, 
+			_mm_sub_ps(_mm_mul_ps(x, _mm_set1_ps(6.0f)), _mm_set1_ps(15.0f))), _mm_set1_ps(10.0f)));
+	v = _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(y, y), y), _mm_add_ps(_mm_mul_ps(y, 
+			_mm_sub_ps(_mm_mul_ps(y, _mm_set1_ps(6.0f)), _mm_set1_ps(15.0f))), _mm_set1_ps(10.0f)));
+
+	for (i = 0; i < 4; i++) 
+	{
+		X = xFloors[i] & 0xFF; Y = yFloors[i] & 0xFF;
+		A = p[X] + Y; B = p[X + 1] + Y;
+
+		hash = (p[p[A]]     & 0xF) << 1;
+		gx[0][i] = (float)(((X_FLAGS >> hash) & 3) - 1); gy[0][i] = (float)(((Y_FLAGS >> hash) & 3) - 1);
+		hash = (p[p[B]]     & 0xF) << 1;
+		gx[1][i] = (float)(((X_FLAGS >> hash) & 3) - 1); gy[1][i] = (float)(((Y_FLAGS >> hash) & 3) - 1);
+		hash = (p[p[A + 1]] & 0xF) << 1;
+		gx[2][i] = (float)(((X_FLAGS >> hash) & 3) - 1); gy[2][i] = (float)(((Y_FLAGS >> hash) & 3) - 1);
+		hash = (p[p[B + 1]] & 0xF) << 1;
+		gx[3][i] = (float)(((X_FLAGS >> hash) & 3) - 1); gy[3][i] = (float)(((Y_FLAGS >> hash) & 3) - 1);
+	}
+
+	x1  = _mm_sub_ps(x, one);
+	y1  = _mm_sub_ps(y, one);
+	g22 = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(gx[0]), x),  _mm_mul_ps(_mm_loadu_ps(gy[0]), y));
+	g12 = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(gx[1]), x1), _mm_mul_ps(_mm_loadu_ps(gy[1]), y));
+	g21 = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(gx[2]), x),  _mm_mul_ps(_mm_loadu_ps(gy[2]), y1));
+	g11 = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(gx[3]), x1), _mm_mul_ps(_mm_loadu_ps(gy[3]), y1));
+
+	c1 = _mm_add_ps(g22, _mm_mul_ps(u, _mm_sub_ps(g12, g22)));
+	c2 = _mm_add_ps(g21, _mm_mul_ps(u, _mm_sub_ps(g11, g21)));
+	return _mm_add_ps(c1, _mm_mul_ps(v, _mm_sub_ps(c2, c1)));
+}
+
+static void ImprovedNoise_AddN(const cc_uint8* p, const float* xs, const float* ys, float freq, float amplitude, float* dst, int count) {
+	__m128 vFreq = _mm_set1_ps(freq), vAmp = _mm_set1_ps(amplitude);
+	__m128 x, y, noise;
+	int i;
+
+	for (i = 0; i + 4 <= count; i += 4) 
+	{
+		x     = _mm_mul_ps(_mm_loadu_ps(xs + i), vFreq);
+		y     = _mm_mul_ps(_mm_loadu_ps(ys + i), vFreq);
+		noise = ImprovedNoise_Calc4(p, x, y);
+		_mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_mul_ps(noise, vAmp)));
+	}
+
+	for (; i < count; i++) 
+	{
+		dst[i] += ImprovedNoise_Calc(p, xs[i] * freq, ys[i] * freq) * amplitude;
+	}
+}
+#else
+static void ImprovedNoise_AddN(const cc_uint8* p, const float* xs, const float* ys, float freq, float amplitude, float* dst, int count) {
+	int i;
+	for (i = 0; i < count; i++) 
+	{
+		dst[i] += ImprovedNoise_Calc(p, xs[i] * freq, ys[i] * freq) * amplitude;
+	}
+}
+#endif
+
+
 struct OctaveNoise { cc_uint8 p[8][NOISE_TABLE_SIZE]; int octaves; };
 static void OctaveNoise_Init(struct OctaveNoise* n, RNGState* rnd, int octaves) {
 	int i;
@@ -219,6 +311,23 @@ static float OctaveNoise_Calc(const struct OctaveNoise* n, float x, float y) {
 	return sum;
 }
 
+/* Maximum number of samples that can be calculated at once by the _CalcN functions */
+#define NOISE_MAX_SAMPLES 64
+
+/* Calculates OctaveNoise_Calc(xs[i], ys[i]) for each of the given samples */
+static void OctaveNoise_CalcN(const struct OctaveNoise* n, const float* xs, const float* ys, float* dst, int count) {
+	float amplitude = 1, freq = 1;
+	int i;
+
+	for (i = 0; i < count; i++) dst[i] = 0;
+
+	for (i = 0; i < n->octaves; i++) {
+		ImprovedNoise_AddN(n->p[i], xs, ys, freq, amplitude, dst, count);
+		amplitude *= 2.0f;
+		freq *= 0.5f;
+	}
+}
+
 
 struct CombinedNoise { struct OctaveNoise noise1, noise2; };
 static void CombinedNoise_Init(struct CombinedNoise* n, RNGState* rnd, int octaves1, int octaves2) {
@@ -226,11 +335,42 @@ static void CombinedNoise_Init(struct CombinedNoise* n, RNGState* rnd, int octav
 	OctaveNoise_Init(&n->noise2, rnd, octaves2);
 }
 
-static float CombinedNoise_Calc(const struct CombinedNoise* n, float x, float y) {
-	float offset = OctaveNoise_Calc(&n->noise2, x, y);
-	return OctaveNoise_Calc(&n->noise1, x + offset, y);
+/* Calculates noise1(xs[i] + noise2(xs[i], ys[i]), ys[i]) for each of the given samples */
+static void CombinedNoise_CalcN(const struct CombinedNoise* n, const float* xs, const float* ys, float* dst, int count) {
+	float offsetXs[NOISE_MAX_SAMPLES];
+	int i;
+
+	OctaveNoise_CalcN(&n->noise2, xs, ys, offsetXs, count);
+	for (i = 0; i < count; i++) offsetXs[i] += xs[i];
+	OctaveNoise_CalcN(&n->noise1, offsetXs, ys, dst, count);
 }
 
+#ifdef CC_BUILD_BENCHMARK
+void Gen_CalcNoise(int seed, const float* xs, const float* ys, float* dst, int count, cc_bool batched) {
+	static struct CombinedNoise n;
+	RNGState rnd;
+	float offset;
+	int i;
+
+	Random_Seed(&rnd, seed);
+	CombinedNoise_Init(&n, &rnd, 8, 8);
+
+	if (batched) {
+		for (i = 0; i < count; i += NOISE_MAX_SAMPLES)
+		{
+			CombinedNoise_CalcN(&n, xs + i, ys + i, dst + i, min(count - i, NOISE_MAX_SAMPLES));
+		}
+		return;
+	}
+
+	for (i = 0; i < count; i++)
+	{
+		offset = OctaveNoise_Calc(&n.noise2, xs[i], ys[i]);
+		dst[i] = OctaveNoise_Calc(&n.noise1, xs[i] + offset, ys[i]);
+	}
+}
+#endif
+
 
 /*########################################################################################################################*
 *----------------------------------------------------Notchy map gen-------------------------------------------------------*
@@ -301,40 +441,90 @@ static void NotchyGen_FloodFill(int index, BlockRaw block) {
 }
 
 
-static void NotchyGen_CreateHeightmap(void) {
-	float hLow, hHigh, height;
-	int hIndex = 0, adjHeight;
-	int x, z;
-	struct CombinedNoise n1, n2;
-	struct OctaveNoise n3;
+/* Stages that only depend on noise (not on the RNG) are independent for each X/Z column, */
+/*  so rows of the map along the Z axis are divided between the worker threads */
+#define GEN_ROWS_PER_JOB 16
 
-	CombinedNoise_Init(&n1, &rnd, 8, 8);
-	CombinedNoise_Init(&n2, &rnd, 8, 8);	
-	OctaveNoise_Init(&n3, &rnd, 6);
+static int NotchyGen_RowJobs(void) {
+	return (World.Length + (GEN_ROWS_PER_JOB - 1)) / GEN_ROWS_PER_JOB;
+}
 
-	Gen_CurrentState = "Building heightmap";
-	for (z = 0; z < World.Length; z++) {
-		Gen_CurrentProgress = (float)z / World.Length;
+#define NotchyGen_JobRows(job, zBeg, zEnd) \
+	zBeg = job * GEN_ROWS_PER_JOB; \
+	zEnd = min(zBeg + GEN_ROWS_PER_JOB, World.Length); \
+	Gen_CurrentProgress = (float)zBeg / World.Length;
 
-		for (x = 0; x < World.Width; x++) {
-			hLow   = CombinedNoise_Calc(&n1, x * 1.3f, z * 1.3f) / 6 - 4;
-			height = hLow;
+struct HeightmapNoise { struct CombinedNoise n1, n2; struct OctaveNoise n3; };
 
-			if (OctaveNoise_Calc(&n3, (float)x, (float)z) <= 0) {
-				hHigh = CombinedNoise_Calc(&n2, x * 1.3f, z * 1.3f) / 5 + 6;
-				height = max(hLow, hHigh);
+static void NotchyGen_HeightmapJob(void* obj, int job) {
+	struct HeightmapNoise* n = (struct HeightmapNoise*)obj;
+	float xs[NOISE_MAX_SAMPLES],    zs[NOISE_MAX_SAMPLES];
+	float lowXs[NOISE_MAX_SAMPLES], lowZs[NOISE_MAX_SAMPLES];
+	float highXs[NOISE_MAX_SAMPLES], highZs[NOISE_MAX_SAMPLES];
+	float lows[NOISE_MAX_SAMPLES], highs[NOISE_MAX_SAMPLES], selects[NOISE_MAX_SAMPLES];
+	float hLow, hHigh, height;
+	int i, count, numHigh;
+	int x, z, zBeg, zEnd, hIndex;
+	NotchyGen_JobRows(job, zBeg, zEnd);
+
+	for (z = zBeg; z < zEnd; z++) {
+		hIndex = z * World.Width;
+
+		for (x = 0; x < World.Width; x += count) {
+			count = min(World.Width - x, NOISE_MAX_SAMPLES);
+
+			for (i = 0; i < count; i++) 
+			{
+				xs[i]    = (float)(x + i); zs[i]    = (float)z;
+				lowXs[i] = (x + i) * 1.3f; lowZs[i] = z * 1.3f;
 			}
+			CombinedNoise_CalcN(&n->n1, lowXs, lowZs, lows, count);
+			OctaveNoise_CalcN(&n->n3, xs, zs, selects, count);
+
+			/* Only calculate high noise for the samples that actually use it */
+			for (i = 0, numHigh = 0; i < count; i++) 
+			{
+				if (selects[i] > 0) continue;
+				highXs[numHigh] = lowXs[i]; highZs[numHigh] = lowZs[i]; numHigh++;
+			}
+			CombinedNoise_CalcN(&n->n2, highXs, highZs, highs, numHigh);
+
+			for (i = 0, numHigh = 0; i < count; i++) 
+			{
+				hLow   = lows[i] / 6 - 4;
+				height = hLow;
 
-			height *= 0.5f;
-			if (height < 0) height *= 0.8f;
+				if (selects[i] <= 0) {
+					hHigh = highs[numHigh++] / 5 + 6;
+					height = max(hLow, hHigh);
+				}
 
-			adjHeight = (int)(height + waterLevel);
-			minHeight = min(adjHeight, minHeight);
-			heightmap[hIndex++] = adjHeight;
+				height *= 0.5f;
+				if (height < 0) height *= 0.8f;
+
+				heightmap[hIndex++] = (int)(height + waterLevel);
+			}
 		}
 	}
 }
 
+static void NotchyGen_CreateHeightmap(void) {
+	struct HeightmapNoise n;
+	int i;
+
+	CombinedNoise_Init(&n.n1, &rnd, 8, 8);
+	CombinedNoise_Init(&n.n2, &rnd, 8, 8);	
+	OctaveNoise_Init(&n.n3, &rnd, 6);
+
+	Gen_CurrentState = "Building heightmap";
+	WorkerPool_Run(NotchyGen_HeightmapJob, &n, NotchyGen_RowJobs());
+
+	for (i = 0; i < World.Width * World.Length; i++) 
+	{
+		minHeight = min(heightmap[i], minHeight);
+	}
+}
+
 static int NotchyGen_CreateStrataFast(void) {
 	cc_uint32 oneY = (cc_uint32)World.OneY;
 	int stoneHeight, airHeight;
@@ -364,43 +554,62 @@ static int NotchyGen_CreateStrataFast(void) {
 	return max(stoneHeight, 1);
 }
 
-static void NotchyGen_CreateStrata(void) {
-	int dirtThickness, dirtHeight;
-	int minStoneY, stoneHeight;
-	int hIndex = 0, maxY = World.MaxY, index = 0;
-	int x, y, z;
-	struct OctaveNoise n;
+static int strata_minStoneY;
+static void NotchyGen_StrataJob(void* obj, int job) {
+	struct OctaveNoise* n = (struct OctaveNoise*)obj;
+	float xs[NOISE_MAX_SAMPLES], zs[NOISE_MAX_SAMPLES], noise[NOISE_MAX_SAMPLES];
+	int dirtThickness, dirtHeight, stoneHeight;
+	int minStoneY = strata_minStoneY, maxY = World.MaxY;
+	int i, count, x, y, z, zBeg, zEnd, hIndex, index;
+	NotchyGen_JobRows(job, zBeg, zEnd);
 
-	/* Try to bulk fill bottom of the map if possible */
-	minStoneY = NotchyGen_CreateStrataFast();
-	OctaveNoise_Init(&n, &rnd, 8);
+	for (z = zBeg; z < zEnd; z++) {
+		hIndex = z * World.Width;
 
-	Gen_CurrentState = "Creating strata";
-	for (z = 0; z < World.Length; z++) {
-		Gen_CurrentProgress = (float)z / World.Length;
+		for (x = 0; x < World.Width; x += count) {
+			count = min(World.Width - x, NOISE_MAX_SAMPLES);
 
-		for (x = 0; x < World.Width; x++) {
-			dirtThickness = (int)(OctaveNoise_Calc(&n, (float)x, (float)z) / 24 - 4);
-			dirtHeight    = heightmap[hIndex++];
-			stoneHeight   = dirtHeight + dirtThickness;
+			for (i = 0; i < count; i++) 
+			{
+				xs[i] = (float)(x + i); zs[i] = (float)z;
+			}
+			OctaveNoise_CalcN(n, xs, zs, noise, count);
 
-			stoneHeight = min(stoneHeight, maxY);
-			dirtHeight  = min(dirtHeight,  maxY);
+			for (i = 0; i < count; i++) 
+			{
+				dirtThickness = (int)(noise[i] / 24 - 4);
+				dirtHeight    = heightmap[hIndex++];
+				stoneHeight   = dirtHeight + dirtThickness;
 
-			index = World_Pack(x, minStoneY, z);
-			for (y = minStoneY; y <= stoneHeight; y++) {
-				Gen_Blocks[index] = BLOCK_STONE; index += World.OneY;
-			}
+				stoneHeight = min(stoneHeight, maxY);
+				dirtHeight  = min(dirtHeight,  maxY);
 
-			stoneHeight = max(stoneHeight, 0);
-			index = World_Pack(x, (stoneHeight + 1), z);
-			for (y = stoneHeight + 1; y <= dirtHeight; y++) {
-				Gen_Blocks[index] = BLOCK_DIRT; index += World.OneY;
+				index = World_Pack(x + i, minStoneY, z);
+				for (y = minStoneY; y <= stoneHeight; y++) {
+					Gen_Blocks[index] = BLOCK_STONE; index += World.OneY;
+				}
+
+				stoneHeight = max(stoneHeight, 0);
+				index = World_Pack(x + i, (stoneHeight + 1), z);
+				for (y = stoneHeight + 1; y <= dirtHeight; y++) {
+					Gen_Blocks[index] = BLOCK_DIRT; index += World.OneY;
+				}
 			}
 		}
 	}
 }
 
+static void NotchyGen_CreateStrata(void) {
+	struct OctaveNoise n;
+
+	/* Try to bulk fill bottom of the map if possible */
+	strata_minStoneY = NotchyGen_CreateStrataFast();
+	OctaveNoise_Init(&n, &rnd, 8);
+
+	Gen_CurrentState = "Creating strata";
+	WorkerPool_Run(NotchyGen_StrataJob, &n, NotchyGen_RowJobs());
+}
+
 static void NotchyGen_CarveCaves(void) {
 	int cavesCount, caveLen;
 	float caveX, caveY, caveZ;
@@ -541,18 +750,16 @@ static void NotchyGen_FloodFillLava(void) {
 	}
 }
 
-static void NotchyGen_CreateSurfaceLayer(void) {	
-	int hIndex = 0, index;
-	BlockRaw above;
-	int x, y, z;
-	struct OctaveNoise n1, n2;
+struct SurfaceNoise { struct OctaveNoise n1, n2; };
 
-	OctaveNoise_Init(&n1, &rnd, 8);
-	OctaveNoise_Init(&n2, &rnd, 8);
+static void NotchyGen_SurfaceJob(void* obj, int job) {
+	struct SurfaceNoise* n = (struct SurfaceNoise*)obj;
+	int x, y, z, zBeg, zEnd, hIndex, index;
+	BlockRaw above;
+	NotchyGen_JobRows(job, zBeg, zEnd);
 
-	Gen_CurrentState = "Creating surface";
-	for (z = 0; z < World.Length; z++) {
-		Gen_CurrentProgress = (float)z / World.Length;
+	for (z = zBeg; z < zEnd; z++) {
+		hIndex = z * World.Width;
 
 		for (x = 0; x < World.Width; x++) {
 			y = heightmap[hIndex++];
@@ -562,15 +769,25 @@ static void NotchyGen_CreateSurfaceLayer(void) {
 			above = y >= World.MaxY ? BLOCK_AIR : Gen_Blocks[index + World.OneY];
 
 			/* TODO: update heightmap */
-			if (above == BLOCK_STILL_WATER && (OctaveNoise_Calc(&n2, (float)x, (float)z) > 12)) {
+			if (above == BLOCK_STILL_WATER && (OctaveNoise_Calc(&n->n2, (float)x, (float)z) > 12)) {
 				Gen_Blocks[index] = BLOCK_GRAVEL;
 			} else if (above == BLOCK_AIR) {
-				Gen_Blocks[index] = (y <= waterLevel && (OctaveNoise_Calc(&n1, (float)x, (float)z) > 8)) ? BLOCK_SAND : BLOCK_GRASS;
+				Gen_Blocks[index] = (y <= waterLevel && (OctaveNoise_Calc(&n->n1, (float)x, (float)z) > 8)) ? BLOCK_SAND : BLOCK_GRASS;
 			}
 		}
 	}
 }
 
+static void NotchyGen_CreateSurfaceLayer(void) {
+	struct SurfaceNoise n;
+
+	OctaveNoise_Init(&n.n1, &rnd, 8);
+	OctaveNoise_Init(&n.n2, &rnd, 8);
+
+	Gen_CurrentState = "Creating surface";
+	WorkerPool_Run(NotchyGen_SurfaceJob, &n, NotchyGen_RowJobs());
+}
+
 static void NotchyGen_PlantFlowers(void) {
 	int numPatches;
 	BlockRaw block;
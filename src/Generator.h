@@ -32,6 +32,13 @@ extern const struct MapGenerator* Gen_Active;
 extern const struct MapGenerator FlatgrassGen;
 extern const struct MapGenerator NotchyGen;
 
+#ifdef CC_BUILD_BENCHMARK
+/* Calculates the combined noise used by the heightmap stage of NotchyGen for each of the given samples */
+/*  either one sample at a time using the scalar code, or in batches using the SIMD code */
+/*  (so the benchmark can check both produce exactly the same output) */
+void Gen_CalcNoise(int seed, const float* xs, const float* ys, float* dst, int count, cc_bool batched);
+#endif
+
 
 extern BlockRaw* Tree_Blocks;
 extern RNGState* Tree_Rnd;
@@ -3,6 +3,14 @@
 #include "_GraphicsBase.h"
 #include "Errors.h"
 #include "Window.h"
+#include "Utils.h"
+
+#if (defined __x86_64__ || defined _M_X64) && !defined SOFTGPU_DISABLE_SIMD
+	// Only enabled on x86_64, as scalar float math there is also done using SSE
+	//  (which means the SIMD and scalar paths produce bit-identical output)
+	#define SOFTGPU_SIMD
+	#include <emmintrin.h>
+#endif
 
 static cc_bool faceCulling;
 static int fb_width, fb_height; 
@@ -59,9 +67,11 @@ static void DestroyBuffers(void) {
 	depthBuffer = NULL;
 }
 
+static void FreeBins(void);
 void Gfx_Free(void) { 
 	Gfx_FreeState();
 	DestroyBuffers();
+	FreeBins();
 }
 
 
@@ -475,7 +485,134 @@ static void DrawTriangle2D(Vertex* V0, Vertex* V1, Vertex* V2) {
 	}
 }
 
-static void DrawTriangle3D(Vertex* V0, Vertex* V1, Vertex* V2) {
+/* Attributes of a triangle that are interpolated across its pixels */
+typedef struct TriangleAttribs_ {
+	float w0, w1, w2;
+	float z0, z1, z2;
+	float u0, u1, u2;
+	float v0, v1, v2;
+	PackedCol color;
+} TriangleAttribs;
+
+// NOTE: W in ic0/ic1/ic2 weighted values below is actually 1/W 
+static CC_INLINE void DrawPixel3D(const TriangleAttribs* t, int x, int y, float ic0, float ic1, float ic2, float w, float z) {
+	int db_index = y * db_stride + x;
+#ifndef SOFTGPU_DISABLE_ZBUFFER
+	if (depthTest && (z < 0 || z > depthBuffer[db_index])) return;
+	if (!colWrite) {
+		if (depthWrite) depthBuffer[db_index] = z;
+		return;
+	}
+#else
+	if (!colWrite) return;
+#endif
+
+	int R, G, B, A;
+	PackedCol color = t->color;
+	if (gfx_format == VERTEX_FORMAT_TEXTURED) {
+		float u = (ic0 * t->u0 + ic1 * t->u1 + ic2 * t->u2) * w;
+		float v = (ic0 * t->v0 + ic1 * t->v1 + ic2 * t->v2) * w;
+		int texX = ((int)(Math_AbsF(u - FastFloor(u)) * curTexWidth )) & texWidthMask;
+		int texY = ((int)(Math_AbsF(v - FastFloor(v)) * curTexHeight)) & texHeightMask;
+		int texIndex = texY * curTexWidth + texX;
+
+		BitmapCol tColor = curTexPixels[texIndex];
+		int a1 = PackedCol_A(color), a2 = BitmapCol_A(tColor);
+		A = ( a1 * a2 ) >> 8;
+		int r1 = PackedCol_R(color), r2 = BitmapCol_R(tColor);
+		R = ( r1 * r2 ) >> 8;
+		int g1 = PackedCol_G(color), g2 = BitmapCol_G(tColor);
+		G = ( g1 * g2 ) >> 8;
+		int b1 = PackedCol_B(color), b2 = BitmapCol_B(tColor);
+		B = ( b1 * b2 ) >> 8;
+	} else {
+		R = PackedCol_R(color);
+		G = PackedCol_G(color);
+		B = PackedCol_B(color);
+		A = PackedCol_A(color);
+	}
+
+	if (gfx_alphaTest && A < 0x80) return;
+	int cb_index = y * cb_stride + x;
+	
+	if (gfx_alphaBlend) {
+		BitmapCol dst = colorBuffer[cb_index];
+		int dstR = BitmapCol_R(dst);
+		int dstG = BitmapCol_G(dst);
+		int dstB = BitmapCol_B(dst);
+
+		R = (R * A + dstR * (255 - A)) >> 8;
+		G = (G * A + dstG * (255 - A)) >> 8;
+		B = (B * A + dstB * (255 - A)) >> 8;
+	}
+
+#ifndef SOFTGPU_DISABLE_ZBUFFER
+	if (depthWrite) depthBuffer[db_index] = z;
+#endif
+	colorBuffer[cb_index] = BitmapCol_Make(R, G, B, 0xFF);
+}
+
+#ifdef SOFTGPU_SIMD
+// Returns the edge function values for 4 consecutive pixels
+// NOTE: Steps one pixel at a time, so values are bit-identical to the scalar path
+static CC_INLINE __m128 StepEdge4(float* bc, float step) {
+	float a = *bc;
+	float b = a + step;
+	float c = b + step;
+	float d = c + step;
+	*bc = d + step;
+	return _mm_setr_ps(a, b, c, d);
+}
+
+// Draws 4 pixels at once, returning the X coordinate the scalar path should continue from
+static int DrawRow3D_SIMD(const TriangleAttribs* t, int x, int maxX, int y, float factor, 
+						float* bc0, float* bc1, float* bc2, int dx12, int dx20, int dx01) {
+	__m128 vFactor = _mm_set1_ps(factor);
+	__m128 zero    = _mm_setzero_ps();
+	__m128 one     = _mm_set1_ps(1.0f);
+	__m128 w0 = _mm_set1_ps(t->w0), w1 = _mm_set1_ps(t->w1), w2 = _mm_set1_ps(t->w2);
+	__m128 z0 = _mm_set1_ps(t->z0), z1 = _mm_set1_ps(t->z1), z2 = _mm_set1_ps(t->z2);
+	float IC0[4], IC1[4], IC2[4], W[4], Z[4];
+
+	for (; x + 3 <= maxX; x += 4)
+	{
+		__m128 ic0 = _mm_mul_ps(StepEdge4(bc0, dx12), vFactor);
+		__m128 ic1 = _mm_mul_ps(StepEdge4(bc1, dx20), vFactor);
+		__m128 ic2 = _mm_mul_ps(StepEdge4(bc2, dx01), vFactor);
+
+		// NOT(ic < 0), to match scalar path behaviour with NaN
+		__m128 inside = _mm_and_ps(_mm_cmpnlt_ps(ic0, zero),
+						_mm_and_ps(_mm_cmpnlt_ps(ic1, zero), _mm_cmpnlt_ps(ic2, zero)));
+		int mask = _mm_movemask_ps(inside);
+		if (!mask) continue;
+
+		__m128 w = _mm_div_ps(one, _mm_add_ps(_mm_add_ps(_mm_mul_ps(ic0, w0), _mm_mul_ps(ic1, w1)), _mm_mul_ps(ic2, w2)));
+		__m128 z = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(ic0, z0), _mm_mul_ps(ic1, z1)), _mm_mul_ps(ic2, z2)), w);
+
+#ifndef SOFTGPU_DISABLE_ZBUFFER
+		if (depthTest) {
+			__m128 depth = _mm_loadu_ps(&depthBuffer[y * db_stride + x]);
+			__m128 fail  = _mm_or_ps(_mm_cmplt_ps(z, zero), _mm_cmpgt_ps(z, depth));
+			mask &= ~_mm_movemask_ps(fail);
+			if (!mask) continue;
+		}
+#endif
+
+		_mm_storeu_ps(IC0, ic0); _mm_storeu_ps(IC1, ic1); _mm_storeu_ps(IC2, ic2);
+		_mm_storeu_ps(W,   w);   _mm_storeu_ps(Z,   z);
+
+		for (int i = 0; i < 4; i++)
+		{
+			if (!(mask & (1 << i))) continue;
+			DrawPixel3D(t, x + i, y, IC0[i], IC1[i], IC2[i], W[i], Z[i]);
+		}
+	}
+	return x;
+}
+#endif
+
+// Rasterises the portion of the triangle between bandMinY and bandMaxY (inclusive)
+static void RasterTriangle3D(Vertex* V0, Vertex* V1, Vertex* V2, int bandMinY, int bandMaxY) {
 	int x0 = (int)V0->x, y0 = (int)V0->y;
 	int x1 = (int)V1->x, y1 = (int)V1->y;
 	int x2 = (int)V2->x, y2 = (int)V2->y;
@@ -500,17 +637,18 @@ static void DrawTriangle3D(Vertex* V0, Vertex* V1, Vertex* V2) {
 
 	// NOTE: W in frag variables below is actually 1/W 
 	float factor = 1.0f / area;
-	float w0 = V0->w, w1 = V1->w, w2 = V2->w;
+	TriangleAttribs t;
+	t.w0 = V0->w; t.w1 = V1->w; t.w2 = V2->w;
 	
 	// TODO proper clipping
-	if (w0 <= 0 || w1 <= 0 || w2 <= 0) {
+	if (t.w0 <= 0 || t.w1 <= 0 || t.w2 <= 0) {
 		return;
 	}
 
-	float z0 = V0->z, z1 = V1->z, z2 = V2->z;
-	float u0 = V0->u, u1 = V1->u, u2 = V2->u;
-	float v0 = V0->v, v1 = V1->v, v2 = V2->v;
-	PackedCol color = V0->c;
+	t.z0 = V0->z; t.z1 = V1->z; t.z2 = V2->z;
+	t.u0 = V0->u; t.u1 = V1->u; t.u2 = V2->u;
+	t.v0 = V0->v; t.v1 = V1->v; t.v2 = V2->v;
+	t.color = V0->c;
 	
 	// https://fgiesen.wordpress.com/2013/02/10/optimizing-the-basic-rasterizer/
 	// Essentially these are the deltas of edge functions between X/Y and X/Y + 1 (i.e. one X/Y step)
@@ -521,78 +659,183 @@ static void DrawTriangle3D(Vertex* V0, Vertex* V1, Vertex* V2) {
 	float bc0_start = edgeFunction(x1,y1, x2,y2, minX+0.5f,minY+0.5f);
 	float bc1_start = edgeFunction(x2,y2, x0,y0, minX+0.5f,minY+0.5f);
 	float bc2_start = edgeFunction(x0,y0, x1,y1, minX+0.5f,minY+0.5f);
+	int y = minY;
 
-	for (int y = minY; y <= maxY; y++, bc0_start += dy12, bc1_start += dy20, bc2_start += dy01) 
+	// Step over the rows before this band one row at a time, so values are bit-identical
+	//  regardless of how the framebuffer is divided into bands
+	for (; y < bandMinY; y++, bc0_start += dy12, bc1_start += dy20, bc2_start += dy01) { }
+	maxY = min(maxY, bandMaxY);
+
+	for (; y <= maxY; y++, bc0_start += dy12, bc1_start += dy20, bc2_start += dy01) 
 	{
 		float bc0 = bc0_start;
 		float bc1 = bc1_start;
 		float bc2 = bc2_start;
+		int x = minX;
+#ifdef SOFTGPU_SIMD
+		x = DrawRow3D_SIMD(&t, x, maxX, y, factor, &bc0, &bc1, &bc2, dx12, dx20, dx01);
+#endif
 
-		for (int x = minX; x <= maxX; x++, bc0 += dx12, bc1 += dx20, bc2 += dx01) 
+		for (; x <= maxX; x++, bc0 += dx12, bc1 += dx20, bc2 += dx01) 
 		{
 			float ic0 = bc0 * factor;
 			float ic1 = bc1 * factor;
 			float ic2 = bc2 * factor;
 			if (ic0 < 0 || ic1 < 0 || ic2 < 0) continue;
-			int db_index = y * db_stride + x;
 
-			float w = 1 / (ic0 * w0 + ic1 * w1 + ic2 * w2);
-			float z = (ic0 * z0 + ic1 * z1 + ic2 * z2) * w;
+			float w = 1 / (ic0 * t.w0 + ic1 * t.w1 + ic2 * t.w2);
+			float z = (ic0 * t.z0 + ic1 * t.z1 + ic2 * t.z2) * w;
+			DrawPixel3D(&t, x, y, ic0, ic1, ic2, w, z);
+		}
+	}
+}
 
-#ifndef SOFTGPU_DISABLE_ZBUFFER
-			if (depthTest && (z < 0 || z > depthBuffer[db_index])) continue;
-			if (!colWrite) {
-				if (depthWrite) depthBuffer[db_index] = z;
-				continue;
-			}
-#else
-			if (!colWrite) continue;
-#endif
 
-			int R, G, B, A;
-			if (gfx_format == VERTEX_FORMAT_TEXTURED) {
-				float u = (ic0 * u0 + ic1 * u1 + ic2 * u2) * w;
-				float v = (ic0 * v0 + ic1 * v1 + ic2 * v2) * w;
-				int texX = ((int)(Math_AbsF(u - FastFloor(u)) * curTexWidth )) & texWidthMask;
-				int texY = ((int)(Math_AbsF(v - FastFloor(v)) * curTexHeight)) & texHeightMask;
-				int texIndex = texY * curTexWidth + texX;
+/*########################################################################################################################*
+*------------------------------------------------------Triangle binning---------------------------------------------------*
+*#########################################################################################################################*/
+// Triangles are queued up during a draw call, then sorted into bands of rows 
+//  which are rasterised in parallel. (each band only touches its own rows of the framebuffer)
+#define BAND_HEIGHT 32
+// Draw calls with fewer triangles than this aren't worth the overhead of binning
+#define BIN_MIN_TRIANGLES 16
+
+typedef struct Triangle3D_ {
+	Vertex v[3];
+	int minY, maxY;
+} Triangle3D;
+
+static cc_bool binning;
+static Triangle3D* bin_tris;
+static int bin_trisCount, bin_trisCapacity;
+// Indices of triangles overlapping each band, bands[i] to bands[i + 1] being the range for band i
+static int* bin_indices;
+static int  bin_indicesCapacity;
+static int* bin_bands;
+static int  bin_bandsCapacity;
+
+static void FreeBins(void) {
+	Mem_Free(bin_tris);    bin_tris    = NULL;
+	Mem_Free(bin_indices); bin_indices = NULL;
+	Mem_Free(bin_bands);   bin_bands   = NULL;
+
+	bin_trisCount       = 0; bin_trisCapacity  = 0;
+	bin_indicesCapacity = 0; bin_bandsCapacity = 0;
+}
 
-				BitmapCol tColor = curTexPixels[texIndex];
-				int a1 = PackedCol_A(color), a2 = BitmapCol_A(tColor);
-				A = ( a1 * a2 ) >> 8;
-				int r1 = PackedCol_R(color), r2 = BitmapCol_R(tColor);
-				R = ( r1 * r2 ) >> 8;
-				int g1 = PackedCol_G(color), g2 = BitmapCol_G(tColor);
-				G = ( g1 * g2 ) >> 8;
-				int b1 = PackedCol_B(color), b2 = BitmapCol_B(tColor);
-				B = ( b1 * b2 ) >> 8;
-			} else {
-				R = PackedCol_R(color);
-				G = PackedCol_G(color);
-				B = PackedCol_B(color);
-				A = PackedCol_A(color);
-			}
+static cc_bool ReserveBins(int** bins, int* capacity, int count) {
+	int* data;
+	if (count <= *capacity) return true;
 
-			if (gfx_alphaTest && A < 0x80) continue;
-			int cb_index = y * cb_stride + x;
-			
-			if (gfx_alphaBlend) {
-				BitmapCol dst = colorBuffer[cb_index];
-				int dstR = BitmapCol_R(dst);
-				int dstG = BitmapCol_G(dst);
-				int dstB = BitmapCol_B(dst);
+	data = (int*)Mem_TryRealloc(*bins, count, sizeof(int));
+	if (!data) return false;
 
-				R = (R * A + dstR * (255 - A)) >> 8;
-				G = (G * A + dstG * (255 - A)) >> 8;
-				B = (B * A + dstB * (255 - A)) >> 8;
-			}
+	*bins     = data;
+	*capacity = count;
+	return true;
+}
 
-#ifndef SOFTGPU_DISABLE_ZBUFFER
-			if (depthWrite) depthBuffer[db_index] = z;
-#endif
-			colorBuffer[cb_index] = BitmapCol_Make(R, G, B, 0xFF);
+static void RasterBand(void* obj, int band) {
+	int minY = band * BAND_HEIGHT;
+	int maxY = min(minY + BAND_HEIGHT - 1, fb_maxY);
+	int i;
+
+	for (i = bin_bands[band]; i < bin_bands[band + 1]; i++)
+	{
+		Triangle3D* t = &bin_tris[bin_indices[i]];
+		RasterTriangle3D(&t->v[0], &t->v[1], &t->v[2], minY, maxY);
+	}
+}
+
+static void RasterSerial(void) {
+	int i;
+	for (i = 0; i < bin_trisCount; i++)
+	{
+		Triangle3D* t = &bin_tris[i];
+		RasterTriangle3D(&t->v[0], &t->v[1], &t->v[2], 0, fb_maxY);
+	}
+}
+
+// Rasterises all the queued triangles
+static void FlushTriangles3D(void) {
+	int numBands = (fb_maxY + BAND_HEIGHT) / BAND_HEIGHT;
+	int i, band, total = 0;
+	Triangle3D* t;
+	if (!bin_trisCount) return;
+
+	if (bin_trisCount < BIN_MIN_TRIANGLES || numBands <= 1 || 
+			!ReserveBins(&bin_bands, &bin_bandsCapacity, numBands + 1)) {
+		RasterSerial(); bin_trisCount = 0; return;
+	}
+
+	// Count how many triangles overlap each band
+	Mem_Set(bin_bands, 0, (numBands + 1) * sizeof(int));
+	for (i = 0; i < bin_trisCount; i++) 
+	{
+		t = &bin_tris[i];
+		for (band = t->minY / BAND_HEIGHT; band <= t->maxY / BAND_HEIGHT; band++) bin_bands[band]++;
+	}
+
+	// Convert counts into start offsets
+	for (band = 0; band <= numBands; band++) 
+	{
+		int count = bin_bands[band];
+		bin_bands[band] = total;
+		total += count;
+	}
+
+	if (!ReserveBins(&bin_indices, &bin_indicesCapacity, total)) {
+		RasterSerial(); bin_trisCount = 0; return;
+	}
+
+	// Fill in the triangles for each band, in submission order
+	for (i = 0; i < bin_trisCount; i++) 
+	{
+		t = &bin_tris[i];
+		for (band = t->minY / BAND_HEIGHT; band <= t->maxY / BAND_HEIGHT; band++) 
+		{
+			bin_indices[bin_bands[band]++] = i;
 		}
 	}
+
+	// Filling in moved each offset to the start of the next band
+	for (band = numBands; band > 0; band--) bin_bands[band] = bin_bands[band - 1];
+	bin_bands[0] = 0;
+
+	WorkerPool_Run(RasterBand, NULL, numBands);
+	bin_trisCount = 0;
+}
+
+static void DrawTriangle3D(Vertex* V0, Vertex* V1, Vertex* V2) {
+	Triangle3D* tris;
+	Triangle3D* t;
+	int minY, maxY;
+
+	if (!binning) {
+		RasterTriangle3D(V0, V1, V2, 0, fb_maxY); return;
+	}
+
+	minY = min((int)V0->y, min((int)V1->y, (int)V2->y));
+	maxY = max((int)V0->y, max((int)V1->y, (int)V2->y));
+	// Triangle entirely above or below the framebuffer
+	if (maxY < 0 || minY > fb_maxY) return;
+
+	if (bin_trisCount == bin_trisCapacity) {
+		tris = (Triangle3D*)Mem_TryRealloc(bin_tris, bin_trisCapacity + 1024, sizeof(Triangle3D));
+
+		// Out of memory, so just draw the triangle immediately instead
+		if (!tris) {
+			FlushTriangles3D();
+			RasterTriangle3D(V0, V1, V2, 0, fb_maxY); return;
+		}
+		bin_tris = tris;
+		bin_trisCapacity += 1024;
+	}
+
+	t = &bin_tris[bin_trisCount++];
+	t->v[0] = *V0; t->v[1] = *V1; t->v[2] = *V2;
+	t->minY = max(minY, 0);
+	t->maxY = min(maxY, fb_maxY);
 }
 
 #define V0_VIS (1 << 0)
@@ -875,6 +1118,8 @@ void DrawQuads(int startVertex, int verticesCount) {
 			DrawTriangle2D(&vertices[2], &vertices[0], &vertices[3]);
 		}
 	} else {
+		binning = WorkerPool_Threads() > 1;
+
 		// 4 vertices = 1 quad = 2 triangles
 		for (int i = 0; i < verticesCount / 4; i++, j += 4)
 		{
@@ -899,6 +1144,7 @@ void DrawQuads(int startVertex, int verticesCount) {
 				DrawClipped(clip, &vertices[0], &vertices[1], &vertices[2], &vertices[3]);
 			}
 		}
+		FlushTriangles3D();
 	}
 }
 
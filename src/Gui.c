@@ -641,28 +641,28 @@ static void OnAxisUpdate(void* obj, int port, int axis, float x, float y) {
 /*########################################################################################################################*
 *------------------------------------------------------Gui component------------------------------------------------------*
 *#########################################################################################################################*/
-static void GuiPngProcess(struct Stream* stream, const cc_string* name) {
+static void GuiPngProcess(struct Bitmap* bmp, const cc_string* name) {
 	int heightDivisor = 2; /* only top half of gui png is used */
-	Game_UpdateTexture(&Gui.GuiTex, stream, name, NULL, &heightDivisor);
+	Game_UpdateTextureBitmap(&Gui.GuiTex, bmp, name, NULL, &heightDivisor);
 }
-static struct TextureEntry gui_entry = { "gui.png", GuiPngProcess };
+static struct TextureEntry gui_entry = { "gui.png", NULL, GuiPngProcess };
 
-static void GuiClassicPngProcess(struct Stream* stream, const cc_string* name) {
+static void GuiClassicPngProcess(struct Bitmap* bmp, const cc_string* name) {
 	int heightDivisor = 2; /* only top half of gui png is used */
-	Game_UpdateTexture(&Gui.GuiClassicTex, stream, name, NULL, &heightDivisor);
+	Game_UpdateTextureBitmap(&Gui.GuiClassicTex, bmp, name, NULL, &heightDivisor);
 }
-static struct TextureEntry guiClassic_entry = { "gui_classic.png", GuiClassicPngProcess };
+static struct TextureEntry guiClassic_entry = { "gui_classic.png", NULL, GuiClassicPngProcess };
 
-static void IconsPngProcess(struct Stream* stream, const cc_string* name) {
+static void IconsPngProcess(struct Bitmap* bmp, const cc_string* name) {
 	int heightDivisor = 4; /* only top quarter of icons png is used */
-	Game_UpdateTexture(&Gui.IconsTex, stream, name, NULL, &heightDivisor);
+	Game_UpdateTextureBitmap(&Gui.IconsTex, bmp, name, NULL, &heightDivisor);
 }
-static struct TextureEntry icons_entry = { "icons.png", IconsPngProcess };
+static struct TextureEntry icons_entry = { "icons.png", NULL, IconsPngProcess };
 
-static void TouchPngProcess(struct Stream* stream, const cc_string* name) {
-	Game_UpdateTexture(&Gui.TouchTex, stream, name, NULL, NULL);
+static void TouchPngProcess(struct Bitmap* bmp, const cc_string* name) {
+	Game_UpdateTextureBitmap(&Gui.TouchTex, bmp, name, NULL, NULL);
 }
-static struct TextureEntry touch_entry = { "touch.png", TouchPngProcess };
+static struct TextureEntry touch_entry = { "touch.png", NULL, TouchPngProcess };
 
 static void OnFontChanged(void* obj) { Gui_RefreshAll(); }
 
@@ -30,6 +30,8 @@ struct HttpRequest {
 	char url[URL_MAX_SIZE];   /* URL data is downloaded from/uploaded to. */
 	int id;                   /* Unique identifier for this request. */
 	volatile int progress;    /* Progress with downloading this request */
+	cc_uint64 timeAdded;      /* Time request was added to the queue of pending requests. */
+	cc_uint64 timeStarted;    /* Time request started being performed. */
 	cc_uint64 timeDownloaded; /* Time response contents were completely downloaded. */
 	int statusCode;           /* HTTP status code returned in the response. */
 	cc_uint32 contentLength;  /* HTTP content length returned in the response. */
@@ -51,6 +53,9 @@ struct HttpRequest {
 /* Frees all dynamically allocated data from a HTTP request */
 void HttpRequest_Free(struct HttpRequest* request);
 
+/* Retrieves the URL the given skin is downloaded from. */
+/* If skinName is a url, then just that url. (if not, SKIN_SERVER/[skinName].png) */
+void Http_GetSkinUrl(const cc_string* skinName, cc_string* url);
 /* Aschronously performs a http GET request to download a skin. */
 /* If url is a skin, downloads from there. (if not, downloads from SKIN_SERVER/[skinName].png) */
 int Http_AsyncGetSkin(const cc_string* skinName, cc_uint8 flags);
@@ -88,6 +93,17 @@ int Http_CheckProgress(int reqID);
 /* Clears the list of pending requests. */
 void Http_ClearPending(void);
 
+struct HttpStats {
+	int pending;      /* Number of requests waiting to be performed */
+	int active;       /* Number of requests currently being performed */
+	int peakPending;  /* Most requests that have been waiting to be performed at once */
+	int completed;    /* Number of requests that have been completely performed */
+	cc_uint64 waitMS; /* Total time completed requests spent waiting before being performed */
+	cc_uint64 workMS; /* Total time spent performing completed requests */
+};
+/* Retrieves statistics about the queue of pending requests, and how long requests took. */
+void Http_GetStats(struct HttpStats* stats);
+
 void Http_LogError(const char* action, const struct HttpRequest* item);
 
 CC_END_HEADER
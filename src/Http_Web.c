@@ -44,6 +44,12 @@ void Http_TryCancel(int reqID) {
 	RequestList_TryFree(&processedReqs, reqID);
 }
 
+void Http_GetStats(struct HttpStats* stats) {
+	*stats = http_stats;
+	stats->pending = queuedReqs.count;
+	stats->active  = workingReqs.count;
+}
+
 
 /*########################################################################################################################*
 *----------------------------------------------------Emscripten backend---------------------------------------------------*
@@ -65,6 +71,7 @@ static void Http_StartNextDownload(void) {
 	String_InitArray(url, urlBuffer);
 
 	req = &queuedReqs.entries[0];
+	req->timeStarted = Stopwatch_Measure();
 	Http_GetUrl(req, &url);
 	Platform_Log1("Fetching %s", &url);
 
@@ -128,6 +135,7 @@ static void HttpBackend_Add(struct HttpRequest* req, cc_uint8 flags) {
 	}
 
 	RequestList_Append(&queuedReqs, req, flags);
+	http_stats.peakPending = max(http_stats.peakPending, queuedReqs.count);
 	Http_StartNextDownload();
 }
 
@@ -2,6 +2,19 @@
 #ifndef CC_BUILD_WEB
 #include "_HttpBase.h"
 
+#if (CC_NET_BACKEND == CC_NET_BACKEND_LIBCURL || CC_NET_BACKEND == CC_NET_BACKEND_BUILTIN) && !defined CC_BUILD_PSP && !defined CC_BUILD_NDS
+/* Each request uses a separate curl handle or connection from a pool, so many requests can be performed at once */
+#define HTTP_MAX_WORKERS 8
+#define HTTP_DEF_WORKERS 4
+#else
+/* Other backends only support performing one request at a time */
+#define HTTP_MAX_WORKERS 1
+#define HTTP_DEF_WORKERS 1
+#endif
+/* Maximum number of requests to the same server that are performed at once */
+/*  (less than HTTP_DEF_WORKERS, so that e.g. many skin downloads don't delay requests to other servers) */
+#define HTTP_MAX_HOST_REQUESTS 3
+
 /* Ensures data buffer has enough space left to append amount bytes */
 static cc_bool Http_BufferExpand(struct HttpRequest* req, cc_uint32 amount) {
 	cc_uint32 newSize = req->size + amount;
@@ -114,15 +127,15 @@ static void Http_SetRequestHeaders(struct HttpRequest* req) {
 	Http_AddHeader(req, "Cookie", &cookies);
 }
 
-/* TODO: Rewrite to use a local variable instead */
-static cc_string* Http_GetUserAgent_UNSAFE(void) {
-	static char userAgentBuffer[STRING_SIZE];
-	static cc_string userAgent;
+/* Adds the User-Agent header to the request headers */
+/*  (can't use a static buffer, as requests may be performed on multiple threads at once) */
+static void Http_AddUserAgent(struct HttpRequest* req) {
+	cc_string userAgent; char userAgentBuffer[STRING_SIZE];
 
 	String_InitArray(userAgent, userAgentBuffer);
 	String_AppendConst(&userAgent, GAME_APP_NAME);
 	String_AppendConst(&userAgent, Platform_AppNameSuffix);
-	return &userAgent;
+	Http_AddHeader(req, "User-Agent", &userAgent);
 }
 
 
@@ -228,8 +241,49 @@ static cc_bool LoadCurlFuncs(void) {
 	return success;
 }
 
-static CURL* curl;
 static cc_bool curlSupported, curlVerbose;
+/* Each curl handle can only perform one request at a time, but keeps connections open for later requests to reuse */
+static struct CurlPoolEntry {
+	CURL* handle;
+	cc_bool inUse;
+} curl_pool[HTTP_MAX_WORKERS];
+static void* curlPoolMutex;
+
+static CURL* CurlPool_Acquire(void) {
+	struct CurlPoolEntry* e;
+	CURL* handle = NULL;
+	int i;
+
+	Mutex_Lock(curlPoolMutex);
+	{
+		for (i = 0; i < Array_Elems(curl_pool); i++)
+		{
+			e = &curl_pool[i];
+			if (e->inUse) continue;
+
+			if (!e->handle) e->handle = _curl_easy_init();
+			if (!e->handle) break;
+
+			e->inUse = true;
+			handle   = e->handle;
+			break;
+		}
+	}
+	Mutex_Unlock(curlPoolMutex);
+	return handle;
+}
+
+static void CurlPool_Release(CURL* handle) {
+	int i;
+	Mutex_Lock(curlPoolMutex);
+	{
+		for (i = 0; i < Array_Elems(curl_pool); i++)
+		{
+			if (curl_pool[i].handle == handle) curl_pool[i].inUse = false;
+		}
+	}
+	Mutex_Unlock(curlPoolMutex);
+}
 
 static cc_bool HttpBackend_DescribeError(cc_result res, cc_string* dst) {
 	const char* err;
@@ -246,11 +300,12 @@ static void HttpBackend_Init(void) {
 	static const cc_string msg = String_FromConst("Failed to init libcurl. All HTTP requests will therefore fail.");
 	CURLcode res;
 
+	curlPoolMutex = Mutex_Create("HTTP curl handles");
 	if (!LoadCurlFuncs()) { Logger_WarnFunc(&msg); return; }
 	res = _curl_global_init(CURL_GLOBAL_DEFAULT);
 	if (res) { Logger_SimpleWarn(res, "initing curl"); return; }
-	curl = _curl_easy_init();
-	if (!curl) { Logger_SimpleWarn(res, "initing curl_easy"); return; }
+	curl_pool[0].handle = _curl_easy_init();
+	if (!curl_pool[0].handle) { Logger_SimpleWarn(res, "initing curl_easy"); return; }
 
 	curlSupported = true;
 	curlVerbose = Options_GetBool("curl-verbose", false);
@@ -292,7 +347,7 @@ static size_t Http_ProcessData(char *buffer, size_t size, size_t nitems, void* u
 }
 
 /* Sets general curl options for a request */
-static void Http_SetCurlOpts(struct HttpRequest* req) {
+static void Http_SetCurlOpts(CURL* curl, struct HttpRequest* req) {
 	_curl_easy_setopt(curl, CURLOPT_USERAGENT,      GAME_APP_NAME);
 	_curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
 	_curl_easy_setopt(curl, CURLOPT_MAXREDIRS,      20L);
@@ -313,13 +368,17 @@ static cc_result HttpBackend_Do(struct HttpRequest* req, cc_string* url) {
 	char urlStr[NATIVE_STR_LEN];
 	void* post_data = req->data;
 	CURLcode res;
+	CURL* curl;
+
 	if (!curlSupported) return ERR_NOT_SUPPORTED;
+	curl = CurlPool_Acquire();
+	if (!curl) return ERR_OUT_OF_MEMORY;
 
 	req->meta = NULL;
 	Http_SetRequestHeaders(req);
 	_curl_easy_setopt(curl, CURLOPT_HTTPHEADER, req->meta);
 
-	Http_SetCurlOpts(req);
+	Http_SetCurlOpts(curl, req);
 	String_EncodeUtf8(urlStr, url);
 	_curl_easy_setopt(curl, CURLOPT_URL, urlStr);
 
@@ -359,6 +418,7 @@ static cc_result HttpBackend_Do(struct HttpRequest* req, cc_string* url) {
 	/* can free now that request has finished */
 	Mem_Free(post_data);
 	_curl_easy_setopt(curl, CURLOPT_ERRORBUFFER, NULL);
+	CurlPool_Release(curl);
 	return res;
 }
 #elif CC_NET_BACKEND == CC_NET_BACKEND_BUILTIN
@@ -528,46 +588,75 @@ static cc_result HttpConnection_Write(struct HttpConnection* conn, const cc_uint
 /*########################################################################################################################*
 *-----------------------------------------------------Connection Pool-----------------------------------------------------*
 *#########################################################################################################################*/
+/* NOTE: Must have more entries than HTTP_MAX_WORKERS, so there is always an entry that isn't in use */
 static struct ConnectionPoolEntry {
 	struct HttpConnection conn;
 	cc_string addr;
 	char addrBuffer[STRING_SIZE];
 	cc_bool https;
+	cc_bool inUse; /* Whether a request is currently being performed using this connection */
 } connection_pool[10];
+static void* connectionPoolMutex;
 
-static cc_result ConnectionPool_Insert(int i, struct HttpConnection** conn, const struct HttpUrl* url) {
-	struct ConnectionPoolEntry* e = &connection_pool[i];
-	*conn = &e->conn;
-
-	String_InitArray(e->addr, e->addrBuffer);
-	String_Copy(&e->addr, &url->address);
-	e->https = url->https;
-	return HttpConnection_Open(&e->conn, url);
-}
-
-static cc_result ConnectionPool_Open(struct HttpConnection** conn, const struct HttpUrl* url) {
+/* Finds an unused open connection to the given server, otherwise an entry to open a new connection in */
+static int ConnectionPool_Find(const struct HttpUrl* url, cc_bool* reused) {
 	struct ConnectionPoolEntry* e;
 	int i;
 
+	*reused = true;
 	for (i = 0; i < Array_Elems(connection_pool); i++)
 	{
 		e = &connection_pool[i];
-		if (e->conn.valid && e->https == url->https && String_Equals(&e->addr, &url->address)) {
-			*conn = &connection_pool[i].conn;
-			return 0;
-		}
+		if (e->inUse || !e->conn.valid) continue;
+		if (e->https == url->https && String_Equals(&e->addr, &url->address)) return i;
 	}
 
+	*reused = false;
 	for (i = 0; i < Array_Elems(connection_pool); i++)
 	{
 		e = &connection_pool[i];
-		if (!e->conn.valid) return ConnectionPool_Insert(i, conn, url);
+		if (!e->inUse && !e->conn.valid) return i;
 	}
 
 	/* TODO: Should we be consistent in which entry gets evicted? */
 	i = (cc_uint8)Stopwatch_Measure() % Array_Elems(connection_pool);
+	while (connection_pool[i].inUse) { i = (i + 1) % Array_Elems(connection_pool); }
+
 	HttpConnection_Close(&connection_pool[i].conn);
-	return ConnectionPool_Insert(i, conn, url);
+	return i;
+}
+
+static cc_result ConnectionPool_Open(struct HttpConnection** conn, const struct HttpUrl* url) {
+	struct ConnectionPoolEntry* e;
+	cc_bool reused;
+
+	Mutex_Lock(connectionPoolMutex);
+	{
+		e = &connection_pool[ConnectionPool_Find(url, &reused)];
+		e->inUse = true;
+	}
+	Mutex_Unlock(connectionPoolMutex);
+
+	*conn = &e->conn;
+	if (reused) return 0;
+
+	String_InitArray(e->addr, e->addrBuffer);
+	String_Copy(&e->addr, &url->address);
+	e->https = url->https;
+	return HttpConnection_Open(&e->conn, url);
+}
+
+/* Allows the given connection to be reused for other requests */
+static void ConnectionPool_Release(struct HttpConnection* conn) {
+	int i;
+	Mutex_Lock(connectionPoolMutex);
+	{
+		for (i = 0; i < Array_Elems(connection_pool); i++)
+		{
+			if (&connection_pool[i].conn == conn) connection_pool[i].inUse = false;
+		}
+	}
+	Mutex_Unlock(connectionPoolMutex);
 }
 
 
@@ -625,7 +714,7 @@ static void HttpClient_Serialise(struct HttpClientState* state) {
 					verbs[req->requestType], &state->url.resource);
 
 	Http_AddHeader(req, "Host",       &state->url.address);
-	Http_AddHeader(req, "User-Agent", Http_GetUserAgent_UNSAFE());
+	Http_AddUserAgent(req);
 	if (req->data) String_Format1(buffer, "Content-Length: %i\r\n", &req->size);
 
 	Http_SetRequestHeaders(req);
@@ -898,6 +987,7 @@ static cc_result HttpClient_HandleRedirect(struct HttpClientState* state) {
 *#########################################################################################################################*/
 static void HttpBackend_Init(void) {
 	SSLBackend_Init(httpsVerify);
+	connectionPoolMutex = Mutex_Create("HTTP connections");
 	//httpOnly = true; // TODO: insecure
 }
 
@@ -909,14 +999,12 @@ static cc_result HttpBackend_PerformRequest(struct HttpClientState* state) {
 	cc_result res;
 
 	res = ConnectionPool_Open(&state->conn, &state->url);
-	if (res) { HttpConnection_Close(state->conn); return res; }
-
-	res = HttpClient_SendRequest(state);
-	if (res) { HttpConnection_Close(state->conn); return res; }
-
-	res = HttpClient_ParseResponse(state);
-	if (res) HttpConnection_Close(state->conn);
+	if (!res) res = HttpClient_SendRequest(state);
+	if (!res) res = HttpClient_ParseResponse(state);
 
+	/* Server closes the connection after sending the response in that case */
+	if (res || state->autoClose) HttpConnection_Close(state->conn);
+	ConnectionPool_Release(state->conn);
 	return res;
 }
 
@@ -1073,7 +1161,7 @@ static cc_result HttpBackend_Do(struct HttpRequest* req, cc_string* url) {
 	java_req = req;
 
 	Http_SetRequestHeaders(req);
-	Http_AddHeader(req, "User-Agent", Http_GetUserAgent_UNSAFE());
+	Http_AddUserAgent(req);
 	
 	if (req->data) {
 		if (res = Http_SetData(env, req)) return res;
@@ -1161,7 +1249,7 @@ static cc_result HttpBackend_Do(struct HttpRequest* req, cc_string* url) {
     request = CFHTTPMessageCreateRequest(NULL, verbs[req->requestType], urlRef, kCFHTTPVersion1_1);
     req->meta = request;
     Http_SetRequestHeaders(req);
-    Http_AddHeader(req, "User-Agent", Http_GetUserAgent_UNSAFE());
+    Http_AddUserAgent(req);
     CFRelease(urlRef);
     
     if (req->data) {
@@ -1222,14 +1310,25 @@ static cc_result HttpBackend_Do(struct HttpRequest* req, cc_string* url) {
 #endif
 
 
+struct HttpWorker {
+	cc_bool active;                /* Whether a request is currently being performed */
+	struct StringsBuffer* cookies; /* Cookies of the request currently being performed */
+	cc_string host;                /* Server address of the request currently being performed */
+	char _hostBuffer[STRING_SIZE];
+	struct HttpRequest cur;        /* Request currently being performed (id is 0 when none) */
+};
+static struct HttpWorker http_workers[HTTP_MAX_WORKERS];
+static void* workerThreads[HTTP_MAX_WORKERS];
 static void* workerWaitable;
-static void* workerThread;
+static int nextWorker;
 
+/* NOTE: active/cookies/host of workers are also protected by pendingMutex */
 static void* pendingMutex;
-static struct RequestList pendingReqs;
+/* Priority requests (e.g. texture packs) are always performed before other requests (e.g. skins) */
+static struct RequestList priorityReqs, pendingReqs;
 
+/* NOTE: cur of workers is protected by curRequestMutex */
 static void* curRequestMutex;
-static struct HttpRequest http_curRequest;
 
 
 /*########################################################################################################################*
@@ -1248,26 +1347,43 @@ cc_bool Http_GetResult(int reqID, struct HttpRequest* item) {
 }
 
 cc_bool Http_GetCurrent(int* reqID, int* progress) {
+	int i;
+	*reqID    = 0;
+	*progress = HTTP_PROGRESS_NOT_WORKING_ON;
+
 	Mutex_Lock(curRequestMutex);
 	{
-		*reqID    = http_curRequest.id;
-		*progress = http_curRequest.progress;
+		for (i = 0; i < HTTP_MAX_WORKERS; i++)
+		{
+			if (!http_workers[i].cur.id) continue;
+
+			*reqID    = http_workers[i].cur.id;
+			*progress = http_workers[i].cur.progress;
+			break;
+		}
 	}
 	Mutex_Unlock(curRequestMutex);
 	return *reqID != 0;
 }
 
 int Http_CheckProgress(int reqID) {
-	int curReqID, progress;
-	Http_GetCurrent(&curReqID, &progress);
+	int i, progress = HTTP_PROGRESS_NOT_WORKING_ON;
 
-	if (reqID != curReqID) progress = HTTP_PROGRESS_NOT_WORKING_ON;
+	Mutex_Lock(curRequestMutex);
+	{
+		for (i = 0; i < HTTP_MAX_WORKERS; i++)
+		{
+			if (http_workers[i].cur.id == reqID) progress = http_workers[i].cur.progress;
+		}
+	}
+	Mutex_Unlock(curRequestMutex);
 	return progress;
 }
 
 void Http_ClearPending(void) {
 	Mutex_Lock(pendingMutex);
 	{
+		RequestList_Free(&priorityReqs);
 		RequestList_Free(&pendingReqs);
 	}
 	Mutex_Unlock(pendingMutex);
@@ -1276,7 +1392,8 @@ void Http_ClearPending(void) {
 void Http_TryCancel(int reqID) {
 	Mutex_Lock(pendingMutex);
 	{
-		RequestList_TryFree(&pendingReqs, reqID);
+		RequestList_TryFree(&priorityReqs, reqID);
+		RequestList_TryFree(&pendingReqs,  reqID);
 	}
 	Mutex_Unlock(pendingMutex);
 
@@ -1287,21 +1404,103 @@ void Http_TryCancel(int reqID) {
 	Mutex_Unlock(processedMutex);
 }
 
+void Http_GetStats(struct HttpStats* stats) {
+	int i;
+	Mutex_Lock(processedMutex);
+	{
+		*stats = http_stats;
+	}
+	Mutex_Unlock(processedMutex);
+
+	Mutex_Lock(pendingMutex);
+	{
+		stats->pending     = priorityReqs.count + pendingReqs.count;
+		stats->peakPending = http_stats.peakPending;
+		stats->active      = 0;
+
+		for (i = 0; i < HTTP_MAX_WORKERS; i++)
+		{
+			if (http_workers[i].active) stats->active++;
+		}
+	}
+	Mutex_Unlock(pendingMutex);
+}
+
 
 /*########################################################################################################################*
 *-----------------------------------------------------Http worker---------------------------------------------------------*
 *#########################################################################################################################*/
+/* Extracts the server address from the url of the given request (e.g. "classicube.net:8080") */
+static void Http_GetHost(struct HttpRequest* req, cc_string* host) {
+	char urlBuffer[URL_MAX_SIZE]; cc_string url;
+	int idx;
+
+	String_InitArray(url, urlBuffer);
+	Http_GetUrl(req, &url);
+
+	idx = String_IndexOfConst(&url, "://");
+	if (idx >= 0) url = String_UNSAFE_SubstringAt(&url, idx + 3);
+	idx = String_IndexOf(&url, '/');
+	if (idx >= 0) url = String_UNSAFE_Substring(&url, 0, idx);
+
+	String_Copy(host, &url);
+}
+
+/* Whether the given request can be started without exceeding the limit of requests to its server */
+static cc_bool CanStartRequest(struct HttpRequest* req, const cc_string* host) {
+	struct HttpWorker* worker;
+	int i, count = 0;
+
+	for (i = 0; i < HTTP_MAX_WORKERS; i++)
+	{
+		worker = &http_workers[i];
+		if (!worker->active) continue;
+
+		/* Responses may modify the cookies, so requests sharing cookies are performed one at a time */
+		if (req->cookies && req->cookies == worker->cookies) return false;
+		if (String_CaselessEquals(host, &worker->host)) count++;
+	}
+	return count < HTTP_MAX_HOST_REQUESTS;
+}
+
+/* Removes the first request in the given list that can be started, and marks the worker as performing it */
+static cc_bool TakePendingRequest(struct RequestList* list, struct HttpWorker* worker, struct HttpRequest* req) {
+	cc_string host; char hostBuffer[STRING_SIZE];
+	int i;
+	String_InitArray(host, hostBuffer);
+
+	for (i = 0; i < list->count; i++)
+	{
+		Http_GetHost(&list->entries[i], &host);
+		if (!CanStartRequest(&list->entries[i], &host)) continue;
+
+		HttpRequest_Copy(req, &list->entries[i]);
+		RequestList_RemoveAt(list, i);
+
+		worker->active  = true;
+		worker->cookies = req->cookies;
+		String_Copy(&worker->host, &host);
+		return true;
+	}
+	return false;
+}
+
 /* Sets up state to begin a http request */
-static void PrepareCurrentRequest(struct HttpRequest* req, cc_string* url) {
+static void PrepareCurrentRequest(struct HttpWorker* worker, struct HttpRequest* req, cc_string* url) {
 	static const char* verbs[] = { "GET", "HEAD", "POST" };
+	int queued;
+
+	req->timeStarted = Stopwatch_Measure();
+	queued = Stopwatch_ElapsedMS(req->timeAdded, req->timeStarted);
+
 	Http_GetUrl(req, url);
-	Platform_Log2("Fetching %s (%c)", url, verbs[req->requestType]);
+	Platform_Log3("Fetching %s (%c, queued for %i ms)", url, verbs[req->requestType], &queued);
 	/* TODO change to verbs etc */
 
 	Mutex_Lock(curRequestMutex);
 	{
-		HttpRequest_Copy(&http_curRequest, req);
-		http_curRequest.progress = HTTP_PROGRESS_MAKING_REQUEST;
+		HttpRequest_Copy(&worker->cur, req);
+		worker->cur.progress = HTTP_PROGRESS_MAKING_REQUEST;
 	}
 	Mutex_Unlock(curRequestMutex);
 }
@@ -1321,46 +1520,75 @@ static void PerformRequest(struct HttpRequest* req, cc_string* url) {
 	Http_FinishRequest(req);
 }
 
-static void ClearCurrentRequest(void) {
+static void ClearCurrentRequest(struct HttpWorker* worker) {
 	Mutex_Lock(curRequestMutex);
 	{
-		http_curRequest.id       = 0;
-		http_curRequest.progress = HTTP_PROGRESS_NOT_WORKING_ON;
+		worker->cur.id       = 0;
+		worker->cur.progress = HTTP_PROGRESS_NOT_WORKING_ON;
 	}
 	Mutex_Unlock(curRequestMutex);
+
+	Mutex_Lock(pendingMutex);
+	{
+		worker->active      = false;
+		worker->cookies     = NULL;
+		worker->host.length = 0;
+	}
+	Mutex_Unlock(pendingMutex);
 }
 
-static void DoRequest(struct HttpRequest* request) {
+static void DoRequest(struct HttpWorker* worker, struct HttpRequest* request) {
 	char urlBuffer[URL_MAX_SIZE]; cc_string url;
 
 	String_InitArray(url, urlBuffer);
-	PrepareCurrentRequest(request, &url);
-	PerformRequest(&http_curRequest, &url);
-	ClearCurrentRequest();
+	PrepareCurrentRequest(worker, request, &url);
+	PerformRequest(&worker->cur, &url);
+	ClearCurrentRequest(worker);
+}
+
+static void LogQueueEmpty(void) {
+	struct HttpStats stats;
+	int avgQueued, avgFetch;
+
+	Http_GetStats(&stats);
+	/* Only log when the last busy worker goes back to sleep */
+	if (stats.pending || stats.active) return;
+
+	avgQueued = stats.completed ? (int)(stats.waitMS / stats.completed) : 0;
+	avgFetch  = stats.completed ? (int)(stats.workMS / stats.completed) : 0;
+	Platform_Log4("Download queue empty, going back to sleep... (%i requests, %i ms avg queued, %i ms avg fetch, %i max queued)",
+		&stats.completed, &avgQueued, &avgFetch, &stats.peakPending);
 }
 
 static void WorkerLoop(void) {
+	struct HttpWorker* worker;
 	struct HttpRequest request;
 	cc_bool hasRequest;
+	int pending;
 
-	for (;;) {
-		hasRequest = false;
+	Mutex_Lock(pendingMutex);
+	{
+		worker = &http_workers[nextWorker++];
+	}
+	Mutex_Unlock(pendingMutex);
 
+	for (;;) {
 		Mutex_Lock(pendingMutex);
 		{
-			if (pendingReqs.count) {
-				HttpRequest_Copy(&request, &pendingReqs.entries[0]);
-				hasRequest = true;
-				RequestList_RemoveAt(&pendingReqs, 0);
-			}
+			hasRequest = TakePendingRequest(&priorityReqs, worker, &request) ||
+						 TakePendingRequest(&pendingReqs,  worker, &request);
+			pending    = priorityReqs.count + pendingReqs.count;
 		}
 		Mutex_Unlock(pendingMutex);
 
 		if (hasRequest) {
-			DoRequest(&request);
+			/* Waitable only wakes up one worker, so wake up another worker for the other requests */
+			if (pending) Waitable_Signal(workerWaitable);
+			DoRequest(worker, &request);
 		} else {
 			/* Block until another thread submits a request to do */
-			Platform_LogConst("Download queue empty, going back to sleep...");
+			/*  (or until another worker finishes, for requests waiting on the limit of requests per server) */
+			if (!pending) LogQueueEmpty();
 			Waitable_Wait(workerWaitable);
 		}
 	}
@@ -1370,11 +1598,16 @@ static void WorkerLoop(void) {
 static void HttpBackend_Add(struct HttpRequest* req, cc_uint8 flags) {
 #if defined CC_BUILD_PSP || defined CC_BUILD_NDS
 	/* TODO why doesn't threading work properly on PSP */
-	DoRequest(req);
+	DoRequest(&http_workers[0], req);
 #else
+	int pending;
 	Mutex_Lock(pendingMutex);
 	{
-		RequestList_Append(&pendingReqs, req, flags);
+		/* Requests are performed in the order they were added in each list */
+		RequestList_Append(flags & HTTP_FLAG_PRIORITY ? &priorityReqs : &pendingReqs, req, 0);
+
+		pending = priorityReqs.count + pendingReqs.count;
+		http_stats.peakPending = max(http_stats.peakPending, pending);
 	}
 	Mutex_Unlock(pendingMutex);
 	Waitable_Signal(workerWaitable);
@@ -1385,20 +1618,31 @@ static void HttpBackend_Add(struct HttpRequest* req, cc_uint8 flags) {
 *-----------------------------------------------------Http component------------------------------------------------------*
 *#########################################################################################################################*/
 static void Http_Init(void) {
+	int i, numWorkers;
 	Http_InitCommon();
-	http_curRequest.progress = HTTP_PROGRESS_NOT_WORKING_ON;
 	/* Http component gets initialised multiple times on Android */
-	if (workerThread) return;
+	if (workerThreads[0]) return;
 
 	HttpBackend_Init();
+	RequestList_Init(&priorityReqs);
 	RequestList_Init(&pendingReqs);
 	RequestList_Init(&processedReqs);
 
+	for (i = 0; i < HTTP_MAX_WORKERS; i++)
+	{
+		String_InitArray(http_workers[i].host, http_workers[i]._hostBuffer);
+		http_workers[i].cur.progress = HTTP_PROGRESS_NOT_WORKING_ON;
+	}
+
 	workerWaitable  = Waitable_Create("HTTP wakeup");
 	pendingMutex    = Mutex_Create("HTTP pending");
 	processedMutex  = Mutex_Create("HTTP processed");
 	curRequestMutex = Mutex_Create("HTTP current");
-	
-	Thread_Run(&workerThread, WorkerLoop, 128 * 1024, "HTTP");
+
+	numWorkers = Options_GetInt(OPT_HTTP_WORKERS, 1, HTTP_MAX_WORKERS, HTTP_DEF_WORKERS);
+	for (i = 0; i < numWorkers; i++)
+	{
+		Thread_Run(&workerThreads[i], WorkerLoop, 128 * 1024, "HTTP");
+	}
 }
 #endif
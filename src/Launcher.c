@@ -218,6 +218,8 @@ static void Launcher_Init(void) {
 
 	Utils_EnsureDirectory("texpacks");
 	Utils_EnsureDirectory("audio");
+	/* Default resources are compressed into default.zip */
+	Deflate_Init();
 }
 
 static void Launcher_Free(void) {
@@ -13,6 +13,12 @@
 #include "Options.h"
 #include "Builder.h"
 
+#if (defined __x86_64__ || defined _M_X64) && !defined CLASSIC_LIGHTING_DISABLE_SIMD
+	/* SSE2 is always available on x86_64 */
+	#define CLASSIC_LIGHTING_SIMD
+	#include <emmintrin.h>
+#endif
+
 const char* const LightingMode_Names[LIGHTING_MODE_COUNT] = { "Classic", "Fancy" };
 
 cc_uint8 Lighting_Mode;
@@ -213,12 +219,36 @@ static void ClassicLighting_ResetNeighbour(int x, int y, int z, BlockID block, i
 	}
 }
 
-static void ClassicLighting_ResetColumn(int cx, int cy, int cz, int minCy, int maxCy) {
-	if (minCy == maxCy) {
-		MapRenderer_RefreshChunk(cx, cy, cz);
-	} else {
-		for (cy = maxCy; cy >= minCy; cy--) {
-			MapRenderer_RefreshChunk(cx, cy, cz);
+/* Whether any blocks in the chunk might be drawn differently due to the light changing from minY to maxY in the column */
+/*  (i.e. are there any visible blocks in or directly around those cells of the column) */
+static cc_bool ClassicLighting_RangeAffects(int x, int z, int cy, int minY, int maxY) {
+	int x1 = max(x - 1, x & ~CHUNK_MASK), x2 = min(x + 1, min(x | CHUNK_MASK, World.MaxX));
+	int z1 = max(z - 1, z & ~CHUNK_MASK), z2 = min(z + 1, min(z | CHUNK_MASK, World.MaxZ));
+	int xx, y, zz;
+
+	minY = max(minY - 1, cy << CHUNK_SHIFT);
+	maxY = min(maxY + 1, min((cy << CHUNK_SHIFT) | CHUNK_MASK, World.MaxY));
+
+	for (y = minY; y <= maxY; y++) {
+		for (zz = z1; zz <= z2; zz++) {
+			for (xx = x1; xx <= x2; xx++)
+			{
+				if (Blocks.Draw[World_GetBlock(xx, y, zz)] != DRAW_GAS) return true;
+			}
+		}
+	}
+	return false;
+}
+
+/* Refreshes the chunks in the column whose light changed from minY to maxY */
+/* NOTE: Chunks whose cells around the changed range are all air are skipped, */
+/*  which avoids rebuilding chunks that the light change can't affect in tall worlds */
+static void ClassicLighting_ResetColumn(int x, int z, int minCy, int maxCy, int minY, int maxY) {
+	int cy;
+	for (cy = maxCy; cy >= minCy; cy--)
+	{
+		if (ClassicLighting_RangeAffects(x, z, cy, minY, maxY)) {
+			MapRenderer_RefreshChunk(x >> CHUNK_SHIFT, cy, z >> CHUNK_SHIFT);
 		}
 	}
 }
@@ -232,7 +262,13 @@ static void ClassicLighting_RefreshAffected(int x, int y, int z, BlockID block,
 	int newCy = newHeight < 0 ? 0 : newHeight >> 4;
 	int oldCy = oldHeight < 0 ? 0 : oldHeight >> 4;
 	int minCy = min(oldCy, newCy), maxCy = max(oldCy, newCy);
-	ClassicLighting_ResetColumn(cx, cy, cz, minCy, maxCy);
+
+	if (minCy == maxCy) {
+		MapRenderer_RefreshChunk(cx, cy, cz);
+	} else {
+		ClassicLighting_ResetColumn(x, z, minCy, maxCy,
+			max(min(oldHeight, newHeight), 0), max(oldHeight, newHeight) - 1);
+	}
 
 	if (bX == 0 && cx > 0) {
 		ClassicLighting_ResetNeighbour(x - 1, y, z, block, cx - 1, cy, cz, minCy, maxCy);
@@ -271,118 +307,204 @@ void ClassicLighting_OnBlockChanged(int x, int y, int z, BlockID oldBlock, Block
 
 
 /*########################################################################################################################*
-*---------------------------------------------------Lighting heightmap----------------------------------------------------*
+*-------------------------------------------------Batched lighting update-------------------------------------------------*
 *#########################################################################################################################*/
-static int Heightmap_InitialCoverage(int x1, int z1, int xCount, int zCount, int* skip) {
-	int elemsLeft = 0, index = 0, curRunCount = 0;
-	int x, z, hIndex, lightH;
-
-	for (z = 0; z < zCount; z++) {
-		hIndex = Lighting_Pack(x1, z1 + z);
-		for (x = 0; x < xCount; x++) {
-			lightH = classic_heightmap[hIndex++];
-
-			skip[index] = 0;
-			if (lightH == HEIGHT_UNCALCULATED) {
-				elemsLeft++;
-				curRunCount = 0;
-			} else {
-				skip[index - curRunCount]++;
-				curRunCount++;
-			}
-			index++;
+#ifdef CC_BUILD_LOWMEM
+	#define BATCH_MAX_CHANGES  256
+	#define BATCH_COLUMNS_BITS 9
+#else
+	#define BATCH_MAX_CHANGES  4096
+	#define BATCH_COLUMNS_BITS 13
+#endif
+#define BATCH_COLUMNS_SIZE (1 << BATCH_COLUMNS_BITS)
+
+/* NOTE: key is hIndex + 1, so that 0 means the slot is unused */
+static struct BatchColumn { int key; cc_int16 oldH, maxY; } batch_columns[BATCH_COLUMNS_SIZE];
+static cc_uint16 batch_usedSlots[BATCH_MAX_CHANGES];
+
+static cc_bool ClassicLighting_Affects(BlockID oldBlock, BlockID newBlock) {
+	/* Same early out checks as ClassicLighting_UpdateLighting */
+	if (Blocks.BlocksLight[oldBlock] != Blocks.BlocksLight[newBlock]) return true;
+	if (!Blocks.BlocksLight[oldBlock]) return false;
+	return ((Blocks.LightOffset[oldBlock] ^ Blocks.LightOffset[newBlock]) >> LIGHT_FLAG_SHADES_FROM_BELOW) & 1;
+}
+
+static int ClassicLighting_ColumnSlot(int key) {
+	int slot = (int)(((cc_uint32)key * 0x9E3779B1U) >> (32 - BATCH_COLUMNS_BITS));
+
+	while (batch_columns[slot].key && batch_columns[slot].key != key) 
+	{
+		slot = (slot + 1) & (BATCH_COLUMNS_SIZE - 1);
+	}
+	return slot;
+}
+
+static void ClassicLighting_UpdateBatch(const IVec3* coords, const BlockID* oldBlocks, const BlockID* newBlocks, int count) {
+	struct BatchColumn* col;
+	int i, key, slot, used = 0;
+	int x, y, z, minCy, maxCy;
+	int maxY, oldH, newH;
+
+	/* Find the highest change in each column that might affect lighting */
+	for (i = 0; i < count; i++) 
+	{
+		if (!ClassicLighting_Affects(oldBlocks[i], newBlocks[i])) continue;
+		key  = Lighting_Pack(coords[i].x, coords[i].z) + 1;
+		slot = ClassicLighting_ColumnSlot(key);
+		col  = &batch_columns[slot];
+
+		if (!col->key) {
+			col->key  = key;
+			col->oldH = classic_heightmap[key - 1];
+			col->maxY = -1;
+			batch_usedSlots[used++] = slot;
 		}
-		curRunCount = 0; /* We can only skip an entire X row at most. */
+		if (coords[i].y > col->maxY) col->maxY = coords[i].y;
+	}
+
+	/* Recalculate light height of each affected column just once */
+	for (i = 0; i < used; i++) 
+	{
+		col = &batch_columns[batch_usedSlots[i]];
+		/* Column never had meshes for any of its chunks built, so nothing to do */
+		if (col->oldH == HEIGHT_UNCALCULATED) continue;
+		/* Changes below the topmost block that blocks light can't change light height */
+		if (col->maxY + 1 < col->oldH) continue;
+
+		x = (col->key - 1) % World.Width;
+		z = (col->key - 1) / World.Width;
+
+		/* Blocks above both this and the old light height are unchanged and don't block light */
+		maxY = min(World.MaxY, max(col->maxY, col->oldH + 1));
+		newH = ClassicLighting_CalcHeightAt(x, maxY, z, col->key - 1);
+		if (newH == col->oldH) continue;
+
+		/* Same chunks as ClassicLighting_RefreshAffected resets in the changed column */
+		minCy = min(col->oldH, newH) + 1; minCy = minCy < 0 ? 0 : minCy >> CHUNK_SHIFT;
+		maxCy = max(col->oldH, newH) + 1; maxCy = maxCy < 0 ? 0 : maxCy >> CHUNK_SHIFT;
+
+		ClassicLighting_ResetColumn(x, z, minCy, maxCy,
+			max(min(col->oldH, newH) + 1, 0), max(col->oldH, newH));
+	}
+
+	/* Chunks that neighbour a changed block might also need to be redrawn */
+	/*  (changed block's chunk and column are already refreshed above or by MapRenderer) */
+	for (i = 0; i < count; i++) 
+	{
+		x = coords[i].x; y = coords[i].y; z = coords[i].z;
+		if (((x + 1) & CHUNK_MASK) > 1 && ((y + 1) & CHUNK_MASK) > 1 && ((z + 1) & CHUNK_MASK) > 1) continue;
+
+		key  = Lighting_Pack(x, z) + 1;
+		newH = classic_heightmap[key - 1];
+		col  = used ? &batch_columns[ClassicLighting_ColumnSlot(key)] : NULL;
+		oldH = col && col->key ? col->oldH : newH;
+
+		if (oldH == HEIGHT_UNCALCULATED) continue;
+		ClassicLighting_RefreshAffected(x, y, z, newBlocks[i], oldH + 1, newH + 1);
+	}
+
+	for (i = 0; i < used; i++) 
+	{
+		batch_columns[batch_usedSlots[i]].key = 0;
 	}
-	return elemsLeft;
 }
 
-#define Heightmap_CalculateBody(get_block)\
-for (y = World.Height - 1; y >= 0; y--) {\
-	if (elemsLeft <= 0) { return true; } \
-	mapIndex = World_Pack(x1, y, z1);\
-	hIndex   = Lighting_Pack(x1, z1);\
-\
-	for (z = 0; z < zCount; z++) {\
-		baseIndex = mapIndex;\
-		index = z * xCount;\
-		for (x = 0; x < xCount;) {\
-			curRunCount = skip[index];\
-			x += curRunCount; mapIndex += curRunCount; index += curRunCount;\
-\
-			if (x < xCount && Blocks.BlocksLight[get_block]) {\
-				lightOffset = (Blocks.LightOffset[get_block] >> LIGHT_FLAG_SHADES_FROM_BELOW) & 1;\
-				classic_heightmap[hIndex + x] = (cc_int16)(y - lightOffset);\
-				elemsLeft--;\
-				skip[index] = 0;\
-\
-				offset = prevRunCount + curRunCount;\
-				newRunCount = skip[index - offset] + 1;\
-\
-				/* consider case 1 0 1 0, where we are at last 0 */ \
-				/* we need to make this 3 0 0 0 and advance by 1 */ \
-				oldRunCount = (x - offset + newRunCount) < xCount ? skip[index - offset + newRunCount] : 0; \
-				if (oldRunCount != 0) {\
-					skip[index - offset + newRunCount] = 0; \
-					newRunCount += oldRunCount; \
-				} \
-				skip[index - offset] = newRunCount; \
-				x += oldRunCount; index += oldRunCount; mapIndex += oldRunCount; \
-				prevRunCount = newRunCount; \
-			} else { \
-				prevRunCount = 0; \
-			}\
-			x++; mapIndex++; index++; \
-		}\
-		prevRunCount = 0;\
-		hIndex += World.Width;\
-		mapIndex = baseIndex + World.Width; /* advance one Z */ \
-	}\
+void ClassicLighting_OnBlocksChanged(const IVec3* coords, const BlockID* oldBlocks, const BlockID* newBlocks, int count) {
+	int i, n;
+
+	for (i = 0; i < count; i += BATCH_MAX_CHANGES) 
+	{
+		n = min(count - i, BATCH_MAX_CHANGES);
+		ClassicLighting_UpdateBatch(coords + i, oldBlocks + i, newBlocks + i, n);
+	}
 }
 
-static cc_bool Heightmap_CalculateCoverage(int x1, int z1, int xCount, int zCount, int elemsLeft, int* skip) {
-	int prevRunCount = 0, curRunCount, newRunCount, oldRunCount;
-	int lightOffset, offset;
-	int mapIndex, hIndex, baseIndex, index;
-	int x, y, z;
 
-#ifndef EXTENDED_BLOCKS
-	Heightmap_CalculateBody(World.Blocks[mapIndex]);
+/*########################################################################################################################*
+*---------------------------------------------------Lighting heightmap----------------------------------------------------*
+*#########################################################################################################################*/
+/* Number of adjacent columns whose light height is calculated together */
+#define HEIGHTMAP_GROUP 16
+
+#ifdef CLASSIC_LIGHTING_SIMD
+/* Returns a bitmask of which of the 16 blocks are not air */
+static int Heightmap_NonAirMask(const BlockRaw* blocks) {
+	__m128i row = _mm_loadu_si128((const __m128i*)blocks);
+	return ~_mm_movemask_epi8(_mm_cmpeq_epi8(row, _mm_setzero_si128())) & 0xFFFF;
+}
 #else
-	if (World.IDMask <= 0xFF) {
-		Heightmap_CalculateBody(World.Blocks[mapIndex]);
-	} else {
-		Heightmap_CalculateBody(World.Blocks[mapIndex] | (World.Blocks2[mapIndex] << 8));
+/* Returns a bitmask of which of the 16 blocks are not air */
+static int Heightmap_NonAirMask(const BlockRaw* blocks) {
+	int i, mask = 0;
+	for (i = 0; i < HEIGHTMAP_GROUP; i++)
+	{
+		if (blocks[i]) mask |= 1 << i;
 	}
-#endif
-	return false;
+	return mask;
 }
+#endif
 
-static void Heightmap_FinishCoverage(int x1, int z1, int xCount, int zCount) {
-	int x, z, hIndex, lightH;
+/* Calculates the light height of 16 adjacent columns, by scanning down through the same Y of all the columns at once */
+/* NOTE: Since most of a column above its light height is usually air, only non-air blocks need to be checked individually */
+static void Heightmap_CalculateGroup(int x1, int z) {
+	int hIndex = Lighting_Pack(x1, z);
+	int pending = 0, mask, index, i, y;
+	BlockID block;
 
-	for (z = 0; z < zCount; z++) {
-		hIndex = Lighting_Pack(x1, z1 + z);
-		for (x = 0; x < xCount; x++, hIndex++) {
-			lightH = classic_heightmap[hIndex];
+	for (i = 0; i < HEIGHTMAP_GROUP; i++)
+	{
+		if (classic_heightmap[hIndex + i] == HEIGHT_UNCALCULATED) pending |= 1 << i;
+	}
+	index = World_Pack(x1, World.MaxY, z);
 
-			if (lightH == HEIGHT_UNCALCULATED) {
-				classic_heightmap[hIndex] = -10;
-			}
+	for (y = World.MaxY; y >= 0 && pending; y--, index -= World.OneY)
+	{
+		mask = Heightmap_NonAirMask(World.Blocks + index);
+#ifdef EXTENDED_BLOCKS
+		if (World.IDMask > 0xFF) mask |= Heightmap_NonAirMask(World.Blocks2 + index);
+#endif
+		mask &= pending;
+
+		for (i = 0; mask; i++, mask >>= 1)
+		{
+			if (!(mask & 1)) continue;
+			block = World_GetBlock(x1 + i, y, z);
+			if (!Blocks.BlocksLight[block]) continue;
+
+			classic_heightmap[hIndex + i] = y - ((Blocks.LightOffset[block] >> LIGHT_FLAG_SHADES_FROM_BELOW) & 1);
+			pending &= ~(1 << i);
 		}
 	}
-}
 
+	for (i = 0; pending; i++, pending >>= 1)
+	{
+		if (pending & 1) classic_heightmap[hIndex + i] = -10;
+	}
+}
 
 void ClassicLighting_LightHint(int startX, int startY, int startZ) {
 	int x1 = max(startX, 0), x2 = min(World.Width,  startX + EXTCHUNK_SIZE);
 	int z1 = max(startZ, 0), z2 = min(World.Length, startZ + EXTCHUNK_SIZE);
-	int xCount = x2 - x1, zCount = z2 - z1;
-	int skip[EXTCHUNK_SIZE * EXTCHUNK_SIZE];
+	int x, z;
+
+	/* Columns can only be skipped over when air doesn't block light (e.g. custom block definitions) */
+	if (Blocks.BlocksLight[BLOCK_AIR] || x2 - x1 < HEIGHTMAP_GROUP) {
+		for (z = z1; z < z2; z++)
+			for (x = x1; x < x2; x++)
+		{
+			ClassicLighting_GetLightHeight(x, z);
+		}
+		return;
+	}
 
-	int elemsLeft = Heightmap_InitialCoverage(x1, z1, xCount, zCount, skip);
-	if (!Heightmap_CalculateCoverage(x1, z1, xCount, zCount, elemsLeft, skip)) {
-		Heightmap_FinishCoverage(x1, z1, xCount, zCount);
+	for (z = z1; z < z2; z++)
+	{
+		for (x = x1; x + HEIGHTMAP_GROUP <= x2; x += HEIGHTMAP_GROUP)
+		{
+			Heightmap_CalculateGroup(x, z);
+		}
+		/* Last group overlaps the previous group, whose columns are already calculated by then */
+		if (x < x2) Heightmap_CalculateGroup(x2 - HEIGHTMAP_GROUP, z);
 	}
 }
 
@@ -1,6 +1,7 @@
 #ifndef CC_WORLDLIGHTING_H
 #define CC_WORLDLIGHTING_H
 #include "PackedCol.h"
+#include "Vectors.h"
 CC_BEGIN_HEADER
 
 /*
@@ -86,6 +87,10 @@ void ClassicLighting_LightHint(int startX, int startY, int startZ);
 cc_bool ClassicLighting_IsLit(int x, int y, int z);
 cc_bool ClassicLighting_IsLit_Fast(int x, int y, int z);
 void ClassicLighting_OnBlockChanged(int x, int y, int z, BlockID oldBlock, BlockID newBlock);
+/* Same as calling ClassicLighting_OnBlockChanged for each changed block, but */
+/*  recalculates the light height of each affected column at most once */
+/* NOTE: All of the blocks must have already been changed in the world */
+void ClassicLighting_OnBlocksChanged(const IVec3* coords, const BlockID* oldBlocks, const BlockID* newBlocks, int count);
 
 CC_END_HEADER
 #endif
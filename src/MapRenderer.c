@@ -44,6 +44,12 @@ static int renderChunksCount;
 static cc_uint32* distances;
 /* Maximum number of chunk updates that can be performed in one frame. */
 static int maxChunkUpdates;
+/* Number of layers of the world (from the bottom) which have been loaded. */
+static int loadedHeight;
+#define MAX_CHUNK_UPDATES 1024
+/* Chunks queued to be built together at the end of updating chunks. */
+static struct ChunkInfo* pendingChunks[MAX_CHUNK_UPDATES];
+static int pendingCount;
 /* Cached number of chunks in the world */
 static int chunksCount;
 
@@ -354,15 +360,11 @@ static void DeleteChunk(struct ChunkInfo* info) {
 	}
 }
 
-/* Builds the mesh (hence vertex buffer) for the given chunk, and updates internal state */
-static void BuildChunk(struct ChunkInfo* info, int* chunkUpdates) {
+/* Updates internal state after the mesh (hence vertex buffer) for the given chunk has been built */
+static void FinishChunk(struct ChunkInfo* info) {
 	struct ChunkPartInfo* ptr;
 	int i;
 
-	Game.ChunkUpdates++;
-	(*chunkUpdates)++;
-	Builder_MakeChunk(info);
-
 	info->dirty  = false;
 	info->noData = !info->normalParts && !info->translucentParts;
 	info->empty  = info->noData;
@@ -383,6 +385,31 @@ static void BuildChunk(struct ChunkInfo* info, int* chunkUpdates) {
 	}
 }
 
+/* Builds the mesh (hence vertex buffer) for the given chunk, and updates internal state */
+/* NOTE: When worker threads are enabled, the chunk is only queued to be built in FlushPendingChunks */
+static void BuildChunk(struct ChunkInfo* info, int* chunkUpdates) {
+	Game.ChunkUpdates++;
+	(*chunkUpdates)++;
+
+	if (WorkerPool_Threads() > 1) {
+		pendingChunks[pendingCount++] = info; return;
+	}
+	Builder_MakeChunk(info);
+	FinishChunk(info);
+}
+
+/* Builds the meshes for all the chunks queued by BuildChunk in parallel */
+static void FlushPendingChunks(void) {
+	int i;
+	if (!pendingCount) return;
+	Builder_MakeChunks(pendingChunks, pendingCount);
+
+	for (i = 0; i < pendingCount; i++) {
+		FinishChunk(pendingChunks[i]);
+	}
+	pendingCount = 0;
+}
+
 
 /*########################################################################################################################*
 *----------------------------------------------------Chunks mangagement---------------------------------------------------*
@@ -537,6 +564,11 @@ static int AdjustDist(int dist) {
 	return (dist + 24) * (dist + 24);
 }
 
+/* Whether all the blocks a chunk's mesh depends on (including the layer above) have been loaded */
+#define ChunkIsLoaded(info) (min((info)->centreY + HALF_CHUNK_SIZE + 1, World.Height) <= loadedHeight)
+
+void MapRenderer_SetLoadedHeight(int height) { loadedHeight = height; }
+
 static void CalcViewDists(void) {
 	buildDistSquared  = AdjustDist(Game_UserViewDistance);
 	renderDistSquared = AdjustDist(Game_ViewDistance);
@@ -563,7 +595,7 @@ static int UpdateChunksAndVisibility(int* chunkUpdates) {
 		}
 		noData |= info->dirty;
 
-		if (noData && distSqr <= buildDistSqr && *chunkUpdates < chunksTarget) {
+		if (noData && distSqr <= buildDistSqr && *chunkUpdates < chunksTarget && ChunkIsLoaded(info)) {
 			DeleteChunk(info);
 			BuildChunk(info, chunkUpdates);
 		}
@@ -596,7 +628,7 @@ static int UpdateChunksStill(int* chunkUpdates) {
 		}
 		noData |= info->dirty;
 
-		if (noData && distSqr <= buildDistSqr && *chunkUpdates < chunksTarget) {
+		if (noData && distSqr <= buildDistSqr && *chunkUpdates < chunksTarget && ChunkIsLoaded(info)) {
 			DeleteChunk(info);
 			BuildChunk(info, chunkUpdates);
 
@@ -627,6 +659,7 @@ static void UpdateChunks(float delta) {
 	renderChunksCount = samePos ?
 		UpdateChunksStill(&chunkUpdates) :
 		UpdateChunksAndVisibility(&chunkUpdates);
+	FlushPendingChunks();
 
 	lastCamPos = Camera.CurrentPos;
 	lastPitch  = p->Base.Pitch;
@@ -784,7 +817,8 @@ static void OnNewMapLoaded(void) {
 	/*}*/
 
 	InitChunks();
-	lastCamPos = Vec3_BigPos();
+	lastCamPos   = Vec3_BigPos();
+	loadedHeight = World.Height;
 }
 
 static void OnInit(void) {
@@ -800,7 +834,7 @@ static void OnInit(void) {
 	/* This = 87 fixes map being invisible when no textures */
 	MapRenderer_1DUsedCount = 87; /* Atlas1D_UsedAtlasesCount(); */
 	chunkPos   = IVec3_MaxValue();
-	maxChunkUpdates = Options_GetInt(OPT_MAX_CHUNK_UPDATES, 4, 1024, 30);
+	maxChunkUpdates = Options_GetInt(OPT_MAX_CHUNK_UPDATES, 4, MAX_CHUNK_UPDATES, 30);
 	CalcViewDists();
 }
 
@@ -77,6 +77,9 @@ void MapRenderer_RefreshChunk(int cx, int cy, int cz);
 void MapRenderer_OnBlockChanged(int x, int y, int z, BlockID block);
 /* Deletes all chunks and resets internal state. */
 void MapRenderer_Refresh(void);
+/* Only builds chunks which lie entirely within the given number of layers from the bottom of the world. */
+/* NOTE: Used when showing a world that is still being loaded. Reset to World.Height on new map loaded. */
+void MapRenderer_SetLoadedHeight(int height);
 
 CC_END_HEADER
 #endif
@@ -1333,12 +1333,29 @@ static void SaveLevelScreen_RemoveOverwrites(struct SaveLevelScreen* s) {
 static cc_result DoSaveMap(const cc_string* path, struct GZipState* state) {
 	static const cc_string schematic = String_FromConst(".schematic");
 	static const cc_string mine      = String_FromConst(".mine");
+	static const cc_string ccw       = String_FromConst(".ccw");
 	struct Stream stream, compStream;
 	cc_result res;
+	int level;
 
 	res = Stream_CreateFile(&stream, path);
 	if (res) { Logger_SysWarn2(res, "creating", path); return res; }
-	GZip_MakeStream(&compStream, state, &stream);
+
+	/* Chunked format does its own (much faster) compression */
+	if (String_CaselessEnds(path, &ccw)) {
+		res = Ccw_Save(&stream, true);
+		if (res) {
+			stream.Close(&stream);
+			Logger_SysWarn2(res, "encoding", path); return res;
+		}
+
+		res = stream.Close(&stream);
+		if (res) { Logger_SysWarn2(res, "closing", path); return res; }
+		return 0;
+	}
+	/* Map is compressed on the main thread, so default to a level that is fast enough for large maps */
+	level = Options_GetInt(OPT_MAP_COMPRESSION, DEFLATE_LEVEL_FAST, DEFLATE_LEVEL_MAX, DEFLATE_LEVEL_DEFAULT);
+	GZip_MakeStream2(&compStream, state, &stream, level);
 
 	if (String_CaselessEnds(path, &schematic)) {
 		res = Schematic_Save(&compStream);
@@ -1416,10 +1433,10 @@ static void SaveLevelScreen_UploadCallback(const cc_string* path) {
 
 static void SaveLevelScreen_File(void* screen, void* b) {
 	static const char* const titles[] = {
-		"ClassiCube map", "Minecraft schematic", "Minecraft classic map", NULL
+		"ClassiCube map", "Minecraft schematic", "Minecraft classic map", "ClassiCube chunked map", NULL
 	};
 	static const char* const filters[] = {
-		".cw", ".schematic", ".mine", NULL
+		".cw", ".schematic", ".mine", ".ccw", NULL
 	};
 	struct SaveLevelScreen* s = (struct SaveLevelScreen*)screen;
 	struct SaveFileDialogArgs args;
@@ -1817,7 +1834,7 @@ static void LoadLevelScreen_LoadEntries(struct ListScreen* s) {
 static void LoadLevelScreen_UploadCallback(const cc_string* path) { Map_LoadFrom(path); }
 static void LoadLevelScreen_ActionFunc(void* s, void* w) {
 	static const char* const filters[] = { 
-		".cw", ".dat", ".lvl", ".mine", ".fcm", ".mclevel", NULL 
+		".cw", ".dat", ".lvl", ".mine", ".fcm", ".mclevel", ".ccw", NULL 
 	}; /* TODO not hardcode list */
 	static struct OpenFileDialogArgs args = {
 		"Classic map files", filters,
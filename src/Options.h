@@ -13,6 +13,7 @@ Copyright 2014-2023 ClassiCube | Licensed under BSD-3
 #define OPT_FORCE_OPENAL "forceopenal"
 #define OPT_MIN_MUSIC_DELAY "music-mindelay"
 #define OPT_MAX_MUSIC_DELAY "music-maxdelay"
+#define OPT_AUDIO_MIXER "audio-mixer"
 
 #define OPT_VIEW_DISTANCE "viewdist"
 #define OPT_BLOCK_PHYSICS "singleplayerphysics"
@@ -71,6 +72,11 @@ Copyright 2014-2023 ClassiCube | Licensed under BSD-3
 #define OPT_CLASSIC_CHAT "nostalgia-classicchat"
 #define OPT_CLASSIC_INVENTORY "nostalgia-classicinventory"
 #define OPT_MAX_CHUNK_UPDATES "gfx-maxchunkupdates"
+#define OPT_WORKER_THREADS "worker-threads"
+#define OPT_NET_THREAD "net-thread"
+#define OPT_PROGRESSIVE_MAP "net-progressive-map"
+#define OPT_AUTOSAVE_INTERVAL "autosave-interval"
+#define OPT_MAP_COMPRESSION "map-compression"
 #define OPT_CAMERA_MASS "cameramass"
 #define OPT_CAMERA_SMOOTH "camera-smooth"
 #define OPT_GRAB_CURSOR "win-grab-cursor"
@@ -79,7 +85,9 @@ Copyright 2014-2023 ClassiCube | Licensed under BSD-3
 #define OPT_TOUCH_SCALE "gui-touchscale"
 #define OPT_HTTP_ONLY "http-no-https"
 #define OPT_HTTPS_VERIFY "https-verify"
+#define OPT_HTTP_WORKERS "http-workers"
 #define OPT_SKIN_SERVER "http-skinserver"
+#define OPT_SKIN_CACHE_SIZE "http-skincachesize"
 #define OPT_RAW_INPUT "win-raw-input"
 #define OPT_DPI_SCALING "win-dpi-scaling"
 #define OPT_GAME_VERSION "game-version"
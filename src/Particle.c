@@ -592,10 +592,10 @@ static void Particles_Tick(struct ScheduledTask* task) {
 /*########################################################################################################################*
 *---------------------------------------------------Particles component---------------------------------------------------*
 *#########################################################################################################################*/
-static void ParticlesPngProcess(struct Stream* stream, const cc_string* name) {
-	Game_UpdateTexture(&particles_TexId, stream, name, NULL, NULL);
+static void ParticlesPngProcess(struct Bitmap* bmp, const cc_string* name) {
+	Game_UpdateTextureBitmap(&particles_TexId, bmp, name, NULL, NULL);
 }
-static struct TextureEntry particles_entry = { "particles.png", ParticlesPngProcess };
+static struct TextureEntry particles_entry = { "particles.png", NULL, ParticlesPngProcess };
 
 
 static void OnContextLost(void* obj) {
@@ -280,6 +280,21 @@ cc_result File_Position(cc_file file, cc_uint32* pos);
 /* Attempts to retrieve the length of the given file. */
 cc_result File_Length(cc_file file, cc_uint32* len);
 
+#if defined CC_BUILD_WIN || (defined CC_BUILD_POSIX && !defined CC_BUILD_BEOS && !defined CC_BUILD_OS2)
+#define CC_BUILD_FILEMAPPING
+/* Attempts to map the first length bytes of the given file into memory as readonly. */
+/* NOTE: The mapped memory remains valid even after the file is closed. */
+cc_result File_Map(cc_file file, cc_uint32 length, void** data);
+/* Unmaps memory previously mapped by File_Map. */
+void File_Unmap(void* data, cc_uint32 length);
+#endif
+
+#if defined CC_BUILD_WIN || defined CC_BUILD_POSIX
+#define CC_BUILD_FILERENAME
+/* Attempts to rename the given file, replacing the destination file if it exists. */
+cc_result File_Rename(const cc_filepath* src, const cc_filepath* dst);
+#endif
+
 
 /*########################################################################################################################*
 *---------------------------------------------------------Threading-------------------------------------------------------*
@@ -359,6 +374,12 @@ extern const cc_result ReturnCode_SocketDropped;
 cc_result Socket_CheckReadable(cc_socket s, cc_bool* readable);
 /* Checks if the given socket is currently writable (i.e. has finished connecting) */
 cc_result Socket_CheckWritable(cc_socket s, cc_bool* writable);
+#if defined CC_BUILD_WIN || defined CC_BUILD_POSIX
+#define CC_BUILD_SOCKETWAIT
+/* Blocks the calling thread until the given socket is readable, or milliseconds delay passes */
+/* NOTE: A closed socket is also considered readable */
+cc_result Socket_WaitReadable(cc_socket s, cc_uint32 milliseconds, cc_bool* readable);
+#endif
 /* If the input represents an IP address, then parses the input into a single IP address */
 /* Otherwise, attempts to resolve the input via DNS into one or more IP addresses */
 cc_result Socket_ParseAddress(const cc_string* address, int port, cc_sockaddr* addrs, int* numValidAddrs);
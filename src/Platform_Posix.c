@@ -24,6 +24,7 @@
 #include <sys/ioctl.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <sys/time.h>
 #include <utime.h>
 #include <signal.h>
@@ -393,6 +394,21 @@ cc_result File_Length(cc_file file, cc_uint32* len) {
 	*len = st.st_size; return 0;
 }
 
+cc_result File_Map(cc_file file, cc_uint32 length, void** data) {
+	void* ptr = mmap(NULL, length, PROT_READ, MAP_PRIVATE, file, 0);
+	if (ptr == MAP_FAILED) return errno;
+
+	*data = ptr; return 0;
+}
+
+void File_Unmap(void* data, cc_uint32 length) {
+	munmap(data, length);
+}
+
+cc_result File_Rename(const cc_filepath* src, const cc_filepath* dst) {
+	return rename(src->buffer, dst->buffer) == -1 ? errno : 0;
+}
+
 
 /*########################################################################################################################*
 *--------------------------------------------------------Threading--------------------------------------------------------*
@@ -779,11 +795,13 @@ void Socket_Close(cc_socket s) {
 #if defined CC_BUILD_DARWIN || defined CC_BUILD_BEOS
 /* poll is broken on old OSX apparently https://daniel.haxx.se/docs/poll-vs-select.html */
 /* BeOS lacks support for poll */
-static cc_result Socket_Poll(cc_socket s, int mode, cc_bool* success) {
+static cc_result Socket_Poll(cc_socket s, int mode, cc_uint32 timeout, cc_bool* success) {
 	fd_set set;
-	struct timeval time = { 0 };
+	struct timeval time;
 	int selectCount;
 
+	time.tv_sec  = timeout / 1000;
+	time.tv_usec = (timeout % 1000) * 1000;
 	FD_ZERO(&set);
 	FD_SET(s, &set);
 
@@ -798,13 +816,13 @@ static cc_result Socket_Poll(cc_socket s, int mode, cc_bool* success) {
 }
 #else
 #include <poll.h>
-static cc_result Socket_Poll(cc_socket s, int mode, cc_bool* success) {
+static cc_result Socket_Poll(cc_socket s, int mode, cc_uint32 timeout, cc_bool* success) {
 	struct pollfd pfd;
 	int flags;
 
 	pfd.fd     = s;
 	pfd.events = mode == SOCKET_POLL_READ ? POLLIN : POLLOUT;
-	if (poll(&pfd, 1, 0) == -1) { *success = false; return errno; }
+	if (poll(&pfd, 1, (int)timeout) == -1) { *success = false; return errno; }
 	
 	/* to match select, closed socket still counts as readable */
 	flags    = mode == SOCKET_POLL_READ ? (POLLIN | POLLHUP) : POLLOUT;
@@ -814,12 +832,18 @@ static cc_result Socket_Poll(cc_socket s, int mode, cc_bool* success) {
 #endif
 
 cc_result Socket_CheckReadable(cc_socket s, cc_bool* readable) {
-	return Socket_Poll(s, SOCKET_POLL_READ, readable);
+	return Socket_Poll(s, SOCKET_POLL_READ, 0, readable);
+}
+
+cc_result Socket_WaitReadable(cc_socket s, cc_uint32 milliseconds, cc_bool* readable) {
+	cc_result res = Socket_Poll(s, SOCKET_POLL_READ, milliseconds, readable);
+	/* Being interrupted by a signal while waiting isn't an error */
+	return res == EINTR ? 0 : res;
 }
 
 cc_result Socket_CheckWritable(cc_socket s, cc_bool* writable) {
 	socklen_t resultSize = sizeof(socklen_t);
-	cc_result res = Socket_Poll(s, SOCKET_POLL_WRITE, writable);
+	cc_result res = Socket_Poll(s, SOCKET_POLL_WRITE, 0, writable);
 	if (res || *writable) return res;
 
 	/* https://stackoverflow.com/questions/29479953/so-error-value-after-successful-socket-operation */
@@ -408,6 +408,33 @@ cc_result File_Length(cc_file file, cc_uint32* len) {
 	return *len != INVALID_FILE_SIZE ? 0 : GetLastError();
 }
 
+cc_result File_Map(cc_file file, cc_uint32 length, void** data) {
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	cc_result res  = 0;
+	if (!mapping) return GetLastError();
+
+	*data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, length);
+	if (!(*data)) res = GetLastError();
+
+	/* The view keeps the mapping alive, so the handle is no longer needed */
+	CloseHandle(mapping);
+	return res;
+}
+
+void File_Unmap(void* data, cc_uint32 length) {
+	UnmapViewOfFile(data);
+}
+
+cc_result File_Rename(const cc_filepath* src, const cc_filepath* dst) {
+	cc_result res;
+	if (MoveFileExW(src->uni, dst->uni, MOVEFILE_REPLACE_EXISTING)) return 0;
+	if ((res = GetLastError()) != ERROR_CALL_NOT_IMPLEMENTED) return res;
+
+	/* Windows 9x does not support MoveFileEx */
+	DeleteFileA(dst->ansi);
+	return MoveFileA(src->ansi, dst->ansi) ? 0 : GetLastError();
+}
+
 
 /*########################################################################################################################*
 *--------------------------------------------------------Threading--------------------------------------------------------*
@@ -690,11 +717,13 @@ void Socket_Close(cc_socket s) {
 	_closesocket(s);
 }
 
-static cc_result Socket_Poll(cc_socket s, int mode, cc_bool* success) {
+static cc_result Socket_Poll(cc_socket s, int mode, cc_uint32 timeout, cc_bool* success) {
 	fd_set set;
-	struct timeval time = { 0 };
+	struct timeval time;
 	int selectCount;
 
+	time.tv_sec     = timeout / 1000;
+	time.tv_usec    = (timeout % 1000) * 1000;
 	set.fd_count    = 1;
 	set.fd_array[0] = s;
 
@@ -710,12 +739,16 @@ static cc_result Socket_Poll(cc_socket s, int mode, cc_bool* success) {
 }
 
 cc_result Socket_CheckReadable(cc_socket s, cc_bool* readable) {
-	return Socket_Poll(s, SOCKET_POLL_READ, readable);
+	return Socket_Poll(s, SOCKET_POLL_READ, 0, readable);
+}
+
+cc_result Socket_WaitReadable(cc_socket s, cc_uint32 milliseconds, cc_bool* readable) {
+	return Socket_Poll(s, SOCKET_POLL_READ, milliseconds, readable);
 }
 
 cc_result Socket_CheckWritable(cc_socket s, cc_bool* writable) {
 	int resultSize = sizeof(cc_result);
-	cc_result res  = Socket_Poll(s, SOCKET_POLL_WRITE, writable);
+	cc_result res  = Socket_Poll(s, SOCKET_POLL_WRITE, 0, writable);
 	if (res || *writable) return res;
 
 	/* https://stackoverflow.com/questions/29479953/so-error-value-after-successful-socket-operation */
@@ -33,6 +33,7 @@
 #include "InputHandler.h"
 #include "HeldBlockRenderer.h"
 #include "Options.h"
+#include "MapRenderer.h"
 
 struct _ProtocolData Protocol;
 
@@ -44,6 +45,7 @@ static cc_bool map_begunLoading;
 static cc_uint64 map_receiveBeg;
 static struct Stream map_part;
 static int map_volume;
+static cc_bool map_allocFailedShown;
 
 /*########################################################################################################################*
 *-----------------------------------------------------CPE extensions------------------------------------------------------*
@@ -382,6 +384,16 @@ static CC_INLINE void MapState_SkipHeader(struct MapState* m) {
 	m->sizeIndex     = MAP_SIZE_LEN;
 }
 
+void Classic_PublishMapProgress(struct MapProgress* progress) {
+	progress->blocks      = map1.blocks;
+	progress->index       = map1.index;
+	progress->volume      = map_volume;
+	progress->allocFailed = map1.allocFailed;
+#ifdef EXTENDED_BLOCKS
+	progress->allocFailed |= map2.allocFailed;
+#endif
+}
+
 static void FreeMapStates(void) {
 	Mem_Free(map1.blocks);
 	map1.blocks = NULL;
@@ -413,7 +425,7 @@ static cc_result MapState_Read(struct MapState* m) {
 		m->blocks = (BlockRaw*)Mem_TryAlloc(map_volume, 1);
 		/* unlikely but possible */
 		if (!m->blocks) {
-			Window_ShowDialog("Out of memory", "Not enough free memory to join that map.\nTry joining a different map.");
+			/* NOTE: Dialog is shown later, as this may be called on the network receive thread */
 			m->allocFailed = true;
 			return 0;
 		}
@@ -427,6 +439,107 @@ static cc_result MapState_Read(struct MapState* m) {
 }
 
 
+/*########################################################################################################################*
+*-------------------------------------------------------Map preview-------------------------------------------------------*
+*#########################################################################################################################*/
+/* The map's dimensions are only sent after all of its blocks, so the map usually can't be shown until it has */
+/*  been completely received. However, when the volume is known upfront (FastMap), the dimensions can often be */
+/*  guessed. In that case the completely received layers are shown while the rest of the map is still arriving */
+static cc_bool map_previewing;
+static int map_previewWidth, map_previewHeight, map_previewLength;
+/* Number of bytes of map1 copied into the preview world so far */
+static int map_previewCopied;
+static int map_lastWidth, map_lastHeight, map_lastLength;
+static int map_edgeHeight, map_cloudsHeight;
+
+static void MapPreview_Guess(void) {
+	int size;
+	map_previewHeight = 0;
+	if (!map_volume || !Options_GetBool(OPT_PROGRESSIVE_MAP, false)) return;
+
+	/* Rejoining the same map (e.g. after a /reload) is common */
+	if (map_lastWidth * map_lastHeight * map_lastLength == map_volume) {
+		map_previewWidth  = map_lastWidth;
+		map_previewHeight = map_lastHeight;
+		map_previewLength = map_lastLength;
+		return;
+	}
+
+	/* Otherwise assume the map is square, with the default height of 64 */
+	size = (int)(Math_SqrtF((float)(map_volume / 64)) + 0.5f);
+	if (size < CHUNK_SIZE || size * size * 64 != map_volume) return;
+
+	map_previewWidth  = size;
+	map_previewHeight = 64;
+	map_previewLength = size;
+}
+
+/* Copies any newly completed layers of the map into the preview world */
+static void MapPreview_Update(const struct MapProgress* progress) {
+	int layerSize, layers, end;
+	BlockRaw* blocks;
+	if (!map_previewHeight || !progress->blocks) return;
+
+	layerSize = map_previewWidth * map_previewLength;
+	layers    = min(progress->index / layerSize, map_previewHeight);
+	end       = layers * layerSize;
+	if (end <= map_previewCopied) return;
+
+	if (!map_previewing) {
+		/* No point showing the map until at least one row of chunks can be built */
+		if (layers < min(CHUNK_SIZE + 1, map_previewHeight)) return;
+
+		/* A separate copy is used, as the world's blocks may be freed at any time (e.g. disconnecting) */
+		/*  while the network receive thread is still decompressing into map1's blocks */
+		blocks = (BlockRaw*)Mem_TryAllocCleared(progress->volume, 1);
+		if (!blocks) { map_previewHeight = 0; return; }
+		Mem_Copy(blocks, progress->blocks, end);
+
+		map_edgeHeight   = Env.EdgeHeight;
+		map_cloudsHeight = Env.CloudsHeight;
+		map_previewing   = true;
+		World_SetNewMap(blocks, map_previewWidth, map_previewHeight, map_previewLength);
+	} else {
+		Mem_Copy(World.Blocks + map_previewCopied, progress->blocks + map_previewCopied, end - map_previewCopied);
+#ifdef CC_BUILD_BLOCKSTORE
+		World_UpdateStore(map_previewCopied, end - map_previewCopied);
+#endif
+	}
+
+	map_previewCopied = end;
+	MapRenderer_SetLoadedHeight(layers);
+}
+
+/* Takes the blocks array of the preview world back from the world */
+static BlockRaw* MapPreview_Take(void) {
+	BlockRaw* blocks = World.Blocks;
+	map_previewing   = false;
+	World.Blocks     = NULL;
+	Chat_AddOf(&String_Empty, MSG_TYPE_EXTRASTATUS_1);
+
+#ifdef EXTENDED_BLOCKS
+	/* The user may have placed a block over ID 256 in the preview */
+	if (World.Blocks2 != blocks) Mem_Free(World.Blocks2);
+	World.Blocks2 = NULL;
+	World.IDMask  = 0xFF;
+#endif
+	/* Undo World_SetNewMap defaulting these based on the guessed height */
+	if (map_edgeHeight   == -1) Env.EdgeHeight   = -1;
+	if (map_cloudsHeight == -1) Env.CloudsHeight = -1;
+	return blocks;
+}
+
+static void MapPreview_ShowProgress(float progress) {
+	cc_string msg; char msgBuffer[STRING_SIZE];
+	int percent = (int)(progress * 100);
+	if (!map_previewing) return;
+
+	String_InitArray(msg, msgBuffer);
+	String_Format1(&msg, "&eLoading map.. %i%%", &percent);
+	Chat_AddOf(&msg, MSG_TYPE_EXTRASTATUS_1);
+}
+
+
 /*########################################################################################################################*
 *----------------------------------------------------Classic protocol-----------------------------------------------------*
 *#########################################################################################################################*/
@@ -532,9 +645,14 @@ static void Classic_StartLoading(void) {
 	WoM_CheckMotd();
 	classic_receivedFirstPos = false;
 
-	map_begunLoading = true;
-	map_receiveBeg   = Stopwatch_Measure();
-	map_volume       = 0;
+	map_begunLoading     = true;
+	map_receiveBeg       = Stopwatch_Measure();
+	map_volume           = 0;
+	map_allocFailedShown = false;
+
+	map_previewing    = false;
+	map_previewHeight = 0;
+	map_previewCopied = 0;
 
 	MapState_Init(&map1);
 #ifdef EXTENDED_BLOCKS
@@ -555,16 +673,15 @@ static void Classic_LevelInit(cc_uint8* data) {
 #ifdef EXTENDED_BLOCKS
 	MapState_SkipHeader(&map2);
 #endif
+	MapPreview_Guess();
 }
 
-static void Classic_LevelDataChunk(cc_uint8* data) {
+cc_bool Classic_CanReadMapAsync(void) { return map_begunLoading; }
+
+cc_result Classic_ReadMapChunk(cc_uint8* data) {
 	struct MapState* m;
 	int usedLength;
-	float progress;
 	cc_result res;
-
-	/* Workaround for some servers that send LevelDataChunk before LevelInit due to their async sending behaviour */
-	if (!map_begunLoading) Classic_StartLoading();
 	usedLength = Stream_GetU16_BE(data);
 
 	map_part.meta.mem.cur    = data + 2;
@@ -585,20 +702,44 @@ static void Classic_LevelDataChunk(cc_uint8* data) {
 
 	if (!m->gzHeader.done) {
 		res = GZipHeader_Read(&map_part, &m->gzHeader);
-		if (res && res != ERR_END_OF_STREAM) { DisconnectInvalidMap(res); return; }
+		if (res && res != ERR_END_OF_STREAM) return res;
 	}
 
-	if (m->gzHeader.done) {
-		res = MapState_Read(m);
-		if (res) { DisconnectInvalidMap(res); return; }
+	if (m->gzHeader.done) return MapState_Read(m);
+	return 0;
+}
+
+void Classic_MapChunksRead(cc_result res, const struct MapProgress* progress) {
+	float loaded;
+	if (res) { DisconnectInvalidMap(res); return; }
+
+	if (progress->allocFailed && !map_allocFailedShown) {
+		map_allocFailedShown = true;
+		Window_ShowDialog("Out of memory", "Not enough free memory to join that map.\nTry joining a different map.");
 	}
 
-	progress = !map_volume ? 0.0f : (float)map1.index / map_volume;
-	Event_RaiseFloat(&WorldEvents.Loading, progress);
+	loaded = !progress->volume ? 0.0f : (float)progress->index / progress->volume;
+	Event_RaiseFloat(&WorldEvents.Loading, loaded);
+
+	if (!map_previewHeight) return;
+	MapPreview_Update(progress);
+	MapPreview_ShowProgress(loaded);
+}
+
+static void Classic_LevelDataChunk(cc_uint8* data) {
+	/* Workaround for some servers that send LevelDataChunk before LevelInit due to their async sending behaviour */
+	struct MapProgress progress;
+	cc_result res;
+	if (!map_begunLoading) Classic_StartLoading();
+
+	res = Classic_ReadMapChunk(data);
+	Classic_PublishMapProgress(&progress);
+	Classic_MapChunksRead(res, &progress);
 }
 
 static void Classic_LevelFinalise(cc_uint8* data) {
 	int width, height, length, volume;
+	BlockRaw* preview;
 	cc_uint64 end;
 	int delta;
 
@@ -608,6 +749,19 @@ static void Classic_LevelFinalise(cc_uint8* data) {
 	map_begunLoading = false;
 	WoM_CheckSendWomID();
 
+	/* The final map reuses the preview's blocks, as only the rest of the map needs to be copied into it */
+	if (map_previewing) {
+		preview = MapPreview_Take();
+
+		if (map1.blocks) {
+			Mem_Copy(preview + map_previewCopied, map1.blocks + map_previewCopied, map_volume - map_previewCopied);
+			Mem_Free(map1.blocks);
+			map1.blocks = preview;
+		} else {
+			Mem_Free(preview);
+		}
+	}
+
 #ifdef EXTENDED_BLOCKS
 	if (map2.allocFailed) FreeMapStates();
 #endif
@@ -642,6 +796,10 @@ static void Classic_LevelFinalise(cc_uint8* data) {
 #endif
 	World_SetNewMap(map1.blocks, width, height, length);
 	map1.blocks  = NULL;
+
+	map_lastWidth  = World.Width;
+	map_lastHeight = World.Height;
+	map_lastLength = World.Length;
 }
 
 static void Classic_SetBlock(cc_uint8* data) {
@@ -802,6 +960,10 @@ static void Classic_Reset(void) {
 	map_begunLoading = false;
 	classic_receivedFirstPos = false;
 
+	/* World_Reset has already freed the preview's blocks by this point */
+	if (map_previewing) Chat_AddOf(&String_Empty, MSG_TYPE_EXTRASTATUS_1);
+	map_previewing = false;
+
 	Net_Set(OPCODE_HANDSHAKE, Classic_Handshake, Classic_HandshakeSize());
 	Net_Set(OPCODE_PING, Classic_Ping, 1);
 	Net_Set(OPCODE_LEVEL_BEGIN, Classic_LevelInit, 1);
@@ -1282,6 +1444,7 @@ static void CPE_BulkBlockUpdate(cc_uint8* data) {
 		data += BULK_MAX_BLOCKS / 4;
 	}
 
+	Game_BeginBlockBatch();
 	for (i = 0; i < count; i++) {
 		index = indices[i];
 		if (index < 0 || index >= World.Volume) continue;
@@ -1293,6 +1456,7 @@ static void CPE_BulkBlockUpdate(cc_uint8* data) {
 		Game_UpdateBlock(x, y, z, blocks[i]);
 #endif
 	}
+	Game_CommitBlockBatch();
 }
 
 static void CPE_SetTextColor(cc_uint8* data) {
@@ -1917,7 +2081,12 @@ void Protocol_Tick(void) {
 	cc_uint8 tmp[256];
 	cc_uint8* data = tmp;
 
+	/* Position is sent on its own, so that if the server is slow to read data, */
+	/*  it can replace an older position update that is still waiting to be sent */
 	data = Classic_Tick(data);
+	if (data != tmp) Server.SendData(tmp, (cc_uint32)(data - tmp));
+
+	data = tmp;
 	data = CPE_Tick(data);
 	WoM_Tick();
 
@@ -70,6 +70,25 @@ extern cc_bool cpe_needD3Fix;
 void Classic_SendChat(const cc_string* text, cc_bool partial);
 void Classic_SendSetBlock(int x, int y, int z, cc_bool place, BlockID block);
 void Classic_SendLogin(void);
+/* Whether map data from LevelDataChunk packets can currently be decompressed off the main thread */
+cc_bool Classic_CanReadMapAsync(void);
+/* Decompresses the map data from the given LevelDataChunk packet */
+/* NOTE: Can be called from the network receive thread, only if Classic_CanReadMapAsync returned true */
+cc_result Classic_ReadMapChunk(cc_uint8* data);
+/* Snapshot of the map data decompressed by Classic_ReadMapChunk so far */
+struct MapProgress {
+	BlockRaw* blocks; /* NULL if not allocated yet */
+	int index;        /* Number of bytes of blocks that have been decompressed */
+	int volume;       /* Total number of bytes in the map, 0 if not known yet */
+	cc_bool allocFailed;
+};
+/* Takes a snapshot of the map data decompressed by Classic_ReadMapChunk so far */
+/* NOTE: When called from the network receive thread, the snapshot must only be written and */
+/*  read while holding a lock that both the receive thread and main thread acquire */
+void Classic_PublishMapProgress(struct MapProgress* progress);
+/* Updates map loading progress, after map data has been decompressed using Classic_ReadMapChunk */
+/* NOTE: Only accesses map data described by the given snapshot, not the decompressor's state */
+void Classic_MapChunksRead(cc_result res, const struct MapProgress* progress);
 void CPE_SendPlayerClick(int button, cc_bool pressed, cc_uint8 targetId, struct RayTracer* t);
 
 /* Send a PluginMessage to the server; data must contain 64 bytes. */
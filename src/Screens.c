@@ -89,6 +89,7 @@ static struct HUDScreen {
 static void HUDScreen_RemakeLine1(struct HUDScreen* s) {
 	cc_string status; char statusBuffer[STRING_SIZE * 2];
 	int indices, ping, fps;
+	int sentKB, pendingKB;
 	float real_fps;
 
 	String_InitArray(status, statusBuffer);
@@ -119,6 +120,13 @@ static void HUDScreen_RemakeLine1(struct HUDScreen* s) {
 
 		ping = Ping_AveragePingMS();
 		if (ping) String_Format1(&status, ", ping %i ms", &ping);
+
+		/* Only show when server hasn't been reading data fast enough */
+		if (NetSendStats.Stalls) {
+			sentKB    = NetSendStats.Sent    >> 10;
+			pendingKB = NetSendStats.Pending >> 10;
+			String_Format3(&status, ", sent %i KB (%i KB queued, %i stalls)", &sentKB, &pendingKB, &NetSendStats.Stalls);
+		}
 	}
 	TextWidget_Set(&s->line1, &status, &s->font);
 	s->dirty = true;
@@ -25,6 +25,7 @@
 #include "Input.h"
 #include "Errors.h"
 #include "Options.h"
+#include "Stream.h"
 
 static char nameBuffer[STRING_SIZE];
 static char motdBuffer[STRING_SIZE];
@@ -232,8 +233,11 @@ static void SPConnection_Init(void) {
 static cc_socket net_socket = -1;
 static cc_result net_writeFailure;
 static void OnClose(void);
+struct _NetSendStats NetSendStats;
 
 #ifdef CC_BUILD_NETWORKING
+static void NetThread_Start(void);
+static void SendQueue_Reset(void);
 static cc_uint8  net_readBuffer[4096 * 5];
 static cc_uint8* net_readCurrent;
 static double net_lastPacket;
@@ -250,6 +254,8 @@ static void MPConnection_FinishConnect(void) {
 
 	net_readCurrent = net_readBuffer;
 	net_lastPacket  = Game.Time;
+	SendQueue_Reset();
+	if (Options_GetBool(OPT_NET_THREAD, false)) NetThread_Start();
 	Classic_SendLogin();
 }
 
@@ -376,7 +382,420 @@ static void DisconnectInvalidOpcode(cc_uint8 opcode) {
 	Game_Disconnect(&title, &tmp); return;
 }
 
-static void MPConnection_Tick(struct ScheduledTask* task) {
+static cc_bool net_batchingBlocks;
+/* Block changes from consecutive packets are batched together, */
+/*  so that e.g. lighting for each column is only recalculated once */
+static void BatchBlockChanges(cc_bool batch) {
+	if (batch == net_batchingBlocks) return;
+	net_batchingBlocks = batch;
+
+	if (batch) {
+		Game_BeginBlockBatch();
+	} else {
+		Game_CommitBlockBatch();
+	}
+}
+
+static cc_bool IsBlockChange(cc_uint8 opcode) {
+	return opcode == OPCODE_SET_BLOCK || opcode == OPCODE_BULK_BLOCK_UPDATE;
+}
+
+/*########################################################################################################################*
+*------------------------------------------------------Send queue---------------------------------------------------------*
+*#########################################################################################################################*/
+/* Data that couldn't be written yet (socket send buffer full) is queued here, */
+/*  then written whenever the socket next becomes writable */
+#ifdef CC_BUILD_LOWMEM
+	#define NET_SEND_QUEUE_INITIAL (4  * 1024)
+#else
+	#define NET_SEND_QUEUE_INITIAL (16 * 1024)
+#endif
+/* If this much data is still unsent, the server has most likely stopped reading */
+#define NET_SEND_QUEUE_MAX (4 * 1024 * 1024)
+
+static cc_uint8* net_sendQueue;
+static cc_uint32 net_sendHead, net_sendTail, net_sendCapacity;
+/* Offset and size of last position packet in the send queue which hasn't started being written yet */
+static cc_uint32 net_sendPosOffset, net_sendPosLen;
+
+/* Writes as much queued data as possible without blocking */
+static void SendQueue_Flush(void) {
+	cc_uint32 wrote;
+	cc_result res;
+
+	while (net_sendHead < net_sendTail) {
+		res = Socket_Write(net_socket, net_sendQueue + net_sendHead, net_sendTail - net_sendHead, &wrote);
+
+		if (res == ReturnCode_SocketInProgess || res == ReturnCode_SocketWouldBlock) {
+			NetSendStats.Stalls++; break;
+		}
+		/* NOTE: Not immediately disconnecting here, as otherwise we sometimes miss out on kick messages */
+		if (res)    { net_writeFailure = res;                  break; }
+		if (!wrote) { net_writeFailure = ERR_INVALID_ARGUMENT; break; }
+
+		net_sendHead     += wrote;
+		NetSendStats.Sent += wrote;
+	}
+
+	/* Position packet may have been partially written, so can't be replaced anymore */
+	if (net_sendPosLen && net_sendHead > net_sendPosOffset) net_sendPosLen = 0;
+	if (net_sendHead == net_sendTail) {
+		net_sendHead = 0; net_sendTail = 0; net_sendPosLen = 0;
+	}
+	NetSendStats.Pending = net_sendTail - net_sendHead;
+}
+
+static cc_bool SendQueue_Reserve(cc_uint32 len) {
+	cc_uint32 used = net_sendTail - net_sendHead;
+	cc_uint32 capacity;
+	cc_uint8* queue;
+
+	if (net_sendTail + len <= net_sendCapacity) return true;
+	if (used + len > NET_SEND_QUEUE_MAX)        return false;
+
+	/* Move unsent data back to start of the queue */
+	if (net_sendHead) {
+		Mem_Move(net_sendQueue, net_sendQueue + net_sendHead, used);
+		net_sendPosOffset -= net_sendHead;
+		net_sendHead = 0; net_sendTail = used;
+		if (used + len <= net_sendCapacity) return true;
+	}
+
+	capacity = max(net_sendCapacity, NET_SEND_QUEUE_INITIAL);
+	while (capacity < used + len) capacity *= 2;
+
+	queue = (cc_uint8*)Mem_TryRealloc(net_sendQueue, capacity, 1);
+	if (!queue) return false;
+
+	net_sendQueue    = queue;
+	net_sendCapacity = capacity;
+	return true;
+}
+
+static void SendQueue_Add(const cc_uint8* data, cc_uint32 len, cc_bool isPosition) {
+	/* Only the most recent position actually matters, so overwrite an older */
+	/*  position packet still waiting at the end of the queue instead of sending both */
+	/* NOTE: Can't replace it when other packets were queued after it, */
+	/*  as that would reorder the new position before those packets */
+	if (isPosition && net_sendPosLen == len && net_sendPosOffset + len == net_sendTail) {
+		Mem_Copy(net_sendQueue + net_sendPosOffset, data, len);
+		NetSendStats.Coalesced++;
+		return;
+	}
+
+	if (!SendQueue_Reserve(len)) { net_writeFailure = ERR_OUT_OF_MEMORY; return; }
+	Mem_Copy(net_sendQueue + net_sendTail, data, len);
+
+	if (isPosition) {
+		net_sendPosOffset = net_sendTail;
+		net_sendPosLen    = len;
+	}
+	net_sendTail += len;
+	NetSendStats.Pending = net_sendTail - net_sendHead;
+}
+
+static void SendQueue_Reset(void) {
+	net_sendHead   = 0;
+	net_sendTail   = 0;
+	net_sendPosLen = 0;
+	Mem_Set(&NetSendStats, 0, sizeof(NetSendStats));
+}
+
+static void SendQueue_Free(void) {
+	Mem_Free(net_sendQueue);
+	net_sendQueue    = NULL;
+	net_sendCapacity = 0;
+	SendQueue_Reset();
+}
+
+/*########################################################################################################################*
+*-------------------------------------------------Network receive thread--------------------------------------------------*
+*#########################################################################################################################*/
+static void* net_thread;
+
+#ifndef CC_BUILD_COOPTHREADED
+/* Packets are stored in the ring as 2 byte length, followed by the packet data */
+/* A length of 0 (or less than 2 bytes left before the end) means to wrap around to start of the ring */
+#define NET_RING_SIZE (256 * 1024)
+/* How long the receive thread waits for data to arrive, before checking if it should stop */
+#define NET_THREAD_WAIT_MS 50
+enum NetThreadFailure { NET_THREAD_OK, NET_THREAD_READ_FAILED, NET_THREAD_INVALID_OPCODE, NET_THREAD_INVALID_MAP };
+
+static void* net_ringMutex;
+static void* net_ringConsumed; /* Signalled when main thread consumes packets from the ring */
+static cc_uint8* net_ring;
+static volatile cc_bool net_threadQuit;
+
+/* NOTE: All of the following state is protected by net_ringMutex */
+static cc_uint32 net_ringHead, net_ringTail; /* Total bytes consumed by main thread / produced by receive thread */
+static int net_mapChunks;      /* Number of LevelDataChunk packets decompressed by receive thread */
+static struct MapProgress net_mapProgress; /* Map data decompressed by receive thread so far */
+static cc_bool net_readClosed; /* Whether socket read returned 0 bytes */
+static cc_bool net_d3Skipped;  /* Whether an invalid HackControl byte from a D3 server was skipped */
+static cc_uint8 net_failure;
+static cc_result net_failureRes;
+
+static void NetThread_Fail(int failure, cc_result res) {
+	Mutex_Lock(net_ringMutex);
+	net_failure    = failure;
+	net_failureRes = res;
+	Mutex_Unlock(net_ringMutex);
+}
+
+/* Whether processing the given packet on the main thread may change how subsequent packets are read */
+static cc_bool NetThread_IsSyncPoint(cc_uint8 opcode) {
+	return opcode == OPCODE_EXT_INFO    || opcode == OPCODE_EXT_ENTRY  ||
+		   opcode == OPCODE_LEVEL_BEGIN || opcode == OPCODE_LEVEL_DATA || opcode == OPCODE_LEVEL_END;
+}
+
+/* Whether the size of the given packet is never changed by processing a sync point packet */
+/* (e.g. avoids stalling after every ExtEntry packet while negotiating CPE extensions) */
+static cc_bool NetThread_IsStable(cc_uint8 opcode) {
+	return opcode == OPCODE_EXT_INFO || opcode == OPCODE_EXT_ENTRY;
+}
+
+/* Waits until all the packets in the ring have been processed by the main thread */
+static cc_bool NetThread_WaitDrained(void) {
+	cc_bool drained;
+	for (;;)
+	{
+		Mutex_Lock(net_ringMutex);
+		drained = net_ringHead == net_ringTail;
+		Mutex_Unlock(net_ringMutex);
+
+		if (drained)        return true;
+		if (net_threadQuit) return false;
+		Waitable_Wait(net_ringConsumed);
+	}
+}
+
+/* Copies the given packet into the ring, waiting for the main thread to free up space if necessary */
+static cc_bool NetThread_Push(const cc_uint8* data, int len) {
+	cc_uint32 pos, left, used, skip;
+	for (;;)
+	{
+		Mutex_Lock(net_ringMutex);
+		used = net_ringTail - net_ringHead;
+		pos  = net_ringTail % NET_RING_SIZE;
+		Mutex_Unlock(net_ringMutex);
+
+		/* Packets are never split across the end of the ring */
+		left = NET_RING_SIZE - pos;
+		skip = left < 2 + len ? left : 0;
+		if (used + skip + 2 + len <= NET_RING_SIZE) break;
+
+		if (net_threadQuit) return false;
+		Waitable_Wait(net_ringConsumed);
+	}
+
+	if (skip) {
+		if (left >= 2) { net_ring[pos] = 0; net_ring[pos + 1] = 0; }
+		pos = 0;
+	}
+	Stream_SetU16_BE(&net_ring[pos], len);
+	Mem_Copy(&net_ring[pos + 2], data, len);
+
+	Mutex_Lock(net_ringMutex);
+	net_ringTail += skip + 2 + len;
+	Mutex_Unlock(net_ringMutex);
+	return true;
+}
+
+static void NetThread_Run(void) {
+	cc_bool syncPending = false;
+	cc_uint8* readEnd;
+	cc_uint8* readCur;
+	cc_uint32 read;
+	int i, size, remaining;
+	cc_result res;
+#ifdef CC_BUILD_SOCKETWAIT
+	cc_bool readable;
+#endif
+	net_readCurrent = net_readBuffer;
+
+	while (!net_threadQuit)
+	{
+#ifdef CC_BUILD_SOCKETWAIT
+		res = Socket_WaitReadable(net_socket, NET_THREAD_WAIT_MS, &readable);
+		if (res) { NetThread_Fail(NET_THREAD_READ_FAILED, res); return; }
+		if (!readable) continue;
+#endif
+		/* NOTE: using a read call that is a multiple of 4096 (appears to?) improve read performance */
+		res = Socket_Read(net_socket, net_readCurrent, 4096 * 4, &read);
+
+		if (res == ReturnCode_SocketInProgess || res == ReturnCode_SocketWouldBlock) {
+#ifndef CC_BUILD_SOCKETWAIT
+			Thread_Sleep(1);
+#endif
+			continue;
+		} else if (res) {
+			NetThread_Fail(NET_THREAD_READ_FAILED, res); return;
+		} else if (read == 0) {
+			Mutex_Lock(net_ringMutex);
+			net_readClosed = true;
+			Mutex_Unlock(net_ringMutex);
+			Thread_Sleep(10); continue;
+		}
+
+		readCur = net_readBuffer;
+		readEnd = net_readCurrent + read;
+
+		while (readCur < readEnd) {
+			cc_uint8 opcode = readCur[0];
+
+			/* Packet sizes may be changed by main thread when it processes the sync point packet */
+			if (syncPending && !NetThread_IsStable(opcode)) {
+				if (!NetThread_WaitDrained()) return;
+				syncPending = false;
+			}
+
+			/* Workaround for older D3 servers which wrote one byte too many for HackControl packets */
+			if (cpe_needD3Fix && lastOpcode == OPCODE_HACK_CONTROL && (opcode == 0x00 || opcode == 0xFF)) {
+				Platform_LogConst("Skipping invalid HackControl byte from D3 server");
+				readCur++;
+
+				Mutex_Lock(net_ringMutex);
+				net_d3Skipped = true;
+				Mutex_Unlock(net_ringMutex);
+				continue;
+			}
+
+			size = Protocol.Sizes[opcode];
+			if (readCur + size > readEnd) break;
+			if (!Protocol.Handlers[opcode]) { NetThread_Fail(NET_THREAD_INVALID_OPCODE, opcode); return; }
+			lastOpcode = opcode;
+
+			/* Map data is decompressed here, so the main thread only has to process gameplay packets */
+			if (opcode == OPCODE_LEVEL_DATA && Classic_CanReadMapAsync()) {
+				res = Classic_ReadMapChunk(readCur + 1);
+				if (res) { NetThread_Fail(NET_THREAD_INVALID_MAP, res); return; }
+
+				Mutex_Lock(net_ringMutex);
+				net_mapChunks++;
+				Classic_PublishMapProgress(&net_mapProgress);
+				Mutex_Unlock(net_ringMutex);
+			} else {
+				if (!NetThread_Push(readCur, size)) return;
+				syncPending |= NetThread_IsSyncPoint(opcode);
+			}
+			readCur += size;
+		}
+
+		/* Protocol packets might be split up across TCP packets */
+		/* If so, copy last few unprocessed bytes back to beginning of buffer */
+		remaining = (int)(readEnd - readCur);
+		for (i = 0; i < remaining; i++)
+		{
+			net_readBuffer[i] = readCur[i];
+		}
+		net_readCurrent = net_readBuffer + remaining;
+	}
+}
+
+static void NetThread_Start(void) {
+	net_ring = (cc_uint8*)Mem_TryAlloc(NET_RING_SIZE, 1);
+	if (!net_ring) return;
+
+	net_ringMutex    = Mutex_Create("Net ring");
+	net_ringConsumed = Waitable_Create("Net ring consumed");
+
+	net_ringHead   = 0;
+	net_ringTail   = 0;
+	net_mapChunks  = 0;
+	net_readClosed = false;
+	net_d3Skipped  = false;
+	net_failure    = NET_THREAD_OK;
+	net_threadQuit = false;
+	Thread_Run(&net_thread, NetThread_Run, 256 * 1024, "Net receive");
+}
+
+static void NetThread_Stop(void) {
+	if (!net_thread) return;
+	net_threadQuit = true;
+	/* Wake up receive thread if it is waiting for the ring to be drained */
+	Waitable_Signal(net_ringConsumed);
+	Thread_Join(net_thread);
+	net_thread = NULL;
+
+	Mutex_Free(net_ringMutex);
+	Waitable_Free(net_ringConsumed);
+	Mem_Free(net_ring);
+	net_ring = NULL;
+}
+
+/* Processes all the packets that the receive thread has added to the ring so far */
+static void NetThread_Drain(void) {
+	struct MapProgress mapProgress;
+	cc_uint32 head, tail, pos, len;
+	cc_bool closed, d3Skipped, consumed;
+	int chunks, failure;
+	cc_result failureRes;
+	cc_uint8* packet;
+
+	Mutex_Lock(net_ringMutex);
+	head        = net_ringHead;
+	tail        = net_ringTail;
+	chunks      = net_mapChunks;
+	mapProgress = net_mapProgress;
+	closed      = net_readClosed;
+	d3Skipped   = net_d3Skipped;
+	failure     = net_failure;
+	failureRes  = net_failureRes;
+
+	net_mapChunks  = 0;
+	net_readClosed = false;
+	net_d3Skipped  = false;
+	Mutex_Unlock(net_ringMutex);
+
+	if (d3Skipped) LocalPlayer_ResetJumpVelocity(Entities.CurPlayer);
+	consumed = head != tail;
+	if (chunks || consumed) net_lastPacket = Game.Time;
+
+	if (chunks) {
+		Classic_MapChunksRead(0, &mapProgress);
+		if (Server.Disconnected) return;
+	}
+
+	while (head != tail) 
+	{
+		pos = head % NET_RING_SIZE;
+		len = NET_RING_SIZE - pos < 2 ? 0 : Stream_GetU16_BE(&net_ring[pos]);
+		if (!len) { head += NET_RING_SIZE - pos; continue; }
+
+		packet = &net_ring[pos + 2];
+		BatchBlockChanges(IsBlockChange(packet[0]));
+		Protocol.Handlers[packet[0]](packet + 1); /* skip opcode */
+		head += 2 + len;
+
+		/* Disconnecting stops the receive thread and frees the ring */
+		if (Server.Disconnected) { BatchBlockChanges(false); return; }
+	}
+	BatchBlockChanges(false);
+
+	Mutex_Lock(net_ringMutex);
+	net_ringHead = head;
+	Mutex_Unlock(net_ringMutex);
+	if (consumed) Waitable_Signal(net_ringConsumed);
+
+	if (failure == NET_THREAD_READ_FAILED) {
+		DisconnectReadFailed(failureRes);
+	} else if (failure == NET_THREAD_INVALID_OPCODE) {
+		DisconnectInvalidOpcode((cc_uint8)failureRes);
+	} else if (failure == NET_THREAD_INVALID_MAP) {
+		Classic_MapChunksRead(failureRes, &mapProgress);
+	} else if (closed && net_lastPacket + 30 < Game.Time) {
+		/* recv only returns 0 read when socket is closed.. probably? */
+		MPConnection_Disconnect();
+	}
+}
+#else
+static void NetThread_Start(void) { }
+static void NetThread_Stop(void)  { }
+static void NetThread_Drain(void) { }
+#endif
+
+
+static void MPConnection_ReadPackets(void) {
 	Net_Handler handler;
 	cc_uint8* readEnd;
 	cc_uint8* readCur;
@@ -384,9 +803,6 @@ static void MPConnection_Tick(struct ScheduledTask* task) {
 	int i, remaining;
 	cc_result res;
 
-	if (Server.Disconnected) return;
-	if (net_connecting) { MPConnection_TickConnect(); return; }
-
 	/* NOTE: using a read call that is a multiple of 4096 (appears to?) improve read performance */	
 	res = Socket_Read(net_socket, net_readCurrent, 4096 * 4, &read);
 	
@@ -419,12 +835,14 @@ static void MPConnection_Tick(struct ScheduledTask* task) {
 
 			if (readCur + Protocol.Sizes[opcode] > readEnd) break;
 			handler = Protocol.Handlers[opcode];
-			if (!handler) { DisconnectInvalidOpcode(opcode); return; }
+			if (!handler) { BatchBlockChanges(false); DisconnectInvalidOpcode(opcode); return; }
 
 			lastOpcode = opcode;
+			BatchBlockChanges(IsBlockChange(opcode));
 			handler(readCur + 1); /* skip opcode */
 			readCur += Protocol.Sizes[opcode];
 		}
+		BatchBlockChanges(false);
 
 		/* Protocol packets might be split up across TCP packets */
 		/* If so, copy last few unprocessed bytes back to beginning of buffer */
@@ -436,7 +854,20 @@ static void MPConnection_Tick(struct ScheduledTask* task) {
 		}
 		net_readCurrent = net_readBuffer + remaining;
 	}
+}
+
+static void MPConnection_Tick(struct ScheduledTask* task) {
+	if (Server.Disconnected) return;
+	if (net_connecting) { MPConnection_TickConnect(); return; }
+
+	if (net_thread) {
+		NetThread_Drain();
+	} else {
+		MPConnection_ReadPackets();
+	}
+	if (Server.Disconnected) return;
 
+	SendQueue_Flush();
 	if (net_writeFailure) {
 		Platform_Log1("Error from send: %e", &net_writeFailure);
 		MPConnection_Disconnect(); return;
@@ -450,19 +881,29 @@ static void MPConnection_Tick(struct ScheduledTask* task) {
 }
 
 static void MPConnection_SendData(const cc_uint8* data, cc_uint32 len) {
-	cc_uint32 wrote;
+	cc_uint32 wrote, total = len;
+	cc_bool isPosition;
 	cc_result res;
-	int tries = 0;
-	if (Server.Disconnected) return;
+	if (Server.Disconnected || net_writeFailure) return;
+
+	NetSendStats.Queued += len;
+	isPosition = data[0] == OPCODE_ENTITY_TELEPORT;
+
+	/* Data must be sent in order, so append after any already queued data */
+	if (net_sendHead < net_sendTail) {
+		SendQueue_Flush();
+		if (net_sendHead < net_sendTail) { SendQueue_Add(data, len, isPosition); return; }
+	}
 
 	while (len) {
 		res = Socket_Write(net_socket, data, len, &wrote);
-		/* If sending would block (send buffer full), retry for a bit up to 10 seconds */
-		/* TODO: Avoid doing this and manually buffer data when this happens */
-		if (res && tries < 1000 && (res == ReturnCode_SocketInProgess || res == ReturnCode_SocketWouldBlock)) {
-			Thread_Sleep(10);
-			tries++;
-			continue;
+
+		/* Socket send buffer is full, so write the remaining data later */
+		if (res == ReturnCode_SocketInProgess || res == ReturnCode_SocketWouldBlock) {
+			NetSendStats.Stalls++;
+			/* Packet was partially written, so it can't be replaced by a later one anymore */
+			SendQueue_Add(data, len, isPosition && len == total);
+			return;
 		}
 
 		/* NOTE: Not immediately disconnecting here, as otherwise we sometimes miss out on kick messages */
@@ -470,6 +911,7 @@ static void MPConnection_SendData(const cc_uint8* data, cc_uint32 len) {
 		if (!wrote) { net_writeFailure = ERR_INVALID_ARGUMENT; return; }
 
 		data += wrote; len -= wrote;
+		NetSendStats.Sent += wrote;
 	}
 }
 
@@ -486,6 +928,8 @@ static void MPConnection_Init(void) {
 }
 #else
 static void MPConnection_Init(void) { SPConnection_Init(); }
+static void NetThread_Stop(void) { }
+static void SendQueue_Free(void) { }
 #endif
 
 
@@ -543,6 +987,8 @@ static void OnClose(void) {
 		Ping_Reset();
 		if (Server.Disconnected) return;
 
+		NetThread_Stop();
+		SendQueue_Free();
 		Socket_Close(net_socket);
 		Server.Disconnected = true;
 	}
@@ -67,6 +67,20 @@ CC_VAR extern struct _ServerConnectionData {
 	int Port;
 } Server;
 
+/* Statistics for data sent to a multiplayer server */
+CC_VAR extern struct _NetSendStats {
+	/* Total number of bytes given to Server.SendData */
+	cc_uint32 Queued;
+	/* Total number of bytes actually written to the socket */
+	cc_uint32 Sent;
+	/* Number of bytes currently waiting in the send queue */
+	cc_uint32 Pending;
+	/* Number of times writing to the socket would have blocked */
+	cc_uint32 Stalls;
+	/* Number of position updates that replaced an older unsent one */
+	cc_uint32 Coalesced;
+} NetSendStats;
+
 /* If user hasn't previously accepted url, displays a dialog asking to confirm downloading it */
 /* Otherwise just calls TexturePack_Extract */
 void Server_RetrieveTexturePack(const cc_string* url);
@@ -123,6 +123,35 @@ cc_result Stream_OpenFile(struct Stream* s, const cc_string* path) {
 	return res;
 }
 
+#ifdef CC_BUILD_FILEMAPPING
+static cc_result Stream_MappedClose(struct Stream* s) {
+	File_Unmap(s->meta.mem.base, s->meta.mem.length);
+	s->meta.mem.base = NULL;
+	return 0;
+}
+
+cc_result Stream_OpenMappedFile(struct Stream* s, const cc_string* path) {
+	cc_uint32 length;
+	cc_result res;
+	void* data;
+
+	if ((res = Stream_OpenFile(s, path))) return res;
+	/* Empty files can't be mapped, so just read those normally */
+	if (s->Length(s, &length) || !length) return 0;
+	if (File_Map(s->meta.file, length, &data)) return 0;
+
+	/* No point checking error for closing readonly file */
+	(void)s->Close(s);
+	Stream_ReadonlyMemory(s, data, length);
+	s->Close = Stream_MappedClose;
+	return 0;
+}
+#else
+cc_result Stream_OpenMappedFile(struct Stream* s, const cc_string* path) {
+	return Stream_OpenFile(s, path);
+}
+#endif
+
 cc_result Stream_CreateFile(struct Stream* s, const cc_string* path) {
 	cc_filepath str;
 	cc_file file;
@@ -52,6 +52,9 @@ void Stream_Init(struct Stream* s);
 /* Wrapper for File_Open() then Stream_FromFile() */
 CC_API  cc_result Stream_OpenFile(      struct Stream* s, const cc_string* path);
 typedef cc_result (*FP_Stream_OpenFile)(struct Stream* s, const cc_string* path);
+/* Opens a file for reading, mapping its contents into memory when supported. */
+/* NOTE: Falls back to Stream_OpenFile() if the file cannot be mapped into memory */
+cc_result Stream_OpenMappedFile(struct Stream* s, const cc_string* path);
 /* Wrapper for File_Create() then Stream_FromFile() */
 CC_API  cc_result Stream_CreateFile(      struct Stream* s, const cc_string* path);
 typedef cc_result (*FP_Stream_CreateFile)(struct Stream* s, const cc_string* path);
@@ -426,6 +426,549 @@ static void UpdateCache(struct HttpRequest* req) {
 }
 
 
+/*########################################################################################################################*
+*-------------------------------------------------------Skin cache--------------------------------------------------------*
+*#########################################################################################################################*/
+/* Decoded (and power of two padded) skins are cached in numbered slot files in texturecache/skins */
+/*  Each entry in skins.txt is "[url hash] [content hash] [slot] [size] [last used]" */
+/*  Skins with the same content (e.g. default skins from different URLs) share the same slot */
+static struct StringsBuffer skinsList;
+static int skinsLimit, skinsCounter;
+/* Whether skinsList has changed since it was last saved */
+static cc_bool skinsDirty;
+#define SKINS_TXT "texturecache/skins.txt"
+/* Loading a cached skin updates its last used time, so skins.txt is saved at most every 10 seconds */
+#define SKIN_CACHE_SAVE_INTERVAL 10
+#define SKIN_CACHE_HEADER_SIZE 20
+
+struct SkinCacheEntry { cc_uint32 hash; int slot, size, used; };
+
+static cc_bool SkinCache_Parse(int i, struct SkinCacheEntry* entry) {
+	cc_string line = StringsBuffer_UNSAFE_Get(&skinsList, i);
+	cc_string parts[5];
+	cc_uint64 hash;
+	if (String_UNSAFE_Split(&line, ' ', parts, 5) != 5) return false;
+
+	if (!Convert_ParseUInt64(&parts[1], &hash))     return false;
+	if (!Convert_ParseInt(&parts[2], &entry->slot)) return false;
+	if (!Convert_ParseInt(&parts[3], &entry->size)) return false;
+	if (!Convert_ParseInt(&parts[4], &entry->used)) return false;
+
+	entry->hash = (cc_uint32)hash;
+	return entry->slot >= 0 && entry->size > SKIN_CACHE_HEADER_SIZE;
+}
+
+static void SkinCache_Save(void) {
+	if (!skinsDirty) return;
+	skinsDirty = false;
+	if (Platform_ReadonlyFilesystem) return;
+
+	EntryList_Save(&skinsList,    SKINS_TXT);
+	EntryList_Save(&etagCache,    ETAGS_TXT);
+	EntryList_Save(&lastModCache, LASTMOD_TXT);
+}
+
+static void SkinCache_Tick(struct ScheduledTask* task) { SkinCache_Save(); }
+
+static void SkinCache_Init(void) {
+	struct SkinCacheEntry entry;
+	int i;
+	skinsLimit = Options_GetInt(OPT_SKIN_CACHE_SIZE, 0, 1024, 16) * 1024 * 1024;
+	if (!skinsLimit) return;
+	ScheduledTask_Add(SKIN_CACHE_SAVE_INTERVAL, SkinCache_Tick);
+
+	Utils_EnsureDirectory("texturecache/skins");
+	EntryList_UNSAFE_Load(&skinsList, SKINS_TXT);
+
+	for (i = skinsList.count - 1; i >= 0; i--)
+	{
+		if (!SkinCache_Parse(i, &entry)) {
+			StringsBuffer_Remove(&skinsList, i);
+		} else {
+			skinsCounter = max(skinsCounter, entry.used);
+		}
+	}
+}
+
+static int SkinCache_Find(const cc_string* url) {
+	cc_string key; char keyBuffer[STRING_INT_CHARS];
+	String_InitArray(key, keyBuffer);
+
+	HashUrl(&key, url);
+	return EntryList_Find(&skinsList, &key, ' ');
+}
+
+static void SkinCache_SlotPath(cc_string* path, int slot) {
+	String_Format1(path, "texturecache/skins/%i", &slot);
+}
+
+/* Returns index of the first entry using the given slot, or -1 if no entries use it */
+static int SkinCache_FindSlot(int slot, int except) {
+	struct SkinCacheEntry entry;
+	int i;
+
+	for (i = 0; i < skinsList.count; i++)
+	{
+		if (i == except || !SkinCache_Parse(i, &entry)) continue;
+		if (entry.slot == slot) return i;
+	}
+	return -1;
+}
+
+/* Removes the given entry (and the cached ETag/Last-Modified of its URL), returning number of bytes freed */
+/* NOTE: As there's no way to delete files, an unused slot is truncated instead */
+static int SkinCache_RemoveAt(int i) {
+	cc_string path; char pathBuffer[FILENAME_SIZE];
+	struct SkinCacheEntry entry;
+	struct Stream stream;
+	cc_string line, key, value;
+	cc_bool used;
+	skinsDirty = true;
+
+	/* ETag/Last-Modified are only used to revalidate the cached skin, so would otherwise be kept forever */
+	line = StringsBuffer_UNSAFE_Get(&skinsList, i);
+	if (String_UNSAFE_Separate(&line, ' ', &key, &value)) {
+		EntryList_Remove(&etagCache,    &key, ' ');
+		EntryList_Remove(&lastModCache, &key, ' ');
+	}
+
+	if (!SkinCache_Parse(i, &entry)) { StringsBuffer_Remove(&skinsList, i); return 0; }
+	used = SkinCache_FindSlot(entry.slot, i) >= 0;
+	StringsBuffer_Remove(&skinsList, i);
+	if (used) return 0;
+	/* The slot is no longer used, even though it can't be truncated */
+	if (Platform_ReadonlyFilesystem) return entry.size;
+
+	String_InitArray(path, pathBuffer);
+	SkinCache_SlotPath(&path, entry.slot);
+	if (!Stream_CreateFile(&stream, &path)) stream.Close(&stream);
+	return entry.size;
+}
+
+/* Evicts least recently used entries until total size of all slots is within the limit */
+static void SkinCache_Evict(void) {
+	struct SkinCacheEntry entry, oldest;
+	int i, total = 0, oldestIndex;
+
+	for (i = 0; i < skinsList.count; i++)
+	{
+		if (!SkinCache_Parse(i, &entry)) continue;
+		if (SkinCache_FindSlot(entry.slot, -1) == i) total += entry.size;
+	}
+
+	while (total > skinsLimit && skinsList.count)
+	{
+		oldestIndex = 0;
+		oldest.used = Int32_MaxValue;
+
+		for (i = 0; i < skinsList.count; i++)
+		{
+			if (!SkinCache_Parse(i, &entry) || entry.used >= oldest.used) continue;
+			oldest = entry; oldestIndex = i;
+		}
+		total -= SkinCache_RemoveAt(oldestIndex);
+	}
+}
+
+static void SkinCache_Set(const cc_string* url, cc_uint32 hash, int slot, int size) {
+	cc_string key;   char keyBuffer[STRING_INT_CHARS];
+	cc_string value; char valueBuffer[STRING_INT_CHARS * 4];
+	String_InitArray(key,   keyBuffer);
+	String_InitArray(value, valueBuffer);
+
+	HashUrl(&key, url);
+	String_AppendUInt32(&value, hash); String_Append(&value, ' ');
+	String_AppendInt(&value,    slot); String_Append(&value, ' ');
+	String_AppendInt(&value,    size); String_Append(&value, ' ');
+	String_AppendInt(&value, ++skinsCounter);
+	EntryList_Set(&skinsList, &key, &value, ' ');
+}
+
+int SkinCache_Request(const cc_string* skin, cc_uint8 flags) {
+	cc_string url; char urlBuffer[URL_MAX_SIZE];
+	cc_string time, etag;
+	String_InitArray(url, urlBuffer);
+	Http_GetSkinUrl(skin, &url);
+
+	if (!skinsLimit || SkinCache_Find(&url) == -1) 
+		return Http_AsyncGetData(&url, flags);
+
+	time = GetCachedLastModified(&url);
+	etag = GetCachedETag(&url);
+	return Http_AsyncGetDataEx(&url, flags, &time, &etag, NULL);
+}
+
+static cc_result SkinCache_Read(struct Stream* s, const struct SkinCacheEntry* entry,
+								struct Bitmap* bmp, int* srcWidth, int* srcHeight) {
+	cc_uint8 header[SKIN_CACHE_HEADER_SIZE];
+	cc_uint32 size;
+	cc_result res;
+	if ((res = Stream_Read(s, header, SKIN_CACHE_HEADER_SIZE))) return res;
+
+	if (header[0] != 'C' || header[1] != 'C' || header[2] != 'S' || header[3] != 'K') 
+		return ERR_INVALID_ARGUMENT;
+	if (Stream_GetU32_LE(header + 4) != entry->hash) return ERR_INVALID_ARGUMENT;
+	if (Stream_GetU32_LE(header + 8) != (cc_uint32)BitmapCol_Make(1, 2, 3, 4)) return ERR_INVALID_ARGUMENT;
+
+	*srcWidth   = Stream_GetU16_LE(header + 12);
+	*srcHeight  = Stream_GetU16_LE(header + 14);
+	bmp->width  = Stream_GetU16_LE(header + 16);
+	bmp->height = Stream_GetU16_LE(header + 18);
+
+	size = bmp->width * bmp->height * BITMAPCOLOR_SIZE;
+	if (!size || size != entry->size - SKIN_CACHE_HEADER_SIZE) return ERR_INVALID_ARGUMENT;
+	if (*srcWidth > bmp->width || *srcHeight > bmp->height)    return ERR_INVALID_ARGUMENT;
+
+	bmp->scan0 = (BitmapCol*)Mem_TryAlloc(1, size);
+	if (!bmp->scan0) return ERR_OUT_OF_MEMORY;
+	return Stream_Read(s, (cc_uint8*)bmp->scan0, size);
+}
+
+cc_bool SkinCache_Load(const cc_string* skin, struct Bitmap* bmp, int* srcWidth, int* srcHeight) {
+	cc_string url;  char urlBuffer[URL_MAX_SIZE];
+	cc_string path; char pathBuffer[FILENAME_SIZE];
+	struct SkinCacheEntry entry;
+	struct Stream stream;
+	cc_result res;
+	int i;
+
+	String_InitArray(url, urlBuffer);
+	Http_GetSkinUrl(skin, &url);
+	bmp->scan0 = NULL;
+
+	if (!skinsLimit) return false;
+	i = SkinCache_Find(&url);
+	if (i == -1 || !SkinCache_Parse(i, &entry)) return false;
+
+	String_InitArray(path, pathBuffer);
+	SkinCache_SlotPath(&path, entry.slot);
+	res = Stream_OpenFile(&stream, &path);
+
+	if (!res) {
+		res = SkinCache_Read(&stream, &entry, bmp, srcWidth, srcHeight);
+		stream.Close(&stream);
+	}
+
+	if (res) {
+		if (res != ReturnCode_FileNotFound) Logger_SysWarn2(res, "loading cached skin", &url);
+		Mem_Free(bmp->scan0);
+		bmp->scan0 = NULL;
+		SkinCache_RemoveAt(i);
+	} else {
+		SkinCache_Set(&url, entry.hash, entry.slot, entry.size);
+		skinsDirty = true;
+	}
+	return !res;
+}
+
+static cc_result SkinCache_Write(const cc_string* path, cc_uint32 hash, 
+								struct Bitmap* bmp, int srcWidth, int srcHeight) {
+	cc_uint8 header[SKIN_CACHE_HEADER_SIZE];
+	struct Stream stream;
+	cc_result res, closeRes;
+
+	header[0] = 'C'; header[1] = 'C'; header[2] = 'S'; header[3] = 'K';
+	Stream_SetU32_LE(header + 4,  hash);
+	Stream_SetU32_LE(header + 8,  (cc_uint32)BitmapCol_Make(1, 2, 3, 4));
+	Stream_SetU16_LE(header + 12, srcWidth);
+	Stream_SetU16_LE(header + 14, srcHeight);
+	Stream_SetU16_LE(header + 16, bmp->width);
+	Stream_SetU16_LE(header + 18, bmp->height);
+
+	if ((res = Stream_CreateFile(&stream, path))) return res;
+	res = Stream_Write(&stream, header, SKIN_CACHE_HEADER_SIZE);
+	if (!res) res = Stream_Write(&stream, (cc_uint8*)bmp->scan0, 
+								bmp->width * bmp->height * BITMAPCOLOR_SIZE);
+
+	closeRes = stream.Close(&stream);
+	return res ? res : closeRes;
+}
+
+void SkinCache_Update(const cc_string* skin, struct HttpRequest* item, 
+					struct Bitmap* bmp, int srcWidth, int srcHeight) {
+	cc_string url;  char urlBuffer[URL_MAX_SIZE];
+	cc_string path; char pathBuffer[FILENAME_SIZE];
+	struct SkinCacheEntry entry;
+	cc_string etag, time;
+	cc_uint32 hash;
+	int i, slot, size;
+	cc_result res;
+
+	if (!skinsLimit || Platform_ReadonlyFilesystem) return;
+	etag = String_FromRawArray(item->etag);
+	time = String_FromRawArray(item->lastModified);
+	/* Skins without either header can't be revalidated, so there's no point caching them */
+	if (!etag.length && !time.length) return;
+
+	size = SKIN_CACHE_HEADER_SIZE + bmp->width * bmp->height * BITMAPCOLOR_SIZE;
+	if (size > skinsLimit) return;
+
+	String_InitArray(url, urlBuffer);
+	Http_GetSkinUrl(skin, &url);
+
+	/* NOTE: Must be removed before the new ETag/Last-Modified are set, as removing clears them */
+	i = SkinCache_Find(&url);
+	if (i >= 0) SkinCache_RemoveAt(i);
+	hash = Utils_CRC32(item->data, item->size);
+
+	/* Reuse slot of another skin with identical contents */
+	for (i = 0; i < skinsList.count; i++)
+	{
+		if (!SkinCache_Parse(i, &entry)) continue;
+		if (entry.hash == hash && entry.size == size) break;
+	}
+
+	if (i < skinsList.count) {
+		slot = entry.slot;
+	} else {
+		for (slot = 0; SkinCache_FindSlot(slot, -1) >= 0; slot++) { }
+
+		String_InitArray(path, pathBuffer);
+		SkinCache_SlotPath(&path, slot);
+		res = SkinCache_Write(&path, hash, bmp, srcWidth, srcHeight);
+		if (res) { Logger_SysWarn2(res, "caching skin", &url); SkinCache_Save(); return; }
+	}
+
+	SkinCache_Set(&url, hash, slot, size);
+	SetCachedTag(&url, &etagCache,    &etag, ETAGS_TXT);
+	SetCachedTag(&url, &lastModCache, &time, LASTMOD_TXT);
+	SkinCache_Evict();
+
+	skinsDirty = true;
+	SkinCache_Save();
+}
+
+
+/*########################################################################################################################*
+*-------------------------------------------------Background extraction---------------------------------------------------*
+*#########################################################################################################################*/
+static struct TextureEntry* entries_head;
+static struct TextureEntry* entries_tail;
+
+void TextureEntry_Register(struct TextureEntry* entry) {
+	LinkedList_Append(entry, entries_head, entries_tail);
+}
+
+/* NOTE: Also called from the extract thread, which is safe since entries are only registered in Init */
+static struct TextureEntry* TextureEntry_Find(const cc_string* name) {
+	struct TextureEntry* e;
+
+	for (e = entries_head; e; e = e->next) 
+	{
+		if (String_CaselessEqualsConst(name, e->filename)) return e;
+	}
+	return NULL;
+}
+
+/* END_PNG is used when the texture pack is just a terrain.png, rather than a .zip archive */
+enum PACKFILE_TYPE { PACKFILE_BEGIN, PACKFILE_ENTRY, PACKFILE_END_PNG, PACKFILE_END_ZIP };
+/* A file from a texture pack, that has been read (and decoded if a .png) by the extract thread */
+struct PackFile {
+	struct PackFile* next;
+	cc_uint8 type;
+	cc_uint8* data;
+	cc_uint32 size;
+	struct Bitmap bmp;
+	cc_result res;
+	cc_string name; char nameBuffer[FILENAME_SIZE];
+};
+
+/* A texture pack (.zip archive or just terrain.png) waiting to be extracted */
+struct PackJob {
+	struct PackJob* next;
+	struct Stream stream;
+	cc_uint8* data; /* Downloaded data the stream reads from, freed once extracted */
+	cc_string path; char pathBuffer[FILENAME_SIZE];
+};
+
+static struct PackJob*  jobs_head;
+static struct PackJob*  jobs_tail;
+static struct PackFile* files_head; /* Extracted files waiting to be applied on the main thread */
+static struct PackFile* files_tail;
+
+static void PackFile_Free(struct PackFile* file) {
+	Mem_Free(file->data);
+	Mem_Free(file->bmp.scan0);
+	Mem_Free(file);
+}
+
+static struct PackFile* PackFile_Make(int type, const cc_string* name) {
+	struct PackFile* file = (struct PackFile*)Mem_TryAllocCleared(1, sizeof(struct PackFile));
+	if (!file) return NULL;
+
+	file->type = type;
+	String_InitArray(file->name, file->nameBuffer);
+	String_Copy(&file->name, name);
+	return file;
+}
+
+#ifdef CC_BUILD_COOPTHREADED
+#define Extracted_Lock()
+#define Extracted_Unlock()
+#else
+static void* extractMutex;
+#define Extracted_Lock()   Mutex_Lock(extractMutex)
+#define Extracted_Unlock() Mutex_Unlock(extractMutex)
+#endif
+
+static void PackFile_Push(struct PackFile* file) {
+	Extracted_Lock();
+	{
+		LinkedList_Append(file, files_head, files_tail);
+	}
+	Extracted_Unlock();
+}
+
+static cc_bool SelectZipEntry(const cc_string* path) { return true; }
+static cc_result ReadZipEntry(const cc_string* path, struct Stream* stream, struct ZipEntry* source) {
+	struct TextureEntry* e;
+	struct PackFile* file;
+	struct Stream mem;
+	cc_string name = *path;
+	cc_result res;
+
+	Utils_UNSAFE_GetFilename(&name);
+	file = PackFile_Make(PACKFILE_ENTRY, &name);
+	if (!file) return ERR_OUT_OF_MEMORY;
+
+	if (source->UncompressedSize) {
+		file->data = (cc_uint8*)Mem_TryAlloc(source->UncompressedSize, 1);
+		file->size = source->UncompressedSize;
+		res = file->data ? Stream_Read(stream, file->data, file->size) : ERR_OUT_OF_MEMORY;
+		if (res) { PackFile_Free(file); return res; }
+	}
+
+	/* Decode .png files here, so the main thread only has to upload them */
+	e = TextureEntry_Find(&file->name);
+	if (e && e->Decoded) {
+		Stream_ReadonlyMemory(&mem, file->data, file->size);
+		file->res = Png_Decode(&file->bmp, &mem);
+		if (file->res) { Mem_Free(file->bmp.scan0); file->bmp.scan0 = NULL; }
+	}
+
+	PackFile_Push(file);
+	return 0;
+}
+
+static void PackJob_Extract(struct PackJob* job) {
+	struct ZipEntry entries[512];
+	struct PackFile* file;
+	struct Bitmap bmp;
+	cc_result res;
+
+	file = PackFile_Make(PACKFILE_BEGIN, &job->path);
+	if (file) PackFile_Push(file);
+
+	res = Png_Decode(&bmp, &job->stream);
+	if (res == PNG_ERR_INVALID_SIG) {
+		Mem_Free(bmp.scan0);
+		/* file isn't a .png image, probably a .zip archive then */
+		res  = Zip_Extract(&job->stream, SelectZipEntry, ReadZipEntry,
+							entries, Array_Elems(entries));
+		file = PackFile_Make(PACKFILE_END_ZIP, &job->path);
+	} else {
+		file = PackFile_Make(PACKFILE_END_PNG, &job->path);
+		if (file) { file->bmp = bmp; } else { Mem_Free(bmp.scan0); }
+	}
+
+	if (file) { file->res = res; PackFile_Push(file); }
+	/* No point logging error for closing readonly file */
+	(void)job->stream.Close(&job->stream);
+	Mem_Free(job->data);
+	Mem_Free(job);
+}
+
+#ifdef CC_BUILD_COOPTHREADED
+static void PackJob_Queue(struct PackJob* job) { PackJob_Extract(job); }
+static void PackJob_WaitAll(void) { }
+#else
+static void* extractThread;
+static cc_bool extractRunning; /* NOTE: Protected by extractMutex */
+
+static void ExtractThread_Run(void) {
+	struct PackJob* job;
+
+	for (;;)
+	{
+		Extracted_Lock();
+		{
+			job = jobs_head;
+			if (job) jobs_head = job->next;
+			extractRunning = job != NULL;
+		}
+		Extracted_Unlock();
+
+		if (!job) return;
+		PackJob_Extract(job);
+	}
+}
+
+static void PackJob_Queue(struct PackJob* job) {
+	cc_bool start;
+
+	Extracted_Lock();
+	{
+		LinkedList_Append(job, jobs_head, jobs_tail);
+		start = !extractRunning;
+		extractRunning = true;
+	}
+	Extracted_Unlock();
+	if (!start) return;
+
+	/* Previous thread has already finished, but still needs to be cleaned up */
+	if (extractThread) Thread_Join(extractThread);
+	Thread_Run(&extractThread, ExtractThread_Run, 256 * 1024, "Texture pack");
+}
+
+static void PackJob_WaitAll(void) {
+	if (!extractThread) return;
+	Thread_Join(extractThread);
+	extractThread = NULL;
+}
+#endif
+
+/* Frees texture packs waiting to be extracted, and files waiting to be applied */
+static void PackJob_FreeAll(void) {
+	struct PackJob* job;
+	struct PackJob* nextJob;
+	struct PackFile* file;
+	struct PackFile* nextFile;
+
+	/* Detaching the queued jobs makes the extract thread stop after its current job */
+	Extracted_Lock();
+	{
+		job = jobs_head;
+		jobs_head = NULL;
+		jobs_tail = NULL;
+	}
+	Extracted_Unlock();
+	/* The current job may still push files, so wait for it before freeing anything */
+	PackJob_WaitAll();
+
+	Extracted_Lock();
+	{
+		file = files_head;
+		files_head = NULL;
+		files_tail = NULL;
+	}
+	Extracted_Unlock();
+
+	for (; job; job = nextJob)
+	{
+		nextJob = job->next;
+		(void)job->stream.Close(&job->stream);
+		Mem_Free(job->data);
+		Mem_Free(job);
+	}
+
+	for (; file; file = nextFile)
+	{
+		nextFile = file->next;
+		PackFile_Free(file);
+	}
+}
+
+
 /*########################################################################################################################*
 *-------------------------------------------------------TexturePack-------------------------------------------------------*
 *#########################################################################################################################*/
@@ -462,45 +1005,98 @@ cc_result TexturePack_ExtractDefault(DefaultZipCallback callback) {
 }
 
 
-static cc_bool SelectZipEntry(const cc_string* path) { return true; }
-static cc_result ProcessZipEntry(const cc_string* path, struct Stream* stream, struct ZipEntry* source) {
-	cc_string name = *path;
-	Utils_UNSAFE_GetFilename(&name);
-	Event_RaiseEntry(&TextureEvents.FileChanged, stream, &name);
-	return 0;
-}
+static cc_bool needReload, skipExtracted;
+static void ApplyFile(struct PackFile* file) {
+	struct TextureEntry* e;
+	struct Stream mem;
 
-static cc_result ExtractPng(struct Stream* stream) {
-	struct Bitmap bmp;
-	cc_result res = Png_Decode(&bmp, stream);
-	if (!res && Atlas_TryChange(&bmp)) return 0;
+	switch (file->type)
+	{
+	case PACKFILE_BEGIN:
+		Event_RaiseVoid(&TextureEvents.PackChanged);
+		/* If context is lost, then trying to load textures will just fail */
+		/* So defer loading the texture pack until context is restored */
+		needReload    = Gfx.LostContext;
+		skipExtracted = Gfx.LostContext;
+		return;
 
-	Mem_Free(bmp.scan0);
-	return res;
-}
+	case PACKFILE_ENTRY:
+		if (skipExtracted) return;
+		e = TextureEntry_Find(&file->name);
+
+		if (e && e->Decoded) {
+			if (file->res) {
+				Logger_SysWarn2(file->res, "decoding", &file->name);
+			} else {
+				/* Callback takes ownership of the bitmap */
+				e->Decoded(&file->bmp, &file->name);
+				file->bmp.scan0 = NULL;
+			}
+		} else if (e) {
+			Stream_ReadonlyMemory(&mem, file->data, file->size);
+			e->Callback(&mem, &file->name);
+		}
+
+		Stream_ReadonlyMemory(&mem, file->data, file->size);
+		Event_RaiseEntry(&TextureEvents.FileChanged, &mem, &file->name);
+		return;
 
-static cc_bool needReload;
-static cc_result ExtractFrom(struct Stream* stream, const cc_string* path) {
-	struct ZipEntry entries[512];
-	cc_result res;
+	case PACKFILE_END_PNG:
+		if (skipExtracted) break;
 
-	Event_RaiseVoid(&TextureEvents.PackChanged);
-	/* If context is lost, then trying to load textures will just fail */
-	/* So defer loading the texture pack until context is restored */
-	if (Gfx.LostContext) { needReload = true; return 0; }
-	needReload = false;
+		if (file->res) {
+			Logger_SysWarn2(file->res, "decoding", &file->name);
+		} else if (Atlas_TryChange(&file->bmp)) {
+			file->bmp.scan0 = NULL;
+		}
+		break;
 
-	res = ExtractPng(stream);
-	if (res == PNG_ERR_INVALID_SIG) {
-		/* file isn't a .png image, probably a .zip archive then */
-		res = Zip_Extract(stream, SelectZipEntry, ProcessZipEntry,
-							entries, Array_Elems(entries));
+	case PACKFILE_END_ZIP:
+		if (skipExtracted) break;
+		if (file->res) Logger_SysWarn2(file->res, "extracting", &file->name);
+		break;
+	}
+
+	/* Use fallback terrain texture with 1 pixel per tile */
+	if (!Atlas2D.Bmp.scan0) LoadFallbackAtlas();
+}
+
+void TexturePack_ApplyExtracted(cc_bool wait) {
+	struct PackFile* file;
+	if (wait) PackJob_WaitAll();
 
-		if (res) Logger_SysWarn2(res, "extracting", path);
-	} else if (res) {
-		Logger_SysWarn2(res, "decoding", path);
+	for (;;)
+	{
+		Extracted_Lock();
+		{
+			file = files_head;
+			if (file) files_head = file->next;
+		}
+		Extracted_Unlock();
+
+		if (!file) return;
+		ApplyFile(file);
+		PackFile_Free(file);
 	}
-	return res;
+}
+
+/* Queues the given texture pack to be extracted on a background thread */
+/* NOTE: Takes ownership of the stream and data, even if an error is returned */
+static cc_result ExtractFrom(struct Stream* stream, const cc_string* path, cc_uint8* data) {
+	struct PackJob* job = (struct PackJob*)Mem_TryAlloc(1, sizeof(struct PackJob));
+	if (!job) {
+		(void)stream->Close(stream);
+		Mem_Free(data);
+		return ERR_OUT_OF_MEMORY;
+	}
+
+	job->stream = *stream;
+	job->data   = data;
+	String_InitArray(job->path, job->pathBuffer);
+	String_Copy(&job->path, path);
+
+	PackJob_Queue(job);
+	return 0;
 }
 
 #if defined CC_BUILD_PS1 || defined CC_BUILD_SATURN
@@ -510,7 +1106,7 @@ static cc_result ExtractFromFile(const cc_string* path) {
 	struct Stream stream;
 	Stream_ReadonlyMemory(&stream, ccTextures, ccTextures_length);
 
-	return ExtractFrom(&stream, path);
+	return ExtractFrom(&stream, path, NULL);
 }
 #else
 static cc_result ExtractFromFile(const cc_string* path) {
@@ -520,10 +1116,7 @@ static cc_result ExtractFromFile(const cc_string* path) {
 	res = Stream_OpenFile(&stream, path);
 	if (res) { Logger_SysWarn2(res, "opening", path); return res; }
 
-	res = ExtractFrom(&stream, path);
-	/* No point logging error for closing readonly file */
-	(void)stream.Close(&stream);
-	return res;
+	return ExtractFrom(&stream, path, NULL);
 }
 #endif
 
@@ -557,15 +1150,9 @@ cc_result TexturePack_ExtractCurrent(cc_bool forceReload) {
 	}
 
 	if (url.length && OpenCachedData(&url, &stream)) {
-		res = ExtractFrom(&stream, &url);
+		res = ExtractFrom(&stream, &url, NULL);
 		usingDefault = false;
-
-		/* No point logging error for closing readonly file */
-		(void)stream.Close(&stream);
 	}
-
-	/* Use fallback terrain texture with 1 pixel per tile */
-	if (!Atlas2D.Bmp.scan0) LoadFallbackAtlas();
 	return res;
 }
 
@@ -579,13 +1166,16 @@ static void ApplyDownloaded(struct HttpRequest* item) {
 	/* Took too long to download and is no longer active texture pack */
 	if (!String_Equals(&TexturePack_Url, &url)) return;
 
+	/* Texture pack is extracted directly from the downloaded data */
 	Stream_ReadonlyMemory(&mem, item->data, item->size);
-	ExtractFrom(&mem, &url);
+	ExtractFrom(&mem, &url, item->data);
+	item->data = NULL;
 	usingDefault = false;
 }
 
 void TexturePack_CheckPending(void) {
 	struct HttpRequest item;
+	TexturePack_ApplyExtracted(false);
 	if (!Http_GetResult(TexturePack_ReqID, &item)) return;
 
 	if (item.success) {
@@ -630,42 +1220,16 @@ void TexturePack_Extract(const cc_string* url) {
 	TexturePack_ExtractCurrent(false);
 }
 
-static struct TextureEntry* entries_head;
-static struct TextureEntry* entries_tail;
-
-void TextureEntry_Register(struct TextureEntry* entry) {
-	LinkedList_Append(entry, entries_head, entries_tail);
-}
-
 
 /*########################################################################################################################*
 *---------------------------------------------------Textures component----------------------------------------------------*
 *#########################################################################################################################*/
-static void TerrainPngProcess(struct Stream* stream, const cc_string* name) {
-	struct Bitmap bmp;
-	cc_result res = Png_Decode(&bmp, stream);
-
-	if (res) {
-		Logger_SysWarn2(res, "decoding", name);
-		Mem_Free(bmp.scan0);
-	} else if (!Atlas_TryChange(&bmp)) {
-		Mem_Free(bmp.scan0);
-	}
+static void TerrainPngProcess(struct Bitmap* bmp, const cc_string* name) {
+	if (!Atlas_TryChange(bmp)) Mem_Free(bmp->scan0);
 }
-static struct TextureEntry terrain_entry = { "terrain.png", TerrainPngProcess };
+static struct TextureEntry terrain_entry = { "terrain.png", NULL, TerrainPngProcess };
 
 
-static void OnFileChanged(void* obj, struct Stream* stream, const cc_string* name) {
-	struct TextureEntry* e;
-
-	for (e = entries_head; e; e = e->next) {
-		if (!String_CaselessEqualsConst(name, e->filename)) continue;
-
-		e->Callback(stream, name);
-		return;
-	}
-}
-
 static void OnContextLost(void* obj) {
 	if (!Gfx.ManagedTextures) Atlas1D_Free();
 }
@@ -678,9 +1242,11 @@ static void OnContextRecreated(void* obj) {
 
 static void OnInit(void) {
 	cc_string file;
-	Event_Register_(&TextureEvents.FileChanged,  NULL, OnFileChanged);
 	Event_Register_(&GfxEvents.ContextLost,      NULL, OnContextLost);
 	Event_Register_(&GfxEvents.ContextRecreated, NULL, OnContextRecreated);
+#ifndef CC_BUILD_COOPTHREADED
+	if (!extractMutex) extractMutex = Mutex_Create("Texture pack extract");
+#endif
 
 	TexturePack_Path.length = 0;
 	if (Options_UNSAFE_Get(OPT_DEFAULT_TEX_PACK, &file)) {
@@ -696,6 +1262,7 @@ static void OnInit(void) {
 	Utils_EnsureDirectory("texpacks");
 	Utils_EnsureDirectory("texturecache");
 	TextureCache_Init();
+	SkinCache_Init();
 }
 
 static void OnReset(void) {
@@ -705,6 +1272,8 @@ static void OnReset(void) {
 }
 
 static void OnFree(void) {
+	SkinCache_Save();
+	PackJob_FreeAll();
 	OnContextLost(NULL);
 	Atlas2D_Free();
 	TexturePack_Url.length = 0;
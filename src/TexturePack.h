@@ -92,16 +92,31 @@ void TextureCache_Deny(const cc_string* url);
 /* Clears the list of denied URLs, returning number removed. */
 int TextureCache_ClearDenied(void);
 
+/* Asynchronously downloads the given skin, returning the request ID. */
+/* If the skin is cached, the request is conditional (i.e. 304 when unchanged) */
+int SkinCache_Request(const cc_string* skin, cc_uint8 flags);
+/* Loads the cached decoded skin bitmap, and its original dimensions before padding. */
+/* NOTE: You are responsible for freeing the bitmap's memory! */
+cc_bool SkinCache_Load(const cc_string* skin, struct Bitmap* bmp, int* srcWidth, int* srcHeight);
+/* Caches the decoded skin bitmap of a successful skin download. */
+/* NOTE: Only skins with an ETag or Last-Modified header are cached. */
+void SkinCache_Update(const cc_string* skin, struct HttpRequest* item, 
+					struct Bitmap* bmp, int srcWidth, int srcHeight);
+
 /* Request ID of texture pack currently being downloaded */
 extern int TexturePack_ReqID;
 /* Sets the filename of the default texture pack used. */
 void TexturePack_SetDefault(const cc_string* texPack);
 /* If TexturePack_Url is empty, extracts user's default texture pack. */
 /* Otherwise extracts the cached texture pack for that URL. */
+/* NOTE: Extraction happens in the background, see TexturePack_ApplyExtracted */
 cc_result TexturePack_ExtractCurrent(cc_bool forceReload);
 /* Checks if the texture pack currently being downloaded has completed. */
 /* If completed, then applies the downloaded texture pack and updates cache */
 void TexturePack_CheckPending(void);
+/* Applies the files from texture packs that have finished extracting in the background. */
+/* NOTE: If wait is true, first waits for all queued texture packs to finish extracting */
+void TexturePack_ApplyExtracted(cc_bool wait);
 /* If url is empty, extracts default texture pack. */
 /* Else tries extracting cached texture pack for the given URL, */
 /* then asynchronously downloads the texture pack from the given URL. */
@@ -113,7 +128,11 @@ cc_result TexturePack_ExtractDefault(DefaultZipCallback callback);
 struct TextureEntry;
 struct TextureEntry {
 	const char* filename;
+	/* Called with the raw contents of the file */
 	void (*Callback)(struct Stream* stream, const cc_string* name);
+	/* If non-NULL, called instead with the file already decoded as a .png */
+	/* NOTE: Takes ownership of the bitmap, so must either keep or free it */
+	void (*Decoded)(struct Bitmap* bmp, const cc_string* name);
 	struct TextureEntry* next;
 };
 void TextureEntry_Register(struct TextureEntry* entry);
@@ -5,6 +5,7 @@
 #include "Stream.h"
 #include "Errors.h"
 #include "Logger.h"
+#include "Funcs.h"
 
 
 /*########################################################################################################################*
@@ -366,3 +367,151 @@ int EntryList_Find(struct StringsBuffer* list, const cc_string* key, char separa
 	return -1;
 }
 
+
+
+/*########################################################################################################################*
+*-------------------------------------------------------WorkerPool--------------------------------------------------------*
+*#########################################################################################################################*/
+#ifdef CC_BUILD_COOPTHREADED
+/* Worker threads would just be run one after another anyways */
+void WorkerPool_Init(int numThreads) { }
+void WorkerPool_Free(void) { }
+int  WorkerPool_Threads(void) { return 1; }
+
+void WorkerPool_Run(WorkerPool_Func func, void* obj, int count) {
+	int i;
+	for (i = 0; i < count; i++) func(obj, i);
+}
+#else
+static void* pool_threads[WORKERPOOL_MAX_THREADS];
+static void* pool_wakeups[WORKERPOOL_MAX_THREADS];
+static int pool_numThreads, pool_nextID;
+static void* pool_mutex;
+static void* pool_done;
+static volatile cc_bool pool_quit, pool_busy;
+
+/* State of the currently running task */
+static WorkerPool_Func pool_func;
+static void* pool_obj;
+static int pool_next, pool_count, pool_remaining;
+
+/* Runs portions of the current task until there are none left */
+static void WorkerPool_Drain(void) {
+	WorkerPool_Func func;
+	void* obj;
+	int index;
+
+	for (;;)
+	{
+		Mutex_Lock(pool_mutex);
+		if (pool_next >= pool_count) { Mutex_Unlock(pool_mutex); return; }
+
+		index = pool_next++;
+		func  = pool_func;
+		obj   = pool_obj;
+		Mutex_Unlock(pool_mutex);
+
+		func(obj, index);
+
+		Mutex_Lock(pool_mutex);
+		pool_remaining--;
+		if (!pool_remaining) Waitable_Signal(pool_done);
+		Mutex_Unlock(pool_mutex);
+	}
+}
+
+static void WorkerPool_Loop(void) {
+	int id;
+	Mutex_Lock(pool_mutex);
+	id = pool_nextID++;
+	Mutex_Unlock(pool_mutex);
+
+	for (;;)
+	{
+		Waitable_Wait(pool_wakeups[id]);
+		if (pool_quit) return;
+		WorkerPool_Drain();
+	}
+}
+
+void WorkerPool_Init(int numThreads) {
+	int i;
+	if (pool_numThreads || numThreads <= 0) return;
+	numThreads = min(numThreads, WORKERPOOL_MAX_THREADS);
+
+	pool_mutex  = Mutex_Create("Worker pool");
+	pool_done   = Waitable_Create("Worker pool done");
+	pool_quit   = false;
+	pool_nextID = 0;
+
+	/* Threads are assigned IDs in whatever order they start running in */
+	for (i = 0; i < numThreads; i++)
+	{
+		pool_wakeups[i] = Waitable_Create("Worker wakeup");
+	}
+	for (i = 0; i < numThreads; i++)
+	{
+		Thread_Run(&pool_threads[i], WorkerPool_Loop, 256 * 1024, "Worker");
+	}
+	pool_numThreads = numThreads;
+}
+
+void WorkerPool_Free(void) {
+	int i;
+	if (!pool_numThreads) return;
+	pool_quit = true;
+
+	for (i = 0; i < pool_numThreads; i++)
+	{
+		Waitable_Signal(pool_wakeups[i]);
+		Thread_Join(pool_threads[i]);
+		Waitable_Free(pool_wakeups[i]);
+	}
+
+	Waitable_Free(pool_done);
+	Mutex_Free(pool_mutex);
+	pool_numThreads = 0;
+}
+
+int WorkerPool_Threads(void) { return pool_numThreads + 1; }
+
+void WorkerPool_Run(WorkerPool_Func func, void* obj, int count) {
+	cc_bool busy = true;
+	int i, wakeups;
+
+	if (pool_numThreads && count > 1) {
+		Mutex_Lock(pool_mutex);
+		/* Only one task can be run by the workers at a time */
+		busy = pool_busy;
+		if (!busy) {
+			pool_busy      = true;
+			pool_func      = func;
+			pool_obj       = obj;
+			pool_next      = 0;
+			pool_count     = count;
+			pool_remaining = count;
+		}
+		Mutex_Unlock(pool_mutex);
+	}
+
+	if (busy) {
+		for (i = 0; i < count; i++) func(obj, i);
+		return;
+	}
+
+	/* Calling thread also runs portions of the task */
+	wakeups = min(pool_numThreads, count - 1);
+	for (i = 0; i < wakeups; i++) Waitable_Signal(pool_wakeups[i]);
+	WorkerPool_Drain();
+
+	Mutex_Lock(pool_mutex);
+	while (pool_remaining) 
+	{
+		Mutex_Unlock(pool_mutex);
+		Waitable_Wait(pool_done);
+		Mutex_Lock(pool_mutex);
+	}
+	pool_busy = false;
+	Mutex_Unlock(pool_mutex);
+}
+#endif
@@ -77,5 +77,22 @@ CC_NOINLINE STRING_REF cc_string EntryList_UNSAFE_Get(struct StringsBuffer* list
 /* Finds the index of the entry whose key caselessly equals the given key. */
 CC_NOINLINE int EntryList_Find(struct StringsBuffer* list, const cc_string* key, char separator);
 
+/* Function invoked to perform one portion of a larger task. */
+/* NOTE: index ranges from 0 to count - 1, and portions may be run in any order on any thread. */
+typedef void (*WorkerPool_Func)(void* obj, int index);
+/* Maximum number of background worker threads */
+#define WORKERPOOL_MAX_THREADS 16
+
+/* Starts the given number of background worker threads. (0 disables worker threads) */
+void WorkerPool_Init(int numThreads);
+/* Stops and waits for all the background worker threads to exit. */
+void WorkerPool_Free(void);
+/* Returns the number of threads (including the calling thread) that WorkerPool_Run can divide work between. */
+int  WorkerPool_Threads(void);
+/* Calls func for every index from 0 to count - 1, dividing the calls between */
+/*  the background worker threads and the calling thread. Returns once all calls have completed. */
+/* NOTE: If worker threads are disabled or already busy, all calls are run on the calling thread. */
+void WorkerPool_Run(WorkerPool_Func func, void* obj, int count);
+
 CC_END_HEADER
 #endif
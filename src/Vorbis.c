@@ -7,6 +7,20 @@
 #include "Errors.h"
 #include "Stream.h"
 
+#if (defined __x86_64__ || defined _M_X64) && !defined VORBIS_DISABLE_SIMD
+	/* SSE2 is always available on x86_64, and scalar float math there is also done using SSE */
+	/*  (which means the SIMD and scalar paths produce bit-identical output) */
+	#define VORBIS_SIMD
+	#include <emmintrin.h>
+#endif
+
+#ifdef CC_BUILD_BENCHMARK
+cc_bool Vorbis_ReferenceHuffman, Vorbis_ReferenceScalar;
+#else
+#define Vorbis_ReferenceHuffman false
+#define Vorbis_ReferenceScalar  false
+#endif
+
 /*########################################################################################################################*
 *-------------------------------------------------------Ogg stream--------------------------------------------------------*
 *#########################################################################################################################*/
@@ -137,19 +151,37 @@ void Ogg_Init(struct OggState* ctx, struct Stream* source) {
 /*########################################################################################################################*
 *------------------------------------------------------Vorbis utils-------------------------------------------------------*
 *#########################################################################################################################*/
-#define Vorbis_PushByte(ctx, value) ctx->Bits |= (cc_uint32)(value) << ctx->NumBits; ctx->NumBits += 8;
-#define Vorbis_PeekBits(ctx, bits) (ctx->Bits & ((1UL << (bits)) - 1UL))
+#define Vorbis_PushByte(ctx, value) ctx->Bits |= (cc_uint64)(value) << ctx->NumBits; ctx->NumBits += 8;
+#define Vorbis_PeekBits(ctx, bits) ((cc_uint32)ctx->Bits & ((1UL << (bits)) - 1UL))
 #define Vorbis_ConsumeBits(ctx, bits) ctx->Bits >>= (bits); ctx->NumBits -= (bits);
 /* Aligns bit buffer to be on a byte boundary */
 #define Vorbis_AlignBits(ctx) alignSkip = ctx->NumBits & 7; Vorbis_ConsumeBits(ctx, alignSkip);
 /* See https://xiph.org/vorbis/doc/Vorbis_I_spec.html */
 
+/* Fills up the bit buffer with as many whole bytes as are left in the current packet */
+/* Reading across packet/page boundaries is left to the byte at a time fallback paths below */
+static void Vorbis_Refill(struct VorbisState* ctx) {
+	struct OggState* source = ctx->source;
+	cc_uint32 count = (64 - ctx->NumBits) >> 3;
+	cc_uint8* cur   = source->cur;
+
+	if (count > source->left) count = source->left;
+	source->cur  += count;
+	source->left -= count;
+
+	for (; count; count--, cur++) 
+	{
+		Vorbis_PushByte(ctx, *cur);
+	}
+}
+
 /* TODO: Make sure this is inlined */
 static cc_uint32 Vorbis_ReadBits(struct VorbisState* ctx, cc_uint32 bitsCount) {
 	cc_uint8 portion;
 	cc_uint32 data;
 	cc_result res;
 
+	if (ctx->NumBits < bitsCount) Vorbis_Refill(ctx);
 	while (ctx->NumBits < bitsCount) {
 		res = Ogg_ReadU8(ctx->source, &portion);
 		if (res) { Process_Abort2(res, "Failed to read byte for vorbis"); }
@@ -164,6 +196,7 @@ static cc_result Vorbis_TryReadBits(struct VorbisState* ctx, cc_uint32 bitsCount
 	cc_uint8 portion;
 	cc_result res;
 
+	if (ctx->NumBits < bitsCount) Vorbis_Refill(ctx);
 	while (ctx->NumBits < bitsCount) {
 		res = Ogg_ReadU8(ctx->source, &portion);
 		if (res) return res;
@@ -179,6 +212,7 @@ static cc_uint32 Vorbis_ReadBit(struct VorbisState* ctx) {
 	cc_uint32 data;
 	cc_result res;
 
+	if (!ctx->NumBits) Vorbis_Refill(ctx);
 	if (!ctx->NumBits) {
 		res = Ogg_ReadU8(ctx->source, &portion);
 		if (res) { Process_Abort2(res, "Failed to read byte for vorbis"); }
@@ -190,6 +224,15 @@ static cc_uint32 Vorbis_ReadBit(struct VorbisState* ctx) {
 }
 
 
+static cc_uint32 Vorbis_ReverseBits(cc_uint32 v) {
+	v = ((v >> 1) & 0x55555555) | ((v & 0x55555555) << 1);
+	v = ((v >> 2) & 0x33333333) | ((v & 0x33333333) << 2);
+	v = ((v >> 4) & 0x0F0F0F0F) | ((v & 0x0F0F0F0F) << 4);
+	v = ((v >> 8) & 0x00FF00FF) | ((v & 0x00FF00FF) << 8);
+	v = (v >> 16) | (v << 16);
+	return v;
+}
+
 /* Vorbis spec 9.2.1. ilog */
 static int iLog(int x) {
 	int bits = 0;
@@ -248,6 +291,11 @@ static float float32_unpack(struct VorbisState* ctx) {
 *#########################################################################################################################*/
 /* Vorbis spec 3. Probability Model and Codebooks */
 #define CODEBOOK_SYNC 0x564342
+/* Codewords up to this many bits long are decoded with a single table lookup */
+#define CODEBOOK_FAST_BITS 10
+/* Decoded entries are packed as (value << 8) | codeword length */
+#define CODEBOOK_ENTRY_LEN(entry)   ((entry) & 0xFF)
+#define CODEBOOK_ENTRY_VALUE(entry) ((entry) >> 8)
 
 struct Codebook {
 	cc_uint32 dimensions, entries, totalCodewords;
@@ -258,12 +306,20 @@ struct Codebook {
 	float minValue, deltaValue;
 	cc_uint32 sequenceP, lookupType, lookupValues;
 	cc_uint16* multiplicands;
+	/* huffman decoding tables */
+	cc_uint32 fastBits, maxLen, numLong;
+	cc_uint32* fastTable;     /* indexed by next [fastBits] bits of input, 0 if no short codeword matches */
+	cc_uint32* longCodewords; /* codewords longer than [fastBits], sorted in ascending order */
+	cc_uint32* longEntries;
 };
 
 static void Codebook_Free(struct Codebook* c) {
 	Mem_Free(c->codewords);
 	Mem_Free(c->values);
 	Mem_Free(c->multiplicands);
+	Mem_Free(c->fastTable);
+	Mem_Free(c->longCodewords);
+	Mem_Free(c->longEntries);
 }
 
 static cc_uint32 Codebook_Pow(cc_uint32 base, cc_uint32 exp) {
@@ -357,6 +413,81 @@ static cc_bool Codebook_CalcCodewords(struct Codebook* c, cc_uint8* len) {
 	return true;
 }
 
+static cc_uint32* tmp_codewords;
+static cc_uint32* tmp_entries;
+static void Codebook_SortLong(int left, int right) {
+	cc_uint32* values = tmp_entries;  cc_uint32 value;
+	cc_uint32* keys = tmp_codewords;  cc_uint32 key;
+
+	while (left < right) {
+		int i = left, j = right;
+		cc_uint32 pivot = keys[(i + j) >> 1];
+
+		/* partition the list */
+		while (i <= j) {
+			while (pivot > keys[i]) i++;
+			while (pivot < keys[j]) j--;
+			QuickSort_Swap_KV_Maybe();
+		}
+		/* recurse into the smaller subset */
+		QuickSort_Recurse(Codebook_SortLong)
+	}
+}
+
+static void Codebook_CalcTables(struct Codebook* c) {
+	cc_uint32 len, i, j, offset = 0, idx = 0;
+	cc_uint32 code, entry, fastSize;
+
+	c->maxLen = 0;
+	for (len = 1; len <= 32; len++) 
+	{
+		if (c->numCodewords[len]) c->maxLen = len;
+	}
+	c->fastBits = min(c->maxLen, CODEBOOK_FAST_BITS);
+	fastSize    = 1 << c->fastBits;
+
+	c->numLong = c->totalCodewords;
+	for (len = 1; len <= c->fastBits; len++) 
+	{
+		c->numLong -= c->numCodewords[len];
+	}
+
+	c->fastTable     = (cc_uint32*)Mem_AllocCleared(fastSize, 4, "codebook table");
+	c->longCodewords = NULL;
+	c->longEntries   = NULL;
+
+	if (c->numLong) {
+		c->longCodewords = (cc_uint32*)Mem_Alloc(c->numLong, 4, "long codewords");
+		c->longEntries   = (cc_uint32*)Mem_Alloc(c->numLong, 4, "long entries");
+	}
+
+	for (len = 1; len <= 32; len++) 
+	{
+		for (i = 0; i < c->numCodewords[len]; i++, offset++) 
+		{
+			code  = c->codewords[offset];
+			entry = (c->values[offset] << 8) | len;
+
+			if (len > c->fastBits) {
+				c->longCodewords[idx] = code;
+				c->longEntries[idx]   = entry;
+				idx++; continue;
+			}
+
+			/* Codewords are stored MSB first, but bits are read from the stream LSB first */
+			/* Shortest (then earliest) codeword wins, same as the linear search in Codebook_DecodeSlow */
+			for (j = Vorbis_ReverseBits(code); j < fastSize; j += 1 << len) 
+			{
+				if (!c->fastTable[j]) c->fastTable[j] = entry;
+			}
+		}
+	}
+
+	tmp_codewords = c->longCodewords;
+	tmp_entries   = c->longEntries;
+	Codebook_SortLong(0, (int)c->numLong - 1);
+}
+
 static cc_result Codebook_DecodeSetup(struct VorbisState* ctx, struct Codebook* c) {
 	cc_uint32 sync;
 	cc_uint8* codewordLens;
@@ -411,6 +542,7 @@ static cc_result Codebook_DecodeSetup(struct VorbisState* ctx, struct Codebook*
 
 	c->totalCodewords = entry;
 	Codebook_CalcCodewords(c, codewordLens);
+	Codebook_CalcTables(c);
 	Mem_Free(codewordLens);
 
 	c->lookupType    = Vorbis_ReadBits(ctx, 4);
@@ -438,12 +570,12 @@ static cc_result Codebook_DecodeSetup(struct VorbisState* ctx, struct Codebook*
 	return 0;
 }
 
-static cc_uint32 Codebook_DecodeScalar(struct VorbisState* ctx, struct Codebook* c) {
+/* Reads one bit at a time, only used when too few bits are left in the current packet for the fast path */
+static cc_uint32 Codebook_DecodeSlow(struct VorbisState* ctx, struct Codebook* c) {
 	cc_uint32 codeword = 0, shift = 31, depth, i;
 	cc_uint32* codewords = c->codewords;
 	cc_uint32* values    = c->values;
 
-	/* TODO: This is so massively slow */
 	for (depth = 1; depth <= 32; depth++, shift--) 
 	{
 		codeword |= Vorbis_ReadBit(ctx) << shift;
@@ -461,6 +593,40 @@ static cc_uint32 Codebook_DecodeScalar(struct VorbisState* ctx, struct Codebook*
 	return -1;
 }
 
+static cc_uint32 Codebook_DecodeScalar(struct VorbisState* ctx, struct Codebook* c) {
+	cc_uint32 entry, code, len;
+	int lo, hi, mid;
+
+	if (ctx->NumBits < c->maxLen) Vorbis_Refill(ctx);
+	if (ctx->NumBits < c->maxLen || Vorbis_ReferenceHuffman) return Codebook_DecodeSlow(ctx, c);
+
+	entry = c->fastTable[Vorbis_PeekBits(ctx, c->fastBits)];
+	if (!entry) {
+		/* Binary search for the last long codeword <= next 32 bits of input */
+		code = Vorbis_ReverseBits((cc_uint32)ctx->Bits);
+		lo   = 0; hi = c->numLong;
+		if (!hi || c->longCodewords[0] > code) goto invalid;
+
+		while (hi - lo > 1) {
+			mid = (lo + hi) >> 1;
+			if (c->longCodewords[mid] <= code) { lo = mid; } else { hi = mid; }
+		}
+
+		/* Check the codeword is actually a prefix of the input */
+		entry = c->longEntries[lo];
+		len   = CODEBOOK_ENTRY_LEN(entry);
+		if ((code ^ c->longCodewords[lo]) >> (32 - len)) goto invalid;
+	}
+
+	len = CODEBOOK_ENTRY_LEN(entry);
+	Vorbis_ConsumeBits(ctx, len);
+	return CODEBOOK_ENTRY_VALUE(entry);
+
+invalid:
+	Process_Abort("Invalid huffman code");
+	return -1;
+}
+
 static void Codebook_DecodeVectors(struct VorbisState* ctx, struct Codebook* c, float* v, int step) {
 	cc_uint32 lookupOffset = Codebook_DecodeScalar(ctx, c);
 	float last = 0.0f, value;
@@ -1058,14 +1224,6 @@ static cc_result Mapping_DecodeSetup(struct VorbisState* ctx, struct Mapping* m)
 *------------------------------------------------------imdct impl---------------------------------------------------------*
 *#########################################################################################################################*/
 #define PI MATH_PI
-static cc_uint32 Vorbis_ReverseBits(cc_uint32 v) {
-	v = ((v >> 1) & 0x55555555) | ((v & 0x55555555) << 1);
-	v = ((v >> 2) & 0x33333333) | ((v & 0x33333333) << 2);
-	v = ((v >> 4) & 0x0F0F0F0F) | ((v & 0x0F0F0F0F) << 4);
-	v = ((v >> 8) & 0x00FF00FF) | ((v & 0x00FF00FF) << 8);
-	v = (v >> 16) | (v << 16);
-	return v;
-}
 
 void imdct_init(struct imdct_state* state, int n) {
 	int k, k2, n4 = n >> 2, n8 = n >> 3, log2_n;
@@ -1096,6 +1254,37 @@ void imdct_init(struct imdct_state* state, int n) {
 	}
 }
 
+#ifdef VORBIS_SIMD
+/* Same as the scalar step 3 butterflies in imdct_calc, but calculates two values of r at once */
+/*  (for consecutive r, the inputs/outputs of each butterfly are right next to each other) */
+static void imdct_step3_simd(const float* w, float* u, const float* A, int n2, int l) {
+	int k0 = n2 >> (l+2), k1 = 1 << (l+3);
+	int r, r2, rMax = n2 >> (l+3), s2, s2Max = 1 << (l+2);
+	/* second half of each butterfly is [d_1 * A0 - d_2 * A1, d_2 * A0 + d_1 * A1] */
+	const __m128 sign = _mm_set_ps(-1.0f, 1.0f, -1.0f, 1.0f);
+	__m128 a0, a1, e, f, d, ds, res;
+
+	for (r = 0, r2 = 0; r < rMax; r += 2, r2 += 4) 
+	{
+		/* each vector holds [x_2, x_1] for r + 1, then [x_2, x_1] for r */
+		a0 = _mm_set_ps(A[r*k1],   A[r*k1],   A[(r+1)*k1],   A[(r+1)*k1]);
+		a1 = _mm_set_ps(A[r*k1+1], A[r*k1+1], A[(r+1)*k1+1], A[(r+1)*k1+1]);
+
+		for (s2 = 0; s2 < s2Max; s2 += 2) 
+		{
+			e = _mm_loadu_ps(&w[n2-4-k0*s2-r2]);
+			f = _mm_loadu_ps(&w[n2-4-k0*(s2+1)-r2]);
+			_mm_storeu_ps(&u[n2-4-k0*s2-r2], _mm_add_ps(e, f));
+
+			d   = _mm_sub_ps(e, f);
+			ds  = _mm_shuffle_ps(d, d, _MM_SHUFFLE(2, 3, 0, 1));
+			res = _mm_add_ps(_mm_mul_ps(d, a0), _mm_mul_ps(_mm_mul_ps(ds, a1), sign));
+			_mm_storeu_ps(&u[n2-4-k0*(s2+1)-r2], res);
+		}
+	}
+}
+#endif
+
 void imdct_calc(float* in, float* out, struct imdct_state* state) {
 	int k, k2, k4, n = state->n;
 	int n2 = n >> 1, n4 = n >> 2, n8 = n >> 3, n3_4 = n - n4;
@@ -1138,6 +1327,12 @@ void imdct_calc(float* in, float* out, struct imdct_state* state) {
 		int k0 = n >> (l+3), k1 = 1 << (l+3);
 		int r, r2, rMax = n >> (l+4), s2, s2Max = 1 << (l+2);
 
+#ifdef VORBIS_SIMD
+		if (rMax >= 2 && !Vorbis_ReferenceScalar) {
+			imdct_step3_simd(w, u, A, n2, l);
+			rMax = 0; /* skip scalar version below */
+		}
+#endif
 		for (r = 0, r2 = 0; r < rMax; r++, r2 += 2) 
 		{
 			for (s2 = 0; s2 < s2Max; s2 += 2) 
@@ -1412,6 +1607,9 @@ cc_result Vorbis_DecodeHeaders(struct VorbisState* ctx) {
 
 	if ((res = Vorbis_CheckHeader(ctx, 5)))   return res;
 	if ((res = Vorbis_DecodeSetup(ctx)))      return res;
+	/* Also discard any bytes of the setup packet that were buffered */
+	ctx->Bits    = 0;
+	ctx->NumBits = 0;
 	Ogg_DiscardPacket(ctx->source);
 
 	/* window calculations can be pre-computed here */
@@ -1585,15 +1783,82 @@ cc_result Vorbis_DecodeFrame(struct VorbisState* ctx) {
 	return 0;
 }
 
+/* Windows the overlapping halves of the previous and current blocks, then adds them together */
+static void Vorbis_OverlapAdd(const float* prev, const float* cur, float* dst, 
+							const float* prevWindow, const float* curWindow, int count) {
+	int i = 0;
+#ifdef VORBIS_SIMD
+	__m128 p, c;
+	if (!Vorbis_ReferenceScalar) {
+		for (; i + 4 <= count; i += 4) 
+		{
+			p = _mm_mul_ps(_mm_loadu_ps(&prev[i]), _mm_loadu_ps(&prevWindow[i]));
+			c = _mm_mul_ps(_mm_loadu_ps(&cur[i]),  _mm_loadu_ps(&curWindow[i]));
+			_mm_storeu_ps(&dst[i], _mm_add_ps(p, c));
+		}
+	}
+#endif
+
+	for (; i < count; i++) 
+	{
+		dst[i] = prev[i] * prevWindow[i] + cur[i] * curWindow[i];
+	}
+}
+
+#ifdef VORBIS_SIMD
+/* Clamps 8 samples to between -1 and 1, then converts them to 16 bit PCM */
+static CC_INLINE __m128i Vorbis_ConvertSIMD(__m128 a, __m128 b) {
+	const __m128 one = _mm_set1_ps(1.0f), negOne = _mm_set1_ps(-1.0f), scale = _mm_set1_ps(32767.0f);
+	a = _mm_mul_ps(_mm_min_ps(_mm_max_ps(a, negOne), one), scale);
+	b = _mm_mul_ps(_mm_min_ps(_mm_max_ps(b, negOne), one), scale);
+	return _mm_packs_epi32(_mm_cvttps_epi32(a), _mm_cvttps_epi32(b));
+}
+#endif
+
+/* Converts samples to interleaved 16 bit PCM, returning the end of the written data */
+static cc_int16* Vorbis_OutputSamples(float** src, int channels, int count, cc_int16* data) {
+	float sample;
+	int i = 0, ch;
+#ifdef VORBIS_SIMD
+	__m128 l, r;
+	if (channels == 1 && !Vorbis_ReferenceScalar) {
+		for (; i + 8 <= count; i += 8, data += 8) 
+		{
+			l = _mm_loadu_ps(&src[0][i]);
+			r = _mm_loadu_ps(&src[0][i + 4]);
+			_mm_storeu_si128((__m128i*)data, Vorbis_ConvertSIMD(l, r));
+		}
+	} else if (channels == 2 && !Vorbis_ReferenceScalar) {
+		for (; i + 4 <= count; i += 4, data += 8) 
+		{
+			l = _mm_loadu_ps(&src[0][i]);
+			r = _mm_loadu_ps(&src[1][i]);
+			_mm_storeu_si128((__m128i*)data, Vorbis_ConvertSIMD(_mm_unpacklo_ps(l, r), _mm_unpackhi_ps(l, r)));
+		}
+	}
+#endif
+
+	for (; i < count; i++) 
+	{
+		for (ch = 0; ch < channels; ch++) 
+		{
+			sample = src[ch][i];
+			Math_Clamp(sample, -1.0f, 1.0f);
+			*data++ = (cc_int16)(sample * 32767);
+		}
+	}
+	return data;
+}
+
 int Vorbis_OutputFrame(struct VorbisState* ctx, cc_int16* data) {
 	struct VorbisWindow window;
 	float* prev[VORBIS_MAX_CHANS];
 	float*  cur[VORBIS_MAX_CHANS];
+	float* overlap[VORBIS_MAX_CHANS];
 
 	int curQrtr, prevQrtr, overlapQtr;
 	int curOffset, prevOffset, overlapSize;
-	float sample;
-	int i, ch;
+	int i;
 
 	/* first frame decoded has no data */
 	if (ctx->prevBlockSize == 0) {
@@ -1626,15 +1891,7 @@ int Vorbis_OutputFrame(struct VorbisState* ctx, cc_int16* data) {
 	}
 
 	/* for long prev and short cur block, there will be non-overlapped data before */
-	for (i = 0; i < prevOffset; i++) 
-	{
-		for (ch = 0; ch < ctx->channels; ch++) 
-		{
-			sample = prev[ch][i];
-			Math_Clamp(sample, -1.0f, 1.0f);
-			*data++ = (cc_int16)(sample * 32767);
-		}
-	}
+	data = Vorbis_OutputSamples(prev, ctx->channels, prevOffset, data);
 
 	/* adjust pointers to start at 0 for overlapping */
 	for (i = 0; i < ctx->channels; i++) 
@@ -1647,27 +1904,17 @@ int Vorbis_OutputFrame(struct VorbisState* ctx, cc_int16* data) {
 
 	/* overlap and add data */
 	/* also perform windowing here */
-	for (i = 0; i < overlapSize; i++) 
+	/* (temp array is free at this point, and is large enough for [channels * (largest blocksize / 2)] samples) */
+	for (i = 0; i < ctx->channels; i++) 
 	{
-		for (ch = 0; ch < ctx->channels; ch++) 
-		{
-			sample = prev[ch][i] * window.Prev[i] + cur[ch][i] * window.Cur[i];
-			Math_Clamp(sample, -1.0f, 1.0f);
-			*data++ = (cc_int16)(sample * 32767);
-		}
+		overlap[i] = ctx->temp + i * overlapSize;
+		Vorbis_OverlapAdd(prev[i], cur[i], overlap[i], window.Prev, window.Cur, overlapSize);
 	}
+	data = Vorbis_OutputSamples(overlap, ctx->channels, overlapSize, data);
 
 	/* for long cur and short prev block, there will be non-overlapped data after */
 	for (i = 0; i < ctx->channels; i++) { cur[i] += overlapSize; }
-	for (i = 0; i < curOffset; i++) 
-	{
-		for (ch = 0; ch < ctx->channels; ch++) 
-		{
-			sample = cur[ch][i];
-			Math_Clamp(sample, -1.0f, 1.0f);
-			*data++ = (cc_int16)(sample * 32767);
-		}
-	}
+	Vorbis_OutputSamples(cur, ctx->channels, curOffset, data);
 
 	ctx->prevBlockSize = ctx->curBlockSize;
 	return (prevQrtr + curQrtr) * ctx->channels;
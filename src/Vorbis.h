@@ -35,7 +35,7 @@ struct imdct_state {
 
 struct VorbisWindow { float* Prev; float* Cur; };
 struct VorbisState {
-	cc_uint32 Bits;    /* Holds bits across byte boundaries*/
+	cc_uint64 Bits;    /* Holds bits across byte boundaries*/
 	cc_uint32 NumBits; /* Number of bits in Bits buffer*/
 	struct OggState* source; /* Source for filling Input buffer */
 
@@ -69,5 +69,13 @@ cc_result Vorbis_DecodeFrame(struct VorbisState* ctx);
 /* Produces final interleaved audio samples for the current frame. */
 int Vorbis_OutputFrame(struct VorbisState* ctx, cc_int16* data);
 
+#ifdef CC_BUILD_BENCHMARK
+/* Whether to always decode huffman codes one bit at a time, instead of using the lookup tables */
+/*  (so the benchmark can check the lookup tables produce exactly the same output) */
+extern cc_bool Vorbis_ReferenceHuffman;
+/* Whether to always use the scalar imdct/windowing/output code, even when SIMD is supported */
+extern cc_bool Vorbis_ReferenceScalar;
+#endif
+
 CC_END_HEADER
 #endif
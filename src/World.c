@@ -10,8 +10,13 @@
 #include "Game.h"
 #include "TexturePack.h"
 #include "Window.h"
+#include "Errors.h"
+#include "Funcs.h"
 
 struct _WorldData World;
+#ifdef CC_BUILD_BLOCKSTORE
+struct BlockStore World_Store;
+#endif
 static char nameBuffer[STRING_SIZE];
 /*########################################################################################################################*
 *----------------------------------------------------------World----------------------------------------------------------*
@@ -45,6 +50,9 @@ void World_Reset(void) {
 #endif
 	Mem_Free(World.Blocks);
 	World.Blocks = NULL;
+#ifdef CC_BUILD_BLOCKSTORE
+	BlockStore_Free(&World_Store);
+#endif
 	String_InitArray(World.Name, nameBuffer);
 
 	World_SetDimensions(0, 0, 0);
@@ -75,6 +83,10 @@ void World_SetNewMap(BlockRaw* blocks, int width, int height, int length) {
 		World.IDMask  = 0xFF;
 	}
 #endif
+#ifdef CC_BUILD_BLOCKSTORE
+	BlockStore_Free(&World_Store);
+	if (BlockStore_FromWorld(&World_Store)) { World_OutOfMemory(); return; }
+#endif
 
 	if (Env.EdgeHeight == -1)   { Env.EdgeHeight   = height / 2; }
 	if (Env.CloudsHeight == -1) { Env.CloudsHeight = height + 2; }
@@ -125,6 +137,9 @@ static CC_NOINLINE void LazyInitUpper(int i, BlockID block) {
 void World_SetBlock(int x, int y, int z, BlockID block) {
 	int i = World_Pack(x, y, z);
 	World.Blocks[i] = (BlockRaw)block;
+#ifdef CC_BUILD_BLOCKSTORE
+	BlockStore_Set(&World_Store, i, block);
+#endif
 
 	/* defer allocation of second map array if possible */
 	if (World.Blocks == World.Blocks2) {
@@ -136,7 +151,11 @@ void World_SetBlock(int x, int y, int z, BlockID block) {
 }
 #else
 void World_SetBlock(int x, int y, int z, BlockID block) {
-	World.Blocks[World_Pack(x, y, z)] = block; 
+	int i = World_Pack(x, y, z);
+	World.Blocks[i] = block;
+#ifdef CC_BUILD_BLOCKSTORE
+	BlockStore_Set(&World_Store, i, block);
+#endif
 }
 #endif
 
@@ -152,6 +171,178 @@ BlockID World_SafeGetBlock(int x, int y, int z) {
 }
 
 
+/*########################################################################################################################*
+*-------------------------------------------------------BlockStore--------------------------------------------------------*
+*#########################################################################################################################*/
+/* Number of 32 bit words needed to store every block in a run, with the given bits per block */
+#define BlockStore_Words(bits) ((BLOCKSTORE_RUN_SIZE * (bits)) >> 5)
+
+cc_result BlockStore_Init(struct BlockStore* store, cc_uint32 volume) {
+	store->volume    = volume;
+	store->runsCount = (volume >> BLOCKSTORE_RUN_SHIFT) + ((volume & BLOCKSTORE_RUN_MASK) != 0);
+	store->runs      = NULL;
+	if (!store->runsCount) return 0;
+
+	/* BLOCK_AIR is 0, so every run starts as uniform air */
+	store->runs = (struct BlockStoreRun*)Mem_TryAllocCleared(store->runsCount, sizeof(struct BlockStoreRun));
+	return store->runs ? 0 : ERR_OUT_OF_MEMORY;
+}
+
+void BlockStore_Free(struct BlockStore* store) {
+	cc_uint32 i;
+	if (!store->runs) return;
+
+	for (i = 0; i < store->runsCount; i++)
+	{
+		Mem_Free(store->runs[i].data);
+		Mem_Free(store->runs[i].palette);
+	}
+	Mem_Free(store->runs);
+	store->runs      = NULL;
+	store->runsCount = 0;
+	store->volume    = 0;
+}
+
+/* Reallocates the run's palette and data to use the given number of bits per block */
+static void BlockStore_Repack(struct BlockStoreRun* run, int bits) {
+	cc_uint32* data = (cc_uint32*)Mem_AllocCleared(BlockStore_Words(bits), 4, "block store data");
+	int oldBits = run->bitsPerBlock, mask = (1 << oldBits) - 1;
+	int i, src, dst, value;
+
+	/* Uniform runs have all indices as 0 already */
+	if (oldBits) {
+		for (i = 0; i < BLOCKSTORE_RUN_SIZE; i++)
+		{
+			src   = i * oldBits;
+			dst   = i * bits;
+			value = (run->data[src >> 5] >> (src & 31)) & mask;
+			data[dst >> 5] |= (cc_uint32)value << (dst & 31);
+		}
+	}
+	Mem_Free(run->data);
+	run->data = data;
+
+	run->palette = (BlockID*)Mem_Realloc(run->palette, min(1 << bits, BLOCK_COUNT), 
+										sizeof(BlockID), "block store palette");
+	if (!oldBits) {
+		run->palette[0]   = run->uniform;
+		run->paletteCount = 1;
+	}
+	run->bitsPerBlock = bits;
+}
+
+static int BlockStore_AddToPalette(struct BlockStoreRun* run, BlockID block) {
+	int i, bits = run->bitsPerBlock;
+	for (i = 0; i < run->paletteCount; i++)
+	{
+		if (run->palette[i] == block) return i;
+	}
+
+	if (!bits || run->paletteCount == (1 << bits)) {
+		BlockStore_Repack(run, bits ? bits * 2 : 1);
+	}
+	run->palette[run->paletteCount] = block;
+	return run->paletteCount++;
+}
+
+void BlockStore_Set(struct BlockStore* store, cc_uint32 index, BlockID block) {
+	struct BlockStoreRun* run = &store->runs[index >> BLOCKSTORE_RUN_SHIFT];
+	cc_uint32 i;
+	int value;
+	if (!run->bitsPerBlock && run->uniform == block) return;
+
+	value = BlockStore_AddToPalette(run, block);
+	i     = (index & BLOCKSTORE_RUN_MASK) * run->bitsPerBlock;
+
+	run->data[i >> 5] &= ~((cc_uint32)((1 << run->bitsPerBlock) - 1) << (i & 31));
+	run->data[i >> 5] |= (cc_uint32)value << (i & 31);
+}
+
+#ifdef EXTENDED_BLOCKS
+#define World_FlatBlock(i) ((World.Blocks[i] | (World.Blocks2[i] << 8)) & World.IDMask)
+#else
+#define World_FlatBlock(i) World.Blocks[i]
+#endif
+
+/* Compresses the blocks of the current world in the given run */
+static void BlockStore_CompressRun(struct BlockStoreRun* run, cc_uint32 start, cc_uint32 end) {
+	cc_int16 indices[BLOCK_COUNT];
+	BlockID blocks[BLOCKSTORE_RUN_SIZE];
+	BlockID block;
+	int i, bits, count = 0;
+
+	for (i = 0; start + i < end; i++) 
+	{
+		blocks[i] = World_FlatBlock(start + i);
+	}
+	/* Part of the last run past the end of the world just repeats a block already in the run */
+	for (; i < BLOCKSTORE_RUN_SIZE; i++) blocks[i] = blocks[0];
+
+	Mem_Set(indices, 0xFF, sizeof(indices));
+	for (i = 0; i < BLOCKSTORE_RUN_SIZE; i++)
+	{
+		block = blocks[i];
+		if (indices[block] >= 0) continue;
+		indices[block] = count++;
+	}
+
+	run->uniform = blocks[0];
+	if (count == 1) return;
+
+	for (bits = 1; (1 << bits) < count; bits *= 2) { }
+	BlockStore_Repack(run, bits);
+
+	for (i = 0; i < BLOCKSTORE_RUN_SIZE; i++)
+	{
+		block = blocks[i];
+		run->palette[indices[block]] = block;
+		run->data[(i * bits) >> 5]  |= (cc_uint32)indices[block] << ((i * bits) & 31);
+	}
+	run->paletteCount = count;
+}
+
+cc_result BlockStore_FromWorld(struct BlockStore* store) {
+	cc_uint32 i, start;
+	cc_result res;
+
+	res = BlockStore_Init(store, World.Volume);
+	if (res) return res;
+
+	for (i = 0; i < store->runsCount; i++)
+	{
+		start = i << BLOCKSTORE_RUN_SHIFT;
+		BlockStore_CompressRun(&store->runs[i], start, min(start + BLOCKSTORE_RUN_SIZE, store->volume));
+	}
+	return 0;
+}
+
+cc_uint64 BlockStore_MemoryUsed(const struct BlockStore* store) {
+	const struct BlockStoreRun* run;
+	cc_uint64 size = (cc_uint64)store->runsCount * sizeof(struct BlockStoreRun);
+	cc_uint32 i;
+
+	for (i = 0; i < store->runsCount; i++)
+	{
+		run = &store->runs[i];
+		if (!run->bitsPerBlock) continue;
+
+		size += BlockStore_Words(run->bitsPerBlock) * 4;
+		size += min(1 << run->bitsPerBlock, BLOCK_COUNT) * sizeof(BlockID);
+	}
+	return size;
+}
+
+#ifdef CC_BUILD_BLOCKSTORE
+void World_UpdateStore(int index, int count) {
+	int i;
+	for (i = index; i < index + count; i++)
+	{
+		BlockStore_Set(&World_Store, i, World_FlatBlock(i));
+	}
+}
+#endif
+
+
 /*########################################################################################################################*
 *-------------------------------------------------------Environment-------------------------------------------------------*
 *#########################################################################################################################*/
@@ -2,6 +2,7 @@
 #define CC_WORLD_H
 #include "Vectors.h"
 #include "PackedCol.h"
+#include "Constants.h"
 CC_BEGIN_HEADER
 
 /* 
@@ -62,6 +63,64 @@ CC_VAR extern struct _WorldData {
 	int Seed;
 } World;
 
+
+#define BLOCKSTORE_RUN_SHIFT 12
+#define BLOCKSTORE_RUN_SIZE  (1 << BLOCKSTORE_RUN_SHIFT)
+#define BLOCKSTORE_RUN_MASK  (BLOCKSTORE_RUN_SIZE - 1)
+
+/* Compressed storage of BLOCKSTORE_RUN_SIZE consecutive blocks (i.e. with consecutive World_Pack indices) */
+struct BlockStoreRun {
+	/* Indices into the palette for each block, packed into bitsPerBlock bits each */
+	/* NOTE: NULL when every block in the run is the same (i.e. uniform) */
+	cc_uint32* data;
+	/* Distinct blocks in the run (NULL when uniform) */
+	BlockID* palette;
+	cc_uint16 paletteCount;
+	/* Number of bits each palette index takes up. (0, 1, 2, 4, 8 or 16) */
+	cc_uint8 bitsPerBlock;
+	/* The block every block in the run is when the run is uniform */
+	BlockID uniform;
+};
+
+/* Storage of blocks addressed by World_Pack indices, where each run of blocks only uses as many */
+/*  bits per block as it has distinct blocks. Uses far less memory than a flat array for mostly empty or uniform worlds */
+struct BlockStore {
+	struct BlockStoreRun* runs;
+	cc_uint32 volume, runsCount;
+};
+
+/* Allocates a store of the given volume, with every block initially set to air */
+/* NOTE: Unlike World.Blocks, the volume may be larger than 2^31 blocks */
+cc_result BlockStore_Init(struct BlockStore* store, cc_uint32 volume);
+/* Allocates a store with the same volume and blocks as the current world */
+cc_result BlockStore_FromWorld(struct BlockStore* store);
+/* Frees all memory used by the given store */
+void BlockStore_Free(struct BlockStore* store);
+/* Sets the block at the given index */
+/* NOTE: Does NOT check that the index is inside the store */
+void BlockStore_Set(struct BlockStore* store, cc_uint32 index, BlockID block);
+/* Returns the number of bytes of memory used by the given store */
+cc_uint64 BlockStore_MemoryUsed(const struct BlockStore* store);
+
+/* Returns the block at the given index */
+/* NOTE: Does NOT check that the index is inside the store */
+static CC_INLINE BlockID BlockStore_Get(const struct BlockStore* store, cc_uint32 index) {
+	const struct BlockStoreRun* run = &store->runs[index >> BLOCKSTORE_RUN_SHIFT];
+	cc_uint32 bits = run->bitsPerBlock, i;
+	if (!bits) return run->uniform;
+
+	i = (index & BLOCKSTORE_RUN_MASK) * bits;
+	return run->palette[(run->data[i >> 5] >> (i & 31)) & ((1 << bits) - 1)];
+}
+
+#ifdef CC_BUILD_BLOCKSTORE
+/* Palette compressed blocks of the world, which World_GetBlock/World_SetBlock go through */
+/* NOTE: World.Blocks is still kept up to date, as physics/lighting/mesh building/map formats index it directly */
+CC_VAR extern struct BlockStore World_Store;
+/* Updates World_Store after the given range of World.Blocks was directly modified */
+void World_UpdateStore(int index, int count);
+#endif
+
 /* Frees the blocks array, sets dimensions to 0, resets environment to default. */
 void World_Reset(void);
 /* Sets up state and raises WorldEvents.NewMap event */
@@ -78,7 +137,12 @@ void World_OutOfMemory(void);
 #ifdef EXTENDED_BLOCKS
 /* Sets World.Blocks2 and updates internal state for more than 256 blocks. */
 void World_SetMapUpper(BlockRaw* blocks);
+#endif
 
+#if defined CC_BUILD_BLOCKSTORE
+#define World_GetBlock(x, y, z) BlockStore_Get(&World_Store, World_Pack(x, y, z))
+#define World_GetRawBlock(idx)  BlockStore_Get(&World_Store, idx)
+#elif defined EXTENDED_BLOCKS
 #define World_GetRawBlock(idx) ((World.Blocks[idx] | (World.Blocks2[idx] << 8)) & World.IDMask)
 
 /* Gets the block at the given coordinates. */
@@ -120,6 +184,7 @@ static CC_INLINE cc_bool World_CheckVolume(int width, int height, int length) {
 	return volume <= Int32_MaxValue;
 }
 
+
 enum EnvVar {
 	ENV_VAR_EDGE_BLOCK, ENV_VAR_SIDES_BLOCK, ENV_VAR_EDGE_HEIGHT, ENV_VAR_SIDES_OFFSET,
 	ENV_VAR_CLOUDS_HEIGHT, ENV_VAR_CLOUDS_SPEED, ENV_VAR_WEATHER_SPEED, ENV_VAR_WEATHER_FADE,
@@ -115,6 +115,7 @@ static void RequestList_Free(struct RequestList* list) {
 *#########################################################################################################################*/
 static void* processedMutex;
 static struct RequestList processedReqs;
+static struct HttpStats http_stats;
 static int nextReqID;
 static void HttpBackend_Add(struct HttpRequest* req, cc_uint8 flags);
 
@@ -154,8 +155,9 @@ static int Http_Add(const cc_string* url, cc_uint8 flags, cc_uint8 type, const c
 		Mem_Copy(req.data, data, size);
 		req.size = size;
 	}
-	req.cookies  = cookies;
-	req.progress = HTTP_PROGRESS_NOT_WORKING_ON;
+	req.cookies   = cookies;
+	req.progress  = HTTP_PROGRESS_NOT_WORKING_ON;
+	req.timeAdded = Stopwatch_Measure();
 
 	HttpBackend_Add(&req, flags);
 	return req.id;
@@ -199,6 +201,10 @@ static void Http_FinishRequest(struct HttpRequest* req) {
 	{
 		req->timeDownloaded = Stopwatch_Measure();
 		RequestList_Append(&processedReqs, req, false);
+
+		http_stats.completed++;
+		http_stats.waitMS += Stopwatch_ElapsedMS(req->timeAdded,   req->timeStarted);
+		http_stats.workMS += Stopwatch_ElapsedMS(req->timeStarted, req->timeDownloaded);
 	}
 	Mutex_Unlock(processedMutex);
 }
@@ -228,15 +234,19 @@ static void Http_CleanCacheTask(struct ScheduledTask* task) {
 /*########################################################################################################################*
 *----------------------------------------------------Http public api------------------------------------------------------*
 *#########################################################################################################################*/
+void Http_GetSkinUrl(const cc_string* skinName, cc_string* url) {
+	if (Utils_IsUrlPrefix(skinName)) {
+		String_Copy(url, skinName);
+	} else {
+		String_Format2(url, "%s/%s.png", &skinServer, skinName);
+	}
+}
+
 int Http_AsyncGetSkin(const cc_string* skinName, cc_uint8 flags) {
 	cc_string url; char urlBuffer[URL_MAX_SIZE];
 	String_InitArray(url, urlBuffer);
 
-	if (Utils_IsUrlPrefix(skinName)) {
-		String_Copy(&url, skinName);
-	} else {
-		String_Format2(&url, "%s/%s.png", &skinServer, skinName);
-	}
+	Http_GetSkinUrl(skinName, &url);
 	return Http_AsyncGetData(&url, flags);
 }
 
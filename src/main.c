@@ -10,6 +10,7 @@
 #include "Server.h"
 #include "Options.h"
 #include "main.h"
+#include "Benchmark.h"
 
 /*########################################################################################################################*
 *-------------------------------------------------Complex argument parsing------------------------------------------------*
@@ -231,6 +232,13 @@ void android_main(void) {
 	SetupProgram(0, NULL);
 	for (;;) { RunProgram(0, NULL); }
 }
+#elif defined CC_BUILD_BENCHMARK
+/* Benchmark builds never create a window, and just run the benchmarks */
+int main(int argc, char** argv) {
+	int res = Benchmark_Run(argc, argv);
+	Process_Exit(res);
+	return res;
+}
 #elif defined CC_BUILD_CONSOLE
 int main(int argc, char** argv) {
 	SetupProgram(argc, argv);